@@ -37,6 +37,11 @@ namespace bob {
  */
 namespace ap {
 
+/**
+ * @brief The number of frames processed at once by a thread
+ */
+const size_t CEPS_BATCH_SIZE = 64;
+
 /**
  * @brief This class is used to test the Ceps class (private methods)
  */
@@ -93,9 +98,12 @@ class Ceps: public Spectrogram
     blitz::TinyVector<int,2> getShape(const blitz::Array<double,1>& input) const;
 
     /**
-     * @brief Computes Cepstral features
+     * @brief Computes Cepstral features. The frames are processed by blocks
+     * of CEPS_BATCH_SIZE frames by the threads of the bob::core pool. This
+     * does not modify the extractor, which may therefore be used by several
+     * threads at once.
      */
-    void operator()(const blitz::Array<double,1>& input, blitz::Array<double,2>& output);
+    void operator()(const blitz::Array<double,1>& input, blitz::Array<double,2>& output) const;
 
     /**
      * @brief Returns the sampling frequency/frequency rate
@@ -178,16 +186,47 @@ class Ceps: public Spectrogram
       m_with_delta_delta = with_delta_delta; }
 
   private:
+    /**
+     * @brief Computes the energy (if required) and the cepstral coefficients
+     * of the i-th frame of the input, and writes them at the beginning of
+     * the given output row (coefficients first, then energy)
+     */
+    void computeFrame(const blitz::Array<double,1>& input, const size_t i,
+      blitz::Array<double,1>& ceps_row);
+
     /**
      * @brief Computes the first order derivative from the given input. 
      * This methods is used to compute both the delta's and double delta's.
      */
     void addDerivative(const blitz::Array<double,2>& input, blitz::Array<double,2>& output) const;
     /**
-     * @brief Applies the DCT to the cepstral features:
+     * @brief Computes the cepstral features of the frames [begin, end) using
+     * the working arrays of the given thread
+     */
+    void processFrames(const blitz::Array<double,1>& input,
+      blitz::Array<double,2>& output, std::vector<FrameCache>& caches,
+      size_t begin, size_t end, size_t thread) const;
+
+    /**
+     * @brief Applies the DCT to the output of the filters of n_frames frames
+     * (one per row), which is the product with the transposed DCT kernel,
+     * and writes the coefficients in the rows of the output starting at
+     * the given offset:
      * \f$out[i]=sqrt(2/N)*sum_{j=1}^{N} (in[j]cos(M_PI*i*(j-0.5)/N)\f$
      */
-    void applyDct(blitz::Array<double,1>& ceps_row) const;
+    void applyDct(const blitz::Array<double,2>& filters, const size_t n_frames,
+      blitz::Array<double,2>& output, const size_t offset) const;
+
+    /**
+     * @brief Returns the c-th DCT coefficient of the output of the filters.
+     * Both the batch and the streaming extraction use it, such that their
+     * results are identical.
+     */
+    double dctCoefficient(const blitz::Array<double,1>& filters,
+      const int c) const
+    { double res = 0.;
+      for (int j=0; j<(int)m_n_filters; ++j) res += filters(j) * m_dct_kernel(c,j);
+      return res; }
 
     void initCacheDctKernel();
     /**
@@ -218,6 +257,8 @@ class Ceps: public Spectrogram
 
     blitz::Array<double,2> m_dct_kernel;
 
+    friend class CepsStream;
+
 //    friend class TestCeps;
 };
 /*
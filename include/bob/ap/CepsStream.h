@@ -0,0 +1,185 @@
+/**
+ * @file bob/ap/CepsStream.h
+ * @date Sat Oct 17 16:12:08 CEST 2026
+ * @author Laurent El Shafey <Laurent.El-Shafey@idiap.ch>
+ *
+ * @brief Extracts cepstral features (MFCC and LFCC) from an audio stream,
+ * one block of samples at a time
+ *
+ * Copyright (C) 2011-2013 Idiap Research Institute, Martigny, Switzerland
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef BOB_AP_CEPS_STREAM_H
+#define BOB_AP_CEPS_STREAM_H
+
+#include <blitz/array.h>
+#include "Ceps.h"
+
+namespace bob {
+/**
+ * \ingroup libap_api
+ * @{
+ */
+namespace ap {
+
+/**
+ * @brief This class extracts the same features as a Ceps extractor from an
+ * audio signal which is given as consecutive blocks of samples of arbitrary
+ * sizes.
+ *
+ * Frames are output as soon as they are complete. When first and second
+ * order derivatives are computed, a frame is delayed until the delta_win
+ * (or 2*delta_win) next frames are known. Once the last block has been
+ * pushed, flush() outputs the remaining frames, using the same boundary
+ * handling as Ceps. The concatenation of the outputs is then identical to
+ * the output of Ceps on the whole signal.
+ *
+ * The memory used is bounded by a window of samples and 4*delta_win+2
+ * frames, and is allocated once for all when the extractor is constructed.
+ */
+class CepsStream
+{
+  public:
+    /**
+     * @brief Constructor. The configuration of the given Ceps extractor is
+     * copied, such that later changes of this extractor are not taken into
+     * account.
+     */
+    CepsStream(const Ceps& ceps);
+
+    /**
+     * @brief Copy constructor. The current state of the stream is copied
+     * as well.
+     */
+    CepsStream(const CepsStream& other);
+
+    /**
+     * @brief Assignment operator
+     */
+    CepsStream& operator=(const CepsStream& other);
+
+    /**
+     * @brief Destructor
+     */
+    virtual ~CepsStream();
+
+    /**
+     * @brief Returns the configuration of the features
+     */
+    const Ceps& getCeps() const
+    { return m_ceps; }
+
+    /**
+     * @brief Returns the dimension of the feature vectors
+     */
+    size_t getNFeatures() const
+    { return m_n_features; }
+
+    /**
+     * @brief Returns the maximum number of frames that push() may output
+     * for a block of n_samples samples
+     */
+    size_t getMaxNFrames(const size_t n_samples) const;
+
+    /**
+     * @brief Returns the number of frames that flush() will output
+     */
+    size_t getNPendingFrames() const
+    { return m_n_frames - m_n_output; }
+
+    /**
+     * @brief Returns the number of frames output since the beginning of
+     * the stream
+     */
+    size_t getNOutputFrames() const
+    { return m_n_output; }
+
+    /**
+     * @brief Processes the next block of samples of the stream. The frames
+     * that are complete are written at the beginning of the output array,
+     * which must have at least getMaxNFrames(input.extent(0)) rows and
+     * getNFeatures() columns.
+     * @return The number of frames written.
+     */
+    size_t push(const blitz::Array<double,1>& input,
+      blitz::Array<double,2>& output);
+
+    /**
+     * @brief Ends the stream, by writing the remaining frames at the
+     * beginning of the output array, which must have at least
+     * getNPendingFrames() rows and getNFeatures() columns. The extractor is
+     * then reset and ready to process a new stream.
+     * @return The number of frames written.
+     */
+    size_t flush(blitz::Array<double,2>& output);
+
+    /**
+     * @brief Discards the current stream
+     */
+    void reset();
+
+  private:
+    void initCache();
+    void checkOutput(const blitz::Array<double,2>& output,
+      const size_t n_frames) const;
+
+    /**
+     * @brief Computes the features of the frame held by the window of
+     * samples and outputs the frames which do not require any more
+     * lookahead.
+     */
+    void processFrame(blitz::Array<double,2>& output, size_t& n_output);
+
+    /**
+     * @brief Computes the i-th row of the derivative of the given ring of
+     * frames, as Ceps::addDerivative() would do. n_frames is the length of
+     * the stream if it is known, 0 if it has not ended yet.
+     */
+    void derivative(const blitz::Array<double,2>& input, const size_t i,
+      const size_t n_frames, blitz::Array<double,2>& output) const;
+
+    void outputFrame(const size_t i, blitz::Array<double,2>& output,
+      size_t& n_output);
+
+    Ceps m_ceps;
+    size_t m_n_coefs;
+    size_t m_n_features;
+    size_t m_n_ring;
+
+    // Window of samples and number of samples it contains, and number of
+    // samples to skip before the next window when the shift is larger than
+    // the window
+    blitz::Array<double,1> m_samples;
+    size_t m_n_samples;
+    size_t m_n_skip;
+
+    // Rings of the last static features, first and second order derivatives
+    blitz::Array<double,2> m_ring_static;
+    blitz::Array<double,2> m_ring_delta;
+    blitz::Array<double,2> m_ring_delta_delta;
+
+    // Number of frames computed, of first and second order derivatives
+    // computed, and of frames output
+    size_t m_n_frames;
+    size_t m_n_delta;
+    size_t m_n_delta_delta;
+    size_t m_n_output;
+};
+
+}
+}
+
+#endif /* BOB_AP_CEPS_STREAM_H */
@@ -119,7 +119,9 @@ class FrameExtractor
 
   protected:
     /**
-     * @brief Extracts the frame of the given index
+     * @brief Extracts the frame of the given index. No view of the input
+     * is created, such that several threads may extract frames of the same
+     * input concurrently.
      * @warning No check is performed
      */
     virtual void extractNormalizeFrame(const blitz::Array<double,1>& input, 
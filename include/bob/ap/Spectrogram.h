@@ -30,7 +30,7 @@
 #include <blitz/array.h>
 #include <boost/format.hpp>
 
-#include <bob/sp/FFT1D.h>
+#include <bob/sp/RFFT1D.h>
 
 #include "Energy.h"
 
@@ -89,9 +89,11 @@ class Spectrogram: public Energy
     virtual blitz::TinyVector<int,2> getShape(const blitz::Array<double,1>& input) const;
 
     /**
-     * @brief Computes the spectrogram
+     * @brief Computes the spectrogram. The frames are processed by the
+     * threads of the bob::core pool. This does not modify the extractor,
+     * which may therefore be used by several threads at once.
      */
-    void operator()(const blitz::Array<double,1>& input, blitz::Array<double,2>& output);
+    void operator()(const blitz::Array<double,1>& input, blitz::Array<double,2>& output) const;
 
     /**
      * @brief Returns the number of filters used in the filter bank.
@@ -221,24 +223,55 @@ class Spectrogram: public Energy
     void hammingWindow(blitz::Array<double,1> &data) const;
 
     /**
-     * @brief Computes the power-spectrum of the FFT of the input frame
+     * @brief Computes the power-spectrum of the FFT of the input frame, using
+     * the given working array of win_size/2+1 elements
      */
-    void powerSpectrumFFT(blitz::Array<double,1>& x);
+    void powerSpectrumFFT(blitz::Array<double,1>& x,
+      blitz::Array<std::complex<double>,1>& x_c) const;
     /**
-     * @brief Applies the triangular filter bank
+     * @brief Applies the triangular filter bank, and writes the output of
+     * the filters in the given array
      */
-    void filterBank(blitz::Array<double,1>& x);
+    void filterBank(const blitz::Array<double,1>& x,
+      blitz::Array<double,1>& filters) const;
     /**
      * @brief Applies the triangular filter bank to the input array and
      * returns the logarithm of the magnitude in each band.
      */
-    void logTriangularFilterBank(blitz::Array<double,1>& data) const;
+    void logTriangularFilterBank(const blitz::Array<double,1>& data,
+      blitz::Array<double,1>& filters) const;
     /**
      * @brief Applies the triangular filter bank to the input array and
      * returns the magnitude in each band.
      */
-    void triangularFilterBank(blitz::Array<double,1>& data) const;
+    void triangularFilterBank(const blitz::Array<double,1>& data,
+      blitz::Array<double,1>& filters) const;
 
+    /**
+     * @brief Working arrays of a thread processing frames
+     */
+    struct FrameCache {
+      blitz::Array<double,1> frame_d;
+      blitz::Array<std::complex<double>,1> frame_c;
+      blitz::Array<double,2> filters; ///< output of the filters of n_rows frames
+    };
+
+    /**
+     * @brief Allocates one FrameCache per thread of the bob::core pool
+     */
+    void initFrameCaches(std::vector<FrameCache>& caches,
+      const size_t n_rows) const;
+
+    /**
+     * @brief Extracts the i-th frame of the input, and computes its power
+     * spectrum (in frame_d) and, if energy bands are computed, the output
+     * of the filters. If energy is not null, the log energy of the frame
+     * is computed as well. Only the given working arrays are modified.
+     */
+    void processFrame(const blitz::Array<double,1>& input, const size_t i,
+      blitz::Array<double,1>& frame_d,
+      blitz::Array<std::complex<double>,1>& frame_c,
+      blitz::Array<double,1>& filters, double* energy=0) const;
 
     virtual void initWinLength();
     virtual void initWinSize();
@@ -246,6 +279,14 @@ class Spectrogram: public Energy
     void initCacheHammingKernel();
     void initCacheFilterBank();
 
+    /**
+     * @brief Computes the spectrogram of the frames [begin, end) using the
+     * working arrays of the given thread
+     */
+    void processFrames(const blitz::Array<double,1>& input,
+      blitz::Array<double,2>& output, std::vector<FrameCache>& caches,
+      size_t begin, size_t end, size_t thread) const;
+
     /**
      * @brief Initialize the table m_p_index, which contains the indices of
      * the cut-off frequencies of the triangular filters.. It looks like:
@@ -280,10 +321,9 @@ class Spectrogram: public Energy
     blitz::Array<double,1> m_hamming_kernel;
     blitz::Array<int,1> m_p_index;
     std::vector<blitz::Array<double,1> > m_filter_bank;
-    bob::sp::FFT1D m_fft;
+    bob::sp::RFFT1D m_fft;
 
-    mutable blitz::Array<std::complex<double>,1> m_cache_frame_c1;
-    mutable blitz::Array<std::complex<double>,1> m_cache_frame_c2;
+    mutable blitz::Array<std::complex<double>,1> m_cache_frame_c;
     mutable blitz::Array<double,1> m_cache_filters;
 };
 
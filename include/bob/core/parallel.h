@@ -0,0 +1,166 @@
+/**
+ * @file bob/core/parallel.h
+ * @date Sat Oct 17 14:02:45 CEST 2026
+ * @author Laurent El Shafey <Laurent.El-Shafey@idiap.ch>
+ *
+ * @brief A persistent pool of worker threads with a work-stealing
+ * parallel-for, shared by the modules that parallelize loops.
+ *
+ * Copyright (C) 2011-2013 Idiap Research Institute, Martigny, Switzerland
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef BOB_CORE_PARALLEL_H
+#define BOB_CORE_PARALLEL_H
+
+#include <cstddef>
+#include <string>
+#include <boost/thread.hpp>
+#include <boost/function.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/scoped_array.hpp>
+
+namespace bob { namespace core {
+/**
+ * @ingroup CORE
+ * @{
+ */
+
+/**
+ * @brief A pool of persistent worker threads processing loops.
+ *
+ * The threads are created once and sleep in between calls, such that short
+ * loops issued many times do not pay for the creation of threads. The range
+ * of a loop is first split evenly among the threads, which then process
+ * their part in chunks of a given grain size. A thread that runs out of work
+ * steals the second half of the remaining range of another thread, so that
+ * unevenly expensive iterations are still balanced.
+ *
+ * The calling thread takes part in the computation as the thread of index
+ * 0. A loop issued while the pool is busy (e.g. from within the body of
+ * another loop) is processed serially by the calling thread.
+ */
+class ThreadPool: private boost::noncopyable {
+
+  public:
+
+    /**
+     * @brief The body of a loop is called as body(begin, end, thread_index)
+     * on consecutive sub-ranges [begin, end) of the loop. thread_index is
+     * smaller than getNThreads() and identifies the calling thread for the
+     * duration of the loop, such that it may be used to index per-thread
+     * accumulators.
+     */
+    typedef boost::function<void (size_t, size_t, size_t)> body_type;
+
+    /**
+     * @brief Creates a pool of n_threads threads, including the calling
+     * one. 0 means boost::thread::hardware_concurrency().
+     */
+    explicit ThreadPool(size_t n_threads=0);
+
+    /**
+     * @brief Stops and joins the worker threads.
+     */
+    ~ThreadPool();
+
+    /**
+     * @brief Number of threads processing a loop (including the calling
+     * thread)
+     */
+    size_t getNThreads() const { return m_n_threads; }
+
+    /**
+     * @brief Processes the range [begin, end) and returns once it has been
+     * entirely processed.
+     *
+     * @param grain The number of iterations processed at once by a thread.
+     * 0 picks a grain giving each thread about 8 chunks.
+     * @param max_threads If non zero, at most this number of threads work
+     * on the loop.
+     *
+     * @warning If the body throws, the remaining chunks are skipped and the
+     * message of the first exception is rethrown as a std::runtime_error.
+     *
+     * @warning The reference counting of blitz++ arrays is not thread-safe.
+     * The body must not create views (slices, transposes, copies by
+     * reference) of arrays that other threads may access at the same time.
+     * Such arrays should be accessed by element, through their data
+     * pointer, or through bob::math::prod(), which does not create views.
+     * Views of arrays used by a single thread (e.g. per-thread workspaces
+     * indexed by thread_index) are safe.
+     */
+    void parallelFor(size_t begin, size_t end, const body_type& body,
+      size_t grain=0, size_t max_threads=0);
+
+  private:
+
+    /**
+     * @brief The part of the range that is left to the i-th thread
+     */
+    struct Slot {
+      boost::mutex mutex;
+      size_t begin;
+      size_t end;
+      char pad[64]; ///< keeps the slots on different cache lines
+    };
+
+    void worker(const size_t index);
+    void execute(const size_t index);
+    bool next(const size_t index, size_t& begin, size_t& end);
+    void cancel();
+
+    size_t m_n_threads;
+    boost::scoped_array<Slot> m_slots;
+    boost::thread_group m_threads;
+    boost::mutex m_run_mutex; ///< serializes the loops
+    boost::mutex m_mutex; ///< protects the attributes below
+    boost::condition_variable m_start;
+    boost::condition_variable m_done;
+    const body_type* m_body;
+    size_t m_grain;
+    size_t m_n_participants;
+    size_t m_n_active;
+    size_t m_generation;
+    bool m_stop;
+    std::string m_error;
+};
+
+/**
+ * @brief Returns the number of threads of the process-wide pool. It is
+ * given by the BOB_NUM_THREADS environment variable if set, by
+ * boost::thread::hardware_concurrency() otherwise.
+ */
+size_t getNThreads();
+
+/**
+ * @brief Recreates the process-wide pool with the given number of threads
+ * (0 means boost::thread::hardware_concurrency()).
+ * @warning This must not be called while the pool processes a loop.
+ */
+void setNThreads(const size_t n_threads);
+
+/**
+ * @brief Processes the range [begin, end) with the process-wide pool. See
+ * ThreadPool::parallelFor().
+ */
+void parallelFor(size_t begin, size_t end,
+  const ThreadPool::body_type& body, size_t grain=0, size_t max_threads=0);
+
+/**
+ * @}
+ */
+}}
+
+#endif /* BOB_CORE_PARALLEL_H */
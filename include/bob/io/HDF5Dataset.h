@@ -40,6 +40,18 @@ namespace bob { namespace io { namespace detail { namespace hdf5 {
   class File;
   class Group;
 
+  /**
+   * The target size in bytes of the chunks of datasets created to hold
+   * blocks of samples (see Dataset::addArrays()).
+   */
+  const size_t DEFAULT_CHUNK_SIZE = 1048576;
+
+  /**
+   * Returns the type of a single sample of a block of samples stored
+   * contiguously along the first dimension of the given type.
+   */
+  bob::io::HDF5Type sample_type(const bob::io::HDF5Type& block);
+
   /**
    * An HDF5 C-style dataset that knows how to close itself.
    */
@@ -74,10 +86,15 @@ namespace bob { namespace io { namespace detail { namespace hdf5 {
        * chunking automatically enabled (the chunk size is set to the size of
        * the given variable) and an extra dimension is inserted to accommodate
        * list operations.
+       *
+       * If chunk_size is not zero, each chunk of a list holds as many samples
+       * as fit in chunk_size bytes (at least one), instead of a single one.
+       * This does not change the shape of the dataset, but makes the reading
+       * and writing of blocks of samples much faster.
        */
       Dataset(boost::shared_ptr<Group> parent, const std::string& name,
           const bob::io::HDF5Type& type, bool list=true,
-          size_t compression=0);
+          size_t compression=0, size_t chunk_size=0);
 
     public: //api
 
@@ -259,6 +276,28 @@ namespace bob { namespace io { namespace detail { namespace hdf5 {
           return readArray<T,N>(0);
         }
 
+      /**
+       * Reads a block of consecutive arrays from the file, starting at the
+       * given index. The first dimension of the given array indexes the
+       * samples, and the remaining ones have to be compatible with the shape
+       * of a single sample, as for readArray(index, value). All samples are
+       * read in a single HDF5 operation.
+       *
+       * @param index Position of the first array to read in the current
+       * dataset
+       * @param value The output array with value.extent(0) samples. This
+       * variable has to be a zero-based C-style contiguous storage array. If
+       * that is not the case, we will raise an exception.
+       */
+      template <typename T, int N>
+        void readArrays(size_t index, blitz::Array<T,N>& value) {
+          bob::core::array::assertCZeroBaseContiguous(value);
+          if (!value.extent(0)) return;
+          bob::io::HDF5Type dest_type(value);
+          read_buffer(index, value.extent(0), sample_type(dest_type),
+              reinterpret_cast<void*>(value.data()));
+        }
+
       /**
        * DATA WRITING FUNCTIONALITY
        */
@@ -377,17 +416,61 @@ namespace bob { namespace io { namespace detail { namespace hdf5 {
           }
       }
 
+      /**
+       * Appends a block of arrays to the dataset, in a single HDF5 operation.
+       * The first dimension of the given array indexes the samples, which are
+       * stored exactly as if they were appended one by one using addArray():
+       * they may be read back with readArray() and the dataset may be
+       * extended with addArray() afterwards.
+       */
+      template <typename T, int N>
+        void addArrays(const blitz::Array<T,N>& value) {
+          if (!value.extent(0)) return;
+          bob::io::HDF5Type dest_type(sample_type(bob::io::HDF5Type(value)));
+          if(!bob::core::array::isCZeroBaseContiguous(value)) {
+            blitz::Array<T,N> tmp = bob::core::array::ccopy(value);
+            extend_buffer(value.extent(0), dest_type,
+                reinterpret_cast<const void*>(tmp.data()));
+          }
+          else {
+            extend_buffer(value.extent(0), dest_type,
+                reinterpret_cast<const void*>(value.data()));
+          }
+        }
+
+      /**
+       * Sets the size of the chunk cache of this dataset, which keeps the
+       * most recently accessed chunks in memory. This is only useful for
+       * chunked datasets (lists or compressed datasets). The dataset is
+       * re-opened with the new settings.
+       *
+       * @param nbytes The total size of the cache, in bytes. This should be
+       * large enough to hold all the chunks touched by a single read or write
+       * operation.
+       * @param nslots The number of slots of the hash table of the cache. If
+       * you set it, it should be a prime number about 100 times larger than
+       * the number of chunks fitting in the cache. By default, the value of
+       * the file is kept.
+       * @param w0 The preemption policy of the cache, between 0 and 1. 1
+       * evicts first the chunks that have been entirely read or written.
+       */
+      void set_chunk_cache(size_t nbytes,
+          size_t nslots=H5D_CHUNK_CACHE_NSLOTS_DEFAULT,
+          double w0=H5D_CHUNK_CACHE_W0_DEFAULT);
+
     private: //apis
 
       /**
        * Selects a bit of the file to be affected at the next read or write
        * operation. This method encapsulate calls to H5Sselect_hyperslab().
+       * count consecutive samples of the destination type are selected,
+       * starting at the given index.
        *
-       * The index is checked for existence as well as the consistence of the
-       * destination type.
+       * The indexes are checked for existence as well as the consistence of
+       * the destination type.
        */
       std::vector<bob::io::HDF5Descriptor>::iterator select (size_t index,
-          const bob::io::HDF5Type& dest);
+          size_t count, const bob::io::HDF5Type& dest);
 
     public: //direct access for other bindings -- don't use these!
 
@@ -408,6 +491,26 @@ namespace bob { namespace io { namespace detail { namespace hdf5 {
        */
       void extend_buffer (const bob::io::HDF5Type& dest, const void* buffer);
 
+      /**
+       * Reads count consecutive variables, starting at the given index, into
+       * the given (user) buffer.
+       */
+      void read_buffer (size_t index, size_t count,
+          const bob::io::HDF5Type& dest, void* buffer);
+
+      /**
+       * Writes count consecutive variables, starting at the given index, from
+       * the given buffer.
+       */
+      void write_buffer (size_t index, size_t count,
+          const bob::io::HDF5Type& dest, const void* buffer);
+
+      /**
+       * Extend the dataset with count extra variables.
+       */
+      void extend_buffer (size_t count, const bob::io::HDF5Type& dest,
+          const void* buffer);
+
     public: //attribute support
 
       /**
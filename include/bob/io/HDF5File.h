@@ -242,6 +242,18 @@ namespace bob { namespace io {
           return readArray<T,N>(path, 0);
       }
 
+      /**
+       * Reads a block of consecutive arrays from the file, starting at
+       * position pos, in a single operation. The first dimension of the given
+       * array indexes the samples. Raises an exception if the type is
+       * incompatible or if there are not enough arrays in the dataset.
+       * Relative paths are accepted.
+       */
+      template <typename T, int N> void readArrays(const std::string& path,
+          size_t pos, blitz::Array<T,N>& value) {
+        (*m_cwd)[path]->readArrays(pos, value);
+      }
+
       /**
        * Modifies the value of a scalar inside the file. Relative paths are
        * accepted.
@@ -326,6 +338,39 @@ namespace bob { namespace io {
         (*m_cwd)[path]->addArray(value);
       }
 
+      /**
+       * Appends a block of arrays to a dataset in a single operation. The
+       * first dimension of the given array indexes the samples, which are
+       * stored as if they were appended one by one with appendArray(). If the
+       * dataset does not yet exist, one is created with the type
+       * characteristics of a single sample, and chunks holding as many
+       * samples as fit in chunk_size bytes. The compression and chunk_size
+       * settings have no effect if the Dataset already exists on file.
+       * Relative paths are accepted.
+       */
+      template <typename T, int N> void appendArrays(const std::string& path,
+          const blitz::Array<T,N>& value, size_t compression=0,
+          size_t chunk_size=bob::io::detail::hdf5::DEFAULT_CHUNK_SIZE) {
+        if (!m_file->writeable()) {
+          boost::format m("cannot append arrays to dataset '%s' at path '%s' of file '%s' because it is not writeable");
+          m % path % m_cwd->path() % m_file->filename();
+          throw std::runtime_error(m.str());
+        }
+        if (!contains(path)) m_cwd->create_dataset(path,
+            bob::io::detail::hdf5::sample_type(bob::io::HDF5Type(value)),
+            true, compression, chunk_size);
+        (*m_cwd)[path]->addArrays(value);
+      }
+
+      /**
+       * Sets the size of the chunk cache of an existing dataset. See
+       * bob::io::detail::hdf5::Dataset::set_chunk_cache(). The setting is
+       * lost if the file is closed, or re-read after a rename().
+       */
+      void setChunkCache(const std::string& path, size_t nbytes,
+          size_t nslots=H5D_CHUNK_CACHE_NSLOTS_DEFAULT,
+          double w0=H5D_CHUNK_CACHE_W0_DEFAULT);
+
       /**
        * Sets the scalar at position 0 to the given value. This method is
        * equivalent to checking if the scalar at position 0 exists and then
@@ -370,7 +415,7 @@ namespace bob { namespace io {
        * existing data is compatible with the required type.
        */
       void create (const std::string& path, const HDF5Type& dest, bool list,
-          size_t compression);
+          size_t compression, size_t chunk_size=0);
 
       /**
        * Reads data from the file into a buffer. The given buffer contains
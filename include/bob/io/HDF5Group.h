@@ -203,11 +203,12 @@ namespace bob { namespace io { namespace detail { namespace hdf5 {
        * When you set "list" to true (the default), datasets are created with
        * chunking automatically enabled (the chunk size is set to the size of
        * the given variable) and an extra dimension is inserted to accomodate
-       * list operations.
+       * list operations. If chunk_size is not zero, chunks hold as many
+       * variables as fit in chunk_size bytes instead.
        */
       virtual boost::shared_ptr<Dataset> create_dataset
         (const std::string& path, const bob::io::HDF5Type& type, bool list=true,
-         size_t compression=0);
+         size_t compression=0, size_t chunk_size=0);
 
       /**
        * Deletes a dataset in this group
@@ -26,7 +26,6 @@
 #include <bob/sp/DCT2D.h>
 #include <bob/ip/block.h>
 #include <bob/ip/zigzag.h>
-#include <list>
 #include <limits>
 
 namespace bob {
@@ -226,7 +225,14 @@ class DCTFeatures
     double m_norm_epsilon;
 
     void setCheckSqrtNDctCoefs();
-    void normalizeBlock(const blitz::Array<double,2>& src) const;
+    /**
+      * @brief Computes the DCT of the block with top-left corner (y,x) of
+      *   the given image into m_cache_block2, after normalizing the block
+      *   if required. The block is read in place, without extracting all
+      *   the blocks of the image beforehand.
+      */
+    void blockDCT(const blitz::Array<double,2>& src, const int y,
+      const int x) const;
     void extractRowDCTCoefs(blitz::Array<double,1>& coefs) const;
 
     /**
@@ -73,6 +73,8 @@ namespace bob {
       private:
         // the Gabor wavelet, stored as pairs of indices and values
         std::vector<std::pair<blitz::TinyVector<unsigned,2>, double> > m_kernel_pixel;
+        // the same pixels, stored as offsets in C-contiguous images
+        std::vector<unsigned> m_kernel_offsets;
 
         unsigned m_x_resolution, m_y_resolution;
 
@@ -82,7 +84,10 @@ namespace bob {
     //! \brief The GaborWaveletTransform class computes a Gabor wavelet transform of the given image.
     //! It computes either the complete Gabor wavelet transformed image (short: trafo image) with
     //! number_of_scales * number_of_orientations layers, or a Gabor jet image that includes
-    //! one Gabor jet (with one vector of absolute values and one vector of phases) for each pixel
+    //! one Gabor jet (with one vector of absolute values and one vector of phases) for each pixel.
+    //! The layers are computed by several threads (see bob::core::setNThreads()).
+    //! Alternatively, the Gabor jets can be computed at a few positions only (e.g. the nodes of a Gabor graph),
+    //! by convolving the image with the Gabor wavelets in spatial domain.
     class GaborWaveletTransform {
 
       public:
@@ -156,6 +161,24 @@ namespace bob {
           bool do_normalize = true
         );
 
+        //! \brief computes the Gabor jets (absolute values and phases) at the given positions (one (y,x) pair per row) only.
+        //! The jets are obtained by a direct convolution with the Gabor wavelets in spatial domain,
+        //! which is faster than computing the whole jet image when only a few positions are required.
+        void computeJets(
+          const blitz::Array<std::complex<double>,2>& gray_image,
+          const blitz::Array<int,2>& positions,
+          blitz::Array<double,3>& jets,
+          bool do_normalize = true
+        );
+
+        //! \brief computes the Gabor jets (absolute values only) at the given positions (one (y,x) pair per row) only.
+        void computeJets(
+          const blitz::Array<std::complex<double>,2>& gray_image,
+          const blitz::Array<int,2>& positions,
+          blitz::Array<double,2>& jets,
+          bool do_normalize = true
+        );
+
         //! \brief saves the parameters of this Gabor wavelet family to file
         void save(bob::io::HDF5File& file) const;
 
@@ -166,6 +189,20 @@ namespace bob {
 
         void computeKernelFrequencies();
 
+        // allocates one temporary frequency image per thread
+        void allocateTemporaries();
+        // generates the Gabor wavelets in spatial domain for the given resolution
+        void generateSpatialKernels(blitz::TinyVector<unsigned,2> resolution);
+
+        // computes the layers [begin,end[ of the trafo image (parallel body)
+        void computeLayers(std::complex<double>* trafo_image, size_t begin, size_t end, size_t thread);
+        // computes the absolute values and phases of the layers [begin,end[ of the jet image (parallel body)
+        void computeJetLayers(double* abs_image, double* phase_image, const blitz::TinyVector<int,3>& strides, size_t begin, size_t end, size_t thread);
+        // computes the Gabor jets at the given positions, into jets of the given strides (see computeSpatialJets)
+        void computeJets(const blitz::Array<std::complex<double>,2>& gray_image, const blitz::Array<int,2>& positions, double* jets, const blitz::TinyVector<int,3>& strides, bool do_normalize);
+        // computes the Gabor jets at the positions [begin,end[ in spatial domain (parallel body)
+        void computeSpatialJets(const blitz::Array<std::complex<double>,2>& gray_image, const blitz::Array<int,2>& positions, double* jets, const blitz::TinyVector<int,3>& strides, size_t begin, size_t end, size_t thread) const;
+
         double m_sigma;
         double m_pow_of_k;
         double m_k_max;
@@ -178,7 +215,13 @@ namespace bob {
         bob::sp::FFT2D m_fft;
         bob::sp::IFFT2D m_ifft;
 
-        blitz::Array<std::complex<double>,2> m_temp_array, m_frequency_image;
+        blitz::Array<std::complex<double>,2> m_frequency_image;
+        // one temporary image per thread
+        std::vector<blitz::Array<std::complex<double>,2> > m_temp_arrays;
+
+        // the Gabor wavelets in spatial domain, stored as pairs of (circular) indices and values
+        std::vector<std::vector<std::pair<blitz::TinyVector<int,2>, std::complex<double> > > > m_spatial_kernels;
+        blitz::TinyVector<int,2> m_spatial_resolution;
 
         //! The number of scales (levels, frequencies) of this family
         unsigned m_number_of_scales;
@@ -29,6 +29,9 @@
 
 #include <math.h>
 #include <stdint.h>
+#include <cmath>
+#include <cstdlib>
+#include <algorithm>
 #include <numeric>
 #include <stdexcept>
 #include <boost/format.hpp>
@@ -43,6 +46,30 @@
 
 namespace bob { namespace ip {
 
+  namespace detail {
+    /**
+     * Compares a neighbor to the center pixel as the generic LBP code
+     * extraction does, i.e., (a > b || bob::core::isClose(a, b)) in double
+     * precision, without branches.
+     */
+    template <typename T>
+    inline bool lbpGreaterEqual(const T a, const T b){
+      const double da = static_cast<double>(a), db = static_cast<double>(b);
+      return (da > db) | (std::fabs(da - db) <= (1e-8 + 1e-5 * std::min(std::fabs(da), std::fabs(db))));
+    }
+
+    // two distinct 8 or 16 bit integers are never close
+    template <>
+    inline bool lbpGreaterEqual<uint8_t>(const uint8_t a, const uint8_t b){
+      return a >= b;
+    }
+
+    template <>
+    inline bool lbpGreaterEqual<uint16_t>(const uint16_t a, const uint16_t b){
+      return a >= b;
+    }
+  }
+
   /**
    * Different ways to extract LBP codes: regular, transitional or direction coded (see Cosmin's thesis)
    */
@@ -70,6 +97,9 @@ namespace bob { namespace ip {
    *   "Multivariate Boosting with Look-Up Tables for Face Processing"
    *   http://publications.idiap.ch/index.php/publications/show/2315
    *
+   *   The extraction does not modify the LBP object, so that a single
+   *   object can be shared between threads.
+   *
    */
   class LBP {
 
@@ -313,6 +343,23 @@ namespace bob { namespace ip {
       template <typename T>
         uint16_t lbp_code(const blitz::Array<T,2>& src, int y, int x) const;
 
+      /**
+       * Computes the rectangular LBP codes with P neighbors of the target
+       * pixels [y_begin, y_end) x [x_begin, x_end), for which all neighbors
+       * lie inside the source image.
+       * The codes of a whole row are computed at once, without branches.
+       */
+      template <typename T, int P>
+        void applyRectangular(const blitz::Array<T,2>& src, blitz::Array<uint16_t,2>& dst, const blitz::TinyVector<int,2>& offset, const int y_begin, const int y_end, const int x_begin, const int x_end) const;
+
+      /**
+       * Computes the multi-block LBP codes with P neighbors of all target
+       * pixels from the given integral image, one row at a time, without
+       * branches.
+       */
+      template <typename T, int P>
+        void applyMultiBlock(const blitz::Array<T,2>& src, blitz::Array<uint16_t,2>& dst, const blitz::TinyVector<int,2>& offset) const;
+
 
       /**
        * Attributes
@@ -336,12 +383,6 @@ namespace bob { namespace ip {
       // the positions of the points that have to be processed
       blitz::Array<double, 2> m_positions;
       blitz::Array<int, 2> m_int_positions;
-
-      // a pre-allocated copy of the integral image, just for speed purposes
-      mutable blitz::Array<double, 2> _integral_image;
-
-      // a pre-allocated vector to store the pixels for extracting LBP codes
-      mutable std::vector<double> _pixels;
   };
 
   ///////////////////////////////////////////////////
@@ -369,9 +410,9 @@ namespace bob { namespace ip {
     {
       if (!is_integral_image && m_mb_y > 0 && m_mb_x > 0){
         // apply integral image
-        _integral_image.resize(src.extent(0)+1, src.extent(1)+1);
-        bob::ip::integral(src, _integral_image, true);
-        apply<double>(_integral_image, dst);
+        blitz::Array<double,2> integral_image(src.extent(0)+1, src.extent(1)+1);
+        bob::ip::integral(src, integral_image, true);
+        apply<double>(integral_image, dst);
       } else {
         apply<T>(src, dst);
       }
@@ -383,10 +424,107 @@ namespace bob { namespace ip {
       // offset in the source image
       const blitz::TinyVector<int,2> offset = getOffset();
 
-      // iterate over target pixels
-      for (int y = 0; y < dst.extent(0); ++y)
-        for (int x = 0; x < dst.extent(1); ++x)
-          dst(y, x) = lbp_code(src, y + offset[0], x + offset[1]);
+      // the region of the target image that is computed by the specialized
+      // kernels; by default, the whole image is computed by lbp_code
+      int y_begin = 0, y_end = 0, x_begin = 0, x_end = 0;
+
+      if (m_eLBP_type == ELBP_REGULAR && !m_to_average && !m_add_average_bit && !m_circular){
+        // here, m_P is either 4 or 8 (see init())
+        if (m_mb_y > 0 && m_mb_x > 0){
+          // only shrinking border handling is supported for multi-block LBP
+          if (m_P == 8) applyMultiBlock<T,8>(src, dst, offset);
+          else applyMultiBlock<T,4>(src, dst, offset);
+          return;
+        }
+        // rectangular LBP: the target pixels whose neighbors do not wrap
+        // around the source image
+        int r_y = 0, r_x = 0;
+        for (int p = 0; p < m_P; ++p){
+          r_y = std::max(r_y, std::abs(m_int_positions(p,0)));
+          r_x = std::max(r_x, std::abs(m_int_positions(p,1)));
+        }
+        y_begin = std::min(std::max(0, r_y - offset[0]), dst.extent(0));
+        y_end = std::max(y_begin, std::min(dst.extent(0), src.extent(0) - r_y - offset[0]));
+        x_begin = std::min(std::max(0, r_x - offset[1]), dst.extent(1));
+        x_end = std::max(x_begin, std::min(dst.extent(1), src.extent(1) - r_x - offset[1]));
+        if (m_P == 8) applyRectangular<T,8>(src, dst, offset, y_begin, y_end, x_begin, x_end);
+        else applyRectangular<T,4>(src, dst, offset, y_begin, y_end, x_begin, x_end);
+      }
+
+      // iterate over the remaining target pixels
+      for (int y = 0; y < dst.extent(0); ++y){
+        if (y >= y_begin && y < y_end){
+          for (int x = 0; x < x_begin; ++x)
+            dst(y, x) = lbp_code(src, y + offset[0], x + offset[1]);
+          for (int x = x_end; x < dst.extent(1); ++x)
+            dst(y, x) = lbp_code(src, y + offset[0], x + offset[1]);
+        } else {
+          for (int x = 0; x < dst.extent(1); ++x)
+            dst(y, x) = lbp_code(src, y + offset[0], x + offset[1]);
+        }
+      }
+    }
+
+  template <typename T, int P>
+    inline void LBP::applyRectangular(const blitz::Array<T,2>& src, blitz::Array<uint16_t,2>& dst, const blitz::TinyVector<int,2>& offset, const int y_begin, const int y_end, const int x_begin, const int x_end) const
+    {
+      // the neighbors, relative to the center pixel in memory
+      const int s0 = src.stride(0), s1 = src.stride(1), d1 = dst.stride(1);
+      int neighbors[P];
+      for (int p = 0; p < P; ++p)
+        neighbors[p] = m_int_positions(p,0) * s0 + m_int_positions(p,1) * s1;
+
+      const int n = x_end - x_begin;
+      for (int y = y_begin; y < y_end; ++y){
+        const T* center = src.dataZero() + (y + offset[0]) * s0 + (x_begin + offset[1]) * s1;
+        uint16_t* codes = dst.dataZero() + y * dst.stride(0) + x_begin * d1;
+        // compute the raw codes of the row
+        for (int x = 0; x < n; ++x){
+          const T* c = center + x * s1;
+          uint16_t code = 0;
+          for (int p = 0; p < P; ++p)
+            code |= static_cast<uint16_t>(detail::lbpGreaterEqual<T>(c[neighbors[p]], *c)) << (P - p - 1);
+          codes[x * d1] = code;
+        }
+        // convert them according to the requested setup
+        for (int x = 0; x < n; ++x)
+          codes[x * d1] = m_lut(codes[x * d1]);
+      }
+    }
+
+  template <typename T, int P>
+    inline void LBP::applyMultiBlock(const blitz::Array<T,2>& src, blitz::Array<uint16_t,2>& dst, const blitz::TinyVector<int,2>& offset) const
+    {
+      // the corners of the P neighboring blocks and of the central block,
+      // relative to the current pixel of the integral image in memory
+      const int s0 = src.stride(0), s1 = src.stride(1), d1 = dst.stride(1);
+      int top_left[P+1], bottom_right[P+1], top_right[P+1], bottom_left[P+1];
+      for (int p = 0; p <= P; ++p){
+        top_left[p] = m_int_positions(p,0) * s0 + m_int_positions(p,2) * s1;
+        bottom_right[p] = m_int_positions(p,1) * s0 + m_int_positions(p,3) * s1;
+        top_right[p] = m_int_positions(p,0) * s0 + m_int_positions(p,3) * s1;
+        bottom_left[p] = m_int_positions(p,1) * s0 + m_int_positions(p,2) * s1;
+      }
+
+      const int n = dst.extent(1);
+      for (int y = 0; y < dst.extent(0); ++y){
+        const T* row = src.dataZero() + (y + offset[0]) * s0 + offset[1] * s1;
+        uint16_t* codes = dst.dataZero() + y * dst.stride(0);
+        // compute the raw codes of the row, summing up the blocks in the same order as lbp_code
+        for (int x = 0; x < n; ++x){
+          const T* c = row + x * s1;
+          const double center = static_cast<double>(c[top_left[P]]) + static_cast<double>(c[bottom_right[P]]) - static_cast<double>(c[top_right[P]]) - static_cast<double>(c[bottom_left[P]]);
+          uint16_t code = 0;
+          for (int p = 0; p < P; ++p){
+            const double block = static_cast<double>(c[top_left[p]]) + static_cast<double>(c[bottom_right[p]]) - static_cast<double>(c[top_right[p]]) - static_cast<double>(c[bottom_left[p]]);
+            code |= static_cast<uint16_t>(detail::lbpGreaterEqual<double>(block, center)) << (P - p - 1);
+          }
+          codes[x * d1] = code;
+        }
+        // convert them according to the requested setup
+        for (int x = 0; x < n; ++x)
+          codes[x * d1] = m_lut(codes[x * d1]);
+      }
     }
 
   template <typename T>
@@ -414,12 +552,18 @@ namespace bob { namespace ip {
   template <typename T>
   inline uint16_t LBP::extract_(const blitz::Array<T,2>& src, int y, int x, bool is_integral_image) const{
     if (!is_integral_image && m_mb_y > 0 && m_mb_x > 0){
-      // apply integral image
-      _integral_image.resize(src.extent(0)+1, src.extent(1)+1);
+      // the code only depends on the top-left part of the integral image,
+      // up to the bottom-right corner of the blocks
+      int bottom = 0, right = 0;
+      for (int p = 0; p <= m_P; ++p){
+        bottom = std::max(bottom, y + m_int_positions(p,1));
+        right = std::max(right, x + m_int_positions(p,3));
+      }
+      blitz::Array<double,2> integral_image(bottom+1, right+1);
       // compute integral image; adds one line of zeros in the front
-      bob::ip::integral(src, _integral_image, true);
+      bob::ip::integral(src(blitz::Range(0, bottom-1), blitz::Range(0, right-1)), integral_image, true);
       // return LBP code from integral image
-      return lbp_code<double>(_integral_image, y, x);
+      return lbp_code<double>(integral_image, y, x);
     } else {
       // return LBP code from source image
       return lbp_code<T>(src, y, x);
@@ -430,6 +574,8 @@ namespace bob { namespace ip {
   // implementation of the LBP code extraction
   template <typename T>
   inline uint16_t LBP::lbp_code(const blitz::Array<T,2>& src, int y, int x) const{
+    // the pixels used to compute the LBP code (at most 16, see init())
+    double pixels[16];
     double center;
     if (m_mb_y > 0 && m_mb_x > 0){
       // extract the pixels from the INTEGRAL image
@@ -439,7 +585,7 @@ namespace bob { namespace ip {
                   y1 = y + m_int_positions(p,1),
                   x0 = x + m_int_positions(p,2),
                   x1 = x + m_int_positions(p,3);
-        _pixels[p] = static_cast<double>(src(y0, x0)) + static_cast<double>(src(y1, x1)) - static_cast<double>(src(y0, x1)) - static_cast<double>(src(y1, x0));
+        pixels[p] = static_cast<double>(src(y0, x0)) + static_cast<double>(src(y1, x1)) - static_cast<double>(src(y0, x1)) - static_cast<double>(src(y1, x0));
       }
       const int y0 = y + m_int_positions(m_P,0),
                 y1 = y + m_int_positions(m_P,1),
@@ -449,14 +595,14 @@ namespace bob { namespace ip {
     }else if (m_circular){
       // extract the pixels from the image by interpolating the image
       for (int p = 0; p < m_P; ++p)
-        _pixels[p] = bob::sp::detail::bilinearInterpolationWrapNoCheck(src, y + m_positions(p,0), x + m_positions(p,1));
+        pixels[p] = bob::sp::detail::bilinearInterpolationWrapNoCheck(src, y + m_positions(p,0), x + m_positions(p,1));
       center = static_cast<double>(src(y, x));
     }else{
       // extract the pixels from the image by wrapping around (also works for shrinking since these positions will never be used)
       for (int p = 0; p < m_P; ++p){
         const int cy = (y + m_int_positions(p,0) + src.extent(0)) % src.extent(0);
         const int cx = (x + m_int_positions(p,1) + src.extent(1)) % src.extent(1);
-        _pixels[p] = static_cast<double>(src(cy, cx));
+        pixels[p] = static_cast<double>(src(cy, cx));
       }
       center = static_cast<double>(src(y, x));
     }
@@ -464,14 +610,14 @@ namespace bob { namespace ip {
 
     double cmp_point = center;
     if (m_to_average)
-      cmp_point = std::accumulate(_pixels.begin(), _pixels.end(), center) / (m_P + 1); // /(P+1) since (averaged over P+1 points)
+      cmp_point = std::accumulate(pixels, pixels + m_P, center) / (m_P + 1); // /(P+1) since (averaged over P+1 points)
 
     // the formulas are implemented from Cosmin's thesis
     uint16_t lbp_code = 0;
     switch (m_eLBP_type){
       case ELBP_REGULAR:{
         for (int p = 0; p < m_P; ++p){
-          lbp_code |= (_pixels[p] > cmp_point || bob::core::isClose(_pixels[p], cmp_point)) << (m_P - p - 1);
+          lbp_code |= (pixels[p] > cmp_point || bob::core::isClose(pixels[p], cmp_point)) << (m_P - p - 1);
         }
         if (m_add_average_bit && !m_rotation_invariant && !m_uniform)
         {
@@ -483,7 +629,7 @@ namespace bob { namespace ip {
 
       case ELBP_TRANSITIONAL:{
         for (int p = 0; p < m_P; ++p){
-          lbp_code |= (_pixels[p] > _pixels[(p+1)%m_P] || bob::core::isClose(_pixels[p], _pixels[(p+1)%m_P])) << (m_P - p - 1);
+          lbp_code |= (pixels[p] > pixels[(p+1)%m_P] || bob::core::isClose(pixels[p], pixels[(p+1)%m_P])) << (m_P - p - 1);
         }
         break;
       }
@@ -492,8 +638,8 @@ namespace bob { namespace ip {
         int p_half = m_P/2;
         for (int p = 0; p < p_half; ++p){
           lbp_code <<= 2;
-          if ((_pixels[p] - cmp_point) * (_pixels[p+p_half] - cmp_point) >= 0.) lbp_code += 1;
-          double p1 = std::abs(_pixels[p] - cmp_point), p2 = std::abs(_pixels[p+p_half] - cmp_point);
+          if ((pixels[p] - cmp_point) * (pixels[p+p_half] - cmp_point) >= 0.) lbp_code += 1;
+          double p1 = std::abs(pixels[p] - cmp_point), p2 = std::abs(pixels[p+p_half] - cmp_point);
           if ( p1 > p2 || bob::core::isClose(p1, p2) ) lbp_code += 2;
         }
         break;
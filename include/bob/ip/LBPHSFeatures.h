@@ -28,7 +28,6 @@
 #include "bob/ip/block.h"
 #include "bob/ip/histo.h"
 #include "bob/ip/LBP.h"
-#include <list>
 
 namespace bob {
 /**
@@ -86,6 +85,16 @@ namespace bob {
       template <typename T, typename U>
       void operator()(const blitz::Array<T,2>& src, U& dst);
 
+      /**
+        * @brief Process a 2D blitz Array/Image by extracting LBPHS features.
+        * @param src The 2D input blitz array
+        * @param dst The 2D output array, with one LBP histogram per row, in
+        *   the order of the block decomposition. Its expected shape is
+        *   (getNBlocks(src), getNBins()).
+        */
+      template <typename T>
+      void operator()(const blitz::Array<T,2>& src, blitz::Array<uint64_t,2>& dst);
+
       /**
         * @brief Function which returns the number of blocks when applying
         *   the LBPHSFeatures extractor on a 2D blitz::array/image.
@@ -118,28 +127,65 @@ namespace bob {
   void LBPHSFeatures::operator()(const blitz::Array<T,2>& src,
     U& dst)
   {
-    // cast to double
-    blitz::Array<double,2> double_version = bob::core::array::cast<double>(src);
+    blitz::Array<uint64_t,2> histograms(getNBlocks(src), getNBins());
+    operator()(src, histograms);
 
-    // get all the blocks
-    std::list<blitz::Array<double,2> > blocks;
-    blockReference(double_version, blocks, m_block_h, m_block_w, m_overlap_h, m_overlap_w);
+    // Push the histogram of each block in the container
+    for (int i = 0; i < histograms.extent(0); ++i)
+      dst.push_back(histograms(i, blitz::Range::all()));
+  }
 
-    // compute an lbp histogram for each block
-    for( std::list<blitz::Array<double,2> >::const_iterator it = blocks.begin();
-      it != blocks.end(); ++it)
+  template <typename T>
+  void LBPHSFeatures::operator()(const blitz::Array<T,2>& src,
+    blitz::Array<uint64_t,2>& dst)
+  {
+    const int n_blocks = getNBlocks(src);
+    const int n_bins = m_lbp.getMaxLabel();
+    bob::core::array::assertZeroBase(dst);
+    bob::core::array::assertSameShape(dst, blitz::TinyVector<int,2>(n_blocks, n_bins));
+
+    // Geometry of the block decomposition
+    const int size_ov_h = m_block_h - m_overlap_h;
+    const int size_ov_w = m_block_w - m_overlap_w;
+    const int n_blocks_w = (src.extent(1) - m_overlap_w) / size_ov_w;
+    const blitz::TinyVector<int,2> lbp_shape = m_lbp.getLBPShape(blitz::TinyVector<int,2>(m_block_h, m_block_w));
+    if (lbp_shape(0) == 0 || lbp_shape(1) == 0)
     {
-      // extract lbp using operator()
-      blitz::Array<uint16_t,2> lbp_tmp_block(m_lbp.getLBPShape(*it));
-      m_lbp(*it, lbp_tmp_block);
-
-      // Compute the LBP histogram
-      blitz::Array<uint64_t, 1> lbp_histo(m_lbp.getMaxLabel());
-      histogram<uint16_t>(lbp_tmp_block, lbp_histo, 0, m_lbp.getMaxLabel()-1,
-        m_lbp.getMaxLabel());
+      // the blocks are too small to contain any LBP code
+      dst = 0;
+      return;
+    }
 
-      // Push the resulting processed block in the container
-      dst.push_back(lbp_histo);
+    if (!m_lbp.getCircular() && m_lbp.getBlockSize()(0) <= 0 &&
+        m_lbp.getBorderHandling() == LBP_BORDER_SHRINK)
+    {
+      // The LBP codes of rectangular LBP operators only depend on the
+      // neighboring pixels: the codes of each block are the ones of the
+      // whole image, which are computed once.
+      blitz::Array<uint16_t,2> lbp_image(m_lbp.getLBPShape(src));
+      m_lbp(src, lbp_image);
+      for (int b = 0; b < n_blocks; ++b)
+      {
+        const int y = (b / n_blocks_w) * size_ov_h, x = (b % n_blocks_w) * size_ov_w;
+        const blitz::Array<uint16_t,2> lbp_block = lbp_image(
+          blitz::Range(y, y+lbp_shape(0)-1), blitz::Range(x, x+lbp_shape(1)-1));
+        blitz::Array<uint64_t,1> lbp_histo = dst(b, blitz::Range::all());
+        histogram<uint16_t>(lbp_block, lbp_histo, 0, n_bins-1, n_bins);
+      }
+    }
+    else
+    {
+      // compute an lbp histogram for each block, read in place
+      blitz::Array<uint16_t,2> lbp_block(lbp_shape);
+      for (int b = 0; b < n_blocks; ++b)
+      {
+        const int y = (b / n_blocks_w) * size_ov_h, x = (b % n_blocks_w) * size_ov_w;
+        const blitz::Array<T,2> block = src(
+          blitz::Range(y, y+m_block_h-1), blitz::Range(x, x+m_block_w-1));
+        m_lbp(block, lbp_block);
+        blitz::Array<uint64_t,1> lbp_histo = dst(b, blitz::Range::all());
+        histogram<uint16_t>(lbp_block, lbp_histo, 0, n_bins-1, n_bins);
+      }
     }
   }
 
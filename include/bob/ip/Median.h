@@ -23,11 +23,12 @@
 #ifndef BOB_IP_MEDIAN_H
 #define BOB_IP_MEDIAN_H
 
-#include <stdexcept>
-#include <boost/shared_ptr.hpp>
-#include <list>
+#include <vector>
+#include <algorithm>
+#include <boost/cstdint.hpp>
 #include "bob/core/assert.h"
 #include "bob/core/cast.h"
+#include "bob/core/parallel.h"
 
 namespace bob {
 
@@ -39,46 +40,104 @@ namespace bob {
   namespace ip {
 
     namespace detail {
+      /**
+       * @brief Describes a strip of rows of the output of a median filter.
+       * The arrays are accessed through their data pointers and strides,
+       * such that strips may be processed concurrently.
+       */
       template <typename T>
-      struct Pixel {
-        int y;
-        int x;
-        T value;
-        Pixel(): y(0), x(0), value(0) {}
-        Pixel(int b, int a, T v): y(b), x(a), value(v) {}
+      struct MedianStrip {
+        const T* src;
+        int src_stride_y;
+        int src_stride_x;
+        T* dst;
+        int dst_stride_y;
+        int dst_stride_x;
+        int dst_width;
+        int radius_y;
+        int radius_x;
       };
 
+      /**
+       * @brief Median filter of the output rows [y_begin, y_end), using a
+       * sorted window of the values. The window is updated with binary
+       * searches when moving along a row, and its buffer is allocated once
+       * for the strip.
+       */
       template <typename T>
-      void listInsertPixel(const boost::shared_ptr<Pixel<T> > p,
-                           std::list<boost::shared_ptr<Pixel<T> > >& l)
+      void medianFilter(const MedianStrip<T>& s, const int y_begin,
+        const int y_end)
       {
-        typename std::list<boost::shared_ptr<Pixel<T> > >::iterator it=l.begin();
-        for( ; it!=l.end(); ++it)
-          if( p->value > (*it)->value) break;
-        l.insert(it, p);
-      }
+        const int h = 2*s.radius_y+1;
+        const int w = 2*s.radius_x+1;
+        const int median_pos = (h*w)/2;
+        std::vector<T> window;
+        window.reserve(h*w);
 
-      template <typename T>
-      T listGetValueAtPosition(const int pos,
-        const std::list<boost::shared_ptr<Pixel<T> > >& l)
-      {
-        typename std::list<boost::shared_ptr<Pixel<T> > >::const_iterator it=l.begin();
-        int c=0;
-        for( ; it!=l.end(); ++it, ++c)
-          if( c==pos) return (*it)->value;
-        throw std::runtime_error("reached the end of method w/o returning");
+        for (int y=y_begin; y<y_end; ++y)
+        {
+          const T* src_row = s.src + y*s.src_stride_y;
+          T* dst_row = s.dst + y*s.dst_stride_y;
+
+          // Initial window of the row
+          window.clear();
+          for (int j=0; j<h; ++j)
+            for (int i=0; i<w; ++i)
+              window.push_back(src_row[j*s.src_stride_y + i*s.src_stride_x]);
+          std::sort(window.begin(), window.end());
+
+          for (int x=0; x<s.dst_width; ++x)
+          {
+            dst_row[x*s.dst_stride_x] = window[median_pos];
+            if (x == s.dst_width-1) break;
+
+            // Replaces column x by column x+w
+            for (int j=0; j<h; ++j)
+            {
+              const T* p = src_row + j*s.src_stride_y + x*s.src_stride_x;
+              typename std::vector<T>::iterator it =
+                std::lower_bound(window.begin(), window.end(), p[0]);
+              if (it == window.end()) --it;
+              window.erase(it);
+              const T v = p[w*s.src_stride_x];
+              window.insert(std::upper_bound(window.begin(), window.end(), v), v);
+            }
+          }
+        }
       }
 
+      /**
+       * @brief Median filter of the output rows [y_begin, y_end) of an 8-bit
+       * image, in constant time per pixel with respect to the radius. One
+       * histogram is kept per column of the input and moved down along
+       * with the rows, while the kernel histogram is moved along a row by
+       * adding and removing whole column histograms (Perreault and Hebert,
+       * "Median Filtering in Constant Time", 2007).
+       */
+      void medianFilter(const MedianStrip<uint8_t>& s, const int y_begin,
+        const int y_end);
+
+      /**
+       * @brief Median filter of the output rows [y_begin, y_end) of a 16-bit
+       * image. The kernel histogram is moved along a row by removing and
+       * adding one column of pixels (Huang, 1979), and is split in coarse
+       * and fine levels such that finding the median only scans 2x256
+       * bins.
+       */
+      void medianFilter(const MedianStrip<uint16_t>& s, const int y_begin,
+        const int y_end);
+
+      /**
+       * @brief Binds a strip to the body of a parallel loop
+       */
       template <typename T>
-      void printList(const std::list<boost::shared_ptr<Pixel<T> > >& l)
-      {
-        typename std::list<boost::shared_ptr<Pixel<T> > >::const_iterator it=l.begin();
-        for( ; it!=l.end(); ++it)
-        {
-          std::cout << "(" << (*it)->y << "," << (*it)->x << "," << (*it)->value << ") - ";
+      struct MedianStripBody {
+        MedianStripBody(const MedianStrip<T>& strip): m_strip(strip) {}
+        void operator()(size_t begin, size_t end, size_t) const {
+          medianFilter(m_strip, (int)begin, (int)end);
         }
-        std::cout << std::endl;
-      }
+        MedianStrip<T> m_strip;
+      };
     }
 
     /**
@@ -92,10 +151,15 @@ namespace bob {
          * @brief Creates an object to filter images with a median filter
          * @param radius_y The radius of the kernel along the y-axis (height=2*radius_y+1)
          * @param radius_x The radius of the kernel along the x-axis (width=2*radius_x+1)
+         * @param n_threads The maximum number of threads processing strips
+         * of rows of an image (0 means all the threads of the bob::core
+         * thread pool)
          */
-        Median(const size_t radius_y=1, const size_t radius_x=1):
+        Median(const size_t radius_y=1, const size_t radius_x=1,
+            const size_t n_threads=0):
           m_radius_y(radius_y), m_radius_x(radius_x),
-          m_median_pos((2*radius_y+1)*(2*radius_x+1)/2)
+          m_median_pos((2*radius_y+1)*(2*radius_x+1)/2),
+          m_n_threads(n_threads)
         {
         }
 
@@ -113,6 +177,14 @@ namespace bob {
           m_median_pos = (2*(int)radius_y+1)*(2*(int)radius_x+1)/2;
         }
 
+        /**
+          * @brief Gets/Sets the maximum number of threads processing
+          * strips of rows of an image (0 means all the threads of the
+          * bob::core thread pool)
+          */
+        size_t getNThreads() const { return m_n_threads; }
+        void setNThreads(const size_t n_threads) { m_n_threads = n_threads; }
+
         /**
          * @brief Processes a 2D blitz Array/Image
          * @param src The 2D input blitz array
@@ -131,92 +203,15 @@ namespace bob {
 
 
       private:
-        /**
-          * @brief Initializes the ordered lists of values
-          */
-        void initLists(const blitz::Array<T,2>& src);
-        /**
-          * @brief Efficiently updates the ordered lists
-          */
-        void listRemoveAddColumn(const int j, const int i,
-                const blitz::Array<T,2>& src,
-                std::list<boost::shared_ptr<struct detail::Pixel<T> > >& l);
-        void listRemoveAddRow(const int j, const int i,
-                const blitz::Array<T,2>& src,
-                std::list<boost::shared_ptr<struct detail::Pixel<T> > >& l);
-
         /**
          * @brief Attributes
          */
         int m_radius_y;
         int m_radius_x;
         int m_median_pos;
-
-        std::list<boost::shared_ptr<struct detail::Pixel<T> > > m_list_current;
-        std::list<boost::shared_ptr<struct detail::Pixel<T> > > m_list_first_col;
+        size_t m_n_threads;
     };
 
-    template <typename T>
-    void bob::ip::Median<T>::initLists(const blitz::Array<T,2>& src)
-    {
-      // Clears content
-      m_list_first_col.clear();
-      m_list_current.clear();
-      typedef struct bob::ip::detail::Pixel<T> Pix;
-      for(int j=0; j<2*m_radius_y+1; ++j)
-        for(int i=0; i<2*m_radius_x+1; ++i)
-        {
-          boost::shared_ptr<Pix> pix(new Pix(j,i,src(j,i)));
-          bob::ip::detail::listInsertPixel(pix, m_list_first_col);
-        }
-      m_list_current = m_list_first_col;
-    }
-
-
-    template <typename T>
-    void bob::ip::Median<T>::listRemoveAddColumn(const int j, const int i,
-                  const blitz::Array<T,2>& src,
-                  std::list<boost::shared_ptr<struct detail::Pixel<T> > >& l)
-    {
-      // Erases elements from column i
-      typename std::list<boost::shared_ptr<struct detail::Pixel<T> > >::iterator it=l.begin();
-      for( ; it!=l.end(); )
-      {
-        if( (*it)->x == i) it = l.erase(it);
-        else ++it;
-      }
-      // Adds elements from new column i+2*m_radius_x+1
-      blitz::Array<T,1> col_new = src(blitz::Range(j,j+2*m_radius_y), i+2*m_radius_x+1);
-      for(int k=0; k<col_new.extent(0); ++k)
-      {
-        boost::shared_ptr<struct detail::Pixel<T> > pix(
-          new struct detail::Pixel<T>(j+k,i+2*m_radius_x+1,src(j+k,i+2*m_radius_x+1)));
-        bob::ip::detail::listInsertPixel(pix, l);
-      }
-    }
-
-    template <typename T>
-    void bob::ip::Median<T>::listRemoveAddRow(const int j, const int i,
-                  const blitz::Array<T,2>& src,
-                  std::list<boost::shared_ptr<struct detail::Pixel<T> > >& l)
-    {
-      // Erases elements from row j
-      typename std::list<boost::shared_ptr<struct detail::Pixel<T> > >::iterator it=l.begin();
-      for( ; it!=l.end(); )
-      {
-        if( (*it)->y == j) it = l.erase(it);
-        else ++it;
-      }
-      // Adds elements from new row j+2*m_radius_y+2
-      blitz::Array<T,1> col_new = src(j+2*m_radius_y+1,blitz::Range(i,i+2*m_radius_x));
-      for(int k=0; k<col_new.extent(0); ++k)
-      {
-        boost::shared_ptr<struct detail::Pixel<T> > pix(
-          new struct detail::Pixel<T>(j+2*m_radius_y+1,i+k,src(j+2*m_radius_y+1,i+k)));
-        bob::ip::detail::listInsertPixel(pix, l);
-      }
-    }
-
     template <typename T>
     void bob::ip::Median<T>::operator()(const blitz::Array<T,2>& src,
       blitz::Array<T,2>& dst)
@@ -229,27 +224,24 @@ namespace bob {
       dst_size(1) = src.extent(1) - 2 * m_radius_x;
       bob::core::array::assertSameShape(dst, dst_size);
 
-      // Initializes the lists
-      initLists(src);
+      detail::MedianStrip<T> strip;
+      strip.src = src.data();
+      strip.src_stride_y = src.stride(0);
+      strip.src_stride_x = src.stride(1);
+      strip.dst = dst.data();
+      strip.dst_stride_y = dst.stride(0);
+      strip.dst_stride_x = dst.stride(1);
+      strip.dst_width = dst.extent(1);
+      strip.radius_y = m_radius_y;
+      strip.radius_x = m_radius_x;
 
-      // Filters
-      for(int j=0; j<dst.extent(0); ++j)
-      {
-        for(int i=0; i<dst.extent(1); ++i)
-        {
-          dst(j,i) = bob::ip::detail::listGetValueAtPosition( m_median_pos, m_list_current);
-          // Updates current ordered list
-          if( i<dst.extent(1) - 1) {
-            listRemoveAddColumn(j, i, src, m_list_current);
-          }
-        }
-        // Updates current ordered list
-        if(j<dst.extent(0)-1)
-        {
-          listRemoveAddRow(j, 0, src, m_list_first_col);
-          m_list_current = m_list_first_col;
-        }
-      }
+      // Filters strips of rows in parallel. The strips are high enough to
+      // amortize the initialization of the histograms/windows.
+      const size_t height = dst.extent(0);
+      const size_t grain = std::max((size_t)(4*(2*m_radius_y+1)),
+          height / (4*bob::core::getNThreads()));
+      bob::core::parallelFor(0, height, detail::MedianStripBody<T>(strip),
+          grain, m_n_threads);
     }
 
     template <typename T>
@@ -45,6 +45,13 @@ namespace bob { namespace machine {
        */
       virtual double f (double z) const =0;
 
+      /**
+       * Computes the activated values of n contiguous inputs, in place. The
+       * default implementation calls f() on each value. Derived classes
+       * override it with a loop that does not dispatch on every value.
+       */
+      virtual void f_inplace (double* z, size_t n) const;
+
       /**
        * Computes the derivative of the current activation - i.e., the same
        * input as for f().
@@ -107,6 +114,7 @@ namespace bob { namespace machine {
     public: // api
 
       virtual double f (double z) const;
+      virtual void f_inplace (double* z, size_t n) const;
       virtual double f_prime (double z) const;
       virtual double f_prime_from_f (double a) const;
       virtual void save(bob::io::HDF5File&) const;
@@ -126,6 +134,7 @@ namespace bob { namespace machine {
       LinearActivation(double C=1.);
       virtual ~LinearActivation();
       virtual double f (double z) const;
+      virtual void f_inplace (double* z, size_t n) const;
       virtual double f_prime (double z) const;
       virtual double f_prime_from_f (double a) const;
       double C() const;
@@ -148,6 +157,7 @@ namespace bob { namespace machine {
     public: // api
 
       virtual double f (double z) const;
+      virtual void f_inplace (double* z, size_t n) const;
       virtual double f_prime (double z) const;
       virtual double f_prime_from_f (double a) const;
       virtual void save(bob::io::HDF5File& f) const;
@@ -167,6 +177,7 @@ namespace bob { namespace machine {
       MultipliedHyperbolicTangentActivation(double C=1., double M=1.);
       virtual ~MultipliedHyperbolicTangentActivation();
       virtual double f (double z) const;
+      virtual void f_inplace (double* z, size_t n) const;
       virtual double f_prime (double z) const;
       virtual double f_prime_from_f (double a) const;
       double C() const;
@@ -191,6 +202,7 @@ namespace bob { namespace machine {
     public: // api
 
       virtual double f (double z) const;
+      virtual void f_inplace (double* z, size_t n) const;
       virtual double f_prime (double z) const;
       virtual double f_prime_from_f (double a) const;
       virtual void save(bob::io::HDF5File& f) const;
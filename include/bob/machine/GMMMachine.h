@@ -39,6 +39,40 @@ namespace bob { namespace machine {
  * @{
  */
 
+/**
+ * @brief Scratch arrays used by the GMMMachine methods that take a
+ * workspace. The machine itself is then never written to, so that a single
+ * GMMMachine can be shared by several threads, each of them owning its own
+ * GMMMachineWorkspace.
+ */
+class GMMMachineWorkspace
+{
+  public:
+    /**
+     * Default constructor (the arrays are resized on first use)
+     */
+    GMMMachineWorkspace();
+
+    /**
+     * Constructor
+     * @param[in] n_gaussians  The number of Gaussian components
+     * @param[in] n_inputs     The feature dimensionality
+     */
+    GMMMachineWorkspace(const size_t n_gaussians, const size_t n_inputs);
+
+    /**
+     * Resizes the arrays if they do not match the given dimensions
+     */
+    void resize(const size_t n_gaussians, const size_t n_inputs);
+
+    /// For each Gaussian, i: log(weight_i*p(x|Gaussian_i))
+    blitz::Array<double,1> log_weighted_gaussian_likelihoods;
+    /// Responsibilities of the Gaussian components
+    blitz::Array<double,1> P;
+    /// Responsibilities times the sample
+    blitz::Array<double,2> Px;
+};
+
 /**
  * @brief This class implements a multivariate diagonal Gaussian distribution.
  * @details See Section 2.3.9 of Bishop, "Pattern recognition and machine learning", 2006
@@ -237,6 +271,27 @@ class GMMMachine: public Machine<blitz::Array<double,1>, double>
      */
     double logLikelihood_(const blitz::Array<double, 1> &x) const;
 
+    /**
+     * Output the log likelihood of the sample, x, i.e. log(p(x|GMM)),
+     * using the scratch arrays of the given workspace. This method does not
+     * modify the machine and may be called concurrently by several threads,
+     * provided that each of them uses its own workspace.
+     * @param[in]  x  The sample
+     * @param[out] ws The workspace (resized if required)
+     * Dimension of the input is checked
+     */
+    double logLikelihood(const blitz::Array<double, 1> &x,
+      GMMMachineWorkspace& ws) const;
+
+    /**
+     * Output the log likelihood of the sample, x, i.e. log(p(x|GMM)),
+     * using the scratch arrays of the given workspace.
+     * @see logLikelihood(const blitz::Array<double,1>&, GMMMachineWorkspace&)
+     * @warning Dimension of the input and of the workspace are not checked
+     */
+    double logLikelihood_(const blitz::Array<double, 1> &x,
+      GMMMachineWorkspace& ws) const;
+
     /**
      * Output the log likelihood of the sample, x
      * (overrides Machine::forward)
@@ -253,14 +308,24 @@ class GMMMachine: public Machine<blitz::Array<double,1>, double>
 
     /**
      * Accumulates the GMM statistics over a set of samples.
+     * Each sample is evaluated against all the Gaussian components at once,
+     * using a contiguous copy of their means and variances. The samples are
+     * split over the threads of the bob::core pool (see
+     * bob::core::setNThreads()). The first thread accumulates into stats,
+     * and each other thread into its own statistics, which are then added
+     * in the order of the threads. With a single thread, the result is the
+     * one of the sample-wise accStatistics(); otherwise, it only differs by
+     * the order of the additions.
      * @see bool accStatistics(const blitz::Array<double,1> &x, GMMStats stats)
+     * @param[in]  input     The samples (one per row)
+     * @param[out] stats     The accumulated statistics
      * Dimensions of the parameters are checked
      */
     void accStatistics(const blitz::Array<double,2>& input, GMMStats &stats) const;
 
     /**
      * Accumulates the GMM statistics over a set of samples.
-     * @see bool accStatistics(const blitz::Array<double,1> &x, GMMStats stats)
+     * @see accStatistics(const blitz::Array<double,2>&, GMMStats&)
      * @warning Dimensions of the parameters are not checked
      */
     void accStatistics_(const blitz::Array<double,2>& input, GMMStats &stats) const;
@@ -283,6 +348,30 @@ class GMMMachine: public Machine<blitz::Array<double,1>, double>
      */
     void accStatistics_(const blitz::Array<double,1> &x, GMMStats &stats) const;
 
+    /**
+     * Accumulate the GMM statistics for this sample, using the scratch
+     * arrays of the given workspace. This method does not modify the
+     * machine and may be called concurrently by several threads, provided
+     * that each of them uses its own workspace and statistics.
+     *
+     * @param[in]  x     The current sample
+     * @param[out] stats The accumulated statistics
+     * @param[out] ws    The workspace (resized if required)
+     * Dimensions of the parameters are checked
+     */
+    void accStatistics(const blitz::Array<double,1> &x, GMMStats &stats,
+      GMMMachineWorkspace& ws) const;
+
+    /**
+     * Accumulate the GMM statistics for this sample, using the scratch
+     * arrays of the given workspace.
+     * @see accStatistics(const blitz::Array<double,1>&, GMMStats&, GMMMachineWorkspace&)
+     * @warning Dimensions of the parameters and of the workspace are not
+     *   checked
+     */
+    void accStatistics_(const blitz::Array<double,1> &x, GMMStats &stats,
+      GMMMachineWorkspace& ws) const;
+
     /**
      * Get a pointer to a particular Gaussian component
      * @param[in] i The index of the Gaussian component
@@ -318,6 +407,10 @@ class GMMMachine: public Machine<blitz::Array<double,1>, double>
 
     /**
      * Load/Reload mean/variance supervector in cache
+     * @warning The supervectors are lazily computed by
+     *   getMeanSupervector() and getVarianceSupervector(). This method
+     *   should be called once before the machine is shared by several
+     *   threads.
      */
     void reloadCacheSupervectors() const;
 
@@ -368,10 +461,16 @@ class GMMMachine: public Machine<blitz::Array<double,1>, double>
      * @param[in]  x     The current sample
      * @param[out] stats The accumulated statistics
      * @param[in]  log_likelihood  The current log_likelihood
+     * @param[in]  log_weighted_gaussian_likelihoods  The weighted log
+     *   likelihoods of each Gaussian component for this sample
+     * @param[out] P     Scratch array for the responsibilities
+     * @param[out] Px    Scratch array for the first order statistics
      * @warning Dimensions of the parameters are not checked
      */
     void accStatisticsInternal(const blitz::Array<double,1> &x,
-      GMMStats &stats, const double log_likelihood) const;
+      GMMStats &stats, const double log_likelihood,
+      const blitz::Array<double,1>& log_weighted_gaussian_likelihoods,
+      blitz::Array<double,1>& P, blitz::Array<double,2>& Px) const;
 
 
     /// Some cache arrays to avoid re-allocation when computing log-likelihoods
@@ -0,0 +1,141 @@
+/**
+ * @file bob/machine/GaborGraphGallery.h
+ * @date Sat Oct 17 21:02:18 CEST 2026
+ * @author Laurent El Shafey <Laurent.El-Shafey@idiap.ch>
+ *
+ * @brief A gallery of Gabor graphs, which are compared to a probe graph all
+ * at once.
+ *
+ * Copyright (C) 2011-2013 Idiap Research Institute, Martigny, Switzerland
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef BOB_MACHINE_GABOR_GRAPH_GALLERY_H
+#define BOB_MACHINE_GABOR_GRAPH_GALLERY_H
+
+#include <bob/ip/GaborWaveletTransform.h>
+#include <bob/machine/GaborJetSimilarities.h>
+
+#include <vector>
+
+namespace bob{ namespace machine {
+  /**
+   * @ingroup MACHINE
+   * @{
+   */
+
+  //! \brief A gallery of Gabor graphs (of the same topology), stored in one contiguous (models x nodes x jet) memory block.
+  //! A probe graph is compared to all graphs of the gallery at once, using several threads (see bob::core::setNThreads()).
+  //! The similarity of a model graph and the probe graph is the average Gabor jet similarity over the nodes,
+  //! as computed by GaborGraphMachine::similarity().
+  //!
+  //! The SCALAR_PRODUCT and CANBERRA similarities use the absolute values of the jets only.
+  //! For SCALAR_PRODUCT, the jets are stored normalized to unit length, so that the gallery is scored with a single matrix-vector product.
+  //! Hence, the normalized scalar product is computed, which is identical to the GaborJetSimilarity for normalized Gabor jets.
+  //! The disparity-like similarities require Gabor graphs including phases.
+  class GaborGraphGallery {
+    public:
+      //! creates an empty gallery, whose graphs are compared with the given Gabor jet similarity function
+      GaborGraphGallery(
+        GaborJetSimilarity::SimilarityType type,
+        const bob::ip::GaborWaveletTransform& gwt = bob::ip::GaborWaveletTransform()
+      );
+
+      //! returns the number of graphs in the gallery
+      int size() const {return m_n_graphs;}
+
+      //! returns the number of nodes of the graphs of the gallery (0 if the gallery is empty)
+      int numberOfNodes() const {return m_n_nodes;}
+
+      //! returns the Gabor jet similarity function used to compare the graphs
+      const GaborJetSimilarity& similarityFunction() const {return m_similarity;}
+
+      //! reserves the memory for the given number of graphs, which avoids re-allocations when adding graphs
+      void reserve(int n_graphs);
+
+      //! removes all graphs from the gallery
+      void clear();
+
+      //! adds a Gabor graph (absolute values only) to the gallery
+      void add(const blitz::Array<double,2>& graph_jets);
+
+      //! adds a Gabor graph (including phases) to the gallery
+      void add(const blitz::Array<double,3>& graph_jets);
+
+      //! computes the similarities of the given probe graph (absolute values only) to all graphs of the gallery; scores must have size() elements
+      void similarity(
+        const blitz::Array<double,2>& probe_graph_jets,
+        blitz::Array<double,1>& scores
+      ) const;
+
+      //! computes the similarities of the given probe graph (including phases) to all graphs of the gallery; scores must have size() elements
+      void similarity(
+        const blitz::Array<double,3>& probe_graph_jets,
+        blitz::Array<double,1>& scores
+      ) const;
+
+      //! \brief returns the indices and the similarities of the k most similar gallery graphs to the given probe graph (absolute values only).
+      //! The outputs are resized to min(k, size()) elements, sorted by decreasing similarity (ties by increasing index).
+      void topK(
+        const blitz::Array<double,2>& probe_graph_jets,
+        int k,
+        blitz::Array<int,1>& indices,
+        blitz::Array<double,1>& scores
+      ) const;
+
+      //! \brief returns the indices and the similarities of the k most similar gallery graphs to the given probe graph (including phases).
+      //! The outputs are resized to min(k, size()) elements, sorted by decreasing similarity (ties by increasing index).
+      void topK(
+        const blitz::Array<double,3>& probe_graph_jets,
+        int k,
+        blitz::Array<int,1>& indices,
+        blitz::Array<double,1>& scores
+      ) const;
+
+    private:
+      // checks the number of nodes and kernels of the given graph and converts it to the layout of the gallery
+      void convert(const blitz::Array<double,2>& graph_jets, std::vector<double>& jets) const;
+      void convert(const blitz::Array<double,3>& graph_jets, std::vector<double>& jets) const;
+      // appends the converted graph to the gallery
+      void append(const std::vector<double>& jets, int n_nodes, int n_kernels);
+      // scores the converted probe against all graphs of the gallery
+      void score(const std::vector<double>& probe, blitz::Array<double,1>& scores) const;
+      // selects the k best scores
+      void select(const blitz::Array<double,1>& all_scores, int k, blitz::Array<int,1>& indices, blitz::Array<double,1>& scores) const;
+
+      // scores the probe against the gallery graphs [begin,end[ (parallel bodies)
+      void scoreScalarProducts(const std::vector<double>& probe, double* scores, size_t begin, size_t end, size_t) const;
+      void scoreCanberra(const std::vector<double>& probe, double* scores, size_t begin, size_t end, size_t) const;
+      void scoreDisparities(const std::vector<double>& probe, std::vector<GaborJetSimilarityWorkspace>& workspaces, double* scores, size_t begin, size_t end, size_t thread) const;
+
+      // the similarity function
+      GaborJetSimilarity m_similarity;
+      // whether the similarity function requires Gabor phases
+      bool m_with_phases;
+
+      // the graph jets, stored one graph after the other
+      std::vector<double> m_jets;
+      int m_n_graphs;
+      int m_n_nodes;
+      int m_n_kernels;
+      // the number of values per graph
+      int m_graph_size;
+  };
+
+  /**
+   * @}
+   */
+}}
+
+#endif // BOB_MACHINE_GABOR_GRAPH_GALLERY_H
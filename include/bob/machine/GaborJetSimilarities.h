@@ -26,6 +26,7 @@
 #include <bob/core/assert.h>
 #include <blitz/array.h>
 #include <numeric>
+#include <vector>
 #include <bob/ip/GaborWaveletTransform.h>
 
 namespace bob { namespace machine {
@@ -34,6 +35,18 @@ namespace bob { namespace machine {
    * @{
    */
 
+  //! \brief Working memory of the disparity-like Gabor jet similarities.
+  //! A single GaborJetSimilarity can be used by several threads at the same time, when each of them passes its own workspace.
+  class GaborJetSimilarityWorkspace{
+    public:
+      //! The confidences of the Gabor jet entries
+      std::vector<double> confidences;
+      //! The phase differences of the Gabor jet entries
+      std::vector<double> phase_differences;
+      //! The disparity vector estimated during the last call of the similarity function
+      blitz::TinyVector<double,2> disparity;
+  };
+
   //! Class to compute Gabor jet similarities
   class GaborJetSimilarity{
     public:
@@ -59,8 +72,15 @@ namespace bob { namespace machine {
       //! The similarity between two Gabor jets, including absolute values only
       double operator()(const blitz::Array<double,1>& jet1, const blitz::Array<double,1>& jet2) const;
 
+      //! \brief The similarity between two Gabor jets, including absolute values and phases, using the given workspace.
+      //! This function does not modify this object, so that it can be called by several threads at the same time.
+      double operator()(const blitz::Array<double,2>& jet1, const blitz::Array<double,2>& jet2, GaborJetSimilarityWorkspace& workspace) const;
+
       //! returns the disparity vector estimated during the last call of similarity; only valid for disparity types
-      blitz::TinyVector<double,2> disparity() const {return m_disparity;}
+      blitz::TinyVector<double,2> disparity() const {return m_workspace.disparity;}
+
+      //! returns the type of this Gabor jet similarity function
+      SimilarityType type() const {return m_type;}
 
       //! \brief saves the parameters of this Gabor jet similarity to file
       void save(bob::io::HDF5File& file) const;
@@ -78,14 +98,13 @@ namespace bob { namespace machine {
       // initializes the internal memory to be used for disparity-like Gabor jet similarities
       void init();
       // computes confidences from the given Gabor jets
-      void compute_confidences(const blitz::Array<double,2>& jet1, const blitz::Array<double,2>& jet2) const;
-      // computes the disparity using the m_confidences and m_phase_differences values
-      void compute_disparity() const;
+      void compute_confidences(const blitz::Array<double,2>& jet1, const blitz::Array<double,2>& jet2, GaborJetSimilarityWorkspace& workspace) const;
+      // computes the disparity using the confidences and phase differences of the workspace
+      void compute_disparity(GaborJetSimilarityWorkspace& workspace) const;
 
-      mutable blitz::TinyVector<double,2> m_disparity;
+      // the workspace used by the similarity functions without workspace parameter
+      mutable GaborJetSimilarityWorkspace m_workspace;
 
-      mutable std::vector<double> m_confidences;
-      mutable std::vector<double> m_phase_differences;
       std::vector<double> m_wavelet_extends;
 
   }; // class GaborJetSimilarity
@@ -174,6 +174,13 @@ class Gaussian: public Machine<blitz::Array<double,1>, double>
      */
     void applyVarianceThresholds();
 
+    /**
+     * Get the normalization constant g_norm = n_inputs*log(2*pi) +
+     * log(det(variance)), such that log(p(x)) = -0.5*(g_norm + z(x))
+     */
+    inline double getGNorm() const
+    { return m_g_norm; }
+
     /**
      * Output the log likelihood of the sample, x
      * @param x The data sample (feature vector)
@@ -26,6 +26,7 @@
 #include "GMMMachine.h"
 #include "GMMStats.h"
 #include <bob/io/HDF5File.h>
+#include <vector>
 
 namespace bob { namespace machine {
 /**
@@ -33,6 +34,53 @@ namespace bob { namespace machine {
  * @{
  */
 
+/**
+ * @brief Scratch arrays used by the IVectorMachine methods that take a
+ * workspace. The machine is then never written to, so that a single
+ * IVectorMachine can be shared by several threads, each of them owning its
+ * own IVectorMachineWorkspace.
+ */
+class IVectorMachineWorkspace
+{
+  public:
+    /**
+     * @brief Default constructor (the arrays are resized on first use)
+     */
+    IVectorMachineWorkspace();
+
+    /**
+     * @brief Constructor
+     * @param dim_d The feature dimensionality D
+     * @param dim_rt The rank of the \f$T\f$ matrix
+     */
+    IVectorMachineWorkspace(const size_t dim_d, const size_t dim_rt);
+
+    /**
+     * @brief Resizes the arrays if they do not match the given dimensions
+     */
+    void resize(const size_t dim_d, const size_t dim_rt);
+
+    /**
+     * @brief Resizes the arrays used to process n_samples GMMStats at once
+     * (tmp_n, tmp_fnorm, tmp_rhs and tmp_precision), if they do not match
+     * the given dimensions
+     */
+    void resizeBatch(const size_t dim_c, const size_t dim_d,
+      const size_t dim_rt, const size_t n_samples);
+
+    /// Working arrays
+    blitz::Array<double,1> tmp_d;
+    blitz::Array<double,1> tmp_t1;
+    blitz::Array<double,1> tmp_t2;
+    blitz::Array<double,2> tmp_tt;
+
+    /// Working arrays of the batched methods (one row per sample)
+    blitz::Array<double,2> tmp_n;
+    blitz::Array<double,2> tmp_fnorm;
+    blitz::Array<double,2> tmp_rhs;
+    blitz::Array<double,3> tmp_precision;
+};
+
 /**
  * @brief An IVectorMachine consists of a Total Variability subspace \f$T\f$
  *   and allows the extraction of IVector\n
@@ -40,6 +88,11 @@ namespace bob { namespace machine {
  * "Front-End Factor Analysis For Speaker Verification",
  *    N. Dehak, P. Kenny, R. Dehak, P. Dumouchel, P. Ouellet, 
  *   IEEE Trans. on Audio, Speech and Language Processing
+ *
+ * The symmetric matrices \f$T_{c}^{T} \Sigma_{c}^{-1} T_{c}\f$ are cached
+ * in packed storage (upper triangle, row by row), which halves the memory
+ * of this cache (C x rt(rt+1)/2 values). It may further be stored in single
+ * precision (see setSinglePrecisionCache()).
  */
 class IVectorMachine: public bob::machine::Machine<bob::machine::GMMStats, blitz::Array<double,1> >
 {
@@ -136,6 +189,13 @@ class IVectorMachine: public bob::machine::Machine<bob::machine::GMMStats, blitz
     const double getVarianceThreshold() const 
     { return m_variance_threshold; }
 
+    /**
+     * @brief Tells whether the cache of the \f$T_{c}^{T} \Sigma_{c}^{-1}
+     * T_{c}\f$ matrices is stored in single precision
+     */
+    const bool getSinglePrecisionCache() const
+    { return m_single_precision_cache; }
+
     /**
      * @brief Returns the number of Gaussian components C.
      * @warning An exception is thrown if no Universal Background Model has 
@@ -210,6 +270,14 @@ class IVectorMachine: public bob::machine::Machine<bob::machine::GMMStats, blitz
      */
     void setVarianceThreshold(const double value);
 
+    /**
+     * @brief Stores the cache of the \f$T_{c}^{T} \Sigma_{c}^{-1} T_{c}\f$
+     * matrices in single precision (halving its memory) or in double
+     * precision (default). The accumulations are always performed in double
+     * precision.
+     */
+    void setSinglePrecisionCache(const bool value);
+
     /**
      * @brief Update arrays in cache
      * @warning It is only useful when using updateT() or updateSigma()
@@ -223,12 +291,66 @@ class IVectorMachine: public bob::machine::Machine<bob::machine::GMMStats, blitz
      */
     void computeIdTtSigmaInvT(const bob::machine::GMMStats& input, blitz::Array<double,2>& output) const;
 
+    /**
+     * @brief Computes \f$(Id + \sum_{c=1}^{C} N_{i,j,c} T^{T} \Sigma_{c}^{-1} T)\f$
+     * for several samples at once, given their zeroth order statistics (one
+     * row per sample, C columns). The output is n_samples x rt x rt and
+     * should be C-style contiguous. Each block of the cache is then read
+     * once for all the samples.
+     * @warning No check is perform
+     */
+    void computeIdTtSigmaInvT(const blitz::Array<double,2>& n,
+      blitz::Array<double,3>& output) const;
+
     /**
      * @brief Computes \f$T^{T} \Sigma^{-1} \sum_{c=1}^{C} (F_c - N_c ubmmean_{c})\f$
      * @warning No check is perform
      */
     void computeTtSigmaInvFnorm(const bob::machine::GMMStats& input, blitz::Array<double,1>& output) const;
 
+    /**
+     * @brief Computes \f$T^{T} \Sigma^{-1} \sum_{c=1}^{C} (F_c - N_c ubmmean_{c})\f$
+     * using the scratch arrays of the given workspace
+     * @warning No check is perform
+     */
+    void computeTtSigmaInvFnorm(const bob::machine::GMMStats& input,
+      blitz::Array<double,1>& output, IVectorMachineWorkspace& ws) const;
+
+    /**
+     * @brief Computes \f$T^{T} \Sigma^{-1} F_{norm}\f$ for several samples
+     * at once (a single matrix product), given their centered first order
+     * statistics \f$F_{norm} = F_c - N_c ubmmean_{c}\f$ (one row per sample,
+     * CD columns). The output is n_samples x rt.
+     * @warning No check is perform
+     */
+    void computeTtSigmaInvFnorm(const blitz::Array<double,2>& fnorm,
+      blitz::Array<double,2>& output) const;
+
+    /**
+     * @brief Number of GMM statistics processed at once by computeBatch():
+     * each block of the cache of the \f$T_{c}^{T} \Sigma_{c}^{-1} T_{c}\f$
+     * matrices is then read once for all of them
+     */
+    static size_t getBatchSize() { return 16; }
+
+    /**
+     * @brief Computes the linear systems giving the ivectors of the GMM
+     * statistics [begin,end) (at most getBatchSize() of them): the precision
+     * matrices \f$Id + T^{T} \Sigma^{-1} T\f$ and the right-hand sides
+     * \f$T^{T} \Sigma^{-1} F_{norm}\f$ are written to the first rows of
+     * ws.tmp_precision and ws.tmp_rhs, from the statistics of the batch
+     * (ws.tmp_n and ws.tmp_fnorm).
+     *
+     * @param input GMM statistics
+     * @param means The mean supervector of the UBM
+     * @param ws workspace, resized with resizeBatch() for getBatchSize()
+     *   samples
+     * @warning No check is perform
+     */
+    void computeBatch(const std::vector<bob::machine::GMMStats>& input,
+      const blitz::Array<double,1>& means, const size_t begin,
+      const size_t end, IVectorMachineWorkspace& ws) const;
+
     /**
      * @brief Extracts an ivector from the input GMM statistics
      *
@@ -246,6 +368,38 @@ class IVectorMachine: public bob::machine::Machine<bob::machine::GMMStats, blitz
      */
     void forward_(const bob::machine::GMMStats& input, blitz::Array<double,1>& output) const;
 
+    /**
+     * @brief Extracts an ivector from the input GMM statistics, using the
+     * scratch arrays of the given workspace. The machine is not modified,
+     * such that several threads may extract ivectors with the same machine,
+     * provided that each of them uses its own workspace.
+     *
+     * @param input GMM statistics to be used by the machine
+     * @param output I-vector computed by the machine
+     * @param ws workspace (resized if required)
+     */
+    void forward(const bob::machine::GMMStats& input,
+      blitz::Array<double,1>& output, IVectorMachineWorkspace& ws) const;
+
+    /**
+     * @brief Extracts an ivector from the input GMM statistics, using the
+     * scratch arrays of the given workspace.
+     * @warning Inputs and the workspace size are NOT checked
+     */
+    void forward_(const bob::machine::GMMStats& input,
+      blitz::Array<double,1>& output, IVectorMachineWorkspace& ws) const;
+
+    /**
+     * @brief Extracts the ivectors of several GMM statistics at once. The
+     * samples are processed by batches, which are distributed over the
+     * threads of bob::core::parallelFor().
+     *
+     * @param input GMM statistics to be used by the machine
+     * @param output I-vectors computed by the machine (one per row)
+     */
+    void forward(const std::vector<bob::machine::GMMStats>& input,
+      blitz::Array<double,2>& output) const;
+
   protected:
     /**
      * @brief Apply the variance flooring thresholds.
@@ -265,6 +419,27 @@ class IVectorMachine: public bob::machine::Machine<bob::machine::GMMStats, blitz
      * @brief Resize cache and working arrays before updating cache
      */
     void resizePrecompute();
+    /**
+     * @brief Computes \f$T^{T} \Sigma^{-1} \sum_{c=1}^{C} (F_c - N_c ubmmean_{c})\f$
+     * (tmp_d and tmp_t are working arrays)
+     */
+    void computeTtSigmaInvFnorm(const bob::machine::GMMStats& input,
+      blitz::Array<double,1>& output, blitz::Array<double,1>& tmp_d,
+      blitz::Array<double,1>& tmp_t) const;
+    /**
+     * @brief Computes the cache of the Gaussians [begin,end) (body of the
+     * parallel loop of precompute())
+     */
+    void precomputeGaussians(const blitz::Array<double,2>& T,
+      const size_t begin, const size_t end, const size_t thread);
+    /**
+     * @brief Extracts the ivectors of the samples [begin,end) (body of the
+     * parallel loop of the batched forward())
+     */
+    void forwardBatch(const std::vector<bob::machine::GMMStats>& input,
+      const blitz::Array<double,1>& means, blitz::Array<double,2>& output,
+      std::vector<IVectorMachineWorkspace>& ws, const size_t begin,
+      const size_t end, const size_t thread) const;
 
     // UBM
     boost::shared_ptr<bob::machine::GMMMachine> m_ubm;
@@ -277,9 +452,14 @@ class IVectorMachine: public bob::machine::Machine<bob::machine::GMMStats, blitz
     blitz::Array<double,2> m_T; ///< The total variability matrix \f$T\f$
     blitz::Array<double,1> m_sigma; ///< The diagonal covariance matrix \f$\Sigma\f$
     double m_variance_threshold; ///< The variance flooring threshold
-
-    blitz::Array<double,3> m_cache_Tct_sigmacInv;
-    blitz::Array<double,3> m_cache_Tct_sigmacInv_Tc;
+    bool m_single_precision_cache;
+
+    ///< \f$\Sigma^{-1} T\f$ (CD x rt)
+    blitz::Array<double,2> m_cache_sigmaInv_T;
+    ///< \f$T_{c}^{T} \Sigma_{c}^{-1} T_{c}\f$, packed (C x rt(rt+1)/2), in
+    ///< double or in single precision
+    blitz::Array<double,2> m_cache_Tct_sigmacInv_Tc;
+    blitz::Array<float,2> m_cache_Tct_sigmacInv_Tc_single;
 
     mutable blitz::Array<double,1> m_tmp_d;
     mutable blitz::Array<double,1> m_tmp_t1;
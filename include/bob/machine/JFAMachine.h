@@ -38,6 +38,49 @@ namespace bob { namespace machine {
  * @{
  */
 
+/**
+ * @brief Scratch arrays used to estimate the session variable x and to
+ * compute scores with the JFAMachine and ISVMachine methods that take a
+ * workspace. The machines are then never written to, so that a single
+ * (possibly large) model can be shared by several threads, each of them
+ * owning its own FAWorkspace.
+ */
+class FAWorkspace
+{
+  public:
+    /**
+     * @brief Default constructor (the arrays are resized on first use)
+     */
+    FAWorkspace();
+
+    /**
+     * @brief Constructor
+     * @param dim_c The number of Gaussian components C
+     * @param dim_d The feature dimensionality D
+     * @param dim_ru The rank of the U matrix
+     */
+    FAWorkspace(const size_t dim_c, const size_t dim_d, const size_t dim_ru);
+
+    /**
+     * @brief Resizes the arrays if they do not match the given dimensions
+     */
+    void resize(const size_t dim_c, const size_t dim_d, const size_t dim_ru);
+
+    /// (Id + U^T.Sigma^-1.U.N_{i,h}.U)^-1 (ru x ru)
+    blitz::Array<double,2> IdPlusUSProdInv;
+    /// Normalised first order statistics (CD)
+    blitz::Array<double,1> Fn_x;
+    /// Session variable x (ru)
+    blitz::Array<double,1> x;
+    /// Session offset Ux (CD)
+    blitz::Array<double,1> Ux;
+    /// Working arrays
+    blitz::Array<double,1> tmp_ru;
+    blitz::Array<double,2> tmp_ruD;
+    blitz::Array<double,2> tmp_ruru;
+    blitz::Array<double,2> tmp_ruru2;
+};
+
 /**
  * @brief A FA Base class which contains U, V and D matrices
  * TODO: add a reference to the journal articles
@@ -241,6 +284,15 @@ class FABase
      */
     void estimateX(const bob::machine::GMMStats& gmm_stats, blitz::Array<double,1>& x) const;
 
+    /**
+     * @brief Estimates x from the GMM statistics considering the LPT
+     * assumption, using the scratch arrays of the given workspace.
+     * This method does not modify the FABase and may be called concurrently
+     * by several threads, provided that each of them uses its own workspace.
+     */
+    void estimateX(const bob::machine::GMMStats& gmm_stats,
+      blitz::Array<double,1>& x, bob::machine::FAWorkspace& ws) const;
+
     /**
      * @brief Compute and put U^{T}.Sigma^{-1} matrix in cache
      * @warning Should only be used by the trainer for efficiency reason,
@@ -265,9 +317,12 @@ class FABase
     /**
      * @brief Computes (Id + U^T.Sigma^-1.U.N_{i,h}.U)^-1 =
      *   (Id + sum_{c=1..C} N_{i,h}.U_{c}^T.Sigma_{c}^-1.U_{c})^-1
+     * tmp_ruD, tmp_ruru and tmp_ruru2 are working arrays.
      */
     void computeIdPlusUSProdInv(const bob::machine::GMMStats& gmm_stats,
-      blitz::Array<double,2>& out) const;
+      blitz::Array<double,2>& out, blitz::Array<double,2>& tmp_ruD,
+      blitz::Array<double,2>& tmp_ruru,
+      blitz::Array<double,2>& tmp_ruru2) const;
     /**
      * @brief Computes Fn_x = sum_{sessions h}(N*(o - m))
      * (Normalised first order statistics)
@@ -277,9 +332,11 @@ class FABase
     /**
      * @brief Estimates the value of x from the passed arguments
      * (IdPlusUSProdInv and Fn_x), considering the LPT assumption
+     * tmp_ru is a working array.
      */
     void estimateX(const blitz::Array<double,2>& IdPlusUSProdInv,
-      const blitz::Array<double,1>& Fn_x, blitz::Array<double,1>& x) const;
+      const blitz::Array<double,1>& Fn_x, blitz::Array<double,1>& x,
+      blitz::Array<double,1>& tmp_ru) const;
 
 
     // UBM
@@ -305,6 +362,7 @@ class FABase
     mutable blitz::Array<double,1> m_tmp_ru;
     mutable blitz::Array<double,2> m_tmp_ruD;
     mutable blitz::Array<double,2> m_tmp_ruru;
+    mutable blitz::Array<double,2> m_tmp_ruru2;
 };
 
 
@@ -512,6 +570,15 @@ class JFABase
     void estimateX(const bob::machine::GMMStats& gmm_stats, blitz::Array<double,1>& x) const
     { m_base.estimateX(gmm_stats, x); }
 
+    /**
+     * @brief Estimates x from the GMM statistics considering the LPT
+     * assumption, using the scratch arrays of the given workspace
+     * (thread-safe as long as each thread uses its own workspace)
+     */
+    void estimateX(const bob::machine::GMMStats& gmm_stats,
+        blitz::Array<double,1>& x, bob::machine::FAWorkspace& ws) const
+    { m_base.estimateX(gmm_stats, x, ws); }
+
     /**
      * @brief Precompute (put U^{T}.Sigma^{-1} matrix in cache)
      * @warning Should only be used by the trainer for efficiency reason,
@@ -713,6 +780,15 @@ class ISVBase
     void estimateX(const bob::machine::GMMStats& gmm_stats, blitz::Array<double,1>& x) const
     { m_base.estimateX(gmm_stats, x); }
 
+    /**
+     * @brief Estimates x from the GMM statistics considering the LPT
+     * assumption, using the scratch arrays of the given workspace
+     * (thread-safe as long as each thread uses its own workspace)
+     */
+    void estimateX(const bob::machine::GMMStats& gmm_stats,
+        blitz::Array<double,1>& x, bob::machine::FAWorkspace& ws) const
+    { m_base.estimateX(gmm_stats, x, ws); }
+
     /**
      * @brief Precompute (put U^{T}.Sigma^{-1} matrix in cache)
      * @warning Should only be used by the trainer for efficiency reason,
@@ -900,6 +976,14 @@ class JFAMachine: public Machine<bob::machine::GMMStats, double>
      */
     void estimateX(const bob::machine::GMMStats& gmm_stats, blitz::Array<double,1>& x) const
     { m_jfa_base->estimateX(gmm_stats, x); }
+    /**
+     * @brief Estimates x from the GMM statistics considering the LPT
+     * assumption, using the scratch arrays of the given workspace
+     * (thread-safe as long as each thread uses its own workspace)
+     */
+    void estimateX(const bob::machine::GMMStats& gmm_stats,
+        blitz::Array<double,1>& x, bob::machine::FAWorkspace& ws) const
+    { m_jfa_base->estimateX(gmm_stats, x, ws); }
     /**
      * @brief Estimates Ux from the GMM statistics considering the LPT
      * assumption, that is the latent session variable x is approximated
@@ -931,6 +1015,29 @@ class JFAMachine: public Machine<bob::machine::GMMStats, double>
      */
     void forward_(const bob::machine::GMMStats& input, double& score) const;
 
+    /**
+     * @brief Execute the machine using the scratch arrays of the given
+     * workspace. The machine is not modified (in particular, getX() is not
+     * updated, the estimated x being stored in ws.x), such that several
+     * threads may score against the same machine, provided that each of
+     * them uses its own workspace.
+     *
+     * @param input input data used by the machine
+     * @param score value computed by the machine
+     * @param ws workspace (resized if required)
+     * @warning Inputs are checked
+     */
+    void forward(const bob::machine::GMMStats& input, double& score,
+      bob::machine::FAWorkspace& ws) const;
+
+    /**
+     * @brief Execute the machine using the scratch arrays of the given
+     * workspace.
+     * @warning Inputs and the workspace size are NOT checked
+     */
+    void forward_(const bob::machine::GMMStats& input, double& score,
+      bob::machine::FAWorkspace& ws) const;
+
   protected:
     /**
      * @brief Resize latent variable according to the JFABase
@@ -1103,6 +1210,14 @@ class ISVMachine: public Machine<bob::machine::GMMStats, double>
      */
     void estimateX(const bob::machine::GMMStats& gmm_stats, blitz::Array<double,1>& x) const
     { m_isv_base->estimateX(gmm_stats, x); }
+    /**
+     * @brief Estimates x from the GMM statistics considering the LPT
+     * assumption, using the scratch arrays of the given workspace
+     * (thread-safe as long as each thread uses its own workspace)
+     */
+    void estimateX(const bob::machine::GMMStats& gmm_stats,
+        blitz::Array<double,1>& x, bob::machine::FAWorkspace& ws) const
+    { m_isv_base->estimateX(gmm_stats, x, ws); }
     /**
      * @brief Estimates Ux from the GMM statistics considering the LPT
      * assumption, that is the latent session variable x is approximated
@@ -1134,6 +1249,29 @@ class ISVMachine: public Machine<bob::machine::GMMStats, double>
      */
     void forward_(const bob::machine::GMMStats& input, double& score) const;
 
+    /**
+     * @brief Execute the machine using the scratch arrays of the given
+     * workspace. The machine is not modified (in particular, getX() is not
+     * updated, the estimated x being stored in ws.x), such that several
+     * threads may score against the same machine, provided that each of
+     * them uses its own workspace.
+     *
+     * @param input input data used by the machine
+     * @param score value computed by the machine
+     * @param ws workspace (resized if required)
+     * @warning Inputs are checked
+     */
+    void forward(const bob::machine::GMMStats& input, double& score,
+      bob::machine::FAWorkspace& ws) const;
+
+    /**
+     * @brief Execute the machine using the scratch arrays of the given
+     * workspace.
+     * @warning Inputs and the workspace size are NOT checked
+     */
+    void forward_(const bob::machine::GMMStats& input, double& score,
+      bob::machine::FAWorkspace& ws) const;
+
   protected:
     /**
      * @brief Resize latent variable according to the ISVBase
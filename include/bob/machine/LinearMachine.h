@@ -136,6 +136,32 @@ namespace bob { namespace machine {
       void forward (const blitz::Array<double,1>& input,
           blitz::Array<double,1>& output) const;
 
+      /**
+       * Forwards data through the network, outputs the values of each linear
+       * component the input signal is decomposed at. This variant will take a
+       * number of inputs in one single input matrix with inputs arranged
+       * row-wise (i.e., every row contains an individual input). The inputs
+       * are projected by mini-batches of rows, with a single matrix-matrix
+       * product each.
+       *
+       * The input and output are NOT checked for compatibility each time. It
+       * is your responsibility to do it.
+       */
+      void forward_ (const blitz::Array<double,2>& input,
+          blitz::Array<double,2>& output) const;
+
+      /**
+       * Forwards data through the network, outputs the values of each linear
+       * component the input signal is decomposed at. This variant will take a
+       * number of inputs in one single input matrix with inputs arranged
+       * row-wise (i.e., every row contains an individual input).
+       *
+       * The input and output are checked for compatibility each time the
+       * forward method is applied.
+       */
+      void forward (const blitz::Array<double,2>& input,
+          blitz::Array<double,2>& output) const;
+
       /**
        * Resizes the machine. If either the input or output increases in size,
        * the weights and other factors should be considered uninitialized. If
@@ -282,6 +308,8 @@ namespace bob { namespace machine {
       boost::shared_ptr<Activation> m_activation; ///< currently set activation type
 
       mutable blitz::Array<double, 1> m_buffer; ///< a buffer for speed
+      mutable blitz::Array<double, 2> m_batch_input; ///< normalized inputs of a mini-batch
+      mutable blitz::Array<double, 2> m_batch_output; ///< outputs of a mini-batch
   
   };
 
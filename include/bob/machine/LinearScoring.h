@@ -22,8 +22,10 @@
 
 #include <blitz/array.h>
 #include <boost/shared_ptr.hpp>
+#include <string>
 #include <vector>
 #include <bob/machine/GMMMachine.h>
+#include <bob/io/HDF5File.h>
 
 namespace bob { namespace machine {
 /**
@@ -44,6 +46,10 @@ namespace bob { namespace machine {
  * @param frame_length_normalisation   perform a normalisation by the number of feature vectors
  * @param[out] scores 2D matrix of scores, <tt>scores[m, s]</tt> is the score for model @c m against statistics @c s
  * @warning the output scores matrix should have the correct size (number of models x number of test_stats)
+ *
+ * The scores are computed by blocks of models and tiles of test statistics,
+ * whose supervectors are built on the fly and multiplied in parallel, such
+ * that the matrix of the test supervectors is never built as a whole.
  */
 void linearScoring(const std::vector<blitz::Array<double,1> >& models,
                    const blitz::Array<double,1>& ubm_mean, const blitz::Array<double,1>& ubm_variance,
@@ -57,6 +63,35 @@ void linearScoring(const std::vector<blitz::Array<double,1> >& models,
                    const bool frame_length_normalisation,
                    blitz::Array<double,2>& scores);
 
+/**
+ * Compute a matrix of scores using linear scoring, and append it to a dataset
+ * of an HDF5 file, one array of scores per model (i.e. one row of the matrix
+ * of scores at a time). Only the scores of a block of models are held in
+ * memory, such that very large matrices of scores can be computed.
+ *
+ * @warning Each GMM must have the same size.
+ * 
+ * @param models        list of mean supervector for the client models
+ * @param ubm_mean      mean supervector of the world model
+ * @param ubm_variance  variance supervector of the world model
+ * @param test_stats    list of accumulate statistics for each test trial
+ * @param test_channelOffset  list of channel offset if any (for JFA/ISA for instance)
+ * @param frame_length_normalisation   perform a normalisation by the number of feature vectors
+ * @param file          HDF5 file opened for writing
+ * @param path          dataset to which the scores are appended
+ */
+void linearScoring(const std::vector<blitz::Array<double,1> >& models,
+                   const blitz::Array<double,1>& ubm_mean, const blitz::Array<double,1>& ubm_variance,
+                   const std::vector<boost::shared_ptr<const bob::machine::GMMStats> >& test_stats,
+                   const std::vector<blitz::Array<double, 1> >& test_channelOffset,
+                   const bool frame_length_normalisation,
+                   bob::io::HDF5File& file, const std::string& path);
+void linearScoring(const std::vector<blitz::Array<double,1> >& models,
+                   const blitz::Array<double,1>& ubm_mean, const blitz::Array<double,1>& ubm_variance,
+                   const std::vector<boost::shared_ptr<const bob::machine::GMMStats> >& test_stats,
+                   const bool frame_length_normalisation,
+                   bob::io::HDF5File& file, const std::string& path);
+
 /**
  * Compute a matrix of scores using linear scoring.
  *
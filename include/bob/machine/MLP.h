@@ -173,6 +173,10 @@ namespace bob { namespace machine {
        * matrix with inputs arranged row-wise (i.e., every row contains an
        * individual input).
        *
+       * The inputs are processed by mini-batches of rows: each layer is then
+       * a single matrix-matrix product, followed by the activation of the
+       * whole mini-batch.
+       *
        * The input and output are NOT checked for compatibility each time. It
        * is your responsibility to do it.
        */
@@ -377,6 +381,14 @@ namespace bob { namespace machine {
        */
       void randomize(double lower_bound=-0.1, double upper_bound=+0.1);
 
+    private: //helpers
+
+      /**
+       * Allocates the buffers of the outputs of each layer for mini-batches
+       * of the given number of rows, if not done yet.
+       */
+      void resizeBatchBuffers(int batch_size);
+
     private: //representation
 
       blitz::Array<double, 1> m_input_sub; ///< input subtraction
@@ -386,6 +398,7 @@ namespace bob { namespace machine {
       boost::shared_ptr<Activation> m_hidden_activation; ///< currently set activation type
       boost::shared_ptr<Activation> m_output_activation; ///< currently set activation type
       mutable std::vector<blitz::Array<double, 1> > m_buffer; ///< buffer for the outputs of each layer
+      std::vector<blitz::Array<double, 2> > m_batch_buffer; ///< buffer for the outputs of each layer, for a mini-batch
   
   };
 
@@ -28,6 +28,7 @@
 #include <blitz/array.h>
 #include <bob/io/HDF5File.h>
 #include <map>
+#include <vector>
 #include <iostream>
 #include <stdexcept>
 
@@ -37,6 +38,44 @@ namespace bob { namespace machine {
  * @{
  */
   
+/**
+ * @brief Scratch arrays used by the PLDAMachine methods that take a
+ * workspace. Neither the PLDAMachine nor its PLDABase are then written to
+ * (\f$\gamma_a\f$ and the log likelihood constant term are computed into
+ * the workspace when they are not already cached), so that a single model
+ * can be shared by several threads, each of them owning its own
+ * PLDAMachineWorkspace.
+ */
+class PLDAMachineWorkspace
+{
+  public:
+    /**
+     * @brief Default constructor (the arrays are resized on first use)
+     */
+    PLDAMachineWorkspace();
+
+    /**
+     * @brief Constructor
+     * @param dim_d Dimensionality of the input feature vector
+     * @param dim_f Size/rank of the \f$F\f$ subspace
+     */
+    PLDAMachineWorkspace(const size_t dim_d, const size_t dim_f);
+
+    /**
+     * @brief Resizes the arrays if they do not match the given dimensions
+     */
+    void resize(const size_t dim_d, const size_t dim_f);
+
+    /// \f$\gamma_a\f$, when it is not cached by the machine
+    blitz::Array<double,2> gamma;
+    /// Working arrays
+    blitz::Array<double,1> tmp_d_1;
+    blitz::Array<double,1> tmp_d_2;
+    blitz::Array<double,1> tmp_nf_1;
+    blitz::Array<double,1> tmp_nf_2;
+    blitz::Array<double,2> tmp_nf_nf_1;
+};
+
 /**
  * @brief This class is a container for the \f$F\f$, \f$G\f$ and \f$\Sigma\f$
  * matrices and the mean vector \f$\mu\f$ of a PLDA model. This also 
@@ -346,6 +385,13 @@ class PLDABase
      * \f$\gamma_a = (Id + a F^T \beta F)^{-1}\f$
      */
     void computeGamma(const size_t a, blitz::Array<double,2> res) const;
+    /**
+     * @brief Computes the \f$\gamma_a\f$ matrix for a given \f$a\f$ (number
+     * of samples) and put the result in the provided array, using the
+     * provided working array of size dim_f x dim_f (thread-safe).
+     */
+    void computeGamma(const size_t a, blitz::Array<double,2>& res,
+      blitz::Array<double,2>& tmp_nf_nf) const;
     /**
      * @brief Tells if the \f$\gamma_a\f$ matrix for a given a (number of 
      * samples) exists.
@@ -358,6 +404,14 @@ class PLDABase
      * @brief Clears the maps (\f$\gamma_a\f$ and loglike_constterm_a).
      */
     void clearMaps();
+    /**
+     * @brief Computes in parallel (see bob::core::setNThreads()) and caches
+     * the \f$\gamma_a\f$ matrices and the log likelihood constant terms
+     * for all the given \f$a\f$ (numbers of samples) which are not already
+     * cached.
+     * @warning precomputeLogLike() should have been called before.
+     */
+    void precomputeGammaLogLike(const std::vector<size_t>& a);
 
     /**
      * @brief Gets the log-likelihood of an observation, given the current model
@@ -403,7 +457,12 @@ class PLDABase
      * @brief \f$\beta = (\Sigma+G G^T)^{-1} = (\Sigma^{-1} - \Sigma^{-1} G \alpha G^T \Sigma^{-1})^{-1}\f$
      */
     blitz::Array<double,2> m_cache_beta;
-    std::map<size_t, blitz::Array<double,2> > m_cache_gamma; ///< \f$\gamma_{a} = (Id + a F^T \beta F)^{-1}\f$
+    /**
+     * @brief \f$\gamma_{a} = (Id + a F^T \beta F)^{-1}\f$, indexed by the
+     * numbers of samples \f$a\f$ met at enrollment/scoring time, which are
+     * sparse and not known beforehand (unlike in PLDATrainer).
+     */
+    std::map<size_t, blitz::Array<double,2> > m_cache_gamma;
     blitz::Array<double,2> m_cache_Ft_beta; ///< \f$F^{T} \beta \f$
     blitz::Array<double,2> m_cache_Gt_isigma; ///< \f$G^{T} \Sigma^{-1} \f$
     double m_cache_logdet_alpha; ///< \f$\log(\det(\alpha))\f$
@@ -433,6 +492,12 @@ class PLDABase
     void precomputeLogDetAlpha();
     void precomputeLogDetSigma();
     void precomputeLogLikeConstTerm(const size_t a);
+    void computeGammaLogLike(const std::vector<size_t>& a,
+      const std::vector<bool>& compute_gamma,
+      const std::vector<blitz::Array<double,2>*>& gamma,
+      std::vector<double>& constterm,
+      std::vector<blitz::Array<double,2> >& tmp_nf_nf,
+      size_t begin, size_t end, size_t thread) const;
 };
 
 
@@ -663,6 +728,33 @@ class PLDAMachine: public Machine<blitz::Array<double,1>, double>
     void forward_(const blitz::Array<double,1>& sample, double& score) const;
     void forward(const blitz::Array<double,2>& samples, double& score) const;
 
+    /**
+     * @brief Compute the log-likelihood of the given sample and (optionally)
+     * the enrolled samples, using the scratch arrays of the given workspace.
+     * This method does not modify the machine nor its PLDABase, and may be
+     * called concurrently by several threads, provided that each of them
+     * uses its own workspace.
+     */
+    double computeLogLikelihood(const blitz::Array<double,1>& sample,
+      bool with_enrolled_samples, PLDAMachineWorkspace& ws) const;
+    /**
+     * @brief Compute the log-likelihood of the given samples and (optionally)
+     * the enrolled samples, using the scratch arrays of the given workspace.
+     * @see computeLogLikelihood(const blitz::Array<double,1>&, bool, PLDAMachineWorkspace&)
+     */
+    double computeLogLikelihood(const blitz::Array<double,2>& samples,
+      bool with_enrolled_samples, PLDAMachineWorkspace& ws) const;
+
+    /**
+     * @brief Computes a log likelihood ratio from a 1D or 2D blitz::Array,
+     * using the scratch arrays of the given workspace (thread-safe as long
+     * as each thread uses its own workspace)
+     */
+    void forward(const blitz::Array<double,1>& sample, double& score,
+      PLDAMachineWorkspace& ws) const;
+    void forward(const blitz::Array<double,2>& samples, double& score,
+      PLDAMachineWorkspace& ws) const;
+
 
   private:
     /**
@@ -713,6 +805,12 @@ class PLDAMachine: public Machine<blitz::Array<double,1>, double>
      * @brief Resize working arrays
      */
     void resizeTmp();
+    /**
+     * @brief Adds the \f$\gamma_a\f$ dependent terms to the log-likelihood
+     * terma, given the weighted sum of the samples stored in ws.tmp_nf_1
+     */
+    double finalizeLogLikelihood(const size_t n_samples, const double terma,
+      PLDAMachineWorkspace& ws) const;
 };
 
 /**
@@ -25,7 +25,6 @@
 
 #include <svm.h>
 #include <boost/shared_ptr.hpp>
-#include <boost/shared_array.hpp>
 #include <blitz/array.h>
 #include <fstream>
 #include <bob/io/HDF5File.h>
@@ -316,6 +315,11 @@ namespace bob { namespace machine {
       /**
        * Predicts class and scores output for each class on this SVM,
        *
+       * The scores are the decision values of libsvm, in its order (class 0
+       * vs. 1, 0 vs. 2, ...). A classifier of N classes has N*(N-1)/2 of
+       * them, but only the first outputSize() are returned, which drops
+       * some when N > 3.
+       *
        * Note: The output array must be lying on contiguous memory. This is
        * also checked.
        */
@@ -330,6 +334,38 @@ namespace bob { namespace machine {
         (const blitz::Array<double,1>& input,
          blitz::Array<double,1>& scores) const;
 
+      /**
+       * Predicts the classes of several inputs, given as the rows of a 2D
+       * array. The rows are processed in parallel by the bob::core threads.
+       * The labels are the same as the ones of predictClass() called on
+       * each row.
+       */
+      void predictClass(const blitz::Array<double,2>& input,
+        blitz::Array<int,1>& labels) const;
+
+      /**
+       * Predicts the classes of several inputs. Same as above, but does not
+       * check
+       */
+      void predictClass_(const blitz::Array<double,2>& input,
+        blitz::Array<int,1>& labels) const;
+
+      /**
+       * Predicts the classes and scores of several inputs, given as the rows
+       * of a 2D array. The i-th row of "scores" receives the scores of the
+       * i-th input. The rows are processed in parallel by the bob::core
+       * threads.
+       */
+      void predictClassAndScores(const blitz::Array<double,2>& input,
+        blitz::Array<int,1>& labels, blitz::Array<double,2>& scores) const;
+
+      /**
+       * Predicts the classes and scores of several inputs. Same as above,
+       * but does not check
+       */
+      void predictClassAndScores_(const blitz::Array<double,2>& input,
+        blitz::Array<int,1>& labels, blitz::Array<double,2>& scores) const;
+
       /**
        * Predict, output class and probabilities for each class on this SVM,
        * but only if the model supports it. Otherwise, throws a run-time
@@ -377,14 +413,76 @@ namespace bob { namespace machine {
        */
       void reset();
 
+      /**
+       * Packs the support vectors and the coefficients of the decision
+       * functions of the libsvm model in contiguous arrays, which are used
+       * for prediction instead of the libsvm linked lists
+       */
+      void packModel();
+
+      /**
+       * Scales the input and stores it, densely, in x
+       */
+      void scaleInput(const blitz::Array<double,1>& input, double* x) const;
+
+      /**
+       * Scales the given row of a 2D input and stores it, densely, in x
+       */
+      void scaleInput(const blitz::Array<double,2>& input, const int row,
+        double* x) const;
+
+      /**
+       * Computes the kernel values between the n (scaled) inputs stored in
+       * the rows of x and all the support vectors. Each kernel value is
+       * computed with the same operations, in the same order, as libsvm's
+       * k_function(), such that the results are identical.
+       */
+      void kernelValues(const double* x, const int n, double* kvalue) const;
+
+      /**
+       * Computes the decision values of one input from its kernel values,
+       * as libsvm's svm_predict_values() does. Returns the predicted label
+       * (or the regression output)
+       */
+      double decide(const double* kvalue, double* dec) const;
+
+      /**
+       * Computes the decision values of one input with the collapsed linear
+       * model. Returns false if a decision value is too close to 0 for its
+       * sign to be trusted, in which case the kernel path should be used.
+       */
+      bool decideLinear(const double* x, double* dec, double& retval) const;
+
+      /**
+       * Predicts the label (or the regression output) of one scaled input
+       * x, and stores its decision values in dec. kvalue is a buffer for
+       * the kernel values.
+       */
+      double predict(const double* x, double* kvalue, double* dec) const;
+
+      /**
+       * Predicts the rows [begin,end[ of the input (parallel body)
+       */
+      void predictRows(const blitz::Array<double,2>& input,
+        blitz::Array<int,1>& labels, blitz::Array<double,2>& scores,
+        const bool with_scores, size_t begin, size_t end,
+        size_t thread_idx) const;
+
     private: //representation
 
       boost::shared_ptr<svm_model> m_model; ///< libsvm model pointer
-      mutable boost::shared_array<svm_node> m_input_cache; ///< cache
       size_t m_input_size; ///< vector size expected as input for the SVM's
       blitz::Array<double,1> m_input_sub; ///< scaling: subtraction
       blitz::Array<double,1> m_input_div; ///< scaling: division
 
+      // Packed model
+      size_t m_n_decisions; ///< number of decision functions
+      size_t m_n_scores; ///< number of decision values kept as scores
+      blitz::Array<double,2> m_sv; ///< support vectors (one per row)
+      blitz::Array<int,1> m_sv_start; ///< first SV of each class
+      blitz::Array<double,2> m_linear_weights; ///< collapsed linear model
+      blitz::Array<double,1> m_linear_bound; ///< magnitude of the terms
+
   };
 
   /**
@@ -23,6 +23,9 @@
 #define BOB_MACHINE_ZTNORM_H
 
 #include <blitz/array.h>
+#include <bob/io/HDF5File.h>
+#include <string>
+#include <vector>
 
 namespace bob { namespace machine {
 /**
@@ -101,6 +104,206 @@ void zNorm(const blitz::Array<double,2>& rawscores_probes_vs_models,
            const blitz::Array<double,2>& rawscores_zprobes_vs_models,
            blitz::Array<double,2>& normalizedscores);
 
+/**
+ * @brief Z-, T-, ZT- and (adaptive) symmetric normalization of scores, from
+ * cohort statistics accumulated over blocks of cohort scores.
+ *
+ * The cohort scores are streamed (e.g. from HDF5 files) rather than held in
+ * memory: the mean and standard deviation of the scores of each model
+ * (Z-norm) and of each probe (T-norm) are accumulated in a single pass with
+ * Welford's algorithm, such that the memory only depends on the number of
+ * models, probes and T-norm models. The raw scores are then normalized by
+ * tiles, in parallel (see bob::core::setNThreads()).
+ *
+ * The statistics are accumulated from:
+ *  - the scores of the models against the Z-norm probes (Z-norm), by blocks
+ *    of rows (models) and of columns (Z-norm probes)
+ *  - the scores of the T-norm models against the Z-norm probes (ZT-norm,
+ *    optional), by blocks of rows (T-norm models) and of columns (Z-norm
+ *    probes). When present, the T-norm scores are Z-normalized with these
+ *    statistics before being accumulated, as done by ztNorm().
+ *  - the scores of the T-norm models against the probes (T-norm), by blocks
+ *    of rows (T-norm models) and of columns (probes). When ZT-norm is used,
+ *    these must be accumulated last.
+ *
+ * If top_n is non zero, adaptive cohort selection is used: the Z-norm
+ * (resp. T-norm) statistics of a model (resp. probe) are computed from its
+ * top_n highest cohort scores only, which are kept in bounded heaps. This is
+ * typically combined with symmetricNormalize() (AS-norm).
+ */
+class ZTNormalizer
+{
+  public:
+    /**
+     * @brief Constructor, for n_models models and n_probes probes
+     * @param top_n If non zero, only the top_n highest cohort scores of each
+     * model and probe are used for its statistics
+     */
+    ZTNormalizer(const size_t n_models, const size_t n_probes,
+      const size_t top_n=0);
+
+    /**
+     * @brief Returns the number of models
+     */
+    size_t getNModels() const { return m_n_models; }
+
+    /**
+     * @brief Returns the number of probes
+     */
+    size_t getNProbes() const { return m_n_probes; }
+
+    /**
+     * @brief Returns the size of the adaptive cohorts (0 if disabled)
+     */
+    size_t getTopN() const { return m_top_n; }
+
+    /**
+     * @brief Forgets all the accumulated statistics
+     */
+    void reset();
+
+    /**
+     * @brief Accumulates the scores of the models [first_model,
+     * first_model+scores.extent(0)[ against some Z-norm probes
+     */
+    void accumulateZNorm(const blitz::Array<double,2>& scores,
+      const size_t first_model=0);
+
+    /**
+     * @brief Accumulates the scores of the T-norm models [first_tmodel,
+     * first_tmodel+scores.extent(0)[ against some Z-norm probes
+     */
+    void accumulateZTNorm(const blitz::Array<double,2>& scores,
+      const size_t first_tmodel=0);
+
+    /**
+     * @brief Accumulates the scores of the T-norm models [first_tmodel,
+     * first_tmodel+scores.extent(0)[ against some Z-norm probes, skipping
+     * the true trials given by the mask. As with ztNorm(), a T-norm model
+     * whose scores are all masked has a NaN mean, which makes all the
+     * ZT-normalized scores NaN.
+     */
+    void accumulateZTNorm(const blitz::Array<double,2>& scores,
+      const blitz::Array<bool,2>& mask_istruetrial,
+      const size_t first_tmodel=0);
+
+    /**
+     * @brief Accumulates the scores of the T-norm models [first_tmodel,
+     * first_tmodel+scores.extent(0)[ against the probes [first_probe,
+     * first_probe+scores.extent(1)[
+     */
+    void accumulateTNorm(const blitz::Array<double,2>& scores,
+      const size_t first_tmodel=0, const size_t first_probe=0);
+
+    /**
+     * @brief Accumulates the scores of the models (Z-norm), of the T-norm
+     * models against the Z-norm probes (ZT-norm) or of the T-norm models
+     * against the probes (T-norm) from a dataset of an HDF5 file, which
+     * contains one array of scores per (T-norm) model, as written by
+     * linearScoring(). The dataset is read by blocks of rows.
+     */
+    void accumulateZNorm(bob::io::HDF5File& file, const std::string& path);
+    void accumulateZTNorm(bob::io::HDF5File& file, const std::string& path);
+    void accumulateTNorm(bob::io::HDF5File& file, const std::string& path);
+
+    /**
+     * @brief Normalizes the raw scores of the models [first_model,
+     * first_model+scores.extent(0)[ against the probes [first_probe,
+     * first_probe+scores.extent(1)[ with the statistics accumulated so far
+     * (Z-norm, T-norm or ZT-norm, depending on the accumulated statistics)
+     * @warning The destination array should have the same size as scores
+     */
+    void normalize(const blitz::Array<double,2>& scores,
+      const size_t first_model, const size_t first_probe,
+      blitz::Array<double,2>& normalized);
+
+    /**
+     * @brief Normalizes the raw scores with the symmetric normalization
+     * (S-norm, or AS-norm if top_n is non zero), which averages the
+     * Z-normalized and the T-normalized scores. Both Z-norm and T-norm
+     * statistics are required.
+     * @warning The destination array should have the same size as scores
+     */
+    void symmetricNormalize(const blitz::Array<double,2>& scores,
+      const size_t first_model, const size_t first_probe,
+      blitz::Array<double,2>& normalized);
+
+    /**
+     * @brief Normalizes the raw scores stored in a dataset of an HDF5 file
+     * (one array of scores per model), and appends the normalized scores to
+     * a dataset of another file, by blocks of rows
+     */
+    void normalize(bob::io::HDF5File& input_file,
+      const std::string& input_path, bob::io::HDF5File& output_file,
+      const std::string& output_path, const bool symmetric=false);
+
+  private:
+    /**
+     * @brief Statistics of a set of (cohort) score distributions, either
+     * running means and sums of squared deviations (Welford), or the top_n
+     * highest scores of each distribution
+     */
+    struct Statistics
+    {
+      void resize(const size_t n, const size_t top_n);
+      void add(const size_t i, const double score);
+      void get(blitz::Array<double,1>& mean, blitz::Array<double,1>& std) const;
+      double mean(const size_t i) const;
+      double std(const size_t i) const;
+
+      std::vector<double> count;
+      std::vector<double> running_mean;
+      std::vector<double> m2;
+      size_t top_n;
+      std::vector<std::vector<double> > best;
+    };
+
+    /**
+     * @brief Computes the means and standard deviations from the statistics
+     */
+    void updateStatistics();
+
+    /**
+     * @brief Parallel bodies of the accumulation and of the normalization
+     */
+    void accumulateZRows(const blitz::Array<double,2>& scores,
+      const size_t first_model, size_t begin, size_t end, size_t);
+    void accumulateZTRows(const blitz::Array<double,2>& scores,
+      const blitz::Array<bool,2>* mask, const size_t first_tmodel,
+      size_t begin, size_t end, size_t);
+    void accumulateTColumns(const blitz::Array<double,2>& scores,
+      const size_t first_tmodel, const size_t first_probe,
+      size_t begin, size_t end, size_t);
+    void normalizeRows(const blitz::Array<double,2>& scores,
+      const size_t first_model, const size_t first_probe,
+      const bool symmetric, blitz::Array<double,2>& normalized,
+      size_t begin, size_t end, size_t) const;
+
+    void normalize(const blitz::Array<double,2>& scores,
+      const size_t first_model, const size_t first_probe,
+      const bool symmetric, blitz::Array<double,2>& normalized);
+
+    size_t m_n_models;
+    size_t m_n_probes;
+    size_t m_top_n;
+
+    // Statistics of the models (Z-norm), of the T-norm models (ZT-norm) and
+    // of the probes (T-norm)
+    Statistics m_z;
+    Statistics m_zt;
+    Statistics m_t;
+    bool m_has_z;
+    bool m_has_zt;
+    bool m_has_t;
+
+    // Means and standard deviations computed from the statistics
+    bool m_updated;
+    blitz::Array<double,1> m_z_mean;
+    blitz::Array<double,1> m_z_std;
+    blitz::Array<double,1> m_t_mean;
+    blitz::Array<double,1> m_t_std;
+};
+
 /**
  * @}
  */
@@ -62,6 +62,27 @@ namespace math {
       C = blitz::sum(A(i,k) * B(k,j), k);
     }
 
+  /**
+   * @brief Performs the matrix multiplication C=A*B for double precision
+   * arrays.
+   *
+   * This overload is picked instead of the generic expression template. It
+   * dispatches to BLAS (dgemm) for large operands whose memory layout BLAS
+   * can handle (C- or Fortran-ordered, possibly with a leading dimension),
+   * and to a built-in cache-blocked kernel otherwise. Overlapping input and
+   * output arrays are supported.
+   *
+   * @warning No checks are performed on the array sizes and is recommended
+   * only in scenarios where you have previously checked conformity and is
+   * focused only on speed.
+   *
+   * @param A The A matrix (left element of the multiplication) (size MxN)
+   * @param B The B matrix (right element of the multiplication) (size NxP)
+   * @param C The resulting matrix (size MxP)
+   */
+  void prod_(const blitz::Array<double,2>& A, const blitz::Array<double,2>& B,
+      blitz::Array<double,2>& C);
+
   /**
    * @brief Performs the matrix multiplication C=A*B
    *
@@ -108,6 +129,22 @@ namespace math {
       c = blitz::sum(A(i,j) * b(j), j);
     }
 
+  /**
+   * @brief Performs the matrix-vector multiplication c=A*b for double
+   * precision arrays, using BLAS (dgemv) for large operands and a built-in
+   * kernel otherwise.
+   *
+   * @warning No checks are performed on the array sizes and is recommended
+   * only in scenarios where you have previously checked conformity and is
+   * focused only on speed.
+   *
+   * @param A The A matrix (left element of the multiplication) (size MxN)
+   * @param b The b vector (right element of the multiplication) (size N)
+   * @param c The resulting vector (size M)
+   */
+  void prod_(const blitz::Array<double,2>& A, const blitz::Array<double,1>& b,
+      blitz::Array<double,1>& c);
+
   /**
    * @brief Performs the matrix-vector multiplication c=A*b
    *
@@ -153,6 +190,22 @@ namespace math {
       c = blitz::sum(a(j) * B(j,i), j);
     }
 
+  /**
+   * @brief Performs the vector-matrix multiplication c=a*B for double
+   * precision arrays, using BLAS (dgemv) for large operands and a built-in
+   * kernel otherwise.
+   *
+   * @warning No checks are performed on the array sizes and is recommended
+   * only in scenarios where you have previously checked conformity and is
+   * focused only on speed.
+   *
+   * @param a The a vector (left element of the multiplication) (size M)
+   * @param B The B matrix (right element of the multiplication) (size MxN)
+   * @param c The resulting vector (size N)
+   */
+  void prod_(const blitz::Array<double,1>& a, const blitz::Array<double,2>& B,
+      blitz::Array<double,1>& c);
+
   /**
    * @brief Performs the vector-matrix multiplication c=a*B
    *
@@ -179,6 +232,38 @@ namespace math {
       prod_(a, B, c);
     }
 
+  namespace detail {
+    /**
+     * @brief Computes C=A*B with BLAS (dgemm), if the memory layout of the
+     * three arrays is supported by BLAS. Returns false (and leaves C
+     * untouched) otherwise. C must not overlap A or B.
+     */
+    bool prodBlas_(const blitz::Array<double,2>& A,
+        const blitz::Array<double,2>& B, blitz::Array<double,2>& C);
+
+    /**
+     * @brief Computes C=A*B with the built-in cache-blocked kernel, which
+     * supports any strides. C must not overlap A or B.
+     */
+    void prodBlocked_(const blitz::Array<double,2>& A,
+        const blitz::Array<double,2>& B, blitz::Array<double,2>& C);
+
+    /**
+     * @brief Computes c=A*b with BLAS (dgemv), if the memory layout of the
+     * arrays is supported by BLAS. Returns false (and leaves c untouched)
+     * otherwise. c must not overlap A or b.
+     */
+    bool prodBlas_(const blitz::Array<double,2>& A,
+        const blitz::Array<double,1>& b, blitz::Array<double,1>& c);
+
+    /**
+     * @brief Computes c=A*b with the built-in kernel, which supports any
+     * strides. c must not overlap A or b.
+     */
+    void prodBlocked_(const blitz::Array<double,2>& A,
+        const blitz::Array<double,1>& b, blitz::Array<double,1>& c);
+  }
+
   /**
    * @brief Performs the outer product between two vectors generating a matrix.
    *
@@ -68,6 +68,64 @@ namespace bob { namespace measure {
   std::pair<double, double> farfrr(const blitz::Array<double,1>& negatives,
       const blitz::Array<double,1>& positives, double threshold);
 
+  /**
+   * Holds the negative and positive scores sorted in ascending order. Once
+   * sorted, the number of errors at any threshold is found with a binary
+   * search instead of a scan of all the scores, such that the curves and
+   * thresholds below cost O(points x log(N)) after a single O(N x log(N))
+   * sort. The same object may be reused for several curves/thresholds.
+   *
+   * Large score sets are sorted in parallel with the bob::core thread pool.
+   */
+  class SortedScores {
+
+    public:
+
+      /**
+       * Copies and sorts the given scores. NaN scores are left out of the
+       * sorted scores, but are still counted in the totals of farfrr() and
+       * precision_recall(). As no comparison with a NaN holds, they are
+       * neither false accepts nor false rejects, as in farfrr() on the
+       * unsorted scores.
+       */
+      SortedScores(const blitz::Array<double,1>& negatives,
+          const blitz::Array<double,1>& positives);
+
+      /**
+       * The sorted negative and positive scores, without the NaN scores
+       */
+      const std::vector<double>& getNegatives() const { return m_negatives; }
+      const std::vector<double>& getPositives() const { return m_positives; }
+
+      /**
+       * The minimum and maximum scores over the negatives and positives.
+       * Empty sets are ignored, as done by blitz::min() and blitz::max().
+       */
+      double getMin() const;
+      double getMax() const;
+
+      /**
+       * The number of negatives that are greater or equal to the threshold
+       * (false accepts), and of positives that are strictly lower (false
+       * rejects), as in farfrr().
+       */
+      size_t falseAccepts(double threshold) const;
+      size_t falseRejects(double threshold) const;
+
+      /**
+       * Same as farfrr() and precision_recall() on the unsorted scores
+       */
+      std::pair<double, double> farfrr(double threshold) const;
+      std::pair<double, double> precision_recall(double threshold) const;
+
+    private:
+
+      size_t m_total_negatives; ///< number of negatives, including NaNs
+      size_t m_total_positives; ///< number of positives, including NaNs
+      std::vector<double> m_negatives;
+      std::vector<double> m_positives;
+  };
+
   /**
    * Calculates the precision and recall (sensitiveness) values given positive and negative
    * scores and a threshold. 'positives' holds the score information for
@@ -126,9 +184,8 @@ namespace bob { namespace measure {
    * supposed to be used through that method.
    */
   template <typename T>
-  static double recursive_minimization(const blitz::Array<double,1>& negatives,
-      const blitz::Array<double,1>& positives, T& predicate,
-      double min, double max, size_t steps) {
+  static double recursive_minimization(const SortedScores& scores,
+      T& predicate, double min, double max, size_t steps) {
     static const double QUIT_THRESHOLD = 1e-10;
     const double diff = max - min;
     const double too_small = std::abs(diff/max);
@@ -147,8 +204,7 @@ namespace bob { namespace measure {
     for (size_t i=0; i<steps; ++i) {
       double threshold = ((double)i * step_size) + min;
 
-      std::pair<double, double> ratios =
-        farfrr(negatives, positives, threshold);
+      std::pair<double, double> ratios = scores.farfrr(threshold);
 
       double current_cost = predicate(ratios.first, ratios.second);
 
@@ -166,7 +222,7 @@ namespace bob { namespace measure {
     //we stop when it doesn't matter anymore to threshold.
     if (accumulator.size() != steps) {
       //still needs some refinement: pick-up the middle of the range and go
-      return recursive_minimization(negatives, positives, predicate,
+      return recursive_minimization(scores, predicate,
           accumulator[accumulator.size()/2]-step_size,
           accumulator[accumulator.size()/2]+step_size,
           steps);
@@ -204,15 +260,21 @@ namespace bob { namespace measure {
    * The procedure continues until all calculated predicates in a given round
    * give the same minimum. At this point, the center threshold is picked up and
    * returned.
+   *
+   * The scores are sorted once, such that each of the evaluated thresholds
+   * only costs a binary search.
    */
+  template <typename T> double
+    minimizingThreshold(const SortedScores& scores, T& predicate) {
+      const size_t N = 100; ///< number of steps in each iteration
+      return recursive_minimization(scores, predicate, scores.getMin(),
+          scores.getMax(), N);
+    }
+
   template <typename T> double
     minimizingThreshold(const blitz::Array<double,1>& negatives,
         const blitz::Array<double,1>& positives, T& predicate) {
-      const size_t N = 100; ///< number of steps in each iteration
-      double min = std::min(blitz::min(negatives), blitz::min(positives));
-      double max = std::max(blitz::max(negatives), blitz::max(positives));
-      return recursive_minimization(negatives, positives, predicate, min,
-          max, N);
+      return minimizingThreshold(SortedScores(negatives, positives), predicate);
     }
 
   /**
@@ -223,6 +285,7 @@ namespace bob { namespace measure {
    */
   double eerThreshold(const blitz::Array<double,1>& negatives,
       const blitz::Array<double,1>& positives);
+  double eerThreshold(const SortedScores& scores);
 
   /**
    * Calculates the equal-error-rate (EER) given the input data, on the ROC 
@@ -247,6 +310,8 @@ namespace bob { namespace measure {
    */
   double minWeightedErrorRateThreshold(const blitz::Array<double,1>& negatives,
       const blitz::Array<double,1>& positives, double cost);
+  double minWeightedErrorRateThreshold(const SortedScores& scores,
+      double cost);
 
   /**
    * Calculates the minWeightedErrorRateThreshold() when the cost is 0.5.
@@ -255,6 +320,9 @@ namespace bob { namespace measure {
       const blitz::Array<double,1>& positives) {
     return minWeightedErrorRateThreshold(negatives, positives, 0.5);
   }
+  inline double minHterThreshold(const SortedScores& scores) {
+    return minWeightedErrorRateThreshold(scores, 0.5);
+  }
 
   /**
    * Computes the threshold such that the real FAR is as close as possible
@@ -268,6 +336,7 @@ namespace bob { namespace measure {
    */
   double farThreshold(const blitz::Array<double,1>& negatives,
       const blitz::Array<double,1>& positives, double far_value);
+  double farThreshold(const SortedScores& scores, double far_value);
 
   /**
    * Computes the threshold such that the real FRR is as close as possible
@@ -281,6 +350,7 @@ namespace bob { namespace measure {
    */
   double frrThreshold(const blitz::Array<double,1>& negatives,
       const blitz::Array<double,1>& positives, double frr_value);
+  double frrThreshold(const SortedScores& scores, double frr_value);
 
   /**
    * Calculates the ROC curve given a set of positive and negative scores and a
@@ -293,6 +363,7 @@ namespace bob { namespace measure {
   blitz::Array<double,2> roc
     (const blitz::Array<double,1>& negatives,
      const blitz::Array<double,1>& positives, size_t points);
+  blitz::Array<double,2> roc(const SortedScores& scores, size_t points);
      
   /**
    * Calculates the precision-recall curve given a set of positive and negative scores and a
@@ -305,6 +376,8 @@ namespace bob { namespace measure {
   blitz::Array<double,2> precision_recall_curve
     (const blitz::Array<double,1>& negatives,
      const blitz::Array<double,1>& positives, size_t points);
+  blitz::Array<double,2> precision_recall_curve(const SortedScores& scores,
+      size_t points);
 
   /**
    * Calculates the ROC Convex Hull (ROCCH) given a set of positive and 
@@ -339,6 +412,8 @@ namespace bob { namespace measure {
       const blitz::Array<double,1>& negatives,
       const blitz::Array<double,1>& positives,
       const blitz::Array<double,1>& far_list);
+  blitz::Array<double,2> roc_for_far(const SortedScores& scores,
+      const blitz::Array<double,1>& far_list);
 
   /**
    * Returns the Deviate Scale equivalent of a false rejection/acceptance
@@ -373,6 +448,7 @@ namespace bob { namespace measure {
   blitz::Array<double,2> det
     (const blitz::Array<double,1>& negatives,
      const blitz::Array<double,1>& positives, size_t points);
+  blitz::Array<double,2> det(const SortedScores& scores, size_t points);
 
   /**
    * Calculates the EPC curve given a set of positive and negative scores and a
@@ -399,6 +475,8 @@ namespace bob { namespace measure {
      const blitz::Array<double,1>& test_negatives,
      const blitz::Array<double,1>& test_positives,
      size_t points);
+  blitz::Array<double,2> epc(const SortedScores& dev_scores,
+      const SortedScores& test_scores, size_t points);
 
 }}
 
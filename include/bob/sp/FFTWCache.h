@@ -0,0 +1,139 @@
+/**
+ * @file bob/sp/FFTWCache.h
+ * @date Sat Oct 17 10:12:31 CEST 2026
+ * @author Laurent El Shafey <Laurent.El-Shafey@idiap.ch>
+ *
+ * @brief Process-wide cache of FFTW plans shared by the FFT/DCT classes,
+ * together with the planner configuration and wisdom management.
+ *
+ * Copyright (C) 2011-2013 Idiap Research Institute, Martigny, Switzerland
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef BOB_SP_FFTWCACHE_H
+#define BOB_SP_FFTWCACHE_H
+
+#include <string>
+#include <cstddef>
+#include <fftw3.h>
+
+namespace bob { namespace sp {
+/**
+ * @ingroup SP
+ * @{
+ */
+
+/**
+ * @brief Rigor used by the FFTW planner when a plan is first created.
+ * ESTIMATE is cheap but may give slower transforms, while MEASURE, PATIENT
+ * and EXHAUSTIVE time several candidate algorithms before picking one.
+ * Combined with wisdom import/export, the expensive rigors only have to be
+ * paid once per machine.
+ */
+typedef enum {
+  PLANNER_ESTIMATE = 0,
+  PLANNER_MEASURE,
+  PLANNER_PATIENT,
+  PLANNER_EXHAUSTIVE
+} PlannerRigor;
+
+/**
+ * @brief Sets the rigor used for plans that are created from now on.
+ * Plans already in the cache are kept, as the rigor is part of the key.
+ */
+void setPlannerRigor(const PlannerRigor rigor);
+
+/**
+ * @brief Gets the rigor used for plans that are created from now on.
+ */
+PlannerRigor getPlannerRigor();
+
+/**
+ * @brief Imports FFTW wisdom from the given file. Subsequent plans created
+ * with a matching rigor are then obtained without any measurement.
+ * @return true if the wisdom could be successfully imported
+ */
+bool importWisdom(const std::string& filename);
+
+/**
+ * @brief Exports the FFTW wisdom accumulated so far to the given file.
+ * @warning Throws a std::runtime_error if the file cannot be written.
+ */
+void exportWisdom(const std::string& filename);
+
+/**
+ * @brief Forgets the FFTW wisdom accumulated so far.
+ */
+void forgetWisdom();
+
+/**
+ * @brief Destroys all the cached plans.
+ * @warning This must not be called while a transform is being computed by
+ * another thread.
+ */
+void clearPlanCache();
+
+/**
+ * @brief Returns the number of plans currently held by the cache.
+ */
+size_t getPlanCacheSize();
+
+namespace detail {
+
+/**
+ * @brief Returns a cached plan for a complex-to-complex transform of the
+ * given rank and shape (sign is FFTW_FORWARD or FFTW_BACKWARD). The plan
+ * is compatible with the given arrays, and must be run with
+ * fftw_execute_dft(). It is owned by the cache and must not be destroyed.
+ */
+fftw_plan planDFT(const int rank, const int* n, const int sign,
+  fftw_complex* in, fftw_complex* out);
+
+/**
+ * @brief Returns a cached plan for a real-to-real transform of the given
+ * rank, shape and kinds (one per dimension). The plan is compatible with
+ * the given arrays, and must be run with fftw_execute_r2r(). It is owned
+ * by the cache and must not be destroyed.
+ */
+fftw_plan planR2R(const int rank, const int* n, const fftw_r2r_kind* kind,
+  double* in, double* out);
+
+/**
+ * @brief Returns a cached plan for a real-to-complex transform of the given
+ * rank and (real) shape. The complex output has n[rank-1]/2+1 elements
+ * along the last dimension. The plan is compatible with the given arrays,
+ * and must be run with fftw_execute_dft_r2c(). It is owned by the cache
+ * and must not be destroyed.
+ */
+fftw_plan planR2C(const int rank, const int* n, double* in,
+  fftw_complex* out);
+
+/**
+ * @brief Returns a cached plan for a complex-to-real transform of the given
+ * rank and (real) shape. Out-of-place plans of rank 1 preserve their input,
+ * which is overwritten otherwise. The plan is compatible
+ * with the given arrays, and must be run with fftw_execute_dft_c2r(). It is
+ * owned by the cache and must not be destroyed.
+ */
+fftw_plan planC2R(const int rank, const int* n, fftw_complex* in,
+  double* out);
+
+}
+
+/**
+ * @}
+ */
+}}
+
+#endif /* BOB_SP_FFTWCACHE_H */
@@ -0,0 +1,178 @@
+/**
+ * @file bob/sp/RFFT1D.h
+ * @date Sat Oct 17 17:04:31 CEST 2026
+ * @author Laurent El Shafey <Laurent.El-Shafey@idiap.ch>
+ *
+ * @brief Implement a blitz-based 1D Fast Fourier Transform of real signals
+ * using FFTW functions
+ *
+ * Copyright (C) 2011-2013 Idiap Research Institute, Martigny, Switzerland
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef BOB_SP_RFFT1D_H
+#define BOB_SP_RFFT1D_H
+
+#include <complex>
+#include <blitz/array.h>
+
+namespace bob { namespace sp {
+/**
+ * @ingroup SP
+ * @{
+ */
+
+/**
+ * @brief This class implements a 1D Discrete Fourier Transform of real
+ * signals based on the FFTW library. The Fourier transform of a real signal
+ * of length N is Hermitian symmetric, and is therefore represented by its
+ * N/2+1 first coefficients only. It is used as a base class for the RFFT1D
+ * and IRFFT1D classes.
+ */
+class RFFT1DAbstract
+{
+  public:
+    /**
+     * @brief Constructor: Initialize working array
+     */
+    RFFT1DAbstract(const size_t length);
+
+    /**
+     * @brief Copy constructor
+     */
+    RFFT1DAbstract(const RFFT1DAbstract& other);
+
+    /**
+     * @brief Destructor
+     */
+    virtual ~RFFT1DAbstract();
+
+    /**
+     * @brief Assignment operator
+     */
+    RFFT1DAbstract& operator=(const RFFT1DAbstract& other);
+
+    /**
+     * @brief Equal operator
+     */
+    bool operator==(const RFFT1DAbstract& other) const;
+
+    /**
+     * @brief Not equal operator
+     */
+    bool operator!=(const RFFT1DAbstract& other) const;
+
+    /**
+     * @brief Reset the RFFT1D object for the given 1D shape
+     */
+    void reset(const size_t length);
+
+    /**
+     * @brief Getters
+     */
+    size_t getLength() const { return m_length; }
+    /**
+     * @brief Returns the number of complex coefficients (length/2+1)
+     */
+    size_t getComplexLength() const { return m_length/2+1; }
+    /**
+     * @brief Setters
+     */
+    void setLength(const size_t length);
+
+  protected:
+    /**
+     * Private attributes
+     */
+    size_t m_length;
+};
+
+
+/**
+ * @brief This class implements a direct 1D Discrete Fourier Transform of
+ * real signals based on the FFTW library. The output contains the
+ * length/2+1 first coefficients of the transform.
+ */
+class RFFT1D: public RFFT1DAbstract
+{
+  public:
+    /**
+     * @brief Constructor
+     */
+    RFFT1D();
+
+    /**
+     * @brief Constructor: Initialize working arrays
+     */
+    RFFT1D(const size_t length);
+
+    /**
+     * @brief Copy constructor
+     */
+    RFFT1D(const RFFT1D& other);
+
+    /**
+     * @brief Destructor
+     */
+    virtual ~RFFT1D();
+
+    /**
+     * @brief process an array by applying the direct FFT
+     */
+    void operator()(const blitz::Array<double,1>& src,
+      blitz::Array<std::complex<double>,1>& dst) const;
+};
+
+
+/**
+ * @brief This class implements an inverse 1D Discrete Fourier Transform
+ * which outputs a real signal, based on the FFTW library. The input
+ * contains the length/2+1 first coefficients of the transform.
+ */
+class IRFFT1D: public RFFT1DAbstract
+{
+  public:
+    /**
+     * @brief Constructor
+     */
+    IRFFT1D();
+
+    /**
+     * @brief Constructor: Initialize working array
+     */
+    IRFFT1D(const size_t length);
+
+    /**
+     * @brief Copy constructor
+     */
+    IRFFT1D(const IRFFT1D& other);
+
+    /**
+     * @brief Destructor
+     */
+    virtual ~IRFFT1D();
+
+    /**
+     * @brief process an array by applying the inverse FFT
+     */
+    void operator()(const blitz::Array<std::complex<double>,1>& src,
+      blitz::Array<double,1>& dst) const;
+};
+
+/**
+ * @}
+ */
+}}
+
+#endif /* BOB_SP_RFFT1D_H */
@@ -0,0 +1,173 @@
+/**
+ * @file bob/trainer/DataBlockSampler.h
+ * @date Sat Oct 17 19:12:40 CEST 2026
+ * @author Laurent El Shafey <Laurent.El-Shafey@idiap.ch>
+ *
+ * @brief Streams the samples stored in a list of files, one block of samples
+ * at a time
+ *
+ * Copyright (C) 2011-2013 Idiap Research Institute, Martigny, Switzerland
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef BOB_TRAINER_DATABLOCKSAMPLER_H
+#define BOB_TRAINER_DATABLOCKSAMPLER_H
+
+#include <bob/io/HDF5File.h>
+#include <bob/core/array.h>
+#include <blitz/array.h>
+#include <boost/shared_ptr.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <boost/thread.hpp>
+#include <string>
+#include <vector>
+
+namespace bob { namespace trainer {
+/**
+ * @ingroup TRAINER
+ * @{
+ */
+
+/**
+ * @brief This class streams the samples stored in a list of HDF5 files, such
+ * that trainers can process datasets which do not fit in memory.
+ *
+ * The first dataset of each file is read. It either contains 1D arrays (one
+ * sample each, which is how a 2D array saved into an HDF5 file is seen) or 2D
+ * arrays (one sample per row, e.g. the features of an utterance). The
+ * samples are returned by blocks of at most block_size rows, in the order of
+ * the files. Each block is read with as few hyperslab selections as possible
+ * (see bob::io::HDF5File::readArrays()): only the samples of the current
+ * block are loaded, except for a 2D array overlapping the end of a block,
+ * which is kept until its last row is returned.
+ *
+ * When prefetching is enabled, the next block is read by a background thread
+ * while the current one is processed. The files must then not be accessed by
+ * other threads during a pass over the data.
+ */
+class DataBlockSampler
+{
+  public:
+    /**
+     * @brief Constructor, from HDF5 files opened for reading
+     */
+    DataBlockSampler(const std::vector<boost::shared_ptr<bob::io::HDF5File> >& files,
+      const size_t block_size=10000, const bool prefetch=true);
+
+    /**
+     * @brief Constructor, from the names of the files
+     */
+    DataBlockSampler(const std::vector<std::string>& filenames,
+      const size_t block_size=10000, const bool prefetch=true);
+
+    /**
+     * @brief Destructor (stops the background thread)
+     */
+    virtual ~DataBlockSampler();
+
+    /**
+     * @brief Returns the dimensionality of the samples
+     */
+    size_t getNInputs() const { return m_n_inputs; }
+
+    /**
+     * @brief Returns the maximum number of samples of a block
+     */
+    size_t getBlockSize() const { return m_block_size; }
+
+    /**
+     * @brief Tells whether the blocks are read by a background thread
+     */
+    bool getPrefetch() const { return m_prefetch; }
+
+    /**
+     * @brief Rewinds to the first block of the first file
+     */
+    void reset();
+
+    /**
+     * @brief Gets the next block of samples, and returns false once all the
+     * samples have been returned. The block refers to an internal buffer,
+     * which is valid until the next call to next() or reset().
+     */
+    bool next(blitz::Array<double,2>& block);
+
+  private:
+    /**
+     * @brief Disallow copy
+     */
+    DataBlockSampler(const DataBlockSampler& other);
+    DataBlockSampler& operator=(const DataBlockSampler& other);
+
+    /**
+     * @brief Checks the files and allocates the buffers
+     */
+    void initialize();
+
+    /**
+     * @brief Stops the background thread, if any
+     */
+    void stop();
+
+    /**
+     * @brief Reads the next samples into the given buffer, and returns their
+     * number (0 at the end of the data)
+     */
+    size_t readBlock(double* block);
+
+    /**
+     * @brief Reads all the blocks into the two buffers in turn (body of the
+     * background thread)
+     */
+    void prefetchBlocks();
+
+    // Data: the files, and the path, type and number of arrays of the
+    // dataset read in each of them
+    std::vector<boost::shared_ptr<bob::io::HDF5File> > m_files;
+    std::vector<std::string> m_paths;
+    std::vector<bob::core::array::typeinfo> m_types;
+    std::vector<size_t> m_sizes;
+    size_t m_n_inputs;
+    size_t m_block_size;
+    bool m_prefetch;
+
+    // Position in the data: file, array in the file and row in the array,
+    // and the 2D array overlapping the end of the previous block
+    size_t m_file;
+    size_t m_array;
+    int m_row;
+    blitz::Array<double,2> m_array_cache;
+
+    // Buffers, filled in turn by the background thread (which only uses the
+    // raw pointers), and their state
+    blitz::Array<double,2> m_buffer[2];
+    double* m_buffer_data[2];
+    size_t m_buffer_rows[2];
+    bool m_buffer_full[2];
+    int m_current;
+    int m_next;
+    bool m_done;
+    bool m_stop;
+    std::string m_error;
+    boost::mutex m_mutex;
+    boost::condition_variable m_condition;
+    boost::scoped_ptr<boost::thread> m_thread;
+};
+
+/**
+ * @}
+ */
+}}
+
+#endif /* BOB_TRAINER_DATABLOCKSAMPLER_H */
@@ -31,6 +31,7 @@
 #include <bob/core/check.h>
 #include <bob/core/logging.h>
 #include <boost/shared_ptr.hpp>
+#include <boost/bind.hpp>
 #include <boost/random.hpp>
 
 
@@ -121,51 +122,8 @@ namespace bob { namespace trainer {
       // Initialization
       initialize(machine, sampler);
       // Do the Expectation-Maximization algorithm
-      double average_output_previous;
-      double average_output = - std::numeric_limits<double>::max();
-      
-      // - eStep
-      eStep(machine, sampler);
-   
-      if(m_compute_likelihood)
-        average_output = computeLikelihood(machine);
-
-      // - iterates...
-      for(size_t iter=0; ; ++iter) {
-        
-        // - saves average output from last iteration
-        average_output_previous = average_output;
-       
-        // - mStep
-        mStep(machine, sampler);
-        
-        // - eStep
-        eStep(machine, sampler);
-   
-        // - Computes log likelihood if required
-        if(m_compute_likelihood) {
-          average_output = computeLikelihood(machine);
-        
-          bob::core::info << "# Iteration " << iter+1 << ": " 
-            << average_output_previous << " -> " 
-            << average_output << std::endl;
-        
-          // - Terminates if converged (and likelihood computation is set)
-          if(fabs((average_output_previous - average_output)/average_output_previous) <= m_convergence_threshold) {
-            bob::core::info << "# EM terminated: likelihood converged" << std::endl;
-            break;
-          }
-        }
-        else
-          bob::core::info << "# Iteration " << iter+1 << std::endl;
-        
-        // - Terminates if maximum number of iterations has been reached
-        if(m_max_iterations > 0 && iter+1 >= m_max_iterations) {
-          bob::core::info << "# EM terminated: maximum number of iterations reached." << std::endl;
-          break;
-        }
-      }
-
+      iterate(machine, boost::bind(&EMTrainer::eStep, this, _1,
+        boost::cref(sampler)), sampler);
       // Finalization
       finalize(machine, sampler);
     }
@@ -254,6 +212,60 @@ namespace bob { namespace trainer {
     size_t m_max_iterations; ///< maximum number of EM iterations
     boost::shared_ptr<boost::mt19937> m_rng; ///< The random number generator for the inialization
 
+    /**
+     * @brief The EM iterations: the E-step is performed by calling
+     * e_step(machine), and the M-step is given mstep_data
+     */
+    template <typename T_estep>
+    void iterate(T_machine& machine, const T_estep& e_step,
+      const T_sampler& mstep_data)
+    {
+      double average_output_previous;
+      double average_output = - std::numeric_limits<double>::max();
+      
+      // - eStep
+      e_step(machine);
+   
+      if(m_compute_likelihood)
+        average_output = computeLikelihood(machine);
+
+      // - iterates...
+      for(size_t iter=0; ; ++iter) {
+        
+        // - saves average output from last iteration
+        average_output_previous = average_output;
+       
+        // - mStep
+        mStep(machine, mstep_data);
+        
+        // - eStep
+        e_step(machine);
+   
+        // - Computes log likelihood if required
+        if(m_compute_likelihood) {
+          average_output = computeLikelihood(machine);
+        
+          bob::core::info << "# Iteration " << iter+1 << ": " 
+            << average_output_previous << " -> " 
+            << average_output << std::endl;
+        
+          // - Terminates if converged (and likelihood computation is set)
+          if(fabs((average_output_previous - average_output)/average_output_previous) <= m_convergence_threshold) {
+            bob::core::info << "# EM terminated: likelihood converged" << std::endl;
+            break;
+          }
+        }
+        else
+          bob::core::info << "# Iteration " << iter+1 << std::endl;
+        
+        // - Terminates if maximum number of iterations has been reached
+        if(m_max_iterations > 0 && iter+1 >= m_max_iterations) {
+          bob::core::info << "# EM terminated: maximum number of iterations reached." << std::endl;
+          break;
+        }
+      }
+    }
+
     /**
      * @brief Protected constructor to be called in the constructor of derived
      * classes
@@ -25,6 +25,7 @@
 #define BOB_TRAINER_GMMTRAINER_H
 
 #include "EMTrainer.h"
+#include "DataBlockSampler.h"
 #include <bob/machine/GMMMachine.h>
 #include <bob/machine/GMMStats.h>
 #include <limits>
@@ -62,11 +63,30 @@ class GMMTrainer: public EMTrainer<bob::machine::GMMMachine, blitz::Array<double
      */
     virtual ~GMMTrainer();
 
+    using EMTrainer<bob::machine::GMMMachine, blitz::Array<double,2> >::train;
+
+    /**
+     * @brief Trains the GMM over the blocks of samples streamed by the
+     * sampler, with the same EM iterations as the in-memory training. Only
+     * the initialization and the E-step read the samples; the M-step and the
+     * finalization are given an empty dataset.
+     */
+    virtual void train(bob::machine::GMMMachine& gmm,
+      DataBlockSampler& sampler);
+
     /**
      * @brief Initialization before the EM steps
      */
     virtual void initialize(bob::machine::GMMMachine& gmm,
       const blitz::Array<double,2>& data);
+
+    /**
+     * @brief Initialization before the EM steps, when training over a
+     * DataBlockSampler. The data is not used by the initialization of the
+     * GMM trainers, which is given an empty dataset.
+     */
+    virtual void initialize(bob::machine::GMMMachine& gmm,
+      DataBlockSampler& sampler);
     
     /**
      * @brief Calculates and saves statistics across the dataset,
@@ -80,6 +100,15 @@ class GMMTrainer: public EMTrainer<bob::machine::GMMMachine, blitz::Array<double
     virtual void eStep(bob::machine::GMMMachine& gmm,
       const blitz::Array<double,2>& data);
 
+    /**
+     * @brief Calculates and saves the same statistics as the E-step above,
+     * over the blocks of samples streamed by the sampler. The statistics are
+     * accumulated block by block, which gives the same result as the
+     * in-memory E-step (up to the rounding errors).
+     */
+    virtual void eStep(bob::machine::GMMMachine& gmm,
+      DataBlockSampler& sampler);
+
     /**
      * @brief Computes the likelihood using current estimates of the latent
      * variables
@@ -78,6 +78,12 @@ class IVectorTrainer: public bob::trainer::EMTrainer<bob::machine::IVectorMachin
      * - m_acc_Snormij (only if update_sigma is enabled)
      * 
      * These statistics will be used in the mStep() that follows.
+     *
+     * The samples are processed by blocks. The posteriors of the latent
+     * variables of the samples of a block are first computed in parallel.
+     * The accumulators are then updated in parallel, each thread taking
+     * care of a range of Gaussian components, such that no per-thread copy
+     * of the (C x rt x rt) accumulators is required.
      */
     virtual void eStep(bob::machine::IVectorMachine& ivector, 
       const std::vector<bob::machine::GMMStats>& data);
@@ -152,6 +158,27 @@ class IVectorTrainer: public bob::trainer::EMTrainer<bob::machine::IVectorMachin
       m_acc_Snormij = acc; }
 
   protected:
+    /**
+     * @brief Computes \f$E{wij}\f$ and \f$E{wij.wij^{T}}\f$ (packed) for the
+     * samples [offset+begin,offset+end) of the data (body of the first
+     * parallel loop of the eStep())
+     */
+    void eStepPosteriors(const bob::machine::IVectorMachine& machine,
+      const std::vector<bob::machine::GMMStats>& data,
+      const blitz::Array<double,1>& means, const size_t offset,
+      std::vector<bob::machine::IVectorMachineWorkspace>& ws,
+      const size_t begin, const size_t end, const size_t thread);
+
+    /**
+     * @brief Updates the accumulators of the Gaussians [begin,end) with the
+     * n_samples samples of the data starting at offset (body of the second
+     * parallel loop of the eStep())
+     */
+    void eStepAccumulate(const std::vector<bob::machine::GMMStats>& data,
+      const blitz::Array<double,1>& means, const size_t offset,
+      const size_t n_samples, const size_t begin, const size_t end,
+      const size_t thread);
+
     // Attributes
     bool m_update_sigma;
 
@@ -162,14 +189,11 @@ class IVectorTrainer: public bob::trainer::EMTrainer<bob::machine::IVectorMachin
     blitz::Array<double,2> m_acc_Snormij;
     
     // Working arrays
-    mutable blitz::Array<double,1> m_tmp_wij;
-    mutable blitz::Array<double,2> m_tmp_wij2;
     mutable blitz::Array<double,1> m_tmp_d1;
-    mutable blitz::Array<double,1> m_tmp_t1;
     mutable blitz::Array<double,2> m_tmp_dd1;
-    mutable blitz::Array<double,2> m_tmp_dt1;
-    mutable blitz::Array<double,2> m_tmp_tt1;
-    mutable blitz::Array<double,2> m_tmp_tt2;
+    // E{wij} and E{wij.wij^{T}} (packed upper triangle) of a block of samples
+    mutable blitz::Array<double,2> m_tmp_Ewij;
+    mutable blitz::Array<double,2> m_tmp_Ewij2;
 };
 
 /**
@@ -23,6 +23,7 @@
 
 #include <bob/machine/KMeansMachine.h>
 #include <bob/trainer/EMTrainer.h>
+#include <bob/trainer/DataBlockSampler.h>
 #include <boost/version.hpp>
 
 namespace bob { namespace trainer {
@@ -96,7 +97,18 @@ class KMeansTrainer: public EMTrainer<bob::machine::KMeansMachine, blitz::Array<
      * @brief The name for this trainer
      */
     virtual std::string name() const { return "KMeansTrainer"; }
-   
+
+    using EMTrainer<bob::machine::KMeansMachine, blitz::Array<double,2> >::train;
+
+    /**
+     * @brief Trains the k-means machine over the blocks of samples streamed
+     * by the sampler, with the same EM iterations as the in-memory training.
+     * Only the initialization and the E-step read the samples; the M-step
+     * and the finalization are given an empty dataset.
+     */
+    virtual void train(bob::machine::KMeansMachine& kmeans,
+      DataBlockSampler& sampler);
+
     /**
      * @brief Initialise the means randomly. 
      * Data is split into as many chunks as there are means, 
@@ -105,15 +117,53 @@ class KMeansTrainer: public EMTrainer<bob::machine::KMeansMachine, blitz::Array<
     virtual void initialize(bob::machine::KMeansMachine& kMeansMachine,
       const blitz::Array<double,2>& sampler);
     
+    /**
+     * @brief Initialises the means with samples selected uniformly at random
+     * over the blocks streamed by the sampler, in a single pass (reservoir
+     * sampling). With RANDOM_NO_DUPLICATE, the samples equal to one of the
+     * selected means are skipped. The k-means++ initialization, which
+     * requires a pass over the data per mean, is replaced by this random
+     * selection. If the size of the mini-batches is set, the means are then
+     * updated by one miniBatchStep().
+     */
+    virtual void initialize(bob::machine::KMeansMachine& kmeans,
+      DataBlockSampler& sampler);
+
+    /**
+     * @brief Updates the means with one pass of mini-batch k-means over the
+     * blocks streamed by the sampler: the samples of each mini-batch are
+     * assigned to their closest mean, which is then moved towards them with
+     * a learning rate equal to the inverse of the number of samples assigned
+     * to it so far. The mini-batches are taken in the order of the stream.
+     * This approximates the k-means solution at a fraction of the cost of
+     * the EM iterations.
+     * @see D. Sculley, "Web-scale k-means clustering", WWW 2010
+     */
+    void miniBatchStep(bob::machine::KMeansMachine& kmeans,
+      DataBlockSampler& sampler);
+
     /**
      * @brief Accumulate across the dataset:
      * - zeroeth and first order statistics
      * - average (Square Euclidean) distance from the closest mean 
      * Implements EMTrainer::eStep(double &)
+     *
+     * The closest means of blocks of samples are found from the scalar
+     * products between the samples and the means, computed as a matrix
+     * product, since \f$||x-\mu||^2 = ||x||^2 - 2x.\mu + ||\mu||^2\f$.
+     * The samples are processed in parallel, and each thread accumulates
+     * its own statistics.
      */
     virtual void eStep(bob::machine::KMeansMachine& kmeans,
       const blitz::Array<double,2>& data);
     
+    /**
+     * @brief Accumulates the same statistics as the E-step above, over the
+     * blocks of samples streamed by the sampler.
+     */
+    virtual void eStep(bob::machine::KMeansMachine& kmeans,
+      DataBlockSampler& sampler);
+
     /**
      * @brief Updates the mean based on the statistics from the E-step.
      */
@@ -158,6 +208,18 @@ class KMeansTrainer: public EMTrainer<bob::machine::KMeansMachine, blitz::Array<
      * @brief Gets the initialization method used to generate the initial means
      */
     InitializationMethod getInitializationMethod() const { return m_initialization_method; }
+
+    /**
+     * @brief Sets the number of samples of the mini-batches used to update
+     * the means before the EM iterations, when training over a sampler (0
+     * disables the mini-batch k-means)
+     */
+    void setMiniBatchSize(const size_t v) { m_mini_batch_size = v; }
+
+    /**
+     * @brief Gets the number of samples of the mini-batches
+     */
+    size_t getMiniBatchSize() const { return m_mini_batch_size; }
   
     /**
      * @brief Returns the internal statistics. Useful to parallelize the E-step
@@ -173,6 +235,34 @@ class KMeansTrainer: public EMTrainer<bob::machine::KMeansMachine, blitz::Array<
     void setAverageMinDistance(const double value) { m_average_min_distance = value; }
 
 
+  private:
+    /**
+     * @brief Adds the statistics of the samples to the accumulators, given
+     * the (contiguous) means and their squared norms
+     */
+    void accumulate(const blitz::Array<double,2>& ar,
+      const blitz::Array<double,2>& means,
+      const blitz::Array<double,1>& means_norm);
+
+    /**
+     * @brief Replaces the distances of the samples [begin,end[ to their
+     * closest mean by their distance to the i-th mean, if smaller (parallel
+     * body of the k-means++ initialization)
+     */
+    void updateMinDistances(const blitz::Array<double,2>& ar,
+      const blitz::Array<double,2>& means, const size_t i,
+      blitz::Array<double,1>& min_distances, size_t begin, size_t end,
+      size_t thread_idx) const;
+
+    /**
+     * @brief Accumulates the statistics of the samples [begin,end[ in the
+     * row thread_idx of stats (parallel body of the E-step)
+     */
+    void eStepRows(const blitz::Array<double,2>& ar,
+      const blitz::Array<double,2>& means,
+      const blitz::Array<double,1>& means_norm, blitz::Array<double,2>& stats,
+      size_t begin, size_t end, size_t thread_idx) const;
+
   protected:
     /**
      * @brief The initialization method
@@ -180,6 +270,11 @@ class KMeansTrainer: public EMTrainer<bob::machine::KMeansMachine, blitz::Array<
      */
     InitializationMethod m_initialization_method;
 
+    /**
+     * @brief The number of samples of the mini-batches (0 if disabled)
+     */
+    size_t m_mini_batch_size;
+
     /**
      * @brief The random number generator for the inialization
      */
@@ -64,6 +64,8 @@ class MAP_GMMTrainer: public GMMTrainer
     virtual void initialize(bob::machine::GMMMachine& gmm,
       const blitz::Array<double,2>& data);
 
+    using GMMTrainer::initialize;
+
     /**
      * @brief Assigns from a different MAP_GMMTrainer
      */
@@ -65,6 +65,8 @@ class ML_GMMTrainer: public GMMTrainer {
     virtual void initialize(bob::machine::GMMMachine& gmm,
       const blitz::Array<double,2>& data);
 
+    using GMMTrainer::initialize;
+
     /**
      * @brief Performs a maximum likelihood (ML) update of the GMM parameters
      * using the accumulated statistics in m_ss
@@ -27,7 +27,6 @@
 #include "EMTrainer.h"
 #include <bob/machine/PLDAMachine.h>
 #include <blitz/array.h>
-#include <map>
 #include <vector>
 
 namespace bob { namespace trainer { 
@@ -263,26 +262,47 @@ class PLDATrainer: public EMTrainer<bob::machine::PLDABase,
      */
     std::vector<size_t> m_cache_n_samples_per_id;
     /**
-     * @brief Tells if there is an identity with a 'key'/particular number of 
-     * training samples, and if corresponding matrices are up to date.
+     * @brief Distinct numbers of training samples per individual, in 
+     * increasing order. The matrices below, which depend on the number of 
+     * samples, are stored in tables of this size, allocated once by 
+     * initialize().
      */
-    std::map<size_t,bool> m_cache_n_samples_in_training;
+    std::vector<size_t> m_cache_n_samples_in_training;
+    /**
+     * @brief Index of the number of training samples of each individual in
+     * m_cache_n_samples_in_training
+     */
+    std::vector<size_t> m_cache_n_samples_index_per_id;
     blitz::Array<double,2> m_cache_B; ///< \f$B = [F, G]\f$ (size nfeatures x (m_dim_f+m_dim_g) )
     blitz::Array<double,2> m_cache_Ft_isigma_G; ///< \f$F^T \Sigma^-1 G\f$
     blitz::Array<double,2> m_cache_eta; ///< \f$F^T \Sigma^-1 G \alpha\f$
     // Blocks (with \f$\gamma_{a}\f$) of \f$(Id + A^T \Sigma'^-1 A)^-1\f$ (efficient inversion)
-    std::map<size_t,blitz::Array<double,2> > m_cache_zeta; ///< \f$\zeta_{a} = \alpha + \eta^T \gamma_{a} \eta\f$
-    std::map<size_t,blitz::Array<double,2> > m_cache_iota; ///< \f$\iota_{a} = -\gamma_{a} \eta\f$
+    std::vector<blitz::Array<double,2> > m_cache_gamma; ///< \f$\gamma_{a} = (Id + a F^T \beta F)^{-1}\f$
+    std::vector<blitz::Array<double,2> > m_cache_zeta; ///< \f$\zeta_{a} = \alpha + \eta^T \gamma_{a} \eta\f$
+    std::vector<blitz::Array<double,2> > m_cache_iota; ///< \f$\iota_{a} = -\gamma_{a} \eta\f$
 
     // Working arrays
     mutable blitz::Array<double,1> m_tmp_nf_1; ///< vector of dimension dim_f
-    mutable blitz::Array<double,1> m_tmp_nf_2; ///< vector of dimension dim_f
-    mutable blitz::Array<double,1> m_tmp_ng_1; ///< vector of dimension dim_f
     mutable blitz::Array<double,1> m_tmp_D_1; ///< vector of dimension dim_d 
     mutable blitz::Array<double,1> m_tmp_D_2; ///< vector of dimension dim_d
     mutable blitz::Array<double,2> m_tmp_nfng_nfng; ///< matrix of dimension (dim_f+dim_g)x(dim_f+dim_g)
     mutable blitz::Array<double,2> m_tmp_D_nfng_1; ///< matrix of dimension (dim_d)x(dim_f+dim_g)
-    mutable blitz::Array<double,2> m_tmp_D_nfng_2; ///< matrix of dimension (dim_d)x(dim_f+dim_g)
+
+    /**
+     * @brief Working arrays of a thread of the E-step
+     */
+    struct Workspace
+    {
+      void resize(const size_t dim_d, const size_t dim_f, const size_t dim_g);
+
+      blitz::Array<double,1> tmp_nf_1; ///< vector of dimension dim_f
+      blitz::Array<double,1> tmp_nf_2; ///< vector of dimension dim_f
+      blitz::Array<double,1> tmp_ng_1; ///< vector of dimension dim_g
+      blitz::Array<double,1> tmp_D_1; ///< vector of dimension dim_d
+      blitz::Array<double,1> tmp_D_2; ///< vector of dimension dim_d
+      blitz::Array<double,2> tmp_nf_nf; ///< matrix of dimension dim_f x dim_f
+    };
+    std::vector<Workspace> m_tmp_ws; ///< one workspace per thread
 
     // internal methods
     void computeMeanVariance(bob::machine::PLDABase& machine,
@@ -308,6 +328,27 @@ class PLDATrainer: public EMTrainer<bob::machine::PLDABase,
       const std::vector<blitz::Array<double,2> >& v_ar);
 
     void resizeTmp();
+    void resizeWorkspaces();
+
+    // parallel bodies, processing the numbers of samples [begin,end[, the 
+    // individuals [begin,end[ or the rows [begin,end[ of the accumulated 
+    // statistics
+    void precomputeZetaIota(const bob::machine::PLDABase& machine,
+      const blitz::Array<double,2>& etat, size_t begin, size_t end, 
+      size_t thread);
+    void eStepIdentities(const bob::machine::PLDABase& machine,
+      const std::vector<blitz::Array<double,2> >& v_ar, size_t begin,
+      size_t end, size_t thread);
+    void eStepSumSecondOrder(size_t begin, size_t end, size_t thread);
+    double zSecondOrder(const size_t k, const blitz::Array<double,2>& z_i,
+      const int j, const int p, const int q) const;
+    void updateFGRows(const blitz::Array<double,1>& mu,
+      const std::vector<blitz::Array<double,2> >& v_ar, size_t begin,
+      size_t end, size_t thread);
+    void updateSigmaRows(const blitz::Array<double,1>& mu,
+      const std::vector<blitz::Array<double,2> >& v_ar, 
+      blitz::Array<double,1>& sigma, size_t begin, size_t end, 
+      size_t thread);
 };
 
 /**
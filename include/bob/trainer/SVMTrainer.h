@@ -24,6 +24,7 @@
 #define BOB_TRAINER_SVMTRAINER_H
 
 #include <vector>
+#include <utility>
 #include <bob/machine/SVM.h>
 
 namespace bob { namespace trainer {
@@ -32,6 +33,95 @@ namespace bob { namespace trainer {
    * @{
    */
 
+  /**
+   * A training set converted to the libsvm sparse format. Building it scales
+   * the data and converts it once, such that several trainings (e.g. a grid
+   * search over the parameters of the SVM) can share it.
+   *
+   * The samples are grouped by class, in the order of the given arrays. If
+   * there are 2 classes, their labels are +1 and -1. Otherwise, labels are
+   * picked starting from 1 (i.e., 1, 2, 3, 4, etc.).
+   */
+  class SVMProblem {
+
+    public: //api
+
+      /**
+       * Converts the given data, one 2D array (one sample per row) per
+       * class, without scaling
+       */
+      SVMProblem(const std::vector<blitz::Array<double,2> >& data);
+
+      /**
+       * Converts the given data, one 2D array (one sample per row) per
+       * class, after scaling each column as (x - input_subtract) /
+       * input_division.
+       */
+      SVMProblem(const std::vector<blitz::Array<double,2> >& data,
+          const blitz::Array<double,1>& input_subtract,
+          const blitz::Array<double,1>& input_division);
+
+      /**
+       * Destructor virtualisation
+       */
+      virtual ~SVMProblem();
+
+      /**
+       * Number of classes, samples and features
+       */
+      size_t numberOfClasses() const { return m_labels.size(); }
+      size_t numberOfSamples() const { return m_y.size(); }
+      size_t inputSize() const { return m_input_sub.extent(0); }
+
+      /**
+       * The label of the samples of class i, and the range of samples
+       * [classStart(i), classStart(i+1)[ of this class
+       */
+      double classLabel(size_t i) const { return m_labels[i]; }
+      size_t classStart(size_t i) const { return m_start[i]; }
+
+      /**
+       * Largest feature index (starting from 1) with a non-zero value
+       */
+      int maxIndex() const { return m_max_index; }
+
+      /**
+       * Scaling parameters applied to the data
+       */
+      const blitz::Array<double,1>& getInputSubtraction() const
+      { return m_input_sub; }
+      const blitz::Array<double,1>& getInputDivision() const
+      { return m_input_div; }
+
+      /**
+       * The problem, in libsvm format
+       */
+      const svm_problem* get() const { return &m_problem; }
+
+    private: //not implemented
+
+      SVMProblem(const SVMProblem& other);
+
+      SVMProblem& operator= (const SVMProblem& other);
+
+    private: //methods
+
+      void convert(const std::vector<blitz::Array<double,2> >& data);
+
+    private: //representation
+
+      blitz::Array<double,1> m_input_sub; ///< scaling: subtraction
+      blitz::Array<double,1> m_input_div; ///< scaling: division
+      std::vector<double> m_labels; ///< label of each class
+      std::vector<size_t> m_start; ///< first sample of each class
+      std::vector<svm_node> m_nodes; ///< all the non-zero values
+      std::vector<svm_node*> m_x; ///< first node of each sample
+      std::vector<double> m_y; ///< label of each sample
+      int m_max_index; ///< largest index of a non-zero value
+      svm_problem m_problem; ///< libsvm view on the vectors above
+
+  };
+
   /**
    * This class emulates the behavior of the command line utility called
    * svm-train, from libsvm. These bindings do not support:
@@ -90,6 +180,31 @@ namespace bob { namespace trainer {
          const blitz::Array<double,1>& input_subtract,
          const blitz::Array<double,1>& input_division) const;
 
+      /**
+       * Trains a new machine on a prepared problem. The scaling parameters
+       * of the problem are set on the machine.
+       *
+       * The one-versus-one sub-problems of multi-class problems are trained
+       * in parallel, each with an equal share of the kernel cache. The
+       * machine is the same as the one libsvm trains serially.
+       */
+      boost::shared_ptr<bob::machine::SupportVector> train
+        (const SVMProblem& problem) const;
+
+      /**
+       * Trains one machine for each (cost, gamma) pair of a grid, on the
+       * same problem. The grid points are trained in parallel, each with an
+       * equal share of the kernel cache. The machine trained with costs[i]
+       * and gammas[j] is at position i*gammas.size()+j of the output.
+       *
+       * The other parameters are the ones of this trainer. With probability
+       * estimates, which rely on libsvm's random number generator, the grid
+       * points are trained one after the other to remain reproducible.
+       */
+      std::vector<boost::shared_ptr<bob::machine::SupportVector> > trainGrid
+        (const SVMProblem& problem, const std::vector<double>& costs,
+         const std::vector<double>& gammas) const;
+
       /**
        * Getters and setters for all parameters
        */
@@ -131,6 +246,33 @@ namespace bob { namespace trainer {
       void setProbabilityEstimates(bool v) 
       { m_param.probability = v; }
 
+    private: //methods
+
+      /**
+       * Trains a libsvm model with the given parameters. If parallel is
+       * set, the one-versus-one sub-problems are trained in parallel.
+       */
+      boost::shared_ptr<svm_model> trainModel(const SVMProblem& problem,
+          svm_parameter param, const bool parallel) const;
+
+      /**
+       * Trains the sub-problems [begin,end[ of a multi-class problem
+       * (parallel body)
+       */
+      void trainPairs(const SVMProblem& problem, const svm_parameter& param,
+          const std::vector<std::pair<int,int> >& pairs,
+          std::vector<boost::shared_ptr<svm_model> >& models,
+          size_t begin, size_t end, size_t thread_idx) const;
+
+      /**
+       * Trains the grid points [begin,end[ (parallel body)
+       */
+      void trainGridPoints(const SVMProblem& problem,
+          const svm_parameter& param, const std::vector<double>& costs,
+          const std::vector<double>& gammas,
+          std::vector<boost::shared_ptr<bob::machine::SupportVector> >& machines,
+          size_t begin, size_t end, size_t thread_idx) const;
+
     private: //representation
 
       svm_parameter m_param; ///< training parametrization for libsvm
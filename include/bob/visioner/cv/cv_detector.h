@@ -162,6 +162,17 @@ namespace bob { namespace visioner {
 
     private:
 
+      // Sliding-windows scanned by a task of the parallel scan
+      struct band_t;
+
+      // Scan the sliding-windows of the given band(s)
+      void scan_bands(std::vector<band_t>& bands, size_t begin, size_t end) const;
+      void scan_band(band_t& band) const;
+
+      // Preprocess the scales <is_begin + imodel> with the <imodel>-th copy of the
+      //	model, for <imodel> in [begin, end)
+      void preprocess_scales(uint64_t is_begin, size_t begin, size_t end) const;
+
       static void threshold(std::vector<detection_t>& detections, double thres);
       static void cluster(std::vector<detection_t>& detections, double thres, uint64_t n_outputs);                 
 
@@ -186,6 +197,7 @@ namespace bob { namespace visioner {
       uint64_t			m_levels;	       ///< number of levels (speed-up scanning)
       ipyramid_t  m_ipyramid;	     ///< Pyramid of images
       mutable stats_t m_stats;     ///< Scanning statistics
+      mutable std::vector<boost::shared_ptr<Model> > m_smodels; ///< Copies of the model (one per scale scanned concurrently)
 
   };
 
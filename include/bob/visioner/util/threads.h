@@ -26,10 +26,12 @@
 #define BOB_VISIONER_UTIL_THREADS_H
 
 #include <vector>
+#include <string>
 
 #include <boost/thread.hpp>
 #include <boost/lambda/bind.hpp>
-#include <boost/shared_array.hpp>
+
+#include "bob/core/parallel.h"
 
 namespace bob { namespace visioner {
 
@@ -37,27 +39,76 @@ namespace bob { namespace visioner {
   void thread_split(uint64_t n_objects, std::vector<uint64_t>& sbegins, 
       std::vector<uint64_t>& sends, size_t num_of_threads);
 
+  namespace detail {
+
+    // Adapters calling the loop operators on sub-ranges of the loop (stateless
+    //	operators), or on each of the splits in [begin, end) (state operators)
+    template <typename TOp> struct loop_task {
+      loop_task(TOp op) : m_op(op) {}
+      void operator()(size_t begin, size_t end, size_t) const {
+        const std::pair<uint64_t, uint64_t> range(begin, end);
+        m_op(range);
+      }
+      mutable TOp m_op;
+    };
+
+    template <typename TOp> struct iloop_task {
+      iloop_task(TOp op, const std::vector<uint64_t>& begins, const std::vector<uint64_t>& ends)
+        : m_op(op), m_begins(begins), m_ends(ends) {}
+      void operator()(size_t begin, size_t end, size_t) const {
+        for (uint64_t ith = begin; ith < end; ith ++) {
+          const std::pair<uint64_t, uint64_t> range(m_begins[ith], m_ends[ith]);
+          m_op(ith, range);
+        }
+      }
+      mutable TOp m_op;
+      const std::vector<uint64_t>& m_begins;
+      const std::vector<uint64_t>& m_ends;
+    };
+
+    template <typename TOp, typename TResult> struct rloop_task {
+      rloop_task(TOp op, const std::vector<uint64_t>& begins, const std::vector<uint64_t>& ends,
+          std::vector<TResult>& results)
+        : m_op(op), m_begins(begins), m_ends(ends), m_results(results) {}
+      void operator()(size_t begin, size_t end, size_t) const {
+        for (uint64_t ith = begin; ith < end; ith ++) {
+          const std::pair<uint64_t, uint64_t> range(m_begins[ith], m_ends[ith]);
+          m_op(range, m_results[ith]);
+        }
+      }
+      mutable TOp m_op;
+      const std::vector<uint64_t>& m_begins;
+      const std::vector<uint64_t>& m_ends;
+      std::vector<TResult>& m_results;
+    };
+
+    template <typename TOp, typename TResult> struct riloop_task {
+      riloop_task(TOp op, const std::vector<uint64_t>& begins, const std::vector<uint64_t>& ends,
+          std::vector<TResult>& results)
+        : m_op(op), m_begins(begins), m_ends(ends), m_results(results) {}
+      void operator()(size_t begin, size_t end, size_t) const {
+        for (uint64_t ith = begin; ith < end; ith ++) {
+          const std::pair<uint64_t, uint64_t> range(m_begins[ith], m_ends[ith]);
+          m_op(ith, range, m_results[ith]);
+        }
+      }
+      mutable TOp m_op;
+      const std::vector<uint64_t>& m_begins;
+      const std::vector<uint64_t>& m_ends;
+      std::vector<TResult>& m_results;
+    };
+
+  }
+
   // Split a loop computation of the given size using multiple threads
   // NB: Stateless threads: op(<begin, end>)
+  // NB: The loop is processed in chunks by the bob::core thread pool, using
+  //	at most <num_of_threads> threads, such that <op> may be called on more
+  //	than <num_of_threads> sub-ranges.
   template <typename TOp> void thread_loop(TOp op, uint64_t size,
       size_t num_of_threads=boost::thread::hardware_concurrency()) {
-    
-    boost::shared_array<boost::thread> threads(new boost::thread[num_of_threads]);
-    std::vector<uint64_t> th_begins; th_begins.reserve(num_of_threads);
-    std::vector<uint64_t> th_ends; th_ends.reserve(num_of_threads);
-
-    thread_split(size, th_begins, th_ends, num_of_threads);		
-
-    for (uint64_t ith = 0; ith < num_of_threads; ith ++) {
-      std::pair<uint64_t, uint64_t> range(th_begins[ith], th_ends[ith]);
-      boost::thread t(boost::bind(op, range));
-      threads[ith] = boost::move(t);
-    }
-
-    for (uint64_t ith = 0; ith < num_of_threads; ith ++) {
-      threads[ith].join();
-    }
 
+    bob::core::parallelFor(0, size, detail::loop_task<TOp>(op), 0, num_of_threads);
   }
 
   // Split a loop computation of the given size using multiple threads
@@ -65,29 +116,19 @@ namespace bob { namespace visioner {
   template <typename TOp> void thread_iloop(TOp op, uint64_t size,
       size_t num_of_threads=boost::thread::hardware_concurrency()) {
 
-    boost::shared_array<boost::thread> threads(new boost::thread[num_of_threads]);
     std::vector<uint64_t> th_begins; th_begins.reserve(num_of_threads);
     std::vector<uint64_t> th_ends; th_ends.reserve(num_of_threads);
 
     thread_split(size, th_begins, th_ends, num_of_threads);		
 
-    for (uint64_t ith = 0; ith < num_of_threads; ith ++) {
-      std::pair<uint64_t, uint64_t> range(th_begins[ith], th_ends[ith]);
-      boost::thread t(boost::bind(op, ith, range));
-      threads[ith] = boost::move(t);
-    }
-
-    for (uint64_t ith = 0; ith < num_of_threads; ith ++) {
-      threads[ith].join();
-    }
-
+    bob::core::parallelFor(0, num_of_threads,
+        detail::iloop_task<TOp>(op, th_begins, th_ends), 1);
   }
 
   // Split a loop computation of the given size using multiple threads
   // NB: State threads: op(<begin, end>, result&)
   template <typename TOp, typename TResult> void thread_loop(TOp op, uint64_t size, std::vector<TResult>& results, size_t num_of_threads=boost::thread::hardware_concurrency()) {
 
-    boost::shared_array<boost::thread> threads(new boost::thread[num_of_threads]);
     std::vector<uint64_t> th_begins; th_begins.reserve(num_of_threads);
     std::vector<uint64_t> th_ends; th_ends.reserve(num_of_threads);
 
@@ -95,23 +136,14 @@ namespace bob { namespace visioner {
 
     results.resize(num_of_threads);
 
-    for (uint64_t ith = 0; ith < num_of_threads; ith ++) {
-      std::pair<uint64_t, uint64_t> range(th_begins[ith], th_ends[ith]);
-      boost::thread t(boost::bind(op, range, boost::ref(results[ith])));
-      threads[ith] = boost::move(t);
-    }
-
-    for (uint64_t ith = 0; ith < num_of_threads; ith ++) {
-      threads[ith].join();
-    }
-
+    bob::core::parallelFor(0, num_of_threads,
+        detail::rloop_task<TOp, TResult>(op, th_begins, th_ends, results), 1);
   }
 
   // Split a loop computation of the given size using multiple threads
   // NB: State threads: op(thread_index, <begin, end>, result&)
   template <typename TOp, typename TResult> void thread_iloop(TOp op, uint64_t size, std::vector<TResult>& results, size_t num_of_threads=boost::thread::hardware_concurrency()) {
 
-    boost::shared_array<boost::thread> threads(new boost::thread[num_of_threads]);
     std::vector<uint64_t> th_begins; th_begins.reserve(num_of_threads);
     std::vector<uint64_t> th_ends; th_ends.reserve(num_of_threads);
 
@@ -119,16 +151,8 @@ namespace bob { namespace visioner {
 
     results.resize(num_of_threads);
 
-    for (uint64_t ith = 0; ith < num_of_threads; ith ++) {
-      std::pair<uint64_t, uint64_t> range(th_begins[ith], th_ends[ith]);
-      boost::thread t(boost::bind(op, ith, range, boost::ref(results[ith])));
-      threads[ith] = boost::move(t);
-    }
-
-    for (uint64_t ith = 0; ith < num_of_threads; ith ++) {
-      threads[ith].join();
-    }
-
+    bob::core::parallelFor(0, num_of_threads,
+        detail::riloop_task<TOp, TResult>(op, th_begins, th_ends, results), 1);
   }
 
 }}
@@ -23,6 +23,7 @@ import numpy
 import array
 import math
 import time
+from ...test import utils
 
 #############################################################################
 # Tests blitz-based extrapolation implementation with values returned
@@ -462,3 +463,85 @@ class CepsTest(unittest.TestCase):
     self.assertFalse(c0 != c1)
     self.assertFalse(c0 == c2)
     self.assertTrue( c0 != c2)
+
+  def test_stream(self):
+    import pkg_resources
+    rate_wavsample = _read(pkg_resources.resource_filename(__name__, os.path.join('data', 'sample.wav')))
+    rate = rate_wavsample[0]
+    data = rate_wavsample[1]
+
+    # (win_length_ms, win_shift_ms, delta_win, mel_scale, with_energy, with_delta, with_delta_delta)
+    configurations = [
+        (20., 10., 2, True, True, True, True),
+        (30., 15., 5, False, True, True, False),
+        (20., 10., 3, True, False, False, False),
+        (10., 15., 2, True, True, True, True), # shift larger than the window
+        ]
+    numpy.random.seed(42)
+    for (win_length_ms, win_shift_ms, delta_win, mel_scale, with_energy, with_delta, with_delta_delta) in configurations:
+      c = bob.ap.Ceps(rate, win_length_ms, win_shift_ms, 24, 19, 0., 4000., delta_win, 0.97, mel_scale, True)
+      c.with_energy = with_energy
+      c.with_delta = with_delta
+      c.with_delta_delta = with_delta_delta
+      A = c(data)
+
+      s = bob.ap.CepsStream(c)
+      self.assertEqual(s.n_features, A.shape[1])
+      # Processes the same stream twice, to check that flush() resets it
+      for r in range(2):
+        blocks = []
+        pos = 0
+        while pos < len(data):
+          n = numpy.random.randint(1, 2000)
+          blocks.append(s.push(data[pos:pos+n]))
+          pos += n
+        self.assertEqual(s.n_output_frames + s.n_pending_frames, A.shape[0])
+        blocks.append(s.flush())
+        B = numpy.vstack(blocks)
+        self.assertEqual(B.shape, A.shape)
+        self.assertTrue((A == B).all())
+        self.assertEqual(s.n_output_frames, 0)
+
+      # Blocks of a single sample
+      blocks = [s.push(data[k:k+1]) for k in range(4000)]
+      blocks.append(s.flush())
+      self.assertTrue((c(data[:4000]) == numpy.vstack(blocks)).all())
+
+      # Discards a stream
+      s.push(data[:1000])
+      s.reset()
+      self.assertEqual(s.n_pending_frames, 0)
+      self.assertEqual(s.n_output_frames, 0)
+
+  def test_threads(self):
+    import pkg_resources
+    rate_wavsample = _read(pkg_resources.resource_filename(__name__, os.path.join('data', 'sample.wav')))
+    rate = rate_wavsample[0]
+    data = rate_wavsample[1]
+
+    c = bob.ap.Ceps(rate)
+    c.with_energy = True
+    c.with_delta = True
+    c.with_delta_delta = True
+    s = bob.ap.Spectrogram(rate)
+
+    # Frames are processed independently, so that the number of threads
+    # does not change the output
+    with utils.n_threads(1):
+      A = c(data)
+      S = s(data)
+    for n in (2, 4, 7):
+      with utils.n_threads(n):
+        self.assertTrue((c(data) == A).all())
+        self.assertTrue((s(data) == S).all())
+
+  def test_single_thread(self):
+    import pkg_resources
+    rate_wavsample = _read(pkg_resources.resource_filename(__name__, os.path.join('data', 'sample.wav')))
+
+    # A signal of more than 64 frames, which a single thread processes at once
+    c = bob.ap.Ceps(rate_wavsample[0])
+    self.assertTrue(c(rate_wavsample[1]).shape[0] > 64)
+    with utils.n_threads(1):
+      cepstral_comparison_run(self, rate_wavsample, 20, 10, 24, 19, True, 0.,
+        4000., 2, 0.97, True, True, True, True)
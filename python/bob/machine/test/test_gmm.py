@@ -26,6 +26,7 @@ import bob
 import numpy
 import tempfile
 import pkg_resources
+from ...test import utils
 
 def F(f):
   """Returns the test file on the "data" subdirectory"""
@@ -229,3 +230,34 @@ class GMMMachineTest(unittest.TestCase):
     # implementation
     matlab_ll_ref = -2.361583051672024e+02
     self.assertTrue( abs(gmm(data) - matlab_ll_ref) < 1e-10)
+
+  def test05_GMMMachine(self):
+    # Test a GMMMachine (statistics of a data matrix, using several threads)
+
+    numpy.random.seed(3)
+    data = numpy.random.randn(2000, 5)
+    gmm = bob.machine.GMMMachine(8, 5)
+    gmm.weights   = numpy.random.uniform(0.5, 1., (8,))
+    gmm.weights  /= gmm.weights.sum()
+    gmm.means     = numpy.random.randn(8, 5)
+    gmm.variances = numpy.random.uniform(0.5, 2., (8, 5))
+
+    # Sample-wise statistics
+    stats_ref = bob.machine.GMMStats(8, 5)
+    for x in data: gmm.acc_statistics(x, stats_ref)
+
+    # A single thread performs the same operations in the same order
+    with utils.n_threads(1):
+      stats = bob.machine.GMMStats(8, 5)
+      gmm.acc_statistics(data, stats)
+    self.assertTrue( stats == stats_ref )
+
+    # Several threads only change the order of the additions
+    with utils.n_threads(4):
+      stats = bob.machine.GMMStats(8, 5)
+      gmm.acc_statistics(data, stats)
+    self.assertEqual( stats.t, stats_ref.t )
+    self.assertTrue( abs(stats.log_likelihood - stats_ref.log_likelihood) < 1e-8 )
+    self.assertTrue( numpy.allclose(stats.n, stats_ref.n, atol=1e-10) )
+    self.assertTrue( numpy.allclose(stats.sum_px, stats_ref.sum_px, atol=1e-10) )
+    self.assertTrue( numpy.allclose(stats.sum_pxx, stats_ref.sum_pxx, atol=1e-10) )
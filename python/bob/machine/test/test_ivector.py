@@ -23,6 +23,7 @@
 
 import unittest
 import bob, numpy, numpy.linalg, numpy.random
+from ...test import utils
 
 
 ### Test class inspired by an implementation of Chris McCool
@@ -166,3 +167,35 @@ class IVectorTests(unittest.TestCase):
     wij = mc.forward(gs)
     self.assertTrue(numpy.allclose(wij_ref, wij, 1e-5))
 
+
+  def test02_machine_batch(self):
+    # Random UBM, subspace and statistics
+    numpy.random.seed(3)
+    dim_c, dim_d, dim_t = 4, 3, 5
+    ubm = bob.machine.GMMMachine(dim_c, dim_d)
+    ubm.weights = numpy.ones((dim_c,), numpy.float64) / dim_c
+    ubm.means = numpy.random.randn(dim_c, dim_d)
+    ubm.variances = numpy.random.rand(dim_c, dim_d) + 0.5
+    data = []
+    for i in range(50):
+      gs = bob.machine.GMMStats(dim_c, dim_d)
+      gs.n = numpy.random.rand(dim_c) * 10
+      gs.sum_px = numpy.random.randn(dim_c, dim_d)
+      gs.sum_pxx = numpy.random.rand(dim_c, dim_d) * 10
+      data.append(gs)
+
+    m = bob.machine.IVectorMachine(ubm, dim_t)
+    m.t = numpy.random.randn(dim_c*dim_d, dim_t)
+    m.sigma = numpy.random.rand(dim_c*dim_d) + 0.5
+    ref = numpy.array([m.forward(gs) for gs in data])
+
+    # Batched extraction, with one and several threads
+    for n in (1, 3):
+      with utils.n_threads(n):
+        self.assertTrue(numpy.allclose(ref, m.forward(data), 1e-10, 1e-10))
+
+    # Cache in single precision
+    m.single_precision_cache = True
+    self.assertTrue(m.single_precision_cache)
+    self.assertTrue(numpy.allclose(ref, m.forward(data), 1e-4, 1e-5))
+    self.assertTrue(numpy.allclose(ref, numpy.array([m.forward(gs) for gs in data]), 1e-4, 1e-5))
@@ -21,9 +21,11 @@
 """
 
 import os, sys
+import tempfile
 import unittest
 import bob
 import numpy
+from ...test import utils
 
 class LinearScoringTest(unittest.TestCase):
   """Performs various LinearScoring tests."""
@@ -138,3 +140,46 @@ class LinearScoringTest(unittest.TestCase):
     self.assertTrue(abs(score - ref_scores_11[1,1]) < 1e-7)
     score = bob.machine.linear_scoring(model2.mean_supervector, ubm.mean_supervector, ubm.variance_supervector, stats3, test_channeloffset[2], True)
     self.assertTrue(abs(score - ref_scores_11[1,2]) < 1e-7)
+
+  def test02_LinearScoringBlocks(self):
+
+    # Scores more models and statistics than fit in a block/tile, and compares
+    # with a direct implementation
+    C = 4
+    D = 3
+    n_models = 150
+    n_stats = 70
+    ubm_mean = numpy.random.randn(C*D)
+    ubm_variance = numpy.random.rand(C*D) + 0.5
+    models = [numpy.random.randn(C*D) for m in range(n_models)]
+    stats = []
+    for t in range(n_stats):
+      s = bob.machine.GMMStats(C, D)
+      s.n = numpy.random.rand(C) * 10
+      s.sum_px = numpy.random.randn(C, D)
+      s.t = int(numpy.sum(s.n))
+      stats.append(s)
+    offsets = [numpy.random.randn(C*D) for t in range(n_stats)]
+
+    A = numpy.array([(m - ubm_mean) / ubm_variance for m in models])
+    B = numpy.array([s.sum_px.flatten() - numpy.repeat(s.n, D) * (ubm_mean + o)
+      for (s, o) in zip(stats, offsets)])
+    B /= numpy.array([s.t for s in stats], 'float64').reshape(n_stats, 1)
+    ref_scores = numpy.dot(A, B.T)
+
+    for n in (1, 3):
+      with utils.n_threads(n):
+        scores = bob.machine.linear_scoring(models, ubm_mean, ubm_variance, stats, offsets, True)
+        self.assertTrue((abs(scores - ref_scores) < 1e-10).all())
+
+    # Scores appended to a file
+    filename = str(tempfile.mkstemp(".hdf5")[1])
+    try:
+      f = bob.io.HDF5File(filename, 'w')
+      bob.machine.linear_scoring_to_file(models, ubm_mean, ubm_variance, stats, f, 'scores', offsets, True)
+      del f
+      scores = bob.io.HDF5File(filename).read('scores')
+      self.assertEqual(scores.shape, (n_models, n_stats))
+      self.assertTrue((abs(scores - ref_scores) < 1e-10).all())
+    finally:
+      os.unlink(filename)
@@ -151,6 +151,22 @@ def test_100in_100_10_4out():
 
   X = numpy.random.rand(20,100)
   assert numpy.allclose(m(X), pymac.forward(X), rtol=1e-10, atol=1e-15)
+
+def test_batch_forward():
+
+  # more samples than a single mini-batch, with different activations
+  m = MLP((30,50,20,3))
+  m.hidden_activation = LogisticActivation()
+  m.randomize()
+  m.input_subtract = numpy.random.rand(30)
+  m.input_divide = numpy.random.rand(30) + 0.5
+
+  X = numpy.random.rand(600,30)
+  Y = m(X)
+  assert Y.shape == (600,3)
+  for k in range(X.shape[0]):
+    assert numpy.allclose(Y[k], m(X[k]), rtol=1e-10, atol=1e-15)
+
 def test_resize():
     
   m = MLP((2,3,5,1))
@@ -26,6 +26,7 @@ import unittest
 import numpy
 import bob
 import pkg_resources
+from ...test import utils
 
 def F(f):
   """Returns the test file on the "data" subdirectory"""
@@ -136,3 +137,104 @@ class ZTNormTest(unittest.TestCase):
     empty = numpy.zeros(shape=(0,0), dtype=numpy.float64)
     zA = bob.machine.ztnorm(my_A, my_B, empty, empty)
     self.assertTrue((abs(zA - zA_py) < 1e-7).all())
+
+  def test05_normalizer_blocks(self):
+    my_A = bob.io.load(F("ztnorm_eval_eval.mat"))
+    my_B = bob.io.load(F("ztnorm_znorm_eval.mat"))
+    my_C = bob.io.load(F("ztnorm_eval_tnorm.mat"))
+    my_D = bob.io.load(F("ztnorm_znorm_tnorm.mat"))
+    ref_scores = bob.io.load(F("ztnorm_result.mat"))
+
+    for n_threads in (1, 3):
+      with utils.n_threads(n_threads):
+        # Streams the cohort scores and normalizes by tiles
+        n = bob.machine.ZTNormalizer(my_A.shape[0], my_A.shape[1])
+        for r in range(0, my_B.shape[0], 7):
+          for c in range(0, my_B.shape[1], 11):
+            n.accumulate_znorm(my_B[r:r+7, c:c+11], r)
+        for c in range(0, my_D.shape[1], 5):
+          n.accumulate_ztnorm(my_D[:, c:c+5])
+        for r in range(0, my_C.shape[0], 3):
+          for c in range(0, my_C.shape[1], 13):
+            n.accumulate_tnorm(my_C[r:r+3, c:c+13], r, c)
+        scores = numpy.ndarray(my_A.shape, numpy.float64)
+        for r in range(0, my_A.shape[0], 9):
+          for c in range(0, my_A.shape[1], 4):
+            scores[r:r+9, c:c+4] = n.normalize(my_A[r:r+9, c:c+4], r, c)
+        self.assertTrue((abs(scores - ref_scores) < 1e-7).all())
+
+        # T-Norm and Z-Norm
+        n = bob.machine.ZTNormalizer(my_A.shape[0], my_A.shape[1])
+        n.accumulate_tnorm(my_C)
+        self.assertTrue((abs(n.normalize(my_A) - tnorm(my_A, my_C)) < 1e-7).all())
+        n.reset()
+        n.accumulate_znorm(my_B)
+        self.assertTrue((abs(n.normalize(my_A) - znorm(my_A, my_B)) < 1e-7).all())
+
+  def test06_normalizer_adaptive_symmetric(self):
+    my_A = bob.io.load(F("ztnorm_eval_eval.mat"))
+    my_B = bob.io.load(F("ztnorm_znorm_eval.mat"))
+    my_C = bob.io.load(F("ztnorm_eval_tnorm.mat"))
+    top_n = 5
+
+    n = bob.machine.ZTNormalizer(my_A.shape[0], my_A.shape[1], top_n)
+    self.assertEqual(n.top_n, top_n)
+    n.accumulate_znorm(my_B)
+    n.accumulate_tnorm(my_C)
+    scores = n.symmetric_normalize(my_A)
+
+    # Reference: statistics of the top_n highest cohort scores
+    best_B = numpy.sort(my_B, axis=1)[:, -top_n:]
+    best_C = numpy.sort(my_C, axis=0)[-top_n:, :]
+    z = (my_A - best_B.mean(axis=1).reshape(-1,1)) / best_B.std(axis=1, ddof=1).reshape(-1,1)
+    t = (my_A - best_C.mean(axis=0).reshape(1,-1)) / best_C.std(axis=0, ddof=1).reshape(1,-1)
+    self.assertTrue((abs(scores - 0.5 * (z + t)) < 1e-7).all())
+
+    # Symmetric normalization requires both statistics
+    n.reset()
+    n.accumulate_znorm(my_B)
+    self.assertRaises(RuntimeError, n.symmetric_normalize, my_A)
+
+  def test07_normalizer_files(self):
+    import tempfile
+    my_A = bob.io.load(F("ztnorm_eval_eval.mat"))
+    my_B = bob.io.load(F("ztnorm_znorm_eval.mat"))
+    my_C = bob.io.load(F("ztnorm_eval_tnorm.mat"))
+    my_D = bob.io.load(F("ztnorm_znorm_tnorm.mat"))
+    ref_scores = bob.io.load(F("ztnorm_result.mat"))
+
+    filename = tempfile.mkstemp(prefix='bobtest_', suffix='.hdf5')[1]
+    try:
+      f = bob.io.HDF5File(filename, 'w')
+      for name, scores in (('A', my_A), ('B', my_B), ('C', my_C), ('D', my_D)):
+        for row in scores: f.append(name, row)
+
+      n = bob.machine.ZTNormalizer(my_A.shape[0], my_A.shape[1])
+      n.accumulate_znorm_from_file(f, 'B')
+      n.accumulate_ztnorm_from_file(f, 'D')
+      n.accumulate_tnorm_from_file(f, 'C')
+      n.normalize_file(f, 'A', f, 'ZT')
+      scores = numpy.vstack([f.lread('ZT', i) for i in range(my_A.shape[0])])
+      self.assertTrue((abs(scores - ref_scores) < 1e-7).all())
+      del f
+    finally:
+      os.unlink(filename)
+
+  def test08_ztnorm_all_masked(self):
+    # A T-norm model with all its Z-norm scores masked has a NaN mean, which
+    # makes all the ZT-normalized scores NaN
+    my_A = numpy.array([[1, 2, 3, 4, 5], [6, 7, 8, 9, 8], [7, 6, 5, 4, 3]],'float64')
+    my_B = numpy.array([[5, 4, 7, 8],[9, 8, 7, 4],[5, 6, 3, 2]],'float64')
+    my_C = numpy.array([[5, 4, 3, 2, 1],[2, 1, 2, 3, 4]],'float64')
+    my_D = numpy.array([[8, 6, 4, 2],[0, 2, 4, 6]],'float64')
+    mask = numpy.zeros((2, 4), 'bool')
+    mask[0,:] = True
+
+    scores = bob.machine.ztnorm(my_A, my_B, my_C, my_D, mask)
+    self.assertTrue(numpy.isnan(scores).all())
+
+    n = bob.machine.ZTNormalizer(my_A.shape[0], my_A.shape[1])
+    n.accumulate_znorm(my_B)
+    n.accumulate_ztnorm(my_D, mask)
+    n.accumulate_tnorm(my_C)
+    self.assertTrue(numpy.isnan(n.normalize(my_A)).all())
@@ -308,3 +308,57 @@ class ErrorTest(unittest.TestCase):
     self.assertAlmostEqual(min_cllr, 0.337364136)
 
 
+
+  def test08_large_sets(self):
+    # The curves are computed on sorted scores, which are sorted in parallel
+    # for large sets. Compares with the rates computed at each threshold on
+    # the unsorted scores.
+    numpy.random.seed(0)
+    negatives = numpy.round(numpy.random.randn(200000), 2)
+    positives = numpy.round(numpy.random.randn(5000) + 2., 2)
+
+    xy = bob.measure.roc(negatives, positives, 50)
+    pr = bob.measure.precision_recall_curve(negatives, positives, 50)
+    low = min(negatives.min(), positives.min())
+    high = max(negatives.max(), positives.max())
+    step = (high - low) / 49.
+    for i in range(50):
+      far, frr = bob.measure.farfrr(negatives, positives, low + i*step)
+      self.assertEqual(xy[0,i], frr)
+      self.assertEqual(xy[1,i], far)
+      precision, recall = bob.measure.precision_recall(negatives, positives, low + i*step)
+      self.assertEqual(pr[0,i], precision)
+      self.assertEqual(pr[1,i], recall)
+
+    # The thresholds are consistent with the FAR/FRR of the scores
+    threshold = bob.measure.eer_threshold(negatives, positives)
+    far, frr = bob.measure.farfrr(negatives, positives, threshold)
+    self.assertTrue(abs(far - frr) < 1e-2)
+    threshold = bob.measure.far_threshold(negatives, positives, 0.01)
+    far = bob.measure.farfrr(negatives, positives, threshold)[0]
+    self.assertTrue(far + 1e-7 > 0.01 and far - 0.01 < 1e-3)
+
+  def test09_nan_scores(self):
+    # NaN scores are neither false accepts nor false rejects, but count in
+    # the totals, as in farfrr() on the unsorted scores
+    nan = float('nan')
+    negatives = numpy.array([0., 1., nan, 2., 2.5])
+    positives = numpy.array([1.5, 3., nan, 4., 5.])
+    finite = numpy.hstack((negatives[:2], negatives[3:], positives[:2], positives[3:]))
+
+    xy = bob.measure.roc(negatives, positives, 10)
+    pr = bob.measure.precision_recall_curve(negatives, positives, 10)
+    low = finite.min()
+    step = (finite.max() - low) / 9.
+    for i in range(10):
+      far, frr = bob.measure.farfrr(negatives, positives, low + i*step)
+      self.assertEqual(xy[0,i], frr)
+      self.assertEqual(xy[1,i], far)
+      precision, recall = bob.measure.precision_recall(negatives, positives, low + i*step)
+      self.assertEqual(pr[0,i], precision)
+      self.assertEqual(pr[1,i], recall)
+
+    # The thresholds are computed on the other scores
+    self.assertFalse(numpy.isnan(bob.measure.eer_threshold(negatives, positives)))
+    self.assertFalse(numpy.isnan(bob.measure.far_threshold(negatives, positives, 0.2)))
+    self.assertFalse(numpy.isnan(bob.measure.frr_threshold(negatives, positives, 0.2)))
@@ -78,6 +78,23 @@ def _fft1D(N, t, eps, obj):
   for i in range(N):
     obj.assertTrue(compare(u_fft_ifft[i], t[i], 1e-3))
 
+def _rfft1D(N, t, eps, obj):
+  # process using the real FFT, and compare to the first part of the FFT
+  u_rfft = numpy.zeros((N//2+1,), 'complex128')
+  rfft = RFFT1D(N)
+  rfft(t,u_rfft)
+  u_fft = FFT1D(N)(t.astype('complex128'))
+  for i in range(N//2+1):
+    obj.assertTrue(compare(u_rfft[i], u_fft[i], eps))
+
+  # process using inverse real FFT
+  u_rfft_irfft = IRFFT1D(N)(u_rfft)
+  obj.assertEqual(u_rfft_irfft.shape, (N,))
+
+  # get answer and compare to original
+  for i in range(N):
+    obj.assertTrue(compare(u_rfft_irfft[i], t[i], eps))
+
 
 def _fft2D(M, N, t, eps, obj):
   # process using FFT
@@ -189,6 +206,27 @@ class TransformTest(unittest.TestCase):
       _fft1D(N, t, 1e-3, self)
 
 
+  def test_rfft1D_1to64_set(self):
+    # size of the data
+    for N in range(1,65):
+      # set up simple 1D tensor
+      t = numpy.arange(1., N+1.)
+
+      # call the test function
+      _rfft1D(N, t, 1e-3, self)
+
+  def test_rfft1D_range1to2048_random(self):
+    # This tests the 1D real FFT using 10 random vectors
+    for loop in range(0,10):
+      # size of the data
+      N = random.randint(1,2048)
+
+      # set up simple 1D random tensor 
+      t = numpy.array([random.uniform(1, 10) for i in range(N)])
+
+      # call the test function
+      _rfft1D(N, t, 1e-3, self)
+
   def test_fft2D_1x1to8x8_set(self):
     # size of the data
     for M in range(1,9):
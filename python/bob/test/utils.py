@@ -10,6 +10,7 @@ import os
 import tempfile
 import pkg_resources
 import functools
+import contextlib
 from nose.plugins.skip import SkipTest
 from distutils.version import StrictVersion as SV
 
@@ -49,6 +50,27 @@ def temporary_filename(prefix='bobtest_', suffix='.hdf5'):
   os.unlink(name)
   return name
 
+@contextlib.contextmanager
+def n_threads(n):
+  """Runs the enclosed code with n threads in the pool of bob.core, and
+  restores the previous number of threads afterwards
+
+  To use this, enclose the code to be tested in a ``with`` statement:
+
+  .. code-block:: python
+
+    with n_threads(4):
+      ...
+  """
+
+  from ..core import get_n_threads, set_n_threads
+  previous = get_n_threads()
+  set_n_threads(n)
+  try:
+    yield
+  finally:
+    set_n_threads(previous)
+
 # Here is a table of ffmpeg versions against libavcodec, libavformat and
 # libavutil versions
 ffmpeg_versions = {
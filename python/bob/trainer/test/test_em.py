@@ -20,6 +20,7 @@
 """Test trainer package
 """
 import os, sys
+import tempfile
 import unittest
 import bob
 import random
@@ -260,3 +261,31 @@ class GMMTest(unittest.TestCase):
     
     for i in range(0, 2):
       self.assertTrue((ar[i+1] == machine.means[i, :]).all())
+
+  def test08_gmm_ML_sampler(self):
+
+    # Trains a GMMMachine with ML_GMMTrainer over the blocks of samples
+    # streamed from two files, and compares with the training in memory
+
+    ar = bob.io.load(F("faithful.torch3_f64.hdf5"))
+    filenames = [str(tempfile.mkstemp(".hdf5")[1]) for i in range(2)]
+    try:
+      bob.io.save(ar[:100], filenames[0])
+      bob.io.save(ar[100:], filenames[1])
+      sampler = bob.trainer.DataBlockSampler(filenames, 33)
+
+      gmm_ref = loadGMM()
+      ml_gmmtrainer = bob.trainer.ML_GMMTrainer(True, True, True)
+      ml_gmmtrainer.train(gmm_ref, ar)
+
+      gmm = loadGMM()
+      ml_gmmtrainer = bob.trainer.ML_GMMTrainer(True, True, True)
+      ml_gmmtrainer.train(gmm, sampler)
+
+      self.assertTrue(equals(gmm.means, gmm_ref.means, 1e-8))
+      self.assertTrue(equals(gmm.variances, gmm_ref.variances, 1e-8))
+      self.assertTrue(equals(gmm.weights, gmm_ref.weights, 1e-8))
+
+    finally:
+      for filename in filenames:
+        os.unlink(filename)
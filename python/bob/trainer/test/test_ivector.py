@@ -21,6 +21,7 @@
 
 import unittest
 import bob, numpy, numpy.linalg, numpy.random
+from ...test import utils
 
 ### Test class inspired by an implementation of Chris McCool
 ### Chris McCool (chris.mccool@nicta.com.au)
@@ -373,3 +374,44 @@ class IVectorTests(unittest.TestCase):
       self.assertTrue(numpy.allclose(t_ref[it], m.t, 1e-5))
       self.assertTrue(numpy.allclose(sigma_ref[it], m.sigma, 1e-5))
 
+
+  def test03_trainer_threads(self):
+    # Random UBM and statistics, more than a block of samples
+    numpy.random.seed(5)
+    dim_c, dim_d, dim_t = 3, 2, 4
+    ubm = bob.machine.GMMMachine(dim_c, dim_d)
+    ubm.weights = numpy.ones((dim_c,), numpy.float64) / dim_c
+    ubm.means = numpy.random.randn(dim_c, dim_d)
+    ubm.variances = numpy.random.rand(dim_c, dim_d) + 0.5
+    data = []
+    for i in range(300):
+      gs = bob.machine.GMMStats(dim_c, dim_d)
+      gs.n = numpy.random.rand(dim_c) * 10
+      gs.sum_px = numpy.random.randn(dim_c, dim_d)
+      gs.sum_pxx = numpy.random.rand(dim_c, dim_d) * 10
+      data.append(gs)
+    t = numpy.random.randn(dim_c*dim_d, dim_t)
+    sigma = numpy.random.rand(dim_c*dim_d) + 0.5
+
+    # Python implementation of the E-step
+    m = bob.machine.IVectorMachine(ubm, dim_t)
+    trainer = IVectorTrainerPy(sigma_update=True)
+    trainer.initialize(m, data)
+    m.t = t
+    m.sigma = sigma
+    trainer.e_step(m, data)
+
+    # C++ implementation, with one and several threads
+    for n in (1, 4):
+      with utils.n_threads(n):
+        m = bob.machine.IVectorMachine(ubm, dim_t)
+        trainer_c = bob.trainer.IVectorTrainer(update_sigma=True)
+        trainer_c.initialize(m, data)
+        m.t = t
+        m.sigma = sigma
+        trainer_c.e_step(m, data)
+        for c in range(dim_c):
+          self.assertTrue(numpy.allclose(trainer.m_acc_Nij_Sigma_wij2[c], trainer_c.acc_nij_wij2[c], 1e-8))
+          self.assertTrue(numpy.allclose(trainer.m_acc_Fnorm_Sigma_wij[c], trainer_c.acc_fnormij_wij[c], 1e-8))
+        self.assertTrue(numpy.allclose(trainer.m_acc_Snorm.reshape(dim_c,dim_d), trainer_c.acc_snormij, 1e-8))
+        self.assertTrue(numpy.allclose(trainer.m_N, trainer_c.acc_nij, 1e-8))
@@ -20,11 +20,13 @@
 """Test K-Means algorithm
 """
 import os, sys
+import tempfile
 import unittest
 import bob
 import random
 import numpy
 import pkg_resources
+from ...test import utils
 
 def F(f, module=None):
   """Returns the test file on the "data" subdirectory"""
@@ -197,3 +199,114 @@ class KMeansTest(unittest.TestCase):
     trainer.train(machine, data)
     self.assertFalse( numpy.isnan(machine.means).any())
 
+
+  def test04_kmeans_e_step(self):
+
+    # Compares the E-step, which finds the closest means in parallel blocks
+    # of samples, with a direct implementation
+    dim_c = 7
+    dim_d = 5
+    data = numpy.random.randn(1000, dim_d)
+    machine = bob.machine.KMeansMachine(dim_c, dim_d)
+    means = numpy.random.randn(dim_c, dim_d)
+    machine.means = means
+
+    distances = numpy.array([[numpy.sum((x - m) ** 2) for m in machine.means]
+      for x in data])
+    closest = numpy.argmin(distances, axis=1)
+    zeroeth = numpy.array([numpy.sum(closest == k) for k in range(dim_c)],
+        'float64')
+    first = numpy.array([numpy.sum(data[closest == k], axis=0)
+      for k in range(dim_c)])
+    average = numpy.mean(numpy.min(distances, axis=1))
+
+    for n in (1, 3):
+      with utils.n_threads(n):
+        trainer = bob.trainer.KMeansTrainer()
+        trainer.initialize(machine, data) # resizes the statistics
+        machine.means = means
+        trainer.e_step(machine, data)
+        self.assertTrue((trainer.zeroeth_order_statistics == zeroeth).all())
+        self.assertTrue(equals(trainer.first_order_statistics, first, 1e-10))
+        self.assertTrue(abs(trainer.average_min_distance - average) < 1e-10)
+
+  def test05_kmeans_sampler(self):
+
+    # Streams the samples from two files by (small) blocks, and compares the
+    # statistics with the ones of the data in memory
+    data = bob.io.load(F("samplesFrom2G_f64.hdf5"))
+    filenames = [str(tempfile.mkstemp(".hdf5")[1]) for i in range(2)]
+    try:
+      bob.io.save(data[:120], filenames[0])
+      bob.io.save(data[120:], filenames[1])
+
+      for prefetch in (True, False):
+        sampler = bob.trainer.DataBlockSampler(filenames, 17, prefetch)
+        self.assertEqual(sampler.n_inputs, 1)
+        blocks = []
+        block = sampler.next()
+        while block is not None:
+          blocks.append(block)
+          block = sampler.next()
+        self.assertTrue((numpy.vstack(blocks) == data).all())
+
+        machine = bob.machine.KMeansMachine(2, 1)
+        trainer = bob.trainer.KMeansTrainer()
+        trainer.initialize(machine, sampler)
+        # The initial means are samples
+        for m in machine.means:
+          self.assertTrue((data == m).any())
+        means = numpy.array([[-1.], [1.]])
+        machine.means = means
+        trainer.e_step(machine, sampler)
+        zeroeth = trainer.zeroeth_order_statistics
+        first = trainer.first_order_statistics
+        average = trainer.average_min_distance
+        trainer.e_step(machine, data)
+        self.assertTrue((trainer.zeroeth_order_statistics == zeroeth).all())
+        self.assertTrue(equals(trainer.first_order_statistics, first, 1e-10))
+        self.assertTrue(abs(trainer.average_min_distance - average) < 1e-10)
+
+      # Training with and without mini-batch k-means (see test02_kmeans_a)
+      for mini_batch_size in (0, 10):
+        machine = bob.machine.KMeansMachine(2, 1)
+        trainer = bob.trainer.KMeansTrainer()
+        trainer.mini_batch_size = mini_batch_size
+        trainer.train(machine, sampler)
+        means = numpy.sort(machine.means[:,0])
+        self.assertTrue(equals(means, numpy.array([-10.,10.]), 2e-1))
+
+    finally:
+      for filename in filenames:
+        os.unlink(filename)
+
+  def test06_sampler_sets(self):
+
+    # Streams sets of samples (2D arrays of float32) and a 2D array of
+    # samples, with blocks smaller and larger than the sets
+    numpy.random.seed(3)
+    sets = [numpy.random.randn(7, 3).astype('float32') for i in range(5)]
+    data = numpy.random.randn(11, 3)
+    filenames = [str(tempfile.mkstemp(".hdf5")[1]) for i in range(2)]
+    try:
+      f = bob.io.HDF5File(filenames[0], 'w')
+      f.append('sets', sets)
+      del f
+      bob.io.save(data, filenames[1])
+      reference = numpy.vstack(sets + [data])
+
+      for block_size in (5, 7, 16):
+        for prefetch in (True, False):
+          sampler = bob.trainer.DataBlockSampler(filenames, block_size, prefetch)
+          self.assertEqual(sampler.n_inputs, 3)
+          blocks = []
+          block = sampler.next()
+          while block is not None:
+            self.assertTrue(block.shape[0] <= block_size)
+            blocks.append(block)
+            block = sampler.next()
+          self.assertTrue((numpy.vstack(blocks) == reference).all())
+
+    finally:
+      for filename in filenames:
+        os.unlink(filename)
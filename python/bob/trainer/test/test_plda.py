@@ -23,6 +23,7 @@
 import sys, unittest
 import bob
 import numpy, numpy.linalg
+from ...test import utils
 
 class PythonPLDATrainer():
   """A simplified (and slower) version of the PLDATrainer"""
@@ -744,3 +745,53 @@ class PLDATrainerTest(unittest.TestCase):
     self.assertFalse( t1 == t2 )
     self.assertTrue(  t1 != t2 )
     self.assertFalse( t1.is_similar_to(t2) )
+
+  def test05_plda_EM_threads(self):
+
+    # Identities with different numbers of samples
+    D = 7
+    nf = 2
+    ng = 3
+    numpy.random.seed(5)
+    l = [numpy.random.randn(n, D) + 3. * numpy.random.randn(D) for n in (1,2,3,5,2,4,1,3,6,2)]
+
+    for n in (1, 4):
+      with utils.n_threads(n):
+        for use_sum_second_order in (True, False):
+          t = bob.trainer.PLDATrainer(10, use_sum_second_order)
+          t.init_f_method = bob.trainer.PLDATrainer.BETWEEN_SCATTER
+          t.init_g_method = bob.trainer.PLDATrainer.WITHIN_SCATTER
+          t.init_sigma_method = bob.trainer.PLDATrainer.VARIANCE_DATA
+          m = bob.machine.PLDABase(D,nf,ng)
+          t.initialize(m, l)
+
+          # Python implementation, with the same initialization
+          t_py = PythonPLDATrainer()
+          m_py = bob.machine.PLDABase(D,nf,ng)
+          t_py.initialize(m_py, l)
+          m_py.mu = m.mu
+          m_py.sigma = m.sigma
+          m_py.g = m.g
+          m_py.f = m.f
+
+          # Runs two EM steps
+          for k in range(2):
+            t.e_step(m, l)
+            t_py.e_step(m_py, l)
+            for i in range(len(l)):
+              self.assertTrue(numpy.allclose(t.z_first_order[i], t_py.m_z_first_order[i], 1e-10))
+              if not use_sum_second_order:
+                self.assertTrue(numpy.allclose(t.z_second_order[i], t_py.m_z_second_order[i], 1e-10))
+            self.assertTrue(numpy.allclose(t.z_second_order_sum, t_py.m_sum_z_second_order, 1e-10))
+            t.m_step(m, l)
+            t_py.m_step(m_py, l)
+            self.assertTrue(numpy.allclose(m.f, m_py.f, 1e-10))
+            self.assertTrue(numpy.allclose(m.g, m_py.g, 1e-10))
+            self.assertTrue(numpy.allclose(m.sigma, m_py.sigma, 1e-10))
+
+          # The gamma_a and the log likelihood constant terms of all the
+          # numbers of samples are cached at the end of the training
+          t.finalize(m, l)
+          for a in (1,2,3,4,5,6):
+            self.assertTrue(m.has_gamma(a))
+            self.assertTrue(m.has_log_like_const_term(a))
@@ -47,6 +47,7 @@ TEST_MACHINE_NO_PROBS = F('heart_no_probs.svmmodel', 'machine')
 
 HEART_DATA = F('heart.svmdata', 'machine') #13 inputs
 HEART_MACHINE = F('heart.svmmodel', 'machine') #supports probabilities
+IRIS_DATA = F('iris.svmdata', 'machine')
 HEART_EXPECTED = F('heart.out', 'machine') #expected probabilities
 
 class SvmTrainingTest(unittest.TestCase):
@@ -148,3 +149,86 @@ class SvmTrainingTest(unittest.TestCase):
     curr_scores = numpy.array(curr_scores)
     prev_scores = numpy.array(prev_scores)
     #self.assertTrue( numpy.all(abs(curr_scores-prev_scores) < 1e-8) )
+
+  @utils.libsvm_available
+  def test04_batch_prediction_kernels(self):
+
+    # the batch predictions should be the same as the ones of each sample,
+    # for all kernels (the linear ones use a collapsed weight vector)
+    f = bob.machine.SVMFile(HEART_DATA)
+    labels, data = f.read_all()
+    neg = numpy.vstack([k for i,k in enumerate(data) if labels[i] < 0])
+    pos = numpy.vstack([k for i,k in enumerate(data) if labels[i] > 0])
+    data = numpy.vstack(data)
+
+    for kernel in (bob.machine.svm_kernel_type.LINEAR,
+        bob.machine.svm_kernel_type.POLY, bob.machine.svm_kernel_type.RBF,
+        bob.machine.svm_kernel_type.SIGMOID):
+      trainer = bob.trainer.SVMTrainer(kernel_type=kernel)
+      machine = trainer.train((pos, neg))
+
+      single = [machine.predict_class_and_scores(k) for k in data]
+      batch_labels, batch_scores = machine.predict_classes_and_scores(data)
+      self.assertEqual(tuple([k[0] for k in single]), batch_labels)
+      self.assertEqual(machine.predict_classes(data), batch_labels)
+      self.assertTrue( numpy.all(numpy.vstack([k[1] for k in single]) ==
+        numpy.vstack(batch_scores)) )
+      # with two classes, the label is given by the sign of the score
+      for l, s in zip(batch_labels, batch_scores):
+        self.assertEqual(l, machine.labels[0] if s[0] > 0 else machine.labels[1])
+
+  @utils.libsvm_available
+  def test05_multiclass_parallel(self):
+
+    # the one-versus-one sub-problems are trained in parallel, unless
+    # probabilities are estimated (in which case libsvm trains them all).
+    # The decision functions should be the same.
+    f = bob.machine.SVMFile(IRIS_DATA)
+    labels, data = f.read_all()
+    classes = sorted(set(labels))
+    arrays = [numpy.vstack([k for i,k in enumerate(data) if labels[i] == c])
+        for c in classes]
+    data = numpy.vstack(data)
+
+    reference = bob.trainer.SVMTrainer(probability=True).train(arrays)
+    ref_labels, ref_scores = reference.predict_classes_and_scores(data)
+
+    for n in (1, 3):
+      with utils.n_threads(n):
+        machine = bob.trainer.SVMTrainer().train(arrays)
+        curr_labels, curr_scores = machine.predict_classes_and_scores(data)
+        self.assertEqual(curr_labels, ref_labels)
+        self.assertTrue( numpy.all(numpy.vstack(curr_scores) ==
+          numpy.vstack(ref_scores)) )
+
+  @utils.libsvm_available
+  def test06_grid(self):
+
+    # each machine of the grid is the one trained with the same parameters
+    f = bob.machine.SVMFile(HEART_DATA)
+    labels, data = f.read_all()
+    neg = numpy.vstack([k for i,k in enumerate(data) if labels[i] < 0])
+    pos = numpy.vstack([k for i,k in enumerate(data) if labels[i] > 0])
+    data = numpy.vstack(data)
+    problem = bob.trainer.SVMProblem((pos, neg))
+    self.assertEqual(problem.number_of_classes, 2)
+    self.assertEqual(problem.number_of_samples, data.shape[0])
+    self.assertEqual(problem.input_size, data.shape[1])
+
+    costs = (0.5, 1., 4.)
+    gammas = (0.01, 0.1)
+    trainer = bob.trainer.SVMTrainer()
+    machines = trainer.train_grid(problem, costs, gammas)
+    self.assertEqual(len(machines), len(costs) * len(gammas))
+    for i, cost in enumerate(costs):
+      for j, gamma in enumerate(gammas):
+        trainer.cost = cost
+        trainer.gamma = gamma
+        machine = trainer.train(problem)
+        grid_machine = machines[i*len(gammas)+j]
+        self.assertEqual(grid_machine.gamma, gamma)
+        curr_labels, curr_scores = grid_machine.predict_classes_and_scores(data)
+        ref_labels, ref_scores = machine.predict_classes_and_scores(data)
+        self.assertEqual(curr_labels, ref_labels)
+        self.assertTrue( numpy.all(numpy.vstack(curr_scores) ==
+          numpy.vstack(ref_scores)) )
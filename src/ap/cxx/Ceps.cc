@@ -25,6 +25,9 @@
 #include <bob/ap/Ceps.h>
 #include <bob/core/assert.h>
 #include <bob/core/cast.h>
+#include <bob/core/parallel.h>
+#include <boost/bind.hpp>
+#include <algorithm>
 
 bob::ap::Ceps::Ceps(const double sampling_frequency,
     const double win_length_ms, const double win_shift_ms,
@@ -146,7 +149,7 @@ blitz::TinyVector<int,2> bob::ap::Ceps::getShape(const blitz::Array<double,1>& i
 }
 
 void bob::ap::Ceps::operator()(const blitz::Array<double,1>& input, 
-  blitz::Array<double,2>& ceps_matrix)
+  blitz::Array<double,2>& ceps_matrix) const
 {
   // Get expected dimensionality of output array
   blitz::TinyVector<int,2> feature_shape = bob::ap::Ceps::getShape(input);
@@ -154,28 +157,14 @@ void bob::ap::Ceps::operator()(const blitz::Array<double,1>& input,
   bob::core::array::assertSameShape(ceps_matrix, feature_shape);
   int n_frames=feature_shape(0);
 
-  blitz::Range r1(0,m_n_ceps-1);
-  for (int i=0; i<n_frames; ++i) 
-  {
-    // Set padded frame to zero
-    extractNormalizeFrame(input, i, m_cache_frame_d);
-
-    // Update output with energy if required
-    if (m_with_energy)
-      ceps_matrix(i,(int)m_n_ceps) = logEnergy(m_cache_frame_d);
-
-    // Apply pre-emphasis
-    pre_emphasis(m_cache_frame_d);
-    // Apply the Hamming window
-    hammingWindow(m_cache_frame_d);
-    // Take the power spectrum of the first part of the FFT
-    powerSpectrumFFT(m_cache_frame_d);
-    // Filter with the triangular filter bank (either in linear or Mel domain)
-    filterBank(m_cache_frame_d);
-    // Apply DCT kernel and update the output 
-    blitz::Array<double,1> ceps_matrix_row(ceps_matrix(i,r1));
-    applyDct(ceps_matrix_row);
-  }
+  // Frames are independent, and processed in parallel by blocks of
+  // CEPS_BATCH_SIZE frames, with working arrays per thread
+  std::vector<FrameCache> caches;
+  initFrameCaches(caches, CEPS_BATCH_SIZE);
+  bob::core::parallelFor(0, n_frames,
+    boost::bind(&bob::ap::Ceps::processFrames, this, boost::cref(input),
+      boost::ref(ceps_matrix), boost::ref(caches), _1, _2, _3),
+    CEPS_BATCH_SIZE);
 
   //compute the center of the cut-off frequencies
   const int n_coefs = (m_with_energy ?  m_n_ceps + 1 :  m_n_ceps);
@@ -197,11 +186,63 @@ void bob::ap::Ceps::operator()(const blitz::Array<double,1>& input,
   }
 }
 
-void bob::ap::Ceps::applyDct(blitz::Array<double,1>& ceps_row) const
+void bob::ap::Ceps::processFrames(const blitz::Array<double,1>& input,
+  blitz::Array<double,2>& ceps_matrix, std::vector<FrameCache>& caches,
+  size_t begin, size_t end, size_t thread) const
 {
-  blitz::firstIndex i;
-  blitz::secondIndex j;
-  ceps_row = blitz::sum(m_cache_filters(j) * m_dct_kernel(i,j), j);
+  // The output is written by element, and only the working arrays of this
+  // thread are sliced
+  FrameCache& cache = caches[thread];
+  blitz::Range rall = blitz::Range::all();
+  // The range may be longer than the cache (e.g. if processed serially), and
+  // is hence split into blocks of at most CEPS_BATCH_SIZE frames
+  for (size_t block=begin; block<end; block+=CEPS_BATCH_SIZE)
+  {
+    const size_t block_end = std::min(end, block+CEPS_BATCH_SIZE);
+    for (size_t i=block; i<block_end; ++i)
+    {
+      blitz::Array<double,1> filters(cache.filters((int)(i-block), rall));
+      double energy = 0.;
+      processFrame(input, i, cache.frame_d, cache.frame_c, filters,
+        m_with_energy ? &energy : 0);
+      // Update output with energy if required
+      if (m_with_energy)
+        ceps_matrix(i,(int)m_n_ceps) = energy;
+    }
+
+    // Apply the DCT kernel to the output of the filters of the block
+    applyDct(cache.filters, block_end-block, ceps_matrix, block);
+  }
+}
+
+void bob::ap::Ceps::computeFrame(const blitz::Array<double,1>& input,
+  const size_t i, blitz::Array<double,1>& ceps_row)
+{
+  double energy = 0.;
+  processFrame(input, i, m_cache_frame_d, m_cache_frame_c, m_cache_filters,
+    m_with_energy ? &energy : 0);
+
+  // Update output with energy if required
+  if (m_with_energy)
+    ceps_row((int)m_n_ceps) = energy;
+
+  // Apply DCT kernel and update the output 
+  for (int c=0; c<(int)m_n_ceps; ++c)
+    ceps_row(c) = dctCoefficient(m_cache_filters, c);
+}
+
+void bob::ap::Ceps::applyDct(const blitz::Array<double,2>& filters,
+  const size_t n_frames, blitz::Array<double,2>& ceps_matrix,
+  const size_t offset) const
+{
+  // ceps_matrix[offset:offset+n_frames, :n_ceps] = filters * dct_kernel^T
+  blitz::Range rall = blitz::Range::all();
+  for (int i=0; i<(int)n_frames; ++i)
+  {
+    blitz::Array<double,1> filters_row(filters(i, rall));
+    for (int c=0; c<(int)m_n_ceps; ++c)
+      ceps_matrix(offset+i,c) = dctCoefficient(filters_row, c);
+  }
 }
 
 void bob::ap::Ceps::addDerivative(const blitz::Array<double,2>& input, blitz::Array<double,2>& output) const
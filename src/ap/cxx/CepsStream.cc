@@ -0,0 +1,296 @@
+/**
+ * @file ap/cxx/CepsStream.cc
+ * @date Sat Oct 17 16:12:08 CEST 2026
+ * @author Laurent El Shafey <Laurent.El-Shafey@idiap.ch>
+ *
+ * @brief Extracts cepstral features (MFCC and LFCC) from an audio stream,
+ * one block of samples at a time
+ *
+ * Copyright (C) 2011-2013 Idiap Research Institute, Martigny, Switzerland
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <bob/ap/CepsStream.h>
+#include <boost/format.hpp>
+#include <algorithm>
+#include <stdexcept>
+
+bob::ap::CepsStream::CepsStream(const bob::ap::Ceps& ceps):
+  m_ceps(ceps)
+{
+  initCache();
+}
+
+bob::ap::CepsStream::CepsStream(const bob::ap::CepsStream& other):
+  m_ceps(other.m_ceps)
+{
+  initCache();
+  m_samples = other.m_samples;
+  m_n_samples = other.m_n_samples;
+  m_n_skip = other.m_n_skip;
+  m_ring_static = other.m_ring_static;
+  m_ring_delta = other.m_ring_delta;
+  m_ring_delta_delta = other.m_ring_delta_delta;
+  m_n_frames = other.m_n_frames;
+  m_n_delta = other.m_n_delta;
+  m_n_delta_delta = other.m_n_delta_delta;
+  m_n_output = other.m_n_output;
+}
+
+bob::ap::CepsStream&
+bob::ap::CepsStream::operator=(const bob::ap::CepsStream& other)
+{
+  if (this != &other)
+  {
+    m_ceps = other.m_ceps;
+    initCache();
+    m_samples = other.m_samples;
+    m_n_samples = other.m_n_samples;
+    m_n_skip = other.m_n_skip;
+    m_ring_static = other.m_ring_static;
+    m_ring_delta = other.m_ring_delta;
+    m_ring_delta_delta = other.m_ring_delta_delta;
+    m_n_frames = other.m_n_frames;
+    m_n_delta = other.m_n_delta;
+    m_n_delta_delta = other.m_n_delta_delta;
+    m_n_output = other.m_n_output;
+  }
+  return *this;
+}
+
+bob::ap::CepsStream::~CepsStream()
+{
+}
+
+void bob::ap::CepsStream::initCache()
+{
+  m_n_coefs = m_ceps.getNCeps() + (m_ceps.getWithEnergy() ? 1 : 0);
+  m_n_features = m_n_coefs;
+  if (m_ceps.getWithDelta())
+  {
+    m_n_features += m_n_coefs;
+    if (m_ceps.getWithDeltaDelta()) m_n_features += m_n_coefs;
+  }
+
+  // The derivatives of the i-th frame require the frames i-delta_win to
+  // i+delta_win, and the second order ones the first order derivatives of
+  // these frames. When the stream ends, the second order derivatives of the
+  // 2*delta_win last frames are pending and need the first order ones of the
+  // 3*delta_win last frames.
+  m_n_ring = 4*m_ceps.getDeltaWin() + 2;
+
+  m_samples.resize(m_ceps.getWinLength());
+  m_ring_static.resize(m_n_ring, m_n_coefs);
+  m_ring_delta.resize(m_ceps.getWithDelta() ? m_n_ring : 0, m_n_coefs);
+  m_ring_delta_delta.resize(m_ceps.getWithDeltaDelta() ? m_n_ring : 0,
+    m_n_coefs);
+  reset();
+}
+
+void bob::ap::CepsStream::reset()
+{
+  m_n_samples = 0;
+  m_n_skip = 0;
+  m_n_frames = 0;
+  m_n_delta = 0;
+  m_n_delta_delta = 0;
+  m_n_output = 0;
+}
+
+size_t bob::ap::CepsStream::getMaxNFrames(const size_t n_samples) const
+{
+  // Frames end every win_shift samples
+  const size_t win_shift = m_ceps.getWinShift();
+  return (n_samples + win_shift - 1) / win_shift;
+}
+
+void bob::ap::CepsStream::checkOutput(const blitz::Array<double,2>& output,
+  const size_t n_frames) const
+{
+  if ((size_t)output.extent(0) < n_frames ||
+      (size_t)output.extent(1) != m_n_features)
+  {
+    boost::format m("the output array has shape (%d,%d) whereas at least (%d,%d) is expected");
+    m % output.extent(0) % output.extent(1) % n_frames % m_n_features;
+    throw std::runtime_error(m.str());
+  }
+}
+
+size_t bob::ap::CepsStream::push(const blitz::Array<double,1>& input,
+  blitz::Array<double,2>& output)
+{
+  const size_t n_input = input.extent(0);
+  checkOutput(output, getMaxNFrames(n_input));
+
+  const size_t win_length = m_ceps.getWinLength();
+  const size_t win_shift = m_ceps.getWinShift();
+  double* samples = m_samples.data();
+  size_t n_output = 0;
+  size_t pos = 0;
+  while (pos < n_input)
+  {
+    // Skips the samples in between two windows
+    if (m_n_skip)
+    {
+      const size_t n = std::min(m_n_skip, n_input - pos);
+      m_n_skip -= n;
+      pos += n;
+      continue;
+    }
+
+    // Fills in the window
+    const size_t n = std::min(win_length - m_n_samples, n_input - pos);
+    for (size_t j=0; j<n; ++j)
+      samples[m_n_samples+j] = input(input.lbound(0)+(int)(pos+j));
+    m_n_samples += n;
+    pos += n;
+
+    if (m_n_samples == win_length)
+    {
+      processFrame(output, n_output);
+      // Keeps the overlap with the next window
+      if (win_shift < win_length)
+      {
+        std::copy(samples + win_shift, samples + win_length, samples);
+        m_n_samples = win_length - win_shift;
+      }
+      else
+      {
+        m_n_samples = 0;
+        m_n_skip = win_shift - win_length;
+      }
+    }
+  }
+  return n_output;
+}
+
+size_t bob::ap::CepsStream::flush(blitz::Array<double,2>& output)
+{
+  checkOutput(output, getNPendingFrames());
+
+  // The length of the stream is now known, which gives the right boundary
+  // of the derivatives
+  if (m_ceps.getWithDelta())
+  {
+    for (; m_n_delta<m_n_frames; ++m_n_delta)
+      derivative(m_ring_static, m_n_delta, m_n_frames, m_ring_delta);
+    if (m_ceps.getWithDeltaDelta())
+    {
+      for (; m_n_delta_delta<m_n_frames; ++m_n_delta_delta)
+        derivative(m_ring_delta, m_n_delta_delta, m_n_frames,
+          m_ring_delta_delta);
+    }
+  }
+
+  size_t n_output = 0;
+  while (m_n_output < m_n_frames)
+    outputFrame(m_n_output, output, n_output);
+
+  reset();
+  return n_output;
+}
+
+void bob::ap::CepsStream::processFrame(blitz::Array<double,2>& output,
+  size_t& n_output)
+{
+  const size_t k = m_n_frames++;
+  blitz::Array<double,1> row(m_ring_static((int)(k % m_n_ring),
+    blitz::Range::all()));
+  m_ceps.computeFrame(m_samples, 0, row);
+
+  if (!m_ceps.getWithDelta())
+  {
+    outputFrame(k, output, n_output);
+    return;
+  }
+
+  // The first order derivatives of frame k-delta_win are now known, and
+  // the second order ones of frame k-2*delta_win
+  const size_t delta_win = m_ceps.getDeltaWin();
+  if (k < delta_win) return;
+  derivative(m_ring_static, m_n_delta++, 0, m_ring_delta);
+  if (!m_ceps.getWithDeltaDelta())
+  {
+    outputFrame(k - delta_win, output, n_output);
+    return;
+  }
+
+  if (k < 2*delta_win) return;
+  derivative(m_ring_delta, m_n_delta_delta++, 0, m_ring_delta_delta);
+  outputFrame(k - 2*delta_win, output, n_output);
+}
+
+void bob::ap::CepsStream::derivative(const blitz::Array<double,2>& input,
+  const size_t i, const size_t n_frames, blitz::Array<double,2>& output) const
+{
+  // Same computations, in the same order, as Ceps::addDerivative(), such
+  // that the results are identical
+  const size_t delta_win = m_ceps.getDeltaWin();
+  const int dw = (int)delta_win;
+  const int ii = (int)i;
+  const int n = (int)n_frames;
+  const int n_ring = (int)m_n_ring;
+  const double factor = delta_win*(delta_win+1)/2;
+  const double sum = delta_win*(delta_win+1)*(2*delta_win+1)/3;
+  // Last frame, if known (the left boundary of very short streams would
+  // otherwise read past it)
+  const int last = (n ? n-1 : ii+dw);
+
+  for (int c=0; c<(int)m_n_coefs; ++c)
+  {
+    double value = 0.;
+    // Inner part
+    for (int l=1; l<=dw; ++l)
+      if (ii >= l && (!n || ii <= n-l-1))
+        value += l*(input((ii+l)%n_ring,c) - input((ii-l)%n_ring,c));
+    // Left boundary
+    if (ii < dw)
+    {
+      value -= (factor - ii*(ii+1)/2) * input(0,c);
+      for (int l=1+ii; l<=dw; ++l)
+        value += l*input(std::min(ii+l,last)%n_ring,c);
+    }
+    // Right boundary
+    if (n && ii >= n-dw)
+    {
+      const int ir = (n-1)-ii;
+      value += (factor - ir*(ir+1)/2) * input((n-1)%n_ring,c);
+      for (int l=1+ir; l<=dw; ++l)
+        value -= l*input(std::max(ii-l,0)%n_ring,c);
+    }
+    output(ii%n_ring,c) = value / sum;
+  }
+}
+
+void bob::ap::CepsStream::outputFrame(const size_t i,
+  blitz::Array<double,2>& output, size_t& n_output)
+{
+  const int r = (int)(i % m_n_ring);
+  const int o = (int)n_output;
+  const int n_coefs = (int)m_n_coefs;
+  for (int c=0; c<n_coefs; ++c)
+    output(o,c) = m_ring_static(r,c);
+  if (m_ceps.getWithDelta())
+  {
+    for (int c=0; c<n_coefs; ++c)
+      output(o,n_coefs+c) = m_ring_delta(r,c);
+    if (m_ceps.getWithDeltaDelta())
+    {
+      for (int c=0; c<n_coefs; ++c)
+        output(o,2*n_coefs+c) = m_ring_delta_delta(r,c);
+    }
+  }
+  ++n_output;
+  ++m_n_output;
+}
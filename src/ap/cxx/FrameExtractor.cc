@@ -117,9 +117,9 @@ void bob::ap::FrameExtractor::extractNormalizeFrame(const blitz::Array<double,1>
   // Set padded frame to zero
   frame_d = 0.; 
   // Extract frame input vector
-  blitz::Range rf(0,(int)m_win_length-1);
-  blitz::Range ri(i*(int)m_win_shift,i*(int)m_win_shift+(int)m_win_length-1);
-  frame_d(rf) = input(ri);
+  const int offset = i*(int)m_win_shift;
+  for (int j=0; j<(int)m_win_length; ++j)
+    frame_d(j) = input(offset+j);
   // Subtract mean value
   frame_d -= blitz::mean(frame_d);
 }
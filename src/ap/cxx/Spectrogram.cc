@@ -24,6 +24,8 @@
 #include <bob/core/check.h>
 #include <bob/core/assert.h>
 #include <bob/core/cast.h>
+#include <bob/core/parallel.h>
+#include <boost/bind.hpp>
 
 bob::ap::Spectrogram::Spectrogram(const double sampling_frequency,
     const double win_length_ms, const double win_shift_ms,
@@ -277,8 +279,7 @@ void bob::ap::Spectrogram::initWinSize()
 {
   bob::ap::Energy::initWinSize();
   m_fft.reset(m_win_size);
-  m_cache_frame_c1.resize(m_win_size);
-  m_cache_frame_c2.resize(m_win_size);
+  m_cache_frame_c.resize(m_win_size/2+1);
 }
 
 void bob::ap::Spectrogram::pre_emphasis(blitz::Array<double,1> &data) const
@@ -300,50 +301,90 @@ void bob::ap::Spectrogram::hammingWindow(blitz::Array<double,1> &data) const
   data(r) *= m_hamming_kernel;
 }
 
-void bob::ap::Spectrogram::powerSpectrumFFT(blitz::Array<double,1>& x)
+void bob::ap::Spectrogram::powerSpectrumFFT(blitz::Array<double,1>& x,
+  blitz::Array<std::complex<double>,1>& x_c) const
 {
-  // Apply the FFT
-  m_cache_frame_c1 = bob::core::array::cast<std::complex<double> >(x);
-  m_fft(m_cache_frame_c1, m_cache_frame_c2);
+  // Apply the FFT of the real frame, which only computes the first part of
+  // the (symmetric) output
+  m_fft(x, x_c);
 
-  // Take the the power spectrum of the first part of the output of the FFT
+  // Take the the power spectrum
   blitz::Range r(0,(int)m_win_size/2);
   blitz::Array<double,1> x_half(x(r));
-  blitz::Array<std::complex<double>,1> complex_half(m_cache_frame_c2(r));
-  x_half = blitz::abs(complex_half);
+  x_half = blitz::abs(x_c);
   if (m_energy_filter) // Apply the filter bank to the energy
     x_half = blitz::pow2(x_half);
 }
 
-void bob::ap::Spectrogram::filterBank(blitz::Array<double,1>& x)
+void bob::ap::Spectrogram::filterBank(const blitz::Array<double,1>& x,
+  blitz::Array<double,1>& filters) const
 {
   if (m_log_filter) // Apply the log triangular filter bank
-    logTriangularFilterBank(x);
+    logTriangularFilterBank(x, filters);
   else // Apply the triangular filter ban
-    triangularFilterBank(x);
+    triangularFilterBank(x, filters);
 }
 
-void bob::ap::Spectrogram::logTriangularFilterBank(blitz::Array<double,1>& data) const
+void bob::ap::Spectrogram::logTriangularFilterBank(const blitz::Array<double,1>& data,
+  blitz::Array<double,1>& filters) const
 {
+  // Each filter is only applied to its (sparse) support
   for (int i=0; i<(int)m_n_filters; ++i)
   {
     blitz::Array<double,1> data_slice(data(blitz::Range(m_p_index(i),m_p_index(i+2))));
     double res = blitz::sum(data_slice * m_filter_bank[i]);
-    m_cache_filters(i)= (res < m_fb_out_floor ? m_log_fb_out_floor : log(res));
+    filters(i)= (res < m_fb_out_floor ? m_log_fb_out_floor : log(res));
   }
 }
 
-void bob::ap::Spectrogram::triangularFilterBank(blitz::Array<double,1>& data) const
+void bob::ap::Spectrogram::triangularFilterBank(const blitz::Array<double,1>& data,
+  blitz::Array<double,1>& filters) const
 {
   for (int i=0; i<(int)m_n_filters; ++i)
   {
     blitz::Array<double,1> data_slice(data(blitz::Range(m_p_index(i),m_p_index(i+2))));
-    m_cache_filters(i) = blitz::sum(data_slice * m_filter_bank[i]);
+    filters(i) = blitz::sum(data_slice * m_filter_bank[i]);
   }
 }
 
+void bob::ap::Spectrogram::initFrameCaches(std::vector<FrameCache>& caches,
+  const size_t n_rows) const
+{
+  caches.resize(bob::core::getNThreads());
+  for (size_t t=0; t<caches.size(); ++t)
+  {
+    caches[t].frame_d.resize(m_win_size);
+    caches[t].frame_c.resize(m_win_size/2+1);
+    caches[t].filters.resize(n_rows, m_n_filters);
+  }
+}
+
+void bob::ap::Spectrogram::processFrame(const blitz::Array<double,1>& input,
+  const size_t i, blitz::Array<double,1>& frame_d,
+  blitz::Array<std::complex<double>,1>& frame_c,
+  blitz::Array<double,1>& filters, double* energy) const
+{
+  // Extract and normalize frame
+  extractNormalizeFrame(input, i, frame_d);
+
+  // Compute the energy if required
+  if (energy)
+    *energy = logEnergy(frame_d);
+
+  // Apply pre-emphasis
+  pre_emphasis(frame_d);
+  // Apply the Hamming window
+  hammingWindow(frame_d);
+  // Take the power spectrum of the first part of the FFT
+  powerSpectrumFFT(frame_d, frame_c);
+
+  // Filter with the triangular filter bank (either in linear or Mel domain)
+  if (m_energy_bands)
+    filterBank(frame_d, filters);
+}
+
 void bob::ap::Spectrogram::operator()(const blitz::Array<double,1>& input,
-  blitz::Array<double,2>& spectrogram_matrix)
+  blitz::Array<double,2>& spectrogram_matrix) const
 {
   // Get expected dimensionality of output array
   blitz::TinyVector<int,2> spectrogram_shape = bob::ap::Spectrogram::getShape(input);
@@ -351,31 +392,32 @@ void bob::ap::Spectrogram::operator()(const blitz::Array<double,1>& input,
   bob::core::array::assertSameShape(spectrogram_matrix, spectrogram_shape);
   int n_frames=spectrogram_shape(0);
 
-  // Computes the center of the cut-off frequencies
-  blitz::Range r1 = blitz::Range(0,m_win_size/2);
-  if (m_energy_bands)
-    r1 = blitz::Range(0,m_n_filters-1);
-  for (int i=0; i<n_frames; ++i)
-  {
-    // Extract and normalize frame
-    extractNormalizeFrame(input, i, m_cache_frame_d);
-
-    // Apply pre-emphasis
-    pre_emphasis(m_cache_frame_d);
-    // Apply the Hamming window
-    hammingWindow(m_cache_frame_d);
-    // Take the power spectrum of the first part of the FFT
-    powerSpectrumFFT(m_cache_frame_d);
+  // Frames are independent, and processed in parallel with working arrays
+  // per thread
+  std::vector<FrameCache> caches;
+  initFrameCaches(caches, 1);
+  bob::core::parallelFor(0, n_frames,
+    boost::bind(&bob::ap::Spectrogram::processFrames, this, boost::cref(input),
+      boost::ref(spectrogram_matrix), boost::ref(caches), _1, _2, _3));
+}
 
-    // Filter with the triangular filter bank (either in linear or Mel domain)
-    if (m_energy_bands)
-      filterBank(m_cache_frame_d);
+void bob::ap::Spectrogram::processFrames(const blitz::Array<double,1>& input,
+  blitz::Array<double,2>& spectrogram_matrix, std::vector<FrameCache>& caches,
+  size_t begin, size_t end, size_t thread) const
+{
+  // Only the working arrays of this thread are sliced
+  FrameCache& cache = caches[thread];
+  blitz::Array<double,1> filters(cache.filters(0, blitz::Range::all()));
+  for (size_t i=begin; i<end; ++i)
+  {
+    processFrame(input, i, cache.frame_d, cache.frame_c, filters);
 
-    blitz::Array<double,1> spec_matrix_row(spectrogram_matrix(i,r1));
     if (m_energy_bands)
-      spec_matrix_row = m_cache_filters(r1);
+      for (int j=0; j<(int)m_n_filters; ++j)
+        spectrogram_matrix(i,j) = filters(j);
     else
-      spec_matrix_row = m_cache_frame_d(r1);
+      for (int j=0; j<=(int)m_win_size/2; ++j)
+        spectrogram_matrix(i,j) = cache.frame_d(j);
   }
 }
 
@@ -0,0 +1,131 @@
+/**
+ * @file ap/cxx/benchmark/ceps.cc
+ * @date Sat Oct 17 17:04:31 CEST 2026
+ * @author Laurent El Shafey <Laurent.El-Shafey@idiap.ch>
+ *
+ * @brief Benchmark the throughput (in frames per second) of the power
+ * spectrum computation and of the cepstral feature extraction
+ *
+ * Copyright (C) 2011-2013 Idiap Research Institute, Martigny, Switzerland
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <bob/ap/Ceps.h>
+#include <bob/core/parallel.h>
+#include <bob/core/cast.h>
+#include <bob/sp/FFT1D.h>
+#include <bob/sp/RFFT1D.h>
+
+#include <boost/random.hpp>
+#include <boost/date_time/posix_time/posix_time.hpp>
+#include <iostream>
+
+static double framesPerSecond(const int n_frames,
+  const boost::posix_time::time_duration& diff)
+{
+  return n_frames / (diff.total_microseconds() / 1e6);
+}
+
+/**
+ * Power spectrum of n_frames frames of the given size, computed with a
+ * complex FFT of the frames cast to complex (former Spectrogram
+ * implementation) and with a real-to-complex FFT
+ */
+void benchmark_power_spectrum(const int win_size, const int n_frames)
+{
+  boost::mt19937 rng;
+  boost::uniform_real<double> dist(-1., 1.);
+  blitz::Array<double,1> frame(win_size), x(win_size);
+  for (int i=0; i<win_size; ++i) frame(i) = dist(rng);
+  blitz::Range r(0, win_size/2);
+  boost::posix_time::ptime t1;
+  boost::posix_time::ptime t2;
+  boost::posix_time::time_duration diff;
+
+  std::cout << "Power spectrum of frames of size " << win_size << " (" << n_frames << " frames)..." << std::endl;
+
+  bob::sp::FFT1D fft(win_size);
+  blitz::Array<std::complex<double>,1> c1(win_size), c2(win_size);
+  t1 = boost::posix_time::microsec_clock::local_time();
+  for (int i=0; i<n_frames; ++i) {
+    x = frame;
+    c1 = bob::core::array::cast<std::complex<double> >(x);
+    fft(c1, c2);
+    blitz::Array<double,1> x_half(x(r));
+    blitz::Array<std::complex<double>,1> complex_half(c2(r));
+    x_half = blitz::abs(complex_half);
+  }
+  t2 = boost::posix_time::microsec_clock::local_time();
+  diff = t2 - t1;
+  std::cout << "  Complex FFT (frames/second) " << framesPerSecond(n_frames, diff) << std::endl;
+
+  bob::sp::RFFT1D rfft(win_size);
+  blitz::Array<std::complex<double>,1> c(win_size/2+1);
+  t1 = boost::posix_time::microsec_clock::local_time();
+  for (int i=0; i<n_frames; ++i) {
+    x = frame;
+    rfft(x, c);
+    blitz::Array<double,1> x_half(x(r));
+    x_half = blitz::abs(c);
+  }
+  t2 = boost::posix_time::microsec_clock::local_time();
+  diff = t2 - t1;
+  std::cout << "  Real-to-complex FFT (frames/second) " << framesPerSecond(n_frames, diff) << std::endl;
+}
+
+/**
+ * MFCC extraction (with energy and derivatives) on a random signal of the
+ * given duration, with an increasing number of threads
+ */
+void benchmark_ceps(const double sampling_frequency, const double duration)
+{
+  boost::mt19937 rng;
+  boost::uniform_real<double> dist(-1000., 1000.);
+  const int n_samples = (int)(sampling_frequency * duration);
+  blitz::Array<double,1> input(n_samples);
+  for (int i=0; i<n_samples; ++i) input(i) = dist(rng);
+  boost::posix_time::ptime t1;
+  boost::posix_time::ptime t2;
+  boost::posix_time::time_duration diff;
+
+  bob::ap::Ceps ceps(sampling_frequency);
+  ceps.setWithEnergy(true);
+  ceps.setWithDeltaDelta(true);
+  blitz::Array<double,2> output(ceps.getShape(input));
+
+  std::cout << "MFCC of " << duration << "s of signal sampled at " << sampling_frequency << "Hz (" << output.extent(0) << " frames)..." << std::endl;
+
+  const size_t n_threads[4] = {1, 2, 4, 8};
+  for (int k=0; k<4; ++k)
+  {
+    bob::core::setNThreads(n_threads[k]);
+    t1 = boost::posix_time::microsec_clock::local_time();
+    ceps(input, output);
+    t2 = boost::posix_time::microsec_clock::local_time();
+    diff = t2 - t1;
+    std::cout << "  Ceps with " << n_threads[k] << " thread(s) (frames/second) " << framesPerSecond(output.extent(0), diff) << std::endl;
+  }
+  bob::core::setNThreads(0);
+}
+
+int main()
+{
+  benchmark_power_spectrum(256, 200000);
+  benchmark_power_spectrum(512, 100000);
+  benchmark_power_spectrum(1024, 50000);
+  benchmark_ceps(8000., 600.);
+  benchmark_ceps(16000., 600.);
+
+  return 0;
+}
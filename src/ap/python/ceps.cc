@@ -26,6 +26,7 @@
 #include <bob/ap/Energy.h>
 #include <bob/ap/Spectrogram.h>
 #include <bob/ap/Ceps.h>
+#include <bob/ap/CepsStream.h>
 #include <bob/python/ndarray.h>
 
 using namespace boost::python;
@@ -35,6 +36,7 @@ static const char* FRAME_EXTRACTOR_DOC = "Objects of this class, after configura
 static const char* ENERGY_DOC = "Objects of this class, after configuration, can extract the energy of frames extracted from a 1D audio array/signal.";
 static const char* SPECTROGRAM_DOC = "Objects of this class, after configuration, can extract spectrograms from a 1D audio array/signal.";
 static const char* CEPS_DOC = "Objects of this class, after configuration, can extract cepstral coefficients from a 1D audio array/signal.";
+static const char* CEPS_STREAM_DOC = "Objects of this class extract the same cepstral coefficients as a given Ceps object from an audio signal given as consecutive blocks of samples. The frames are output as soon as they are complete, with the delay required by the first and second order derivatives, and the remaining frames when the stream is flushed. The concatenation of the outputs is identical to the output of the Ceps object on the whole signal.";
 
 static boost::python::tuple py_extractor_get_shape(bob::ap::FrameExtractor& ext, object input_object)
 {
@@ -95,6 +97,27 @@ static object py_ceps_call(bob::ap::Ceps& ceps, bob::python::const_ndarray input
   return ceps_matrix.self();
 }
 
+static object py_ceps_stream_push(bob::ap::CepsStream& stream, bob::python::const_ndarray input)
+{
+  const blitz::Array<double,1> input_ = input.bz<double,1>();
+  // Allocates a numpy array for the largest number of frames
+  bob::python::ndarray ceps_matrix(bob::core::array::t_float64,
+    stream.getMaxNFrames(input_.extent(0)), stream.getNFeatures());
+  blitz::Array<double,2> ceps_matrix_ = ceps_matrix.bz<double,2>();
+  // Extracts the features of the complete frames
+  const size_t n = stream.push(input_, ceps_matrix_);
+  return ceps_matrix.self().slice(0, n);
+}
+
+static object py_ceps_stream_flush(bob::ap::CepsStream& stream)
+{
+  bob::python::ndarray ceps_matrix(bob::core::array::t_float64,
+    stream.getNPendingFrames(), stream.getNFeatures());
+  blitz::Array<double,2> ceps_matrix_ = ceps_matrix.bz<double,2>();
+  stream.flush(ceps_matrix_);
+  return ceps_matrix.self();
+}
+
 void bind_ap_ceps()
 {
   class_<bob::ap::FrameExtractor, boost::shared_ptr<bob::ap::FrameExtractor> >("FrameExtractor", FRAME_EXTRACTOR_DOC, init<const double, optional<const double, const double> >((arg("self"), arg("sampling_frequency"), arg("win_length_ms")=20., arg("win_shift_ms")=10.)))
@@ -148,5 +171,15 @@ void bind_ap_ceps()
     .add_property("with_delta_delta", &bob::ap::Ceps::getWithDeltaDelta, &bob::ap::Ceps::setWithDeltaDelta, "Tells if we add the second derivatives to the output feature")
     .def("__call__", &py_ceps_call, (arg("self"), arg("input")), "Computes the cepstral coefficients")
   ;
-}
 
+  class_<bob::ap::CepsStream, boost::shared_ptr<bob::ap::CepsStream> >("CepsStream", CEPS_STREAM_DOC, init<const bob::ap::Ceps&>((arg("self"), arg("ceps")), "Constructs a stream extractor with the configuration of the given Ceps object, which is copied."))
+    .def(init<bob::ap::CepsStream&>((arg("self"), arg("other")), "Constructs a new stream extractor from an existing one, including the state of its stream, using the copy constructor."))
+    .add_property("ceps", make_function(&bob::ap::CepsStream::getCeps, return_value_policy<copy_const_reference>()), "A copy of the configuration of the features")
+    .add_property("n_features", &bob::ap::CepsStream::getNFeatures, "The dimension of the feature vectors")
+    .add_property("n_pending_frames", &bob::ap::CepsStream::getNPendingFrames, "The number of frames which are output when the stream is flushed")
+    .add_property("n_output_frames", &bob::ap::CepsStream::getNOutputFrames, "The number of frames output since the beginning of the stream")
+    .def("push", &py_ceps_stream_push, (arg("self"), arg("input")), "Processes the next block of samples of the stream, and returns the features of the frames which are complete, as a 2D array (possibly with no row)")
+    .def("flush", &py_ceps_stream_flush, (arg("self")), "Ends the stream and returns the features of the remaining frames. The object is then ready to process a new stream.")
+    .def("reset", &bob::ap::CepsStream::reset, (arg("self")), "Discards the current stream")
+  ;
+}
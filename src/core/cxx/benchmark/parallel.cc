@@ -0,0 +1,134 @@
+/**
+ * @file core/cxx/benchmark/parallel.cc
+ * @date Sat Oct 17 14:02:45 CEST 2026
+ * @author Laurent El Shafey <Laurent.El-Shafey@idiap.ch>
+ *
+ * @brief Benchmark the per-call overhead and the load balancing of the
+ * thread pool, compared to the creation of threads at each call
+ *
+ * Copyright (C) 2011-2013 Idiap Research Institute, Martigny, Switzerland
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <bob/core/parallel.h>
+
+#include <boost/bind.hpp>
+#include <boost/date_time/posix_time/posix_time.hpp>
+#include <iostream>
+#include <vector>
+#include <cmath>
+
+/**
+ * Iterations whose cost grows with their index, such that an even split of
+ * the range is unbalanced
+ */
+static void work(std::vector<double>& out, size_t begin, size_t end, size_t)
+{
+  for (size_t i=begin; i<end; ++i) {
+    double v = 0.;
+    for (size_t k=0; k<i; ++k) v += std::sqrt((double)k);
+    out[i] = v;
+  }
+}
+
+static void empty(size_t, size_t, size_t) { }
+
+/**
+ * Processes the range with a thread per even part, created at each call
+ * (the former behaviour of the visioner thread loops)
+ */
+static void spawn(const size_t n_threads, const size_t n,
+  const bob::core::ThreadPool::body_type& body)
+{
+  boost::thread_group threads;
+  for (size_t t=0; t<n_threads; ++t)
+    threads.create_thread(boost::bind(body, (n*t)/n_threads,
+      (n*(t+1))/n_threads, t));
+  threads.join_all();
+}
+
+void benchmark_overhead(bob::core::ThreadPool& pool, const int n_calls)
+{
+  const size_t n_threads = pool.getNThreads();
+  boost::posix_time::ptime t1;
+  boost::posix_time::ptime t2;
+  boost::posix_time::time_duration diff;
+
+  std::cout << "Empty loop with " << n_threads << " threads (" << n_calls << " calls)..." << std::endl;
+
+  t1 = boost::posix_time::microsec_clock::local_time();
+  for (int i=0; i<n_calls; ++i) spawn(n_threads, 1024, &empty);
+  t2 = boost::posix_time::microsec_clock::local_time();
+  diff = t2 - t1;
+  std::cout << "  Threads created at each call (microseconds/call) " << diff.total_microseconds() / (double)n_calls << std::endl;
+
+  t1 = boost::posix_time::microsec_clock::local_time();
+  for (int i=0; i<n_calls; ++i) pool.parallelFor(0, 1024, &empty);
+  t2 = boost::posix_time::microsec_clock::local_time();
+  diff = t2 - t1;
+  std::cout << "  Persistent pool (microseconds/call) " << diff.total_microseconds() / (double)n_calls << std::endl;
+}
+
+void benchmark_balance(bob::core::ThreadPool& pool, const size_t n,
+  const int n_calls)
+{
+  const size_t n_threads = pool.getNThreads();
+  std::vector<double> out(n);
+  boost::posix_time::ptime t1;
+  boost::posix_time::ptime t2;
+  boost::posix_time::time_duration diff;
+
+  std::cout << "Unbalanced loop of " << n << " iterations with " << n_threads << " threads (" << n_calls << " calls)..." << std::endl;
+
+  t1 = boost::posix_time::microsec_clock::local_time();
+  for (int i=0; i<n_calls; ++i) work(out, 0, n, 0);
+  t2 = boost::posix_time::microsec_clock::local_time();
+  diff = t2 - t1;
+  std::cout << "  Serial (microseconds/call) " << diff.total_microseconds() / (double)n_calls << std::endl;
+
+  t1 = boost::posix_time::microsec_clock::local_time();
+  for (int i=0; i<n_calls; ++i)
+    spawn(n_threads, n, boost::bind(&work, boost::ref(out), _1, _2, _3));
+  t2 = boost::posix_time::microsec_clock::local_time();
+  diff = t2 - t1;
+  std::cout << "  Static split, threads created at each call (microseconds/call) " << diff.total_microseconds() / (double)n_calls << std::endl;
+
+  t1 = boost::posix_time::microsec_clock::local_time();
+  for (int i=0; i<n_calls; ++i)
+    pool.parallelFor(0, n, boost::bind(&work, boost::ref(out), _1, _2, _3),
+      (n + n_threads - 1) / n_threads);
+  t2 = boost::posix_time::microsec_clock::local_time();
+  diff = t2 - t1;
+  std::cout << "  Static split, persistent pool (microseconds/call) " << diff.total_microseconds() / (double)n_calls << std::endl;
+
+  t1 = boost::posix_time::microsec_clock::local_time();
+  for (int i=0; i<n_calls; ++i)
+    pool.parallelFor(0, n, boost::bind(&work, boost::ref(out), _1, _2, _3));
+  t2 = boost::posix_time::microsec_clock::local_time();
+  diff = t2 - t1;
+  std::cout << "  Work stealing, persistent pool (microseconds/call) " << diff.total_microseconds() / (double)n_calls << std::endl;
+}
+
+int main()
+{
+  const size_t n_threads[3] = {2, 4, 8};
+  for (int i=0; i<3; ++i)
+  {
+    bob::core::ThreadPool pool(n_threads[i]);
+    benchmark_overhead(pool, 2000);
+    benchmark_balance(pool, 4096, 20);
+  }
+
+  return 0;
+}
@@ -0,0 +1,268 @@
+/**
+ * @file core/cxx/parallel.cc
+ * @date Sat Oct 17 14:02:45 CEST 2026
+ * @author Laurent El Shafey <Laurent.El-Shafey@idiap.ch>
+ *
+ * @brief A persistent pool of worker threads with a work-stealing
+ * parallel-for
+ *
+ * Copyright (C) 2011-2013 Idiap Research Institute, Martigny, Switzerland
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <bob/core/parallel.h>
+#include <boost/scoped_ptr.hpp>
+#include <boost/bind.hpp>
+#include <algorithm>
+#include <stdexcept>
+#include <cstdlib>
+
+namespace {
+
+  size_t resolveNThreads(const size_t n_threads) {
+    if (n_threads) return n_threads;
+    const size_t hw = boost::thread::hardware_concurrency();
+    return hw ? hw : 1;
+  }
+
+  /**
+   * The number of threads of the process-wide pool, which may be set with
+   * the BOB_NUM_THREADS environment variable
+   */
+  size_t defaultNThreads() {
+    const char* value = getenv("BOB_NUM_THREADS");
+    if (value) {
+      const int n = atoi(value);
+      if (n > 0) return n;
+    }
+    return resolveNThreads(0);
+  }
+
+  boost::mutex& globalMutex() {
+    static boost::mutex s_mutex;
+    return s_mutex;
+  }
+
+  boost::scoped_ptr<bob::core::ThreadPool>& globalPool() {
+    static boost::scoped_ptr<bob::core::ThreadPool> s_pool;
+    return s_pool;
+  }
+
+  bob::core::ThreadPool& global() {
+    boost::mutex::scoped_lock lock(globalMutex());
+    boost::scoped_ptr<bob::core::ThreadPool>& pool = globalPool();
+    if (!pool) pool.reset(new bob::core::ThreadPool(defaultNThreads()));
+    return *pool;
+  }
+
+}
+
+bob::core::ThreadPool::ThreadPool(size_t n_threads):
+  m_n_threads(resolveNThreads(n_threads)),
+  m_slots(new Slot[m_n_threads]),
+  m_body(0),
+  m_grain(1),
+  m_n_participants(0),
+  m_n_active(0),
+  m_generation(0),
+  m_stop(false)
+{
+  for (size_t i=0; i<m_n_threads; ++i) m_slots[i].begin = m_slots[i].end = 0;
+  for (size_t i=1; i<m_n_threads; ++i)
+    m_threads.create_thread(boost::bind(&ThreadPool::worker, this, i));
+}
+
+bob::core::ThreadPool::~ThreadPool() {
+  {
+    boost::mutex::scoped_lock lock(m_mutex);
+    m_stop = true;
+  }
+  m_start.notify_all();
+  m_threads.join_all();
+}
+
+void bob::core::ThreadPool::parallelFor(size_t begin, size_t end,
+  const body_type& body, size_t grain, size_t max_threads)
+{
+  if (end <= begin) return;
+  const size_t n = end - begin;
+
+  size_t n_participants = m_n_threads;
+  if (max_threads && max_threads < n_participants)
+    n_participants = max_threads;
+  if (!grain) grain = std::max((size_t)1, n / (8*n_participants));
+  n_participants = std::min(n_participants, (n + grain - 1) / grain);
+
+  // Serial processing with a single thread, or if the pool is already busy
+  // (e.g. nested loops)
+  boost::mutex::scoped_try_lock run_lock(m_run_mutex);
+  if (n_participants < 2 || !run_lock.owns_lock()) {
+    body(begin, end, 0);
+    return;
+  }
+
+  // Splits the range evenly among the participating threads
+  for (size_t i=0; i<m_n_threads; ++i) {
+    boost::mutex::scoped_lock lock(m_slots[i].mutex);
+    if (i < n_participants) {
+      m_slots[i].begin = begin + (n*i) / n_participants;
+      m_slots[i].end = begin + (n*(i+1)) / n_participants;
+    }
+    else m_slots[i].begin = m_slots[i].end = end;
+  }
+
+  {
+    boost::mutex::scoped_lock lock(m_mutex);
+    m_body = &body;
+    m_grain = grain;
+    m_n_participants = n_participants;
+    m_n_active = 1; // the calling thread
+    m_error.clear();
+    ++m_generation;
+  }
+  m_start.notify_all();
+
+  // The calling thread also processes the loop
+  execute(0);
+
+  std::string error;
+  {
+    boost::mutex::scoped_lock lock(m_mutex);
+    --m_n_active;
+    while (m_n_active) m_done.wait(lock);
+    m_body = 0;
+    error.swap(m_error);
+  }
+
+  if (!error.empty()) throw std::runtime_error(error);
+}
+
+void bob::core::ThreadPool::worker(const size_t index) {
+  size_t generation = 0;
+  while (true) {
+    {
+      boost::mutex::scoped_lock lock(m_mutex);
+      while (!m_stop && m_generation == generation) m_start.wait(lock);
+      if (m_stop) return;
+      generation = m_generation;
+      // The loop may already be over, or not need this thread
+      if (!m_body || index >= m_n_participants) continue;
+      ++m_n_active;
+    }
+
+    execute(index);
+
+    {
+      boost::mutex::scoped_lock lock(m_mutex);
+      if (--m_n_active == 0) m_done.notify_all();
+    }
+  }
+}
+
+void bob::core::ThreadPool::execute(const size_t index) {
+  const body_type* body;
+  {
+    boost::mutex::scoped_lock lock(m_mutex);
+    body = m_body;
+  }
+
+  size_t b, e;
+  while (next(index, b, e)) {
+    std::string error;
+    try {
+      (*body)(b, e, index);
+    }
+    catch (std::exception& ex) {
+      error = ex.what();
+    }
+    catch (...) {
+      error = "unknown exception raised by the body of a parallel loop";
+    }
+
+    if (!error.empty()) {
+      {
+        boost::mutex::scoped_lock lock(m_mutex);
+        if (m_error.empty()) m_error = error;
+      }
+      cancel();
+    }
+  }
+}
+
+bool bob::core::ThreadPool::next(const size_t index, size_t& begin,
+  size_t& end)
+{
+  Slot& own = m_slots[index];
+  {
+    boost::mutex::scoped_lock lock(own.mutex);
+    if (own.begin < own.end) {
+      begin = own.begin;
+      end = std::min(own.end, begin + m_grain);
+      own.begin = end;
+      return true;
+    }
+  }
+
+  // Steals the second half of the range left to another thread
+  for (size_t k=1; k<m_n_participants; ++k) {
+    Slot& victim = m_slots[(index + k) % m_n_participants];
+    size_t s_begin, s_end;
+    {
+      boost::mutex::scoped_lock lock(victim.mutex);
+      const size_t left = victim.end - victim.begin;
+      if (!left) continue;
+      if (left <= m_grain) {
+        begin = victim.begin;
+        end = victim.end;
+        victim.begin = victim.end;
+        return true;
+      }
+      s_begin = victim.end - left / 2;
+      s_end = victim.end;
+      victim.end = s_begin;
+    }
+
+    // Keeps the stolen range, such that others may steal from it in turn
+    boost::mutex::scoped_lock lock(own.mutex);
+    begin = s_begin;
+    end = std::min(s_end, s_begin + m_grain);
+    own.begin = end;
+    own.end = s_end;
+    return true;
+  }
+
+  return false;
+}
+
+void bob::core::ThreadPool::cancel() {
+  for (size_t i=0; i<m_n_participants; ++i) {
+    boost::mutex::scoped_lock lock(m_slots[i].mutex);
+    m_slots[i].begin = m_slots[i].end;
+  }
+}
+
+size_t bob::core::getNThreads() {
+  return global().getNThreads();
+}
+
+void bob::core::setNThreads(const size_t n_threads) {
+  boost::mutex::scoped_lock lock(globalMutex());
+  globalPool().reset(new bob::core::ThreadPool(n_threads));
+}
+
+void bob::core::parallelFor(size_t begin, size_t end,
+  const ThreadPool::body_type& body, size_t grain, size_t max_threads)
+{
+  global().parallelFor(begin, end, body, grain, max_threads);
+}
@@ -0,0 +1,166 @@
+/**
+ * @file core/cxx/test/parallel.cc
+ * @date Sat Oct 17 14:02:45 CEST 2026
+ * @author Laurent El Shafey <Laurent.El-Shafey@idiap.ch>
+ *
+ * @brief Test the work-stealing parallel-for of the thread pool
+ *
+ * Copyright (C) 2011-2013 Idiap Research Institute, Martigny, Switzerland
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE core-parallel Tests
+#define BOOST_TEST_MAIN
+#include <boost/test/unit_test.hpp>
+#include <boost/bind.hpp>
+
+#include <bob/core/parallel.h>
+#include <stdexcept>
+#include <vector>
+
+struct T {
+  size_t n;
+  size_t n_threads;
+
+  T(): n(10007), n_threads(4) {}
+
+  ~T() {}
+};
+
+/**
+ * Marks the visited indices
+ */
+static void visit(std::vector<int>& visits, size_t begin, size_t end,
+  size_t) {
+  for (size_t i=begin; i<end; ++i) ++visits[i];
+}
+
+/**
+ * Accumulates indices in the accumulator of the calling thread, checking
+ * that the thread index is valid
+ */
+static void accumulate(std::vector<double>& sums, size_t begin, size_t end,
+  size_t index) {
+  if (index >= sums.size()) throw std::runtime_error("invalid thread index");
+  for (size_t i=begin; i<end; ++i) sums[index] += i;
+}
+
+/**
+ * Runs a nested loop for each index
+ */
+static void nested(bob::core::ThreadPool& pool, std::vector<int>& visits,
+  size_t n, size_t begin, size_t end, size_t) {
+  for (size_t i=begin; i<end; ++i) {
+    std::vector<int> inner(n, 0);
+    pool.parallelFor(0, n, boost::bind(&visit, boost::ref(inner), _1, _2, _3));
+    for (size_t j=0; j<n; ++j) visits[i] += inner[j];
+  }
+}
+
+static void fail(size_t begin, size_t end, size_t) {
+  for (size_t i=begin; i<end; ++i)
+    if (i == 1234) throw std::runtime_error("failed at 1234");
+}
+
+BOOST_FIXTURE_TEST_SUITE( test_setup, T )
+
+BOOST_AUTO_TEST_CASE( test_parallel_visit )
+{
+  bob::core::ThreadPool pool(n_threads);
+  BOOST_CHECK_EQUAL(pool.getNThreads(), n_threads);
+
+  // Different grains, including single-element chunks and a grain larger
+  // than the range
+  const size_t grains[] = {0, 1, 7, 100, 20000};
+  for (size_t g=0; g<sizeof(grains)/sizeof(size_t); ++g) {
+    std::vector<int> visits(n, 0);
+    pool.parallelFor(0, n, boost::bind(&visit, boost::ref(visits), _1, _2, _3),
+      grains[g]);
+    for (size_t i=0; i<n; ++i) BOOST_CHECK_EQUAL(visits[i], 1);
+  }
+
+  // Offset and empty ranges
+  std::vector<int> visits(n, 0);
+  pool.parallelFor(100, n, boost::bind(&visit, boost::ref(visits), _1, _2, _3));
+  pool.parallelFor(50, 50, boost::bind(&visit, boost::ref(visits), _1, _2, _3));
+  for (size_t i=0; i<n; ++i) BOOST_CHECK_EQUAL(visits[i], i<100 ? 0 : 1);
+}
+
+BOOST_AUTO_TEST_CASE( test_parallel_accumulate )
+{
+  bob::core::ThreadPool pool(n_threads);
+  // Repeated calls reuse the same threads
+  for (size_t r=0; r<200; ++r) {
+    std::vector<double> sums(n_threads, 0.);
+    pool.parallelFor(0, n,
+      boost::bind(&accumulate, boost::ref(sums), _1, _2, _3), 3);
+    double sum = 0.;
+    for (size_t t=0; t<n_threads; ++t) sum += sums[t];
+    BOOST_CHECK_EQUAL(sum, (double)n*(n-1)/2);
+  }
+
+  // Limits the number of threads
+  std::vector<double> sums(n_threads, 0.);
+  pool.parallelFor(0, n,
+    boost::bind(&accumulate, boost::ref(sums), _1, _2, _3), 1, 2);
+  BOOST_CHECK_EQUAL(sums[2], 0.);
+  BOOST_CHECK_EQUAL(sums[3], 0.);
+  BOOST_CHECK_EQUAL(sums[0] + sums[1], (double)n*(n-1)/2);
+}
+
+BOOST_AUTO_TEST_CASE( test_parallel_nested )
+{
+  bob::core::ThreadPool pool(n_threads);
+  const size_t n_outer = 64;
+  const size_t n_inner = 100;
+  std::vector<int> visits(n_outer, 0);
+  pool.parallelFor(0, n_outer, boost::bind(&nested, boost::ref(pool),
+    boost::ref(visits), n_inner, _1, _2, _3), 1);
+  for (size_t i=0; i<n_outer; ++i) BOOST_CHECK_EQUAL(visits[i], (int)n_inner);
+}
+
+BOOST_AUTO_TEST_CASE( test_parallel_exception )
+{
+  bob::core::ThreadPool pool(n_threads);
+  BOOST_CHECK_THROW(pool.parallelFor(0, n, &fail, 10), std::runtime_error);
+
+  // The pool is still usable afterwards
+  std::vector<int> visits(n, 0);
+  pool.parallelFor(0, n, boost::bind(&visit, boost::ref(visits), _1, _2, _3));
+  for (size_t i=0; i<n; ++i) BOOST_CHECK_EQUAL(visits[i], 1);
+}
+
+BOOST_AUTO_TEST_CASE( test_parallel_global )
+{
+  bob::core::setNThreads(3);
+  BOOST_CHECK_EQUAL(bob::core::getNThreads(), 3);
+
+  std::vector<double> sums(3, 0.);
+  bob::core::parallelFor(0, n,
+    boost::bind(&accumulate, boost::ref(sums), _1, _2, _3));
+  BOOST_CHECK_EQUAL(sums[0] + sums[1] + sums[2], (double)n*(n-1)/2);
+
+  bob::core::setNThreads(1);
+  BOOST_CHECK_EQUAL(bob::core::getNThreads(), 1);
+  std::vector<int> visits(n, 0);
+  bob::core::parallelFor(0, n,
+    boost::bind(&visit, boost::ref(visits), _1, _2, _3));
+  for (size_t i=0; i<n; ++i) BOOST_CHECK_EQUAL(visits[i], 1);
+
+  bob::core::setNThreads(0);
+  BOOST_CHECK(bob::core::getNThreads() >= 1);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,31 @@
+/**
+ * @file core/python/parallel.cc
+ * @date Sat Oct 17 14:02:45 CEST 2026
+ * @author Laurent El Shafey <Laurent.El-Shafey@idiap.ch>
+ *
+ * @brief Binds the configuration of the process-wide thread pool
+ *
+ * Copyright (C) 2011-2013 Idiap Research Institute, Martigny, Switzerland
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <boost/python.hpp>
+#include <bob/core/parallel.h>
+
+using namespace boost::python;
+
+void bind_core_parallel() {
+  def("get_n_threads", &bob::core::getNThreads, "Returns the number of threads of the process-wide thread pool, used by the C++ code that parallelizes loops. It defaults to the value of the ``BOB_NUM_THREADS`` environment variable if set, or to the number of hardware threads otherwise.");
+  def("set_n_threads", &bob::core::setNThreads, (arg("n_threads")), "Recreates the process-wide thread pool with the given number of threads (``0`` meaning the number of hardware threads). This must not be called while the pool is in use.");
+}
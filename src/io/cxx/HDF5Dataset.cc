@@ -49,7 +49,8 @@ static void delete_h5dataset (hid_t* p) {
 }
 
 static boost::shared_ptr<hid_t> open_dataset
-(boost::shared_ptr<bob::io::detail::hdf5::Group>& par, const std::string& name) {
+(boost::shared_ptr<bob::io::detail::hdf5::Group>& par, const std::string& name,
+ hid_t dapl=H5P_DEFAULT) {
   if (!name.size() || name == "." || name == "..") {
     boost::format m("Cannot open dataset with illegal name `%s' at `%s:%s'");
     m % name % par->file()->filename() % par->path();
@@ -58,7 +59,7 @@ static boost::shared_ptr<hid_t> open_dataset
 
   boost::shared_ptr<hid_t> retval(new hid_t(-1),
       std::ptr_fun(delete_h5dataset));
-  *retval = H5Dopen2(*par->location(), name.c_str(), H5P_DEFAULT);
+  *retval = H5Dopen2(*par->location(), name.c_str(), dapl);
   if (*retval < 0) {
     throw status_error("H5Dopen2", *retval);
   }
@@ -247,7 +248,7 @@ bob::io::detail::hdf5::Dataset::Dataset(boost::shared_ptr<Group> parent,
  */
 static void create_dataset (boost::shared_ptr<bob::io::detail::hdf5::Group> par,
  const std::string& name, const bob::io::HDF5Type& type, bool list,
- size_t compression) {
+ size_t compression, size_t chunk_size) {
 
   if (!name.size() || name == "." || name == "..") {
     boost::format m("Cannot create dataset with illegal name `%s' at `%s:%s'");
@@ -272,14 +273,24 @@ static void create_dataset (boost::shared_ptr<bob::io::detail::hdf5::Group> par,
   *space = H5Screate_simple(xshape.n(), xshape.get(), maxshape.get());
   if (*space < 0) throw status_error("H5Screate_simple", *space);
 
+  boost::shared_ptr<hid_t> cls = type.htype();
+
   //creates the property list saying we need the data to be chunked if this is
   //supposed to be a list -- HDF5 only supports expandability like this.
   boost::shared_ptr<hid_t> dcpl = open_plist(H5P_DATASET_CREATE);
 
   //according to the HDF5 manual, chunks have to have the same rank as the
-  //array shape.
+  //array shape. lists hold as many samples per chunk as fit in chunk_size
+  //bytes, one at least.
   bob::io::HDF5Shape chunking(xshape);
   chunking[0] = 1;
+  if (list && chunk_size) {
+    bob::io::HDF5Shape sample(xshape);
+    sample <<= 1;
+    const size_t sample_size = sample.product() * H5Tget_size(*cls);
+    if (sample_size && chunk_size > sample_size)
+      chunking[0] = chunk_size / sample_size;
+  }
   if (list || compression) { ///< note: compression requires chunking
     herr_t status = H5Pset_chunk(*dcpl, chunking.n(), chunking.get());
     if (status < 0) throw status_error("H5Pset_chunk", status);
@@ -301,8 +312,6 @@ static void create_dataset (boost::shared_ptr<bob::io::detail::hdf5::Group> par,
   //please note that we don't define the fill value as in the example, but
   //according to the HDF5 documentation, this value is set to zero by default.
 
-  boost::shared_ptr<hid_t> cls = type.htype();
-
   //finally create the dataset on the file.
   boost::shared_ptr<hid_t> dataset(new hid_t(-1),
       std::ptr_fun(delete_h5dataset));
@@ -367,7 +376,7 @@ static void create_string_dataset (boost::shared_ptr<bob::io::detail::hdf5::Grou
 
 bob::io::detail::hdf5::Dataset::Dataset(boost::shared_ptr<Group> parent,
     const std::string& name, const bob::io::HDF5Type& type,
-    bool list, size_t compression):
+    bool list, size_t compression, size_t chunk_size):
   m_parent(parent),
   m_name(name),
   m_id(),
@@ -385,7 +394,7 @@ bob::io::detail::hdf5::Dataset::Dataset(boost::shared_ptr<Group> parent,
     if (type.type() == bob::io::s)
       create_string_dataset(parent, m_name, type, compression);
     else
-      create_dataset(parent, m_name, type, list, compression);
+      create_dataset(parent, m_name, type, list, compression, chunk_size);
   }
   else H5Dclose(set_id); //close it, will re-open it properly
 
@@ -463,7 +472,8 @@ static std::vector<bob::io::HDF5Descriptor>::iterator
 }
 
 std::vector<bob::io::HDF5Descriptor>::iterator
-bob::io::detail::hdf5::Dataset::select (size_t index, const bob::io::HDF5Type& dest) {
+bob::io::detail::hdf5::Dataset::select (size_t index, size_t count,
+    const bob::io::HDF5Type& dest) {
 
   //finds compatibility type
   std::vector<bob::io::HDF5Descriptor>::iterator it = find_type_index(m_descr, dest);
@@ -476,26 +486,47 @@ bob::io::detail::hdf5::Dataset::select (size_t index, const bob::io::HDF5Type& d
   }
 
   //checks indexing
-  if (index >= it->size) {
+  if (index + count > it->size) {
     boost::format m("trying to access element %d in Dataset '%s' that only contains %d elements");
-    m % index % url() % it->size;
+    m % (index + count - 1) % url() % it->size;
     throw std::runtime_error(m.str());
   }
 
-  set_memspace(m_memspace, it->type.shape());
-
   it->hyperslab_start[0] = index;
 
-  herr_t status = H5Sselect_hyperslab(*m_filespace, H5S_SELECT_SET,
-      it->hyperslab_start.get(), 0, it->hyperslab_count.get(), 0);
-  if (status < 0) throw status_error("H5Sselect_hyperslab", status);
+  if (count == 1) {
+    set_memspace(m_memspace, it->type.shape());
+
+    herr_t status = H5Sselect_hyperslab(*m_filespace, H5S_SELECT_SET,
+        it->hyperslab_start.get(), 0, it->hyperslab_count.get(), 0);
+    if (status < 0) throw status_error("H5Sselect_hyperslab", status);
+  }
+  else { //the samples are stacked along the first dimension
+    bob::io::HDF5Shape memshape(it->type.shape());
+    memshape >>= 1;
+    memshape[0] = count;
+    set_memspace(m_memspace, memshape);
+
+    bob::io::HDF5Shape hyperslab_count(it->hyperslab_count);
+    hyperslab_count[0] = count;
+    herr_t status = H5Sselect_hyperslab(*m_filespace, H5S_SELECT_SET,
+        it->hyperslab_start.get(), 0, hyperslab_count.get(), 0);
+    if (status < 0) throw status_error("H5Sselect_hyperslab", status);
+  }
 
   return it;
 }
 
 void bob::io::detail::hdf5::Dataset::read_buffer (size_t index, const bob::io::HDF5Type& dest, void* buffer) {
+  read_buffer(index, 1, dest, buffer);
+}
 
-  std::vector<bob::io::HDF5Descriptor>::iterator it = select(index, dest);
+void bob::io::detail::hdf5::Dataset::read_buffer (size_t index, size_t count,
+    const bob::io::HDF5Type& dest, void* buffer) {
+
+  if (!count) return;
+
+  std::vector<bob::io::HDF5Descriptor>::iterator it = select(index, count, dest);
 
   herr_t status = H5Dread(*m_id, *it->type.htype(),
       *m_memspace, *m_filespace, H5P_DEFAULT, buffer);
@@ -505,8 +536,15 @@ void bob::io::detail::hdf5::Dataset::read_buffer (size_t index, const bob::io::H
 
 void bob::io::detail::hdf5::Dataset::write_buffer (size_t index, const bob::io::HDF5Type& dest,
     const void* buffer) {
+  write_buffer(index, 1, dest, buffer);
+}
 
-  std::vector<bob::io::HDF5Descriptor>::iterator it = select(index, dest);
+void bob::io::detail::hdf5::Dataset::write_buffer (size_t index, size_t count,
+    const bob::io::HDF5Type& dest, const void* buffer) {
+
+  if (!count) return;
+
+  std::vector<bob::io::HDF5Descriptor>::iterator it = select(index, count, dest);
 
   herr_t status = H5Dwrite(*m_id, *it->type.htype(),
       *m_memspace, *m_filespace, H5P_DEFAULT, buffer);
@@ -515,6 +553,11 @@ void bob::io::detail::hdf5::Dataset::write_buffer (size_t index, const bob::io::
 }
 
 void bob::io::detail::hdf5::Dataset::extend_buffer (const bob::io::HDF5Type& dest, const void* buffer) {
+  extend_buffer(1, dest, buffer);
+}
+
+void bob::io::detail::hdf5::Dataset::extend_buffer (size_t count,
+    const bob::io::HDF5Type& dest, const void* buffer) {
 
   //finds compatibility type
   std::vector<bob::io::HDF5Descriptor>::iterator it = find_type_index(m_descr, dest);
@@ -532,27 +575,54 @@ void bob::io::detail::hdf5::Dataset::extend_buffer (const bob::io::HDF5Type& des
     throw std::runtime_error(m.str());
   }
 
+  if (!count) return;
+
   //if it is expandible, try expansion
   bob::io::HDF5Shape tmp(it->type.shape());
   tmp >>= 1;
-  tmp[0] = it->size + 1;
+  tmp[0] = it->size + count;
   herr_t status = H5Dset_extent(*m_id, tmp.get());
   if (status < 0) throw status_error("H5Dset_extent", status);
 
   //if expansion succeeded, update all compatible types
   for (size_t k=0; k<m_descr.size(); ++k) {
     if (m_descr[k].expandable) { //updated only the length
-      m_descr[k].size += 1;
+      m_descr[k].size += count;
     }
     else { //not expandable, update the shape/count for a straight read/write
-      m_descr[k].type.shape()[0] += 1;
-      m_descr[k].hyperslab_count[0] += 1;
+      m_descr[k].type.shape()[0] += count;
+      m_descr[k].hyperslab_count[0] += count;
     }
   }
 
   m_filespace = open_filespace(m_id); //update filespace
 
-  write_buffer(tmp[0]-1, dest, buffer);
+  write_buffer(tmp[0]-count, count, dest, buffer);
+}
+
+void bob::io::detail::hdf5::Dataset::set_chunk_cache(size_t nbytes,
+    size_t nslots, double w0) {
+  boost::shared_ptr<hid_t> dapl = open_plist(H5P_DATASET_ACCESS);
+  herr_t status = H5Pset_chunk_cache(*dapl, nslots, nbytes, w0);
+  if (status < 0) throw status_error("H5Pset_chunk_cache", status);
+
+  //all identifiers of an open dataset share the same chunk cache: the current
+  //one has to be closed for the new settings to be taken into account.
+  boost::shared_ptr<Group> par = parent();
+  m_filespace.reset();
+  m_dt.reset();
+  m_id.reset();
+  m_id = open_dataset(par, m_name, *dapl);
+  m_dt = open_datatype(m_id);
+  m_filespace = open_filespace(m_id);
+}
+
+bob::io::HDF5Type bob::io::detail::hdf5::sample_type
+(const bob::io::HDF5Type& block) {
+  if (block.shape().n() <= 1) return bob::io::HDF5Type(block.type());
+  bob::io::HDF5Shape shape(block.shape());
+  shape <<= 1;
+  return bob::io::HDF5Type(block.type(), shape);
 }
 
 void bob::io::detail::hdf5::Dataset::gettype_attribute(const std::string& name,
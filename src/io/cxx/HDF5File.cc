@@ -137,16 +137,22 @@ void bob::io::HDF5File::copy (HDF5File& other) {
 }
 
 void bob::io::HDF5File::create (const std::string& path, const bob::io::HDF5Type& type,
-    bool list, size_t compression) {
+    bool list, size_t compression, size_t chunk_size) {
   if (!m_file->writeable()) {
     boost::format m("cannot create dataset '%s' at path '%s' of file '%s' because it is not writeable");
     m % path % m_cwd->path() % m_file->filename();
     throw std::runtime_error(m.str());
   }
-  if (!contains(path)) m_cwd->create_dataset(path, type, list, compression);
+  if (!contains(path)) m_cwd->create_dataset(path, type, list, compression,
+      chunk_size);
   else (*m_cwd)[path]->size(type);
 }
 
+void bob::io::HDF5File::setChunkCache (const std::string& path, size_t nbytes,
+    size_t nslots, double w0) {
+  (*m_cwd)[path]->set_chunk_cache(nbytes, nslots, w0);
+}
+
 void bob::io::HDF5File::read_buffer (const std::string& path, size_t pos,
     const bob::io::HDF5Type& type, void* buffer) const {
   (*m_cwd)[path]->read_buffer(pos, type, buffer);
@@ -0,0 +1,102 @@
+/**
+ * @file io/cxx/benchmark/hdf5.cc
+ * @date Sat Oct 17 16:12:08 CEST 2026
+ * @author Laurent El Shafey <Laurent.El-Shafey@idiap.ch>
+ *
+ * @brief Benchmark the writing and reading of lists of feature vectors,
+ * one at a time or by blocks
+ *
+ * Copyright (C) 2011-2013 Idiap Research Institute, Martigny, Switzerland
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <bob/io/HDF5File.h>
+#include <bob/core/logging.h>
+
+#include <boost/filesystem.hpp>
+#include <boost/date_time/posix_time/posix_time.hpp>
+#include <iostream>
+#include <cstdlib>
+#include <algorithm>
+
+void benchmark(const int n_samples, const int dim, const int block)
+{
+  blitz::Array<double,2> data(n_samples, dim);
+  data = blitz::tensor::i + 0.001 * blitz::tensor::j;
+  blitz::Array<double,2> read(block, dim);
+
+  boost::posix_time::ptime t1;
+  boost::posix_time::ptime t2;
+  boost::posix_time::time_duration diff;
+
+  std::cout << n_samples << " vectors of dimension " << dim << ", blocks of " << block << " vectors..." << std::endl;
+
+  const std::string filename = bob::core::tmpfile();
+  {
+    bob::io::HDF5File f(filename, bob::io::HDF5File::trunc);
+
+    t1 = boost::posix_time::microsec_clock::local_time();
+    for (int i=0; i<n_samples; ++i) {
+      blitz::Array<double,1> v = data(i, blitz::Range::all());
+      f.appendArray("single", v);
+    }
+    t2 = boost::posix_time::microsec_clock::local_time();
+    diff = t2 - t1;
+    std::cout << "  appendArray (microseconds/vector) " << diff.total_microseconds() / (double)n_samples << std::endl;
+
+    t1 = boost::posix_time::microsec_clock::local_time();
+    for (int i=0; i<n_samples; i+=block) {
+      const int last = std::min(i+block, n_samples) - 1;
+      f.appendArrays("block", data(blitz::Range(i, last), blitz::Range::all()));
+    }
+    t2 = boost::posix_time::microsec_clock::local_time();
+    diff = t2 - t1;
+    std::cout << "  appendArrays (microseconds/vector) " << diff.total_microseconds() / (double)n_samples << std::endl;
+  }
+
+  {
+    bob::io::HDF5File f(filename, bob::io::HDF5File::in);
+    blitz::Array<double,1> v(dim);
+    const int n_read = (n_samples / block) * block;
+
+    t1 = boost::posix_time::microsec_clock::local_time();
+    for (int i=0; i<n_read; ++i) f.readArray("single", i, v);
+    t2 = boost::posix_time::microsec_clock::local_time();
+    diff = t2 - t1;
+    std::cout << "  readArray, one vector per chunk (microseconds/vector) " << diff.total_microseconds() / (double)n_read << std::endl;
+
+    t1 = boost::posix_time::microsec_clock::local_time();
+    for (int i=0; i<n_read; ++i) f.readArray("block", i, v);
+    t2 = boost::posix_time::microsec_clock::local_time();
+    diff = t2 - t1;
+    std::cout << "  readArray, large chunks (microseconds/vector) " << diff.total_microseconds() / (double)n_read << std::endl;
+
+    t1 = boost::posix_time::microsec_clock::local_time();
+    for (int i=0; i<n_read; i+=block) f.readArrays("block", i, read);
+    t2 = boost::posix_time::microsec_clock::local_time();
+    diff = t2 - t1;
+    std::cout << "  readArrays, large chunks (microseconds/vector) " << diff.total_microseconds() / (double)n_read << std::endl;
+  }
+
+  boost::filesystem::remove(filename);
+}
+
+int main(int argc, char** argv)
+{
+  const int n_samples = (argc > 1) ? atoi(argv[1]) : 100000;
+  benchmark(n_samples, 20, 1000);
+  benchmark(n_samples, 60, 100);
+
+  return 0;
+}
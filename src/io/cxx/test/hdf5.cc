@@ -146,4 +146,53 @@ BOOST_AUTO_TEST_CASE( hdf5_write_on_readonly )
   boost::filesystem::remove(filename);
 }
 
+BOOST_AUTO_TEST_CASE( hdf5_block_append_read )
+{
+  const std::string filename = bob::core::tmpfile();
+  bob::io::HDF5File config(filename, bob::io::HDF5File::trunc);
+
+  // Appends blocks of arrays, with a chunk size of 16 samples, mixing
+  // blocks and single arrays
+  blitz::Array<double,2> data(100, 2);
+  for (int i=0; i<100; ++i) data(i,blitz::Range::all()) = 2*i, 2*i+1;
+  config.appendArrays("data", data(blitz::Range(0,49), blitz::Range::all()),
+      0, 16*2*sizeof(double));
+  blitz::Array<double,1> row = data(50, blitz::Range::all());
+  config.appendArray("data", row);
+  config.appendArrays("data", data(blitz::Range(51,99), blitz::Range::all()));
+  config.setChunkCache("data", 4096);
+
+  // The layout is the one of a list of arrays
+  const std::vector<bob::io::HDF5Descriptor>& d = config.describe("data");
+  BOOST_CHECK_EQUAL(d[0].size, (size_t)100);
+  BOOST_CHECK(d[0].expandable);
+  for (int i=0; i<100; ++i) {
+    blitz::Array<double,1> r = config.readArray<double,1>("data", i);
+    blitz::Array<double,1> ref = data(i, blitz::Range::all());
+    check_equal(ref, r);
+  }
+  check_equal(data, config.readArray<double,2>("data"));
+
+  // Reads blocks
+  blitz::Array<double,2> block(30, 2);
+  config.readArrays("data", 45, block);
+  blitz::Array<double,2> ref = data(blitz::Range(45,74), blitz::Range::all());
+  check_equal(ref, block);
+  BOOST_CHECK_THROW(config.readArrays("data", 80, block), std::runtime_error);
+
+  // Blocks of scalars
+  blitz::Array<int32_t,1> scalars(10);
+  scalars = blitz::firstIndex();
+  config.appendArrays("scalars", scalars);
+  config.append("scalars", (int32_t)10);
+  BOOST_CHECK_EQUAL(config.read<int32_t>("scalars", 3), 3);
+  BOOST_CHECK_EQUAL(config.read<int32_t>("scalars", 10), 10);
+  blitz::Array<int32_t,1> scalars_read(5);
+  config.readArrays("scalars", 6, scalars_read);
+  for (int i=0; i<5; ++i) BOOST_CHECK_EQUAL(scalars_read(i), 6+i);
+
+  // Clean-up
+  boost::filesystem::remove(filename);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -98,20 +98,25 @@ bob::ip::DCTFeatures::operator!=(const bob::ip::DCTFeatures& b) const
 }
 
 void
-bob::ip::DCTFeatures::normalizeBlock(const blitz::Array<double,2>& b) const
+bob::ip::DCTFeatures::blockDCT(const blitz::Array<double,2>& src,
+  const int y, const int x) const
 {
+  // Copy the block with top-left corner (y,x) into the contiguous cache,
+  // which is the input of the DCT
+  for (int i=0; i<(int)m_block_h; ++i)
+    for (int j=0; j<(int)m_block_w; ++j)
+      m_cache_block1(i,j) = src(y+i,x+j);
+
   // Normalize block if required and extract DCT for the current block
   if(m_norm_block)
   {
-    double mean = blitz::mean(b);
-    double var = blitz::sum(blitz::pow2(b - mean)) / (double)(m_block_h * m_block_w);
+    double mean = blitz::mean(m_cache_block1);
+    double var = blitz::sum(blitz::pow2(m_cache_block1 - mean)) / (double)(m_block_h * m_block_w);
     double std = 1.;
     if(var >= m_norm_epsilon) std = sqrt(var);
-    m_cache_block1 = (b - mean) / std;
-    m_dct2d(m_cache_block1, m_cache_block2);
+    m_cache_block1 = (m_cache_block1 - mean) / std;
   }
-  else
-    m_dct2d(bob::core::array::ccopy(b), m_cache_block2);
+  m_dct2d(m_cache_block1, m_cache_block2);
 }
 
 void
@@ -152,24 +157,23 @@ void bob::ip::DCTFeatures::operator()<double>(const blitz::Array<double,2>& src,
   bob::core::array::assertZeroBase(dst);
   blitz::TinyVector<int,2> shape = get2DOutputShape(src);
   bob::core::array::assertSameShape(dst, shape);
- 
-  // get all the blocks
-  std::list<blitz::Array<double,2> > blocks;
-  blockReference(src, blocks, m_block_h, m_block_w, m_overlap_h, m_overlap_w);
- 
-  /// dct extract each block
+  const blitz::TinyVector<int,4> block_shape = getBlock4DOutputShape(src, m_block_h, m_block_w, m_overlap_h, m_overlap_w);
+  const int size_ov_h = m_block_h - m_overlap_h;
+  const int size_ov_w = m_block_w - m_overlap_w;
+
+  /// dct extract each block, in the order of the block decomposition
   int i=0;
-  for(std::list<blitz::Array<double,2> >::const_iterator it = blocks.begin();
-    it != blocks.end(); ++it, ++i) 
-  {
-    // Normalize input block (if required)
-    normalizeBlock(*it);
+  for(int h=0; h<block_shape(0); ++h)
+    for(int w=0; w<block_shape(1); ++w, ++i)
+    {
+      // Normalize input block (if required) and extract its DCT
+      blockDCT(src, h*size_ov_h, w*size_ov_w);
 
-    // Extract the required number of coefficients using the zigzag pattern
-    // and push it in the right dst row
-    blitz::Array<double,1> dst_row = dst(i, blitz::Range::all());
-    extractRowDCTCoefs(dst_row);
-  }
+      // Extract the required number of coefficients using the zigzag pattern
+      // and push it in the right dst row
+      blitz::Array<double,1> dst_row = dst(i, blitz::Range::all());
+      extractRowDCTCoefs(dst_row);
+    }
 
   // Normalize dct if required
   if(m_norm_dct)
@@ -193,34 +197,21 @@ void bob::ip::DCTFeatures::operator()<double>(const blitz::Array<double,2>& src,
   bob::core::array::assertZeroBase(dst);
   blitz::TinyVector<int,3> shape = get3DOutputShape(src);
   bob::core::array::assertSameShape(dst, shape);
- 
-  // get all the blocks
-  std::list<blitz::Array<double,2> > blocks;
-  blockReference(src, blocks, m_block_h, m_block_w, m_overlap_h, m_overlap_w);
-  const blitz::TinyVector<int,4> block_shape = getBlock4DOutputShape(src, m_block_h, m_block_w, m_overlap_h, m_overlap_w);
+  const int size_ov_h = m_block_h - m_overlap_h;
+  const int size_ov_w = m_block_w - m_overlap_w;
 
   /// dct extract each block
-  int i=0;
-  int j=0;
-  for(std::list<blitz::Array<double,2> >::const_iterator it = blocks.begin();
-    it != blocks.end(); ++it) 
-  {
-    // Normalize block if required and extract DCT for the current block
-    normalizeBlock(*it);
-
-    // Extract the required number of coefficients using the zigzag pattern
-    // and push it in the right dst row
-    blitz::Array<double,1> dst_row = dst(i, j, blitz::Range::all());
-    extractRowDCTCoefs(dst_row);
-    // Increment block indices
-    if (j>=shape(1)-1)
+  for(int i=0; i<shape(0); ++i)
+    for(int j=0; j<shape(1); ++j)
     {
-      j=0;
-      ++i;
+      // Normalize block if required and extract DCT for the current block
+      blockDCT(src, i*size_ov_h, j*size_ov_w);
+
+      // Extract the required number of coefficients using the zigzag pattern
+      // and push it in the right dst row
+      blitz::Array<double,1> dst_row = dst(i, j, blitz::Range::all());
+      extractRowDCTCoefs(dst_row);
     }
-    else
-      ++j;
-  }
 
   // Normalize dct if required
   if(m_norm_dct)
@@ -22,13 +22,21 @@
 
 #include "bob/core/assert.h"
 #include "bob/core/array_copy.h"
+#include "bob/core/cast.h"
+#include "bob/core/check.h"
+#include "bob/core/parallel.h"
 #include "bob/ip/GaborWaveletTransform.h"
+#include <boost/bind.hpp>
+#include <boost/format.hpp>
 #include <numeric>
 #include <sstream>
 #include <fstream>
 
 static inline double sqr(double x){return x*x;}
 
+//! Relative magnitude (with respect to the largest value) below which the values of the Gabor wavelets in spatial domain are neglected
+static const double GWT_SPATIAL_EPSILON = 1e-6;
+
 /**
  * Generates a Gabor kernel.
  * @param resolution The resolution of the image to generate
@@ -85,10 +93,9 @@ bob::ip::GaborKernel::GaborKernel(
       } // if ! dc_free
 
       if (std::abs(wavelet_value) > epsilon){
-        m_kernel_pixel.push_back(std::make_pair(
-          blitz::TinyVector<int,2>((y + m_y_resolution) % m_y_resolution, (x + m_x_resolution) % m_x_resolution),
-          wavelet_value
-        ));
+        blitz::TinyVector<int,2> index((y + m_y_resolution) % m_y_resolution, (x + m_x_resolution) % m_x_resolution);
+        m_kernel_pixel.push_back(std::make_pair(index, wavelet_value));
+        m_kernel_offsets.push_back(index[0] * m_x_resolution + index[1]);
       }
     } // for x
   } // for y
@@ -98,6 +105,7 @@ bob::ip::GaborKernel::GaborKernel(
   const bob::ip::GaborKernel& other
 )
 : m_kernel_pixel(other.m_kernel_pixel.size()),
+  m_kernel_offsets(other.m_kernel_offsets),
   m_x_resolution(other.m_x_resolution),
   m_y_resolution(other.m_y_resolution)
 {
@@ -114,6 +122,7 @@ bob::ip::GaborKernel::operator =
   m_y_resolution = other.m_y_resolution;
   m_kernel_pixel.resize(other.m_kernel_pixel.size());
   std::copy(other.m_kernel_pixel.begin(), other.m_kernel_pixel.end(), m_kernel_pixel.begin());
+  m_kernel_offsets = other.m_kernel_offsets;
   return *this;
 }
 
@@ -170,6 +179,18 @@ void bob::ip::GaborKernel::transform(
 {
   // assert same size
   bob::core::array::assertSameShape(frequency_domain_image, transformed_frequency_domain_image);
+  if (bob::core::array::isCZeroBaseContiguous(frequency_domain_image) && bob::core::array::isCZeroBaseContiguous(transformed_frequency_domain_image)){
+    // the wavelet is real: scale the complex values at the stored offsets
+    const std::complex<double>* src = frequency_domain_image.data();
+    std::complex<double>* dst = transformed_frequency_domain_image.data();
+    std::fill(dst, dst + transformed_frequency_domain_image.numElements(), std::complex<double>(0));
+    const size_t size = m_kernel_offsets.size();
+    for (size_t i = 0; i < size; ++i){
+      const unsigned offset = m_kernel_offsets[i];
+      dst[offset] = src[offset] * m_kernel_pixel[i].second;
+    }
+    return;
+  }
   // clear resulting image first
   transformed_frequency_domain_image = std::complex<double>(0);
   // iterate through the kernel pixels and do the multiplication
@@ -223,6 +244,7 @@ bob::ip::GaborWaveletTransform::GaborWaveletTransform(
   m_dc_free(dc_free),
   m_fft(0,0),
   m_ifft(0,0),
+  m_spatial_resolution(0,0),
   m_number_of_scales(number_of_scales),
   m_number_of_directions(number_of_directions)
 {
@@ -240,6 +262,7 @@ bob::ip::GaborWaveletTransform::GaborWaveletTransform(
   m_dc_free(other.m_dc_free),
   m_fft(0,0),
   m_ifft(0,0),
+  m_spatial_resolution(0,0),
   m_number_of_scales(other.m_number_of_scales),
   m_number_of_directions(other.m_number_of_directions)
 {
@@ -354,8 +377,22 @@ void bob::ip::GaborWaveletTransform::generateKernels(
     // reset fft sizes
     m_fft.reset(resolution[0], resolution[1]);
     m_ifft.reset(resolution[0], resolution[1]);
-    m_temp_array.resize(blitz::shape(resolution[0],resolution[1]));
-    m_frequency_image.resize(m_temp_array.shape());
+    m_frequency_image.resize(blitz::shape(resolution[0],resolution[1]));
+    m_temp_arrays.clear();
+    // the spatial kernels have to be regenerated as well
+    m_spatial_resolution = 0;
+  }
+}
+
+/**
+ * Allocates one temporary image per thread, for the current resolution.
+ */
+void bob::ip::GaborWaveletTransform::allocateTemporaries(){
+  const size_t n_threads = bob::core::getNThreads();
+  if (m_temp_arrays.size() != n_threads){
+    m_temp_arrays.resize(n_threads);
+    for (size_t t = 0; t < n_threads; ++t)
+      m_temp_arrays[t].resize(m_frequency_image.shape());
   }
 }
 
@@ -365,7 +402,7 @@ void bob::ip::GaborWaveletTransform::generateKernels(
  */
 blitz::Array<double,3> bob::ip::GaborWaveletTransform::kernelImages() const{
   // generate array of desired size
-  blitz::Array<double,3> res(m_gabor_kernels.size(), m_temp_array.shape()[0], m_temp_array.shape()[1]);
+  blitz::Array<double,3> res(m_gabor_kernels.size(), m_frequency_image.shape()[0], m_frequency_image.shape()[1]);
   // fill in the wavelets
   for (int j = m_gabor_kernels.size(); j--;){
     res(j, blitz::Range::all(), blitz::Range::all()) = m_gabor_kernels[j].kernelImage();
@@ -391,17 +428,98 @@ void bob::ip::GaborWaveletTransform::performGWT(
 
   // check that the shape is correct
   bob::core::array::assertSameShape(trafo_image, blitz::shape(m_kernel_frequencies.size(),gray_image.extent(0),gray_image.extent(1)));
+  bob::core::array::assertCZeroBaseContiguous(trafo_image);
 
-  // now, let each kernel compute the transformation result
-  for (unsigned j = 0; j < m_gabor_kernels.size(); ++j){
-    // get a reference to the current layer of the trafo image
-    m_gabor_kernels[j].transform(m_frequency_image, m_temp_array);
+  // now, let each kernel compute the transformation result, one layer per thread at a time
+  allocateTemporaries();
+  bob::core::parallelFor(0, m_gabor_kernels.size(),
+    boost::bind(&bob::ip::GaborWaveletTransform::computeLayers, this, trafo_image.data(), _1, _2, _3), 1);
+}
+
+/**
+ * Computes the layers [begin,end[ of the trafo image, which is accessed through its data pointer only.
+ * @param trafo_image  The data of the (C-contiguous) trafo image
+ */
+void bob::ip::GaborWaveletTransform::computeLayers(
+  std::complex<double>* trafo_image,
+  size_t begin,
+  size_t end,
+  size_t thread
+)
+{
+  blitz::Array<std::complex<double>,2>& temp_array = m_temp_arrays[thread];
+  const int height = temp_array.extent(0), width = temp_array.extent(1);
+  for (size_t j = begin; j < end; ++j){
+    m_gabor_kernels[j].transform(m_frequency_image, temp_array);
     // perform ifft on the trafo image layer
-    blitz::Array<std::complex<double>,2> layer(trafo_image(j, blitz::Range::all(), blitz::Range::all()));
-    m_ifft(m_temp_array, layer);
+    blitz::Array<std::complex<double>,2> layer(trafo_image + j * height * width, blitz::shape(height, width), blitz::neverDeleteData);
+    m_ifft(temp_array, layer);
   } // for j
 }
 
+/**
+ * Computes the absolute values and phases (if phase_image is not NULL) of the layers [begin,end[ of the jet image.
+ * @param abs_image    The address of the absolute value of the first kernel at the first pixel
+ * @param phase_image  The address of the phase of the first kernel at the first pixel, or NULL
+ * @param strides      The strides of the jet image in y, x and kernel direction
+ */
+void bob::ip::GaborWaveletTransform::computeJetLayers(
+  double* abs_image,
+  double* phase_image,
+  const blitz::TinyVector<int,3>& strides,
+  size_t begin,
+  size_t end,
+  size_t thread
+)
+{
+  blitz::Array<std::complex<double>,2>& temp_array = m_temp_arrays[thread];
+  const int height = temp_array.extent(0), width = temp_array.extent(1);
+  for (size_t j = begin; j < end; ++j){
+    m_gabor_kernels[j].transform(m_frequency_image, temp_array);
+    // perform ifft of transformed image
+    m_ifft(temp_array);
+    // convert into absolute and phase part
+    const std::complex<double>* response = temp_array.data();
+    for (int y = 0; y < height; ++y){
+      for (int x = 0; x < width; ++x, ++response){
+        const int offset = y * strides[0] + x * strides[1] + (int)j * strides[2];
+        abs_image[offset] = std::abs(*response);
+        if (phase_image) phase_image[offset] = std::arg(*response);
+      }
+    }
+  } // for j
+}
+
+/**
+ * Normalizes the absolute values of the jets in the rows [begin,end[ of a jet image to unit length (parallel body).
+ * @param abs_image  The address of the absolute value of the first kernel at the first pixel
+ * @param strides    The strides of the jet image in y, x and kernel direction
+ * @param width      The number of jets per row
+ * @param n_kernels  The length of the jets
+ */
+static void normalizeJets(
+  double* abs_image,
+  const blitz::TinyVector<int,3>& strides,
+  const int width,
+  const int n_kernels,
+  size_t begin,
+  size_t end,
+  size_t
+)
+{
+  for (size_t y = begin; y < end; ++y){
+    for (int x = 0; x < width; ++x){
+      double* jet = abs_image + (int)y * strides[0] + x * strides[1];
+      double norm = 0.;
+      for (int j = 0; j < n_kernels; ++j)
+        norm += jet[j * strides[2]] * jet[j * strides[2]];
+      norm = sqrt(norm);
+      for (int j = 0; j < n_kernels; ++j)
+        jet[j * strides[2]] /= norm;
+    }
+  }
+}
+
 /**
  * Computes the Gabor jets including absolute values and phases for the given image (in spatial domain).
  * @param gray_image  The source image in spatial domain
@@ -423,28 +541,17 @@ void bob::ip::GaborWaveletTransform::computeJetImage(
   // check that the shape is correct
   bob::core::array::assertSameShape(jet_image, blitz::shape(gray_image.extent(0), gray_image.extent(1), 2, m_kernel_frequencies.size()));
 
-  // now, let each kernel compute the transformation result
-  for (int j = 0; j < (int)m_gabor_kernels.size(); ++j){
-    // get a reference to the current layer of the trafo image
-    m_gabor_kernels[j].transform(m_frequency_image, m_temp_array);
-    // perform ifft of transformed image
-    m_ifft(m_temp_array);
-    // convert into absolute and phase part
-    blitz::Array<double,2> abs_part(jet_image(blitz::Range::all(), blitz::Range::all(), 0, j));
-    abs_part = blitz::abs(m_temp_array);
-    blitz::Array<double,2> phase_part(jet_image(blitz::Range::all(), blitz::Range::all(), 1, j));
-    phase_part = blitz::arg(m_temp_array);
-  } // for j
+  // now, let each kernel compute the transformation result, one layer per thread at a time
+  allocateTemporaries();
+  blitz::TinyVector<int,3> strides(jet_image.stride(0), jet_image.stride(1), jet_image.stride(3));
+  double* abs_image = &jet_image(0,0,0,0);
+  bob::core::parallelFor(0, m_gabor_kernels.size(),
+    boost::bind(&bob::ip::GaborWaveletTransform::computeJetLayers, this, abs_image, &jet_image(0,0,1,0), boost::cref(strides), _1, _2, _3), 1);
 
   if (do_normalize){
-    // iterate the positions
-    for (int y = jet_image.extent(0); y--;){
-      for (int x = jet_image.extent(1); x--;){
-        // normalize jet
-        blitz::Array<double,2> jet(jet_image(y,x,blitz::Range::all(),blitz::Range::all()));
-        bob::ip::normalizeGaborJet(jet);
-      }
-    }
+    // normalize the jets, by rows of the image
+    bob::core::parallelFor(0, jet_image.extent(0),
+      boost::bind(&normalizeJets, abs_image, boost::cref(strides), jet_image.extent(1), jet_image.extent(3), _1, _2, _3));
   }
 }
 
@@ -469,29 +576,156 @@ void bob::ip::GaborWaveletTransform::computeJetImage(
   // check that the shape is correct
   bob::core::array::assertSameShape(jet_image, blitz::shape(gray_image.extent(0), gray_image.extent(1), m_kernel_frequencies.size()));
 
-  // now, let each kernel compute the transformation result
-  for (int j = 0; j < (int)m_gabor_kernels.size(); ++j){
-    // get a reference to the current layer of the trafo image
-    m_gabor_kernels[j].transform(m_frequency_image, m_temp_array);
-    // perform ifft of transformed image
-    m_ifft(m_temp_array);
-    // convert into absolute part
-    blitz::Array<double,2> abs_part(jet_image(blitz::Range::all(), blitz::Range::all(), j));
-    abs_part = blitz::abs(m_temp_array);
-  } // for j
+  // now, let each kernel compute the transformation result, one layer per thread at a time
+  allocateTemporaries();
+  blitz::TinyVector<int,3> strides(jet_image.stride(0), jet_image.stride(1), jet_image.stride(2));
+  double* abs_image = &jet_image(0,0,0);
+  bob::core::parallelFor(0, m_gabor_kernels.size(),
+    boost::bind(&bob::ip::GaborWaveletTransform::computeJetLayers, this, abs_image, (double*)0, boost::cref(strides), _1, _2, _3), 1);
 
   if (do_normalize){
-    // iterate the positions
-    for (int y = jet_image.extent(0); y--;){
-      for (int x = jet_image.extent(1); x--;){
-        // normalize jet
-        blitz::Array<double,1> jet(jet_image(y,x,blitz::Range::all()));
-        bob::ip::normalizeGaborJet(jet);
+    // normalize the jets, by rows of the image
+    bob::core::parallelFor(0, jet_image.extent(0),
+      boost::bind(&normalizeJets, abs_image, boost::cref(strides), jet_image.extent(1), jet_image.extent(2), _1, _2, _3));
+  }
+}
+
+/**
+ * Generates the Gabor wavelets in spatial domain, as the inverse Fourier transform of the wavelets in frequency domain.
+ * Hence, the convolution with these wavelets is circular, as is the Gabor wavelet transform.
+ * @param resolution  The resolution of the image to generate the kernels for
+ */
+void bob::ip::GaborWaveletTransform::generateSpatialKernels(
+  blitz::TinyVector<unsigned,2> resolution
+)
+{
+  generateKernels(resolution);
+  if ((int)resolution[0] == m_spatial_resolution[0] && (int)resolution[1] == m_spatial_resolution[1])
+    return;
+
+  m_spatial_kernels.resize(m_gabor_kernels.size());
+  blitz::Array<std::complex<double>,2> kernel(resolution[0], resolution[1]);
+  for (unsigned j = 0; j < m_gabor_kernels.size(); ++j){
+    // transform the wavelet into spatial domain
+    kernel = bob::core::array::cast<std::complex<double> >(m_gabor_kernels[j].kernelImage());
+    m_ifft(kernel);
+    // keep the significant values only
+    const double threshold = blitz::max(blitz::abs(kernel)) * GWT_SPATIAL_EPSILON;
+    m_spatial_kernels[j].clear();
+    for (int y = 0; y < kernel.extent(0); ++y)
+      for (int x = 0; x < kernel.extent(1); ++x)
+        if (std::abs(kernel(y,x)) > threshold)
+          m_spatial_kernels[j].push_back(std::make_pair(blitz::TinyVector<int,2>(y,x), kernel(y,x)));
+  }
+  m_spatial_resolution = blitz::TinyVector<int,2>(resolution[0], resolution[1]);
+}
+
+/**
+ * Computes the Gabor jets at the positions [begin,end[ by circular convolution with the Gabor wavelets in spatial domain.
+ * @param jets     The address of the absolute value of the first kernel of the first jet
+ * @param strides  The strides of the jets in position and kernel direction, and the offset of the phases (0 if the phases are not computed)
+ */
+void bob::ip::GaborWaveletTransform::computeSpatialJets(
+  const blitz::Array<std::complex<double>,2>& gray_image,
+  const blitz::Array<int,2>& positions,
+  double* jets,
+  const blitz::TinyVector<int,3>& strides,
+  size_t begin,
+  size_t end,
+  size_t
+) const
+{
+  const int height = gray_image.extent(0), width = gray_image.extent(1);
+  for (size_t n = begin; n < end; ++n){
+    const int py = positions(n,0), px = positions(n,1);
+    double* jet = jets + (int)n * strides[0];
+    for (unsigned j = 0; j < m_spatial_kernels.size(); ++j){
+      std::complex<double> response(0.);
+      std::vector<std::pair<blitz::TinyVector<int,2>, std::complex<double> > >::const_iterator it = m_spatial_kernels[j].begin(), it_end = m_spatial_kernels[j].end();
+      for (; it != it_end; ++it){
+        int y = py - it->first[0], x = px - it->first[1];
+        if (y < 0) y += height;
+        if (x < 0) x += width;
+        response += gray_image(y,x) * it->second;
       }
+      jet[(int)j * strides[1]] = std::abs(response);
+      if (strides[2]) jet[strides[2] + (int)j * strides[1]] = std::arg(response);
     }
   }
 }
 
+/**
+ * Computes the Gabor jets including absolute values and phases at the given positions only.
+ * @param gray_image  The source image in spatial domain
+ * @param positions   The positions (y,x) to compute the Gabor jets at, e.g., the nodes of a Gabor graph
+ * @param jets        The resulting Gabor jets, one per position
+ * @param do_normalize Shall the Gabor jets be normalized?
+ */
+void bob::ip::GaborWaveletTransform::computeJets(
+  const blitz::Array<std::complex<double>,2>& gray_image,
+  const blitz::Array<int,2>& positions,
+  blitz::Array<double,3>& jets,
+  bool do_normalize
+)
+{
+  bob::core::array::assertSameShape(jets, blitz::shape(positions.extent(0), 2, m_kernel_frequencies.size()));
+  blitz::TinyVector<int,3> strides(jets.stride(0), jets.stride(2), jets.stride(1));
+  double* abs_jets = jets.numElements() ? &jets(0,0,0) : 0;
+  computeJets(gray_image, positions, abs_jets, strides, do_normalize);
+}
+
+/**
+ * Computes the Gabor jets including absolute values only at the given positions only.
+ * @param gray_image  The source image in spatial domain
+ * @param positions   The positions (y,x) to compute the Gabor jets at, e.g., the nodes of a Gabor graph
+ * @param jets        The resulting Gabor jets, one per position
+ * @param do_normalize Shall the Gabor jets be normalized?
+ */
+void bob::ip::GaborWaveletTransform::computeJets(
+  const blitz::Array<std::complex<double>,2>& gray_image,
+  const blitz::Array<int,2>& positions,
+  blitz::Array<double,2>& jets,
+  bool do_normalize
+)
+{
+  bob::core::array::assertSameShape(jets, blitz::shape(positions.extent(0), m_kernel_frequencies.size()));
+  blitz::TinyVector<int,3> strides(jets.stride(0), jets.stride(1), 0);
+  double* abs_jets = jets.numElements() ? &jets(0,0) : 0;
+  computeJets(gray_image, positions, abs_jets, strides, do_normalize);
+}
+
+void bob::ip::GaborWaveletTransform::computeJets(
+  const blitz::Array<std::complex<double>,2>& gray_image,
+  const blitz::Array<int,2>& positions,
+  double* jets,
+  const blitz::TinyVector<int,3>& strides,
+  bool do_normalize
+)
+{
+  if (positions.extent(1) != 2)
+    throw std::runtime_error("GaborWaveletTransform: the positions should be given as (y,x) pairs");
+  for (int n = 0; n < positions.extent(0); ++n){
+    if (positions(n,0) < 0 || positions(n,0) >= gray_image.extent(0) || positions(n,1) < 0 || positions(n,1) >= gray_image.extent(1)){
+      boost::format m("GaborWaveletTransform: the position (%d,%d) is outside of the image of size %dx%d");
+      m % positions(n,0) % positions(n,1) % gray_image.extent(0) % gray_image.extent(1);
+      throw std::runtime_error(m.str());
+    }
+  }
+
+  // first, check if we need to reset the kernels
+  generateSpatialKernels(blitz::TinyVector<unsigned,2>(gray_image.extent(0),gray_image.extent(1)));
+
+  // compute the jets, one position per thread at a time
+  bob::core::parallelFor(0, positions.extent(0),
+    boost::bind(&bob::ip::GaborWaveletTransform::computeSpatialJets, this, boost::cref(gray_image), boost::cref(positions), jets, boost::cref(strides), _1, _2, _3), 1);
+
+  if (do_normalize){
+    // normalize the jets; the positions are the rows of a jet image with only one column
+    blitz::TinyVector<int,3> jet_strides(strides[0], 0, strides[1]);
+    normalizeJets(jets, jet_strides, 1, m_kernel_frequencies.size(), 0, positions.extent(0), 0);
+  }
+}
+
 void bob::ip::GaborWaveletTransform::save(bob::io::HDF5File& file) const{
   file.set("Sigma", m_sigma);
   file.set("PowOfK", m_pow_of_k);
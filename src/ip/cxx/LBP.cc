@@ -217,9 +217,6 @@ void bob::ip::LBP::init()
     throw std::runtime_error("Multi-block LBP codes cannot handle other border handling than LBP_BORDER_SHRINK");
   }
 
-  // initialize temporal memory
-  _pixels.resize(m_P);
-
   // initialize the positions
   if (m_mb_y > 0 && m_mb_x > 0){
     // multi-block LBP requested; store the top-left and bottom-right entry for all our positions
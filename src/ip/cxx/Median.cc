@@ -0,0 +1,157 @@
+/**
+ * @file ip/cxx/Median.cc
+ * @date Sat Oct 17 15:20:12 CEST 2026
+ * @author Laurent El Shafey <Laurent.El-Shafey@idiap.ch>
+ *
+ * @brief Histogram-based median filters of 8-bit and 16-bit images
+ *
+ * Copyright (C) 2011-2013 Idiap Research Institute, Martigny, Switzerland
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "bob/ip/Median.h"
+
+/**
+ * Returns the smallest value v such that more than pos elements of the
+ * histogram are lower or equal to v. The fine histogram is split in
+ * buckets of n_fine bins, whose totals are given by the coarse histogram.
+ */
+static inline int findMedian(const uint32_t* coarse, const uint32_t* fine,
+  const int n_fine, const uint32_t pos)
+{
+  uint32_t sum = 0;
+  int c = 0;
+  while (sum + coarse[c] <= pos) sum += coarse[c++];
+  int b = c*n_fine;
+  while (sum + fine[b] <= pos) sum += fine[b++];
+  return b;
+}
+
+void bob::ip::detail::medianFilter(const MedianStrip<uint8_t>& s,
+  const int y_begin, const int y_end)
+{
+  if (y_begin >= y_end) return;
+  const int h = 2*s.radius_y+1;
+  const int w = 2*s.radius_x+1;
+  const int src_width = s.dst_width + 2*s.radius_x;
+  const uint32_t median_pos = (h*w)/2;
+
+  // Column histograms (256 fine bins and 16 coarse ones per column) of the
+  // rows [y, y+h) of the input
+  std::vector<uint32_t> col_fine(src_width*256, 0);
+  std::vector<uint32_t> col_coarse(src_width*16, 0);
+  for (int j=0; j<h; ++j) {
+    const uint8_t* row = s.src + (y_begin+j)*s.src_stride_y;
+    for (int c=0; c<src_width; ++c) {
+      const uint8_t v = row[c*s.src_stride_x];
+      ++col_fine[c*256 + v];
+      ++col_coarse[c*16 + (v>>4)];
+    }
+  }
+
+  uint32_t fine[256];
+  uint32_t coarse[16];
+  for (int y=y_begin; y<y_end; ++y)
+  {
+    // Moves the column histograms one row down
+    if (y > y_begin) {
+      const uint8_t* row_out = s.src + (y-1)*s.src_stride_y;
+      const uint8_t* row_in = s.src + (y-1+h)*s.src_stride_y;
+      for (int c=0; c<src_width; ++c) {
+        const uint8_t v_out = row_out[c*s.src_stride_x];
+        const uint8_t v_in = row_in[c*s.src_stride_x];
+        --col_fine[c*256 + v_out];
+        --col_coarse[c*16 + (v_out>>4)];
+        ++col_fine[c*256 + v_in];
+        ++col_coarse[c*16 + (v_in>>4)];
+      }
+    }
+
+    // Kernel histogram of the first output pixel of the row
+    std::fill(fine, fine+256, 0);
+    std::fill(coarse, coarse+16, 0);
+    for (int c=0; c<w; ++c) {
+      const uint32_t* cf = &col_fine[c*256];
+      const uint32_t* cc = &col_coarse[c*16];
+      for (int b=0; b<256; ++b) fine[b] += cf[b];
+      for (int b=0; b<16; ++b) coarse[b] += cc[b];
+    }
+
+    uint8_t* dst_row = s.dst + y*s.dst_stride_y;
+    for (int x=0; x<s.dst_width; ++x)
+    {
+      dst_row[x*s.dst_stride_x] = (uint8_t)findMedian(coarse, fine, 16, median_pos);
+      if (x == s.dst_width-1) break;
+
+      // Replaces the histogram of column x by the one of column x+w
+      const uint32_t* cf_out = &col_fine[x*256];
+      const uint32_t* cf_in = &col_fine[(x+w)*256];
+      for (int b=0; b<256; ++b) fine[b] += cf_in[b] - cf_out[b];
+      const uint32_t* cc_out = &col_coarse[x*16];
+      const uint32_t* cc_in = &col_coarse[(x+w)*16];
+      for (int b=0; b<16; ++b) coarse[b] += cc_in[b] - cc_out[b];
+    }
+  }
+}
+
+void bob::ip::detail::medianFilter(const MedianStrip<uint16_t>& s,
+  const int y_begin, const int y_end)
+{
+  if (y_begin >= y_end) return;
+  const int h = 2*s.radius_y+1;
+  const int w = 2*s.radius_x+1;
+  const uint32_t median_pos = (h*w)/2;
+
+  // Kernel histogram, which is emptied at the end of each row
+  std::vector<uint32_t> fine(65536, 0);
+  std::vector<uint32_t> coarse(256, 0);
+
+  for (int y=y_begin; y<y_end; ++y)
+  {
+    const uint16_t* src_row = s.src + y*s.src_stride_y;
+    for (int j=0; j<h; ++j)
+      for (int i=0; i<w; ++i) {
+        const uint16_t v = src_row[j*s.src_stride_y + i*s.src_stride_x];
+        ++fine[v];
+        ++coarse[v>>8];
+      }
+
+    uint16_t* dst_row = s.dst + y*s.dst_stride_y;
+    for (int x=0; x<s.dst_width; ++x)
+    {
+      dst_row[x*s.dst_stride_x] = (uint16_t)findMedian(&coarse[0], &fine[0], 256, median_pos);
+
+      // Removes column x, and adds column x+w unless the row is over
+      const bool last = (x == s.dst_width-1);
+      for (int j=0; j<h; ++j) {
+        const uint16_t* p = src_row + j*s.src_stride_y + x*s.src_stride_x;
+        --fine[p[0]];
+        --coarse[p[0]>>8];
+        if (!last) {
+          const uint16_t v = p[w*s.src_stride_x];
+          ++fine[v];
+          ++coarse[v>>8];
+        }
+      }
+    }
+
+    // Empties the kernel histogram
+    for (int j=0; j<h; ++j)
+      for (int i=s.dst_width; i<s.dst_width+w-1; ++i) {
+        const uint16_t v = src_row[j*s.src_stride_y + i*s.src_stride_x];
+        --fine[v];
+        --coarse[v>>8];
+      }
+  }
+}
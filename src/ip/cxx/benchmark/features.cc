@@ -0,0 +1,89 @@
+/**
+ * @file ip/cxx/benchmark/features.cc
+ * @date Sat Oct 17 18:41:52 CEST 2026
+ * @author Laurent El Shafey <Laurent.El-Shafey@idiap.ch>
+ *
+ * @brief Benchmark the throughput (in images per second) of the block-based
+ * feature extractors (DCT and LBP histogram sequences) on face crops
+ *
+ * Copyright (C) 2011-2013 Idiap Research Institute, Martigny, Switzerland
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <bob/ip/DCTFeatures.h>
+#include <bob/ip/LBPHSFeatures.h>
+
+#include <boost/random.hpp>
+#include <boost/date_time/posix_time/posix_time.hpp>
+#include <iostream>
+
+static double imagesPerSecond(const int n_images,
+  const boost::posix_time::time_duration& diff)
+{
+  return n_images / (diff.total_microseconds() / 1e6);
+}
+
+/**
+ * DCT and LBPHS features of n_images random images of the given size, using
+ * blocks of the given size and overlap
+ */
+void benchmark_features(const int height, const int width, const int block,
+  const int overlap, const int n_images)
+{
+  boost::mt19937 rng;
+  boost::uniform_int<> dist(0, 255);
+  blitz::Array<uint8_t,2> image(height, width);
+  for (int y=0; y<height; ++y)
+    for (int x=0; x<width; ++x)
+      image(y,x) = dist(rng);
+  boost::posix_time::ptime t1;
+  boost::posix_time::ptime t2;
+  boost::posix_time::time_duration diff;
+
+  std::cout << "Features of " << height << "x" << width << " images, " << block << "x" << block << " blocks with an overlap of " << overlap << " (" << n_images << " images)..." << std::endl;
+
+  bob::ip::DCTFeatures dct(block, block, overlap, overlap, 45, true, true);
+  blitz::Array<double,2> dct_output(dct.get2DOutputShape(image));
+  t1 = boost::posix_time::microsec_clock::local_time();
+  for (int i=0; i<n_images; ++i)
+    dct(image, dct_output);
+  t2 = boost::posix_time::microsec_clock::local_time();
+  diff = t2 - t1;
+  std::cout << "  DCTFeatures (images/second) " << imagesPerSecond(n_images, diff) << std::endl;
+
+  bob::ip::LBPHSFeatures lbphs(block, block, overlap, overlap, 1., 8, false, false, false, true);
+  blitz::Array<uint64_t,2> lbphs_output(lbphs.getNBlocks(image), lbphs.getNBins());
+  t1 = boost::posix_time::microsec_clock::local_time();
+  for (int i=0; i<n_images; ++i)
+    lbphs(image, lbphs_output);
+  t2 = boost::posix_time::microsec_clock::local_time();
+  diff = t2 - t1;
+  std::cout << "  LBPHSFeatures, rectangular LBP (images/second) " << imagesPerSecond(n_images, diff) << std::endl;
+
+  bob::ip::LBPHSFeatures lbphs_circ(block, block, overlap, overlap, 1., 8, true, false, false, true);
+  t1 = boost::posix_time::microsec_clock::local_time();
+  for (int i=0; i<n_images; ++i)
+    lbphs_circ(image, lbphs_output);
+  t2 = boost::posix_time::microsec_clock::local_time();
+  diff = t2 - t1;
+  std::cout << "  LBPHSFeatures, circular LBP (images/second) " << imagesPerSecond(n_images, diff) << std::endl;
+}
+
+int main()
+{
+  benchmark_features(80, 64, 8, 7, 100);
+  benchmark_features(80, 64, 12, 6, 1000);
+
+  return 0;
+}
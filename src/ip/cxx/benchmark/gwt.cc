@@ -0,0 +1,97 @@
+/**
+ * @file ip/cxx/benchmark/gwt.cc
+ * @date Sat Oct 17 21:48:05 CEST 2026
+ * @author Laurent El Shafey <Laurent.El-Shafey@idiap.ch>
+ *
+ * @brief Benchmark the throughput (in images per second) of the Gabor wavelet
+ * transform, computing whole jet images or the jets at the nodes of a graph
+ *
+ * Copyright (C) 2011-2013 Idiap Research Institute, Martigny, Switzerland
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <bob/ip/GaborWaveletTransform.h>
+#include <bob/core/parallel.h>
+
+#include <boost/random.hpp>
+#include <boost/date_time/posix_time/posix_time.hpp>
+#include <iostream>
+
+static double imagesPerSecond(const int n_images,
+  const boost::posix_time::time_duration& diff)
+{
+  return n_images / (diff.total_microseconds() / 1e6);
+}
+
+/**
+ * Gabor jets of n_images random images of the given size, computed as whole
+ * jet images with an increasing number of threads, and at the nodes of a
+ * regular grid with the given step only
+ */
+void benchmark_gwt(const int height, const int width, const int step,
+  const int n_images)
+{
+  boost::mt19937 rng;
+  boost::uniform_int<> dist(0, 255);
+  blitz::Array<std::complex<double>,2> image(height, width);
+  for (int y=0; y<height; ++y)
+    for (int x=0; x<width; ++x)
+      image(y,x) = dist(rng);
+  boost::posix_time::ptime t1;
+  boost::posix_time::ptime t2;
+  boost::posix_time::time_duration diff;
+
+  bob::ip::GaborWaveletTransform gwt;
+  blitz::Array<double,4> jet_image(height, width, 2, gwt.numberOfKernels());
+
+  // nodes of a regular grid
+  const int n_y = (height - 1) / step, n_x = (width - 1) / step;
+  blitz::Array<int,2> positions(n_y * n_x, 2);
+  for (int y=0; y<n_y; ++y)
+    for (int x=0; x<n_x; ++x) {
+      positions(y*n_x+x, 0) = (y+1) * step;
+      positions(y*n_x+x, 1) = (x+1) * step;
+    }
+  blitz::Array<double,3> jets(positions.extent(0), 2, gwt.numberOfKernels());
+
+  std::cout << "Gabor jets of " << height << "x" << width << " images (" << n_images << " images)..." << std::endl;
+
+  const size_t n_threads[4] = {1, 2, 4, 8};
+  for (int k=0; k<4; ++k)
+  {
+    bob::core::setNThreads(n_threads[k]);
+    t1 = boost::posix_time::microsec_clock::local_time();
+    for (int i=0; i<n_images; ++i)
+      gwt.computeJetImage(image, jet_image, true);
+    t2 = boost::posix_time::microsec_clock::local_time();
+    diff = t2 - t1;
+    std::cout << "  Jet image with " << n_threads[k] << " thread(s) (images/second) " << imagesPerSecond(n_images, diff) << std::endl;
+
+    t1 = boost::posix_time::microsec_clock::local_time();
+    for (int i=0; i<n_images; ++i)
+      gwt.computeJets(image, positions, jets, true);
+    t2 = boost::posix_time::microsec_clock::local_time();
+    diff = t2 - t1;
+    std::cout << "  Jets at " << positions.extent(0) << " nodes with " << n_threads[k] << " thread(s) (images/second) " << imagesPerSecond(n_images, diff) << std::endl;
+  }
+  bob::core::setNThreads(0);
+}
+
+int main()
+{
+  benchmark_gwt(80, 64, 10, 100);
+  benchmark_gwt(160, 128, 20, 50);
+
+  return 0;
+}
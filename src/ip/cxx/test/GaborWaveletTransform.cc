@@ -36,7 +36,9 @@
 #include "bob/core/array_convert.h"
 #include "bob/core/cast.h"
 #include "bob/io/utils.h"
+#include "bob/core/parallel.h"
 #include "bob/ip/GaborWaveletTransform.h"
+#include <boost/random.hpp>
 
 
 
@@ -232,4 +234,58 @@ BOOST_AUTO_TEST_CASE( test_GWT_output )
 
 }
 
+BOOST_AUTO_TEST_CASE( test_GWT_threads_and_positions )
+{
+  // random image of non-square size
+  const int height = 48, width = 64;
+  boost::mt19937 rng;
+  boost::uniform_int<> dist(0, 255);
+  blitz::Array<std::complex<double>,2> image(height, width);
+  for (int y = 0; y < height; ++y)
+    for (int x = 0; x < width; ++x)
+      image(y,x) = dist(rng);
+
+  bob::ip::GaborWaveletTransform gwt;
+  const int n_kernels = gwt.numberOfKernels();
+
+  // the trafo and jet images do not depend on the number of threads
+  bob::core::setNThreads(1);
+  blitz::Array<std::complex<double>,3> trafo_image(n_kernels, height, width), trafo_image_threads(n_kernels, height, width);
+  gwt.performGWT(image, trafo_image);
+  blitz::Array<double,4> jet_image(height, width, 2, n_kernels), jet_image_threads(height, width, 2, n_kernels);
+  gwt.computeJetImage(image, jet_image, true);
+  bob::core::setNThreads(3);
+  gwt.performGWT(image, trafo_image_threads);
+  gwt.computeJetImage(image, jet_image_threads, true);
+  test_close(trafo_image_threads, trafo_image, epsilon);
+  test_close(jet_image_threads, jet_image, epsilon);
+
+  // the jets computed at some positions (including the borders) are those of the jet image
+  blitz::Array<int,2> positions(5, 2);
+  positions = 0, 0,
+              10, 20,
+              24, 32,
+              47, 5,
+              30, 63;
+  blitz::Array<double,3> jets(5, 2, n_kernels);
+  blitz::Array<double,2> abs_jets(5, n_kernels);
+  gwt.computeJets(image, positions, jets, true);
+  gwt.computeJets(image, positions, abs_jets, true);
+  for (int n = 0; n < 5; ++n){
+    for (int j = 0; j < n_kernels; ++j){
+      double a = jet_image(positions(n,0), positions(n,1), 0, j), phi = jet_image(positions(n,0), positions(n,1), 1, j);
+      BOOST_CHECK_SMALL(jets(n,0,j) - a, epsilon);
+      BOOST_CHECK_SMALL(abs_jets(n,j) - a, epsilon);
+      // phases are compared through the complex values, since they are unstable for small absolute values
+      BOOST_CHECK_SMALL(jets(n,0,j) * cos(jets(n,1,j)) - a * cos(phi), epsilon);
+      BOOST_CHECK_SMALL(jets(n,0,j) * sin(jets(n,1,j)) - a * sin(phi), epsilon);
+    }
+  }
+  bob::core::setNThreads(0);
+
+  // positions outside of the image are rejected
+  positions(4,1) = width;
+  BOOST_CHECK_THROW(gwt.computeJets(image, positions, jets, true), std::runtime_error);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
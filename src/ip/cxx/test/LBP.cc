@@ -31,6 +31,7 @@
 #include "bob/ip/LBP.h"
 
 #include <iostream>
+#include <boost/random.hpp>
 
 struct T {
   blitz::Array<uint8_t,2> a1, a2;
@@ -129,6 +130,18 @@ void checkBlitzEqual( blitz::Array<T,3>& t1, blitz::Array<T,3>& t2)
         BOOST_CHECK_EQUAL(t1(i,j,k), t2(i,j,k));
 }
 
+template<typename T>
+void checkDenseExtraction(const bob::ip::LBP& lbp, const blitz::Array<T,2>& image, bool is_integral_image = false)
+{
+  // the codes of the whole image must be identical to the ones extracted pixel by pixel
+  blitz::Array<uint16_t,2> result(lbp.getLBPShape(image, is_integral_image));
+  lbp(image, result, is_integral_image);
+  blitz::TinyVector<int,2> offset = lbp.getOffset();
+  for( int y=0; y<result.extent(0); ++y)
+    for( int x=0; x<result.extent(1); ++x)
+      BOOST_CHECK_EQUAL(result(y,x), lbp(image, y + offset[0], x + offset[1], is_integral_image));
+}
+
 BOOST_FIXTURE_TEST_SUITE( test_setup, T )
 
 BOOST_AUTO_TEST_CASE( test_lbp4_1_uint8 )
@@ -372,4 +385,51 @@ BOOST_AUTO_TEST_CASE( test_lbp_other )
   BOOST_CHECK_EQUAL( lbp_16_a2_t, lbp(a2,1,1) );
 }
 
+BOOST_AUTO_TEST_CASE( test_lbp_dense )
+{
+  // random images, with many identical neighbors
+  boost::mt19937 rng;
+  boost::uniform_int<> dist(0, 7);
+  blitz::Array<uint8_t,2> image(23,31);
+  blitz::Array<double,2> image_d(23,31);
+  for( int y=0; y<image.extent(0); ++y)
+    for( int x=0; x<image.extent(1); ++x){
+      image(y,x) = 32 * dist(rng);
+      // values that are close but not equal
+      image_d(y,x) = image(y,x) + 1e-9 * dist(rng);
+    }
+
+  std::vector<bob::ip::LBP> operators;
+  operators.push_back(bob::ip::LBP(8));
+  operators.push_back(bob::ip::LBP(8, 2.));
+  operators.push_back(bob::ip::LBP(4));
+  operators.push_back(bob::ip::LBP(8, 1., 2.));
+  operators.push_back(bob::ip::LBP(8, 1., false, false, false, true));
+  operators.push_back(bob::ip::LBP(8, 2., false, false, false, true, true));
+  operators.push_back(bob::ip::LBP(8, 1., false, false, false, false, false, bob::ip::ELBP_REGULAR, bob::ip::LBP_BORDER_WRAP));
+  operators.push_back(bob::ip::LBP(8, 2., false, false, false, true, false, bob::ip::ELBP_REGULAR, bob::ip::LBP_BORDER_WRAP));
+  operators.push_back(bob::ip::LBP(8, blitz::TinyVector<int,2>(1, 1)));
+  operators.push_back(bob::ip::LBP(8, blitz::TinyVector<int,2>(3, 2)));
+  operators.push_back(bob::ip::LBP(4, blitz::TinyVector<int,2>(2, 2), false, false, true));
+  operators.push_back(bob::ip::LBP(8, blitz::TinyVector<int,2>(2, 3), false, false, true, true));
+
+  // a non-contiguous part of the image
+  blitz::Array<uint8_t,2> part = image(blitz::Range(1,20), blitz::Range(2,30,2));
+
+  for (size_t i = 0; i < operators.size(); ++i){
+    checkDenseExtraction(operators[i], image);
+    checkDenseExtraction(operators[i], image_d);
+    checkDenseExtraction(operators[i], part);
+    if (operators[i].getBlockSize()[0] > 0){
+      // multi-block LBP from a pre-computed integral image
+      blitz::Array<int,2> ii(image.extent(0)+1, image.extent(1)+1);
+      bob::ip::integral(image, ii, true);
+      checkDenseExtraction(operators[i], ii, true);
+      blitz::Array<double,2> ii_d(image.extent(0)+1, image.extent(1)+1);
+      bob::ip::integral(image_d, ii_d, true);
+      checkDenseExtraction(operators[i], ii_d, true);
+    }
+  }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
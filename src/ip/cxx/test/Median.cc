@@ -26,6 +26,9 @@
 #include <boost/test/unit_test.hpp>
 #include <blitz/array.h>
 #include "bob/ip/Median.h"
+#include <boost/random.hpp>
+#include <vector>
+#include <algorithm>
 
 struct T {
   double eps;
@@ -53,6 +56,59 @@ void checkBlitzEqual( blitz::Array<T,2>& t1, blitz::Array<U,2>& t2)
 }
 
 
+/**
+ * Reference median filter, sorting each window
+ */
+template<typename T>
+void naiveMedian(const blitz::Array<T,2>& src, blitz::Array<T,2>& dst,
+  const int radius_y, const int radius_x)
+{
+  std::vector<T> window;
+  for (int y=0; y<dst.extent(0); ++y)
+    for (int x=0; x<dst.extent(1); ++x) {
+      window.clear();
+      for (int j=0; j<2*radius_y+1; ++j)
+        for (int i=0; i<2*radius_x+1; ++i)
+          window.push_back(src(y+j,x+i));
+      std::sort(window.begin(), window.end());
+      dst(y,x) = window[window.size()/2];
+    }
+}
+
+/**
+ * Compares the median filter with the reference one on random images, for
+ * several radii. The images are high enough to be split in several strips.
+ */
+template<typename T>
+void checkRandomMedian(const int max_value)
+{
+  boost::mt19937 rng(0);
+  boost::uniform_int<int> dist(0, max_value);
+  blitz::Array<T,2> src(151,67);
+  for (int y=0; y<src.extent(0); ++y)
+    for (int x=0; x<src.extent(1); ++x)
+      src(y,x) = (T)dist(rng);
+
+  const int radii[4][2] = {{0,0}, {1,1}, {2,1}, {3,5}};
+  for (int r=0; r<4; ++r) {
+    const int ry = radii[r][0];
+    const int rx = radii[r][1];
+    blitz::Array<T,2> dst(src.extent(0)-2*ry, src.extent(1)-2*rx);
+    blitz::Array<T,2> ref(dst.shape());
+    naiveMedian(src, ref, ry, rx);
+
+    bob::ip::Median<T> filter(ry, rx);
+    filter(src, dst);
+    checkBlitzEqual(dst, ref);
+
+    // Single thread
+    filter.setNThreads(1);
+    dst = 0;
+    filter(src, dst);
+    checkBlitzEqual(dst, ref);
+  }
+}
+
 BOOST_FIXTURE_TEST_SUITE( test_setup, T )
 
 BOOST_AUTO_TEST_CASE( test_median_2d )
@@ -67,4 +123,40 @@ BOOST_AUTO_TEST_CASE( test_median_2d )
   checkBlitzEqual(dst, ref);
 }
 
+BOOST_AUTO_TEST_CASE( test_median_2d_uint8 )
+{
+  checkRandomMedian<uint8_t>(255);
+  // Many ties
+  checkRandomMedian<uint8_t>(2);
+}
+
+BOOST_AUTO_TEST_CASE( test_median_2d_uint16 )
+{
+  checkRandomMedian<uint16_t>(65535);
+  checkRandomMedian<uint16_t>(2);
+}
+
+BOOST_AUTO_TEST_CASE( test_median_2d_float64 )
+{
+  checkRandomMedian<double>(1000);
+  checkRandomMedian<double>(2);
+}
+
+BOOST_AUTO_TEST_CASE( test_median_3d )
+{
+  bob::ip::Median<uint8_t> g_filter(1,1);
+  blitz::Array<uint8_t,3> src(2,4,5), dst(2,2,3);
+  src = 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18, 19, 20,
+        20, 19, 18, 17, 16, 15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1;
+  g_filter(src,dst);
+
+  blitz::Array<uint8_t,2> ref(2,3);
+  ref = 7, 8, 9, 12, 13, 14;
+  blitz::Array<uint8_t,2> dst0 = dst(0, blitz::Range::all(), blitz::Range::all());
+  checkBlitzEqual(dst0, ref);
+  ref = 14, 13, 12, 9, 8, 7;
+  blitz::Array<uint8_t,2> dst1 = dst(1, blitz::Range::all(), blitz::Range::all());
+  checkBlitzEqual(dst1, ref);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -117,4 +117,43 @@ BOOST_AUTO_TEST_CASE( test_lbphs_feature_extract_with_given_lbp )
   }
 }
 
+BOOST_AUTO_TEST_CASE( test_lbphs_feature_extract_overlap )
+{
+  // the histograms of overlapping blocks are the ones of the LBP codes
+  // extracted from each block
+  const bob::ip::LBP lbps[3] = {bob::ip::LBP(8, 1., false, false, false, true),
+    bob::ip::LBP(8, 1., true, false, false, true),
+    bob::ip::LBP(4, blitz::TinyVector<int,2>(1, 1))};
+  for (int k = 0; k < 3; ++k)
+  {
+    bob::ip::LBPHSFeatures lbphsfeatures( 5, 4, 3, 1, lbps[k]);
+    blitz::Array<uint64_t,2> dst(lbphsfeatures.getNBlocks(src), lbphsfeatures.getNBins());
+    lbphsfeatures(src, dst);
+    BOOST_CHECK_EQUAL( dst.extent(0), 9 );
+
+    std::vector<blitz::Array<uint32_t,2> > blocks;
+    bob::ip::blockReference(src, blocks, 5, 4, 3, 1);
+    BOOST_REQUIRE_EQUAL( (int)blocks.size(), dst.extent(0) );
+    for (size_t b = 0; b < blocks.size(); ++b)
+    {
+      blitz::Array<uint16_t,2> codes(lbps[k].getLBPShape(blocks[b]));
+      lbps[k](blocks[b], codes);
+      blitz::Array<uint64_t,1> histo(lbps[k].getMaxLabel());
+      bob::ip::histogram<uint16_t>(codes, histo, 0, lbps[k].getMaxLabel()-1, lbps[k].getMaxLabel());
+      blitz::Array<uint64_t,1> row = dst((int)b, blitz::Range::all());
+      checkBlitzClose( row, histo, eps);
+    }
+
+    // the container interface returns the same histograms
+    std::vector<blitz::Array<uint64_t,1> > dst_list;
+    lbphsfeatures(src, dst_list);
+    BOOST_REQUIRE_EQUAL( (int)dst_list.size(), dst.extent(0) );
+    for (size_t b = 0; b < dst_list.size(); ++b)
+    {
+      blitz::Array<uint64_t,1> row = dst((int)b, blitz::Range::all());
+      checkBlitzClose( dst_list[b], row, eps);
+    }
+  }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
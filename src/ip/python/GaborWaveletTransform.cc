@@ -146,6 +146,22 @@ static bob::python::ndarray compute_jets_2(bob::ip::GaborWaveletTransform& gwt,
   return output_jet_image;
 }
 
+static bob::python::ndarray compute_jets_at(bob::ip::GaborWaveletTransform& gwt, bob::python::const_ndarray input_image, bob::python::const_ndarray positions, bool include_phases, bool normalized){
+  const blitz::Array<std::complex<double>,2>& image = convert_image(input_image);
+  const blitz::Array<int,2> pos = positions.bz<int,2>();
+  if (include_phases){
+    bob::python::ndarray output_jets(bob::core::array::t_float64, pos.extent(0), 2, (int)gwt.numberOfKernels());
+    blitz::Array<double,3> jets = output_jets.bz<double,3>();
+    gwt.computeJets(image, pos, jets, normalized);
+    return output_jets;
+  } else {
+    bob::python::ndarray output_jets(bob::core::array::t_float64, pos.extent(0), (int)gwt.numberOfKernels());
+    blitz::Array<double,2> jets = output_jets.bz<double,2>();
+    gwt.computeJets(image, pos, jets, normalized);
+    return output_jets;
+  }
+}
+
 
 static void normalize_gabor_jet(bob::python::ndarray gabor_jet){
   if (gabor_jet.type().nd == 1){
@@ -316,6 +332,13 @@ void bind_ip_gabor_wavelet_transform() {
     &compute_jets_2,
     (boost::python::arg("self"), boost::python::arg("input_image"), boost::python::arg("include_phases")=true, boost::python::arg("normalized")=true),
     "Performs a Gabor wavelet transform and returns the image of Gabor jets, with or without Gabor phases. If the normalized parameter is set to True (the default), the absolute parts of the Gabor jets are normalized to unit Euclidean length."
+  )
+
+  .def(
+    "compute_jets_at",
+    &compute_jets_at,
+    (boost::python::arg("self"), boost::python::arg("input_image"), boost::python::arg("positions"), boost::python::arg("include_phases")=true, boost::python::arg("normalized")=true),
+    "Computes and returns the Gabor jets (with or without Gabor phases) at the given positions only, which are given as one (y,x) pair per row (e.g., the nodes of a bob.machine.GaborGraphMachine). The jets are obtained by a direct convolution with the Gabor wavelets in spatial domain, which is faster than computing the whole jet image when only a few jets are required. If the normalized parameter is set to True (the default), the absolute parts of the Gabor jets are normalized to unit Euclidean length."
   );
 
   boost::python::def(
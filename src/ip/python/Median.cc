@@ -32,6 +32,7 @@ static const char* medianfilter_doc = "Objects of this class, after configuratio
 #define MEDIAN_CLASS(T,N) \
   class_<bob::ip::Median<T> , boost::shared_ptr<bob::ip::Median<T> > >(N, medianfilter_doc, init<const int, const int>((arg("self"), arg("radius_y"), arg("radius_x")), "Constructs a median filter object.")) \
     .def("reset", (void (bob::ip::Median<T>::*)(const int, const int))&bob::ip::Median<T>::reset, (arg("self"), arg("radius_y"), arg("radius_x")), "Updates the kernel dimensions.") \
+    .add_property("n_threads", &bob::ip::Median<T>::getNThreads, &bob::ip::Median<T>::setNThreads, "The maximum number of threads filtering strips of rows of an image (0 means all the threads of the process-wide pool, see :py:func:`bob.core.set_n_threads`)") \
     .def("__call__", (void (bob::ip::Median<T>::*)(const blitz::Array<T,2>&, blitz::Array<T,2>&))&bob::ip::Median<T>::operator(), (arg("self"), arg("input"), arg("output")), "Call an object of this type to filter an image with a median filter.") \
     .def("__call__", (void (bob::ip::Median<T>::*)(const blitz::Array<T,3>&, blitz::Array<T,3>&))&bob::ip::Median<T>::operator(), (arg("self"), arg("input"), arg("output")), "Call an object of this type to filter an image with a median filter.") \
   ;
@@ -26,8 +26,14 @@
 
 namespace bob { namespace machine {
 
+  void Activation::f_inplace (double* z, size_t n) const {
+    for (size_t i=0; i<n; ++i) z[i] = f(z[i]);
+  }
+
   double IdentityActivation::f (double z) const { return z; }
 
+  void IdentityActivation::f_inplace (double*, size_t) const { }
+
   double IdentityActivation::f_prime (double) const { return 1.; }
   
   double IdentityActivation::f_prime_from_f (double) const { return 1.; }
@@ -53,6 +59,11 @@ namespace bob { namespace machine {
 
   double LinearActivation::f (double z) const { return m_C * z; }
 
+  void LinearActivation::f_inplace (double* z, size_t n) const {
+    const double C = m_C;
+    for (size_t i=0; i<n; ++i) z[i] *= C;
+  }
+
   double LinearActivation::f_prime (double z) const { return m_C; }
   
   double LinearActivation::f_prime_from_f (double a) const { return m_C; }
@@ -80,6 +91,10 @@ namespace bob { namespace machine {
 
   double HyperbolicTangentActivation::f (double z) const { return std::tanh(z); }
 
+  void HyperbolicTangentActivation::f_inplace (double* z, size_t n) const {
+    for (size_t i=0; i<n; ++i) z[i] = std::tanh(z[i]);
+  }
+
   double HyperbolicTangentActivation::f_prime (double z) const { return f_prime_from_f(f(z)); }
 
   double HyperbolicTangentActivation::f_prime_from_f (double a) const { return (1. - (a*a)); }
@@ -105,6 +120,12 @@ namespace bob { namespace machine {
 
   double MultipliedHyperbolicTangentActivation::f (double z) const { return m_C * std::tanh(m_M * z); }
 
+  void MultipliedHyperbolicTangentActivation::f_inplace (double* z, size_t n) const {
+    const double C = m_C;
+    const double M = m_M;
+    for (size_t i=0; i<n; ++i) z[i] = C * std::tanh(M * z[i]);
+  }
+
   double MultipliedHyperbolicTangentActivation::f_prime (double z) const
   { return f_prime_from_f(f(z)); }
 
@@ -139,6 +160,10 @@ namespace bob { namespace machine {
   double LogisticActivation::f (double z) const 
   { return 1. / ( 1. + std::exp(-z) ); }
 
+  void LogisticActivation::f_inplace (double* z, size_t n) const {
+    for (size_t i=0; i<n; ++i) z[i] = 1. / ( 1. + std::exp(-z[i]) );
+  }
+
   double LogisticActivation::f_prime (double z) const { return f_prime_from_f(f(z)); }
 
   double LogisticActivation::f_prime_from_f (double a) const { return a * (1. - a); }
@@ -22,6 +22,34 @@
 #include <bob/machine/GMMMachine.h>
 #include <bob/core/assert.h>
 #include <bob/math/log.h>
+#include <bob/core/parallel.h>
+#include <boost/bind.hpp>
+#include <algorithm>
+#include <vector>
+#include <cmath>
+
+bob::machine::GMMMachineWorkspace::GMMMachineWorkspace()
+{
+}
+
+bob::machine::GMMMachineWorkspace::GMMMachineWorkspace(const size_t n_gaussians,
+    const size_t n_inputs)
+{
+  resize(n_gaussians, n_inputs);
+}
+
+void bob::machine::GMMMachineWorkspace::resize(const size_t n_gaussians,
+  const size_t n_inputs)
+{
+  if (log_weighted_gaussian_likelihoods.extent(0) != (int)n_gaussians)
+  {
+    log_weighted_gaussian_likelihoods.resize(n_gaussians);
+    P.resize(n_gaussians);
+  }
+  if (Px.extent(0) != (int)n_gaussians || Px.extent(1) != (int)n_inputs)
+    Px.resize(n_gaussians, n_inputs);
+}
+
 
 bob::machine::GMMMachine::GMMMachine(): m_gaussians(0) {
   resize(0,0);
@@ -269,6 +297,21 @@ double bob::machine::GMMMachine::logLikelihood_(const blitz::Array<double, 1> &x
   return logLikelihood_(x,m_cache_log_weighted_gaussian_likelihoods);
 }
 
+double bob::machine::GMMMachine::logLikelihood(const blitz::Array<double, 1> &x,
+  bob::machine::GMMMachineWorkspace& ws) const
+{
+  // Check dimension
+  bob::core::array::assertSameDimensionLength(x.extent(0), m_n_inputs);
+  ws.resize(m_n_gaussians, m_n_inputs);
+  return logLikelihood_(x, ws.log_weighted_gaussian_likelihoods);
+}
+
+double bob::machine::GMMMachine::logLikelihood_(const blitz::Array<double, 1> &x,
+  bob::machine::GMMMachineWorkspace& ws) const
+{
+  return logLikelihood_(x, ws.log_weighted_gaussian_likelihoods);
+}
+
 void bob::machine::GMMMachine::forward(const blitz::Array<double,1>& input, double& output) const {
   if(static_cast<size_t>(input.extent(0)) != m_n_inputs) {
     boost::format m("expected input size (%u) does not match the size of input array (%d)");
@@ -284,27 +327,166 @@ void bob::machine::GMMMachine::forward_(const blitz::Array<double,1>& input,
   output = logLikelihood(input);
 }
 
+namespace {
+
+  /**
+   * Number of samples of the blocks distributed to the threads by the
+   * batched E-step
+   */
+  const int GMM_BLOCK_SIZE = 256;
+
+  /**
+   * Parameters of the Gaussian components in the layout used by the
+   * batched E-step. The means and variances are stored as n_inputs x
+   * n_gaussians matrices, so that the inner loops run over all the
+   * Gaussian components at once on contiguous memory.
+   */
+  struct GMMBlockParameters {
+    int n_gaussians;
+    int n_inputs;
+    const double* means;
+    const double* variances;
+    const double* log_weights;
+    const double* g_norms;
+  };
+
+  /**
+   * Accumulates the GMM statistics of n_samples samples, given as a raw
+   * pointer with strides. The operations on each sample are performed in
+   * the same order as by the sample-wise accStatistics().
+   */
+  void accStatisticsBlock(const double* input, const std::ptrdiff_t s0,
+    const std::ptrdiff_t s1, const int n_samples,
+    const GMMBlockParameters* params, bob::machine::GMMStats* stats)
+  {
+    const int n_gaussians = params->n_gaussians;
+    const int n_inputs = params->n_inputs;
+    std::vector<double> l(n_gaussians);
+    std::vector<double> x(n_inputs);
+
+    double* n = stats->n.data();
+    const std::ptrdiff_t sn = stats->n.stride(0);
+    double* sumPx = stats->sumPx.data();
+    const std::ptrdiff_t spx0 = stats->sumPx.stride(0);
+    const std::ptrdiff_t spx1 = stats->sumPx.stride(1);
+    double* sumPxx = stats->sumPxx.data();
+    const std::ptrdiff_t spxx0 = stats->sumPxx.stride(0);
+    const std::ptrdiff_t spxx1 = stats->sumPxx.stride(1);
+
+    for (int s=0; s<n_samples; ++s) {
+      const double* x_in = input + s*s0;
+      for (int d=0; d<n_inputs; ++d) x[d] = x_in[d*s1];
+
+      // z_i = sum_d (x_d-mean_id)^2/variance_id for all the components
+      for (int i=0; i<n_gaussians; ++i) l[i] = 0.;
+      for (int d=0; d<n_inputs; ++d) {
+        const double xd = x[d];
+        const double* m = params->means + d*n_gaussians;
+        const double* v = params->variances + d*n_gaussians;
+        for (int i=0; i<n_gaussians; ++i) {
+          const double diff = xd - m[i];
+          l[i] += diff * diff / v[i];
+        }
+      }
+
+      // l_i = log(weight_i*p(x|gaussian_i)), and log(p(x|GMM))
+      double log_likelihood = bob::math::Log::LogZero;
+      for (int i=0; i<n_gaussians; ++i) {
+        l[i] = params->log_weights[i] + (-0.5 * (params->g_norms[i] + l[i]));
+        log_likelihood = bob::math::Log::logAdd(log_likelihood, l[i]);
+      }
+
+      // Accumulates the statistics using the responsibilities
+      stats->log_likelihood += log_likelihood;
+      stats->T++;
+      for (int i=0; i<n_gaussians; ++i) {
+        const double P = std::exp(l[i] - log_likelihood);
+        n[i*sn] += P;
+        double* px = sumPx + i*spx0;
+        double* pxx = sumPxx + i*spxx0;
+        for (int d=0; d<n_inputs; ++d) {
+          const double Px = P * x[d];
+          px[d*spx1] += Px;
+          pxx[d*spxx1] += Px * x[d];
+        }
+      }
+    }
+  }
+
+  /**
+   * Accumulates the GMM statistics of the blocks of GMM_BLOCK_SIZE samples
+   * [begin, end) into the statistics of the calling thread (parallel body)
+   */
+  void accStatisticsBlocks(const double* input, const std::ptrdiff_t s0,
+    const std::ptrdiff_t s1, const int n_samples,
+    const GMMBlockParameters& params,
+    const std::vector<bob::machine::GMMStats*>& stats,
+    size_t begin, size_t end, size_t thread)
+  {
+    const int start = (int)begin * GMM_BLOCK_SIZE;
+    const int stop = std::min(n_samples, (int)end * GMM_BLOCK_SIZE);
+    accStatisticsBlock(input + start*s0, s0, s1, stop-start, &params,
+      stats[thread]);
+  }
+
+}
+
 void bob::machine::GMMMachine::accStatistics(const blitz::Array<double,2>& input,
     bob::machine::GMMStats& stats) const {
-  // iterate over data
-  blitz::Range a = blitz::Range::all();
-  for(int i=0; i<input.extent(0); ++i) {
-    // Get example
-    blitz::Array<double,1> x(input(i,a));
-    // Accumulate statistics
-    accStatistics(x,stats);
-  }
+  // check GMMStats size
+  bob::core::array::assertSameDimensionLength(stats.sumPx.extent(0), m_n_gaussians);
+  bob::core::array::assertSameDimensionLength(stats.sumPx.extent(1), m_n_inputs);
+  // check input size
+  bob::core::array::assertSameDimensionLength(input.extent(1), m_n_inputs);
+
+  accStatistics_(input, stats);
 }
 
-void bob::machine::GMMMachine::accStatistics_(const blitz::Array<double,2>& input, bob::machine::GMMStats& stats) const {
-  // iterate over data
+void bob::machine::GMMMachine::accStatistics_(const blitz::Array<double,2>& input,
+    bob::machine::GMMStats& stats) const {
+  const int n_samples = input.extent(0);
+  if (n_samples == 0) return;
+
+  // Gathers the parameters of the Gaussian components as n_inputs x
+  // n_gaussians matrices
+  blitz::Array<double,2> means(m_n_inputs, m_n_gaussians);
+  blitz::Array<double,2> variances(m_n_inputs, m_n_gaussians);
+  blitz::Array<double,1> g_norms(m_n_gaussians);
   blitz::Range a = blitz::Range::all();
-  for(int i=0; i<input.extent(0); ++i) {
-    // Get example
-    blitz::Array<double,1> x(input(i, a));
-    // Accumulate statistics
-    accStatistics_(x,stats);
+  for (size_t i=0; i<m_n_gaussians; ++i) {
+    means(a,(int)i) = m_gaussians[i]->getMean();
+    variances(a,(int)i) = m_gaussians[i]->getVariance();
+    g_norms((int)i) = m_gaussians[i]->getGNorm();
+  }
+  blitz::Array<double,1> log_weights(m_cache_log_weights.copy());
+
+  GMMBlockParameters params;
+  params.n_gaussians = m_n_gaussians;
+  params.n_inputs = m_n_inputs;
+  params.means = means.data();
+  params.variances = variances.data();
+  params.log_weights = log_weights.data();
+  params.g_norms = g_norms.data();
+
+  // The first thread accumulates into stats, the other ones into their own
+  // statistics
+  const int n_blocks = (n_samples + GMM_BLOCK_SIZE - 1) / GMM_BLOCK_SIZE;
+  const size_t n_threads = std::min(bob::core::getNThreads(), (size_t)n_blocks);
+  std::vector<boost::shared_ptr<bob::machine::GMMStats> > partial_stats;
+  std::vector<bob::machine::GMMStats*> thread_stats(1, &stats);
+  for (size_t t=1; t<n_threads; ++t) {
+    partial_stats.push_back(boost::shared_ptr<bob::machine::GMMStats>(
+      new bob::machine::GMMStats(m_n_gaussians, m_n_inputs)));
+    thread_stats.push_back(partial_stats.back().get());
   }
+
+  bob::core::parallelFor(0, n_blocks, boost::bind(&accStatisticsBlocks,
+      input.data(), input.stride(0), input.stride(1), n_samples,
+      boost::cref(params), boost::cref(thread_stats), _1, _2, _3),
+    1, n_threads);
+
+  // Reduces the statistics of the threads, in a fixed order
+  for (size_t t=0; t<partial_stats.size(); ++t) stats += *partial_stats[t];
 }
 
 void bob::machine::GMMMachine::accStatistics(const blitz::Array<double, 1>& x, bob::machine::GMMStats& stats) const {
@@ -317,7 +499,8 @@ void bob::machine::GMMMachine::accStatistics(const blitz::Array<double, 1>& x, b
   // - log_likelihood = log(sum_i(weight_i*p(x|gaussian_i)))
   double log_likelihood = logLikelihood(x, m_cache_log_weighted_gaussian_likelihoods);
 
-  accStatisticsInternal(x, stats, log_likelihood);
+  accStatisticsInternal(x, stats, log_likelihood,
+    m_cache_log_weighted_gaussian_likelihoods, m_cache_P, m_cache_Px);
 }
 
 void bob::machine::GMMMachine::accStatistics_(const blitz::Array<double, 1>& x, bob::machine::GMMStats& stats) const {
@@ -326,14 +509,40 @@ void bob::machine::GMMMachine::accStatistics_(const blitz::Array<double, 1>& x,
   // - log_likelihood = log(sum_i(weight_i*p(x|gaussian_i)))
   double log_likelihood = logLikelihood_(x, m_cache_log_weighted_gaussian_likelihoods);
 
-  accStatisticsInternal(x, stats, log_likelihood);
+  accStatisticsInternal(x, stats, log_likelihood,
+    m_cache_log_weighted_gaussian_likelihoods, m_cache_P, m_cache_Px);
+}
+
+void bob::machine::GMMMachine::accStatistics(const blitz::Array<double, 1>& x,
+  bob::machine::GMMStats& stats, bob::machine::GMMMachineWorkspace& ws) const
+{
+  // check GMMStats size
+  bob::core::array::assertSameDimensionLength(stats.sumPx.extent(0), m_n_gaussians);
+  bob::core::array::assertSameDimensionLength(stats.sumPx.extent(1), m_n_inputs);
+
+  ws.resize(m_n_gaussians, m_n_inputs);
+  double log_likelihood = logLikelihood(x, ws.log_weighted_gaussian_likelihoods);
+
+  accStatisticsInternal(x, stats, log_likelihood,
+    ws.log_weighted_gaussian_likelihoods, ws.P, ws.Px);
+}
+
+void bob::machine::GMMMachine::accStatistics_(const blitz::Array<double, 1>& x,
+  bob::machine::GMMStats& stats, bob::machine::GMMMachineWorkspace& ws) const
+{
+  double log_likelihood = logLikelihood_(x, ws.log_weighted_gaussian_likelihoods);
+
+  accStatisticsInternal(x, stats, log_likelihood,
+    ws.log_weighted_gaussian_likelihoods, ws.P, ws.Px);
 }
 
 void bob::machine::GMMMachine::accStatisticsInternal(const blitz::Array<double, 1>& x,
-  bob::machine::GMMStats& stats, const double log_likelihood) const
+  bob::machine::GMMStats& stats, const double log_likelihood,
+  const blitz::Array<double,1>& log_weighted_gaussian_likelihoods,
+  blitz::Array<double,1>& P, blitz::Array<double,2>& Px) const
 {
   // Calculate responsibilities
-  m_cache_P = blitz::exp(m_cache_log_weighted_gaussian_likelihoods - log_likelihood);
+  P = blitz::exp(log_weighted_gaussian_likelihoods - log_likelihood);
 
   // Accumulate statistics
   // - total likelihood
@@ -343,18 +552,18 @@ void bob::machine::GMMMachine::accStatisticsInternal(const blitz::Array<double,
   stats.T++;
 
   // - responsibilities
-  stats.n += m_cache_P;
+  stats.n += P;
 
   // - first order stats
   blitz::firstIndex i;
   blitz::secondIndex j;
 
-  m_cache_Px = m_cache_P(i) * x(j);
+  Px = P(i) * x(j);
 
-  stats.sumPx += m_cache_Px;
+  stats.sumPx += Px;
 
   // - second order stats
-  stats.sumPxx += (m_cache_Px(i,j) * x(j));
+  stats.sumPxx += (Px(i,j) * x(j));
 }
 
 boost::shared_ptr<const bob::machine::Gaussian> bob::machine::GMMMachine::getGaussian(const size_t i) const {
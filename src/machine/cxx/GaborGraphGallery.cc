@@ -0,0 +1,264 @@
+/**
+ * @file machine/cxx/GaborGraphGallery.cc
+ * @date Sat Oct 17 21:02:18 CEST 2026
+ * @author Laurent El Shafey <Laurent.El-Shafey@idiap.ch>
+ *
+ * @brief Implements the comparison of a probe Gabor graph to a gallery of
+ * Gabor graphs.
+ *
+ * Copyright (C) 2011-2013 Idiap Research Institute, Martigny, Switzerland
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "bob/machine/GaborGraphGallery.h"
+#include "bob/core/assert.h"
+#include "bob/core/parallel.h"
+#include "bob/math/linear.h"
+
+#include <boost/bind.hpp>
+#include <boost/format.hpp>
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <stdexcept>
+
+//! Number of gallery graphs scored at once by a thread, for the similarities based on absolute values
+static const size_t GABOR_GALLERY_BLOCK = 256;
+
+bob::machine::GaborGraphGallery::GaborGraphGallery(
+  bob::machine::GaborJetSimilarity::SimilarityType type,
+  const bob::ip::GaborWaveletTransform& gwt
+)
+:
+  m_similarity(type, gwt),
+  m_with_phases(type != GaborJetSimilarity::SCALAR_PRODUCT && type != GaborJetSimilarity::CANBERRA),
+  m_n_graphs(0),
+  m_n_nodes(0),
+  m_n_kernels(m_with_phases ? gwt.numberOfKernels() : 0),
+  m_graph_size(0)
+{
+}
+
+void bob::machine::GaborGraphGallery::reserve(int n_graphs){
+  // the size of the graphs is only known once the first one is added
+  if (m_graph_size) m_jets.reserve((size_t)n_graphs * m_graph_size);
+}
+
+void bob::machine::GaborGraphGallery::clear(){
+  m_jets.clear();
+  m_n_graphs = 0;
+  m_n_nodes = 0;
+  if (!m_with_phases) m_n_kernels = 0;
+  m_graph_size = 0;
+}
+
+// normalizes the absolute values of the given jets to unit length, leaving empty jets untouched
+static void normalize(std::vector<double>& jets, int n_nodes, int n_kernels){
+  for (int n = 0; n < n_nodes; ++n){
+    double* jet = &jets[(size_t)n * n_kernels];
+    double norm = std::sqrt(std::inner_product(jet, jet + n_kernels, jet, 0.));
+    if (norm > 0.){
+      for (int j = 0; j < n_kernels; ++j) jet[j] /= norm;
+    }
+  }
+}
+
+void bob::machine::GaborGraphGallery::convert(const blitz::Array<double,2>& graph_jets, std::vector<double>& jets) const{
+  if (m_with_phases)
+    throw std::runtime_error("GaborGraphGallery: disparity similarity (and its derivatives) need Gabor graphs including phases");
+  const int n_nodes = graph_jets.extent(0), n_kernels = graph_jets.extent(1);
+  if (m_n_graphs && (n_nodes != m_n_nodes || n_kernels != m_n_kernels)){
+    boost::format m("GaborGraphGallery: the graph has %d nodes of %d kernels, whereas the graphs of the gallery have %d nodes of %d kernels");
+    m % n_nodes % n_kernels % m_n_nodes % m_n_kernels;
+    throw std::runtime_error(m.str());
+  }
+
+  jets.resize((size_t)n_nodes * n_kernels);
+  for (int n = 0; n < n_nodes; ++n)
+    for (int j = 0; j < n_kernels; ++j)
+      jets[(size_t)n * n_kernels + j] = graph_jets(n,j);
+  if (m_similarity.type() == GaborJetSimilarity::SCALAR_PRODUCT)
+    normalize(jets, n_nodes, n_kernels);
+}
+
+void bob::machine::GaborGraphGallery::convert(const blitz::Array<double,3>& graph_jets, std::vector<double>& jets) const{
+  const int n_nodes = graph_jets.extent(0), n_kernels = graph_jets.extent(2);
+  if (graph_jets.extent(1) != 2)
+    throw std::runtime_error("GaborGraphGallery: the Gabor graph should contain absolute values and phases");
+  if ((m_n_graphs || m_with_phases) && n_kernels != m_n_kernels){
+    boost::format m("GaborGraphGallery: the graph has jets of %d kernels, whereas %d are expected");
+    m % n_kernels % m_n_kernels;
+    throw std::runtime_error(m.str());
+  }
+  if (m_n_graphs && n_nodes != m_n_nodes){
+    boost::format m("GaborGraphGallery: the graph has %d nodes, whereas the graphs of the gallery have %d nodes");
+    m % n_nodes % m_n_nodes;
+    throw std::runtime_error(m.str());
+  }
+
+  if (!m_with_phases){
+    // keep the absolute values only
+    jets.resize((size_t)n_nodes * n_kernels);
+    for (int n = 0; n < n_nodes; ++n)
+      for (int j = 0; j < n_kernels; ++j)
+        jets[(size_t)n * n_kernels + j] = graph_jets(n,0,j);
+    if (m_similarity.type() == GaborJetSimilarity::SCALAR_PRODUCT)
+      normalize(jets, n_nodes, n_kernels);
+  } else {
+    // absolute values and phases of each node are stored one after the other
+    jets.resize((size_t)n_nodes * 2 * n_kernels);
+    for (int n = 0; n < n_nodes; ++n)
+      for (int i = 0; i < 2; ++i)
+        for (int j = 0; j < n_kernels; ++j)
+          jets[((size_t)n * 2 + i) * n_kernels + j] = graph_jets(n,i,j);
+  }
+}
+
+void bob::machine::GaborGraphGallery::append(const std::vector<double>& jets, int n_nodes, int n_kernels){
+  if (!m_n_graphs){
+    m_n_nodes = n_nodes;
+    m_n_kernels = n_kernels;
+    m_graph_size = jets.size();
+  }
+  m_jets.insert(m_jets.end(), jets.begin(), jets.end());
+  ++m_n_graphs;
+}
+
+void bob::machine::GaborGraphGallery::add(const blitz::Array<double,2>& graph_jets){
+  std::vector<double> jets;
+  convert(graph_jets, jets);
+  append(jets, graph_jets.extent(0), graph_jets.extent(1));
+}
+
+void bob::machine::GaborGraphGallery::add(const blitz::Array<double,3>& graph_jets){
+  std::vector<double> jets;
+  convert(graph_jets, jets);
+  append(jets, graph_jets.extent(0), graph_jets.extent(2));
+}
+
+
+void bob::machine::GaborGraphGallery::scoreScalarProducts(const std::vector<double>& probe, double* scores, size_t begin, size_t end, size_t) const{
+  // the average of the scalar products of the normalized jets is one matrix-vector product
+  const int n_graphs = end - begin;
+  blitz::Array<double,2> gallery(const_cast<double*>(&m_jets[begin * m_graph_size]), blitz::shape(n_graphs, m_graph_size), blitz::neverDeleteData);
+  blitz::Array<double,1> probe_jets(const_cast<double*>(&probe[0]), blitz::shape(m_graph_size), blitz::neverDeleteData);
+  blitz::Array<double,1> block_scores(scores + begin, blitz::shape(n_graphs), blitz::neverDeleteData);
+  bob::math::prod_(gallery, probe_jets, block_scores);
+  block_scores /= m_n_nodes;
+}
+
+void bob::machine::GaborGraphGallery::scoreCanberra(const std::vector<double>& probe, double* scores, size_t begin, size_t end, size_t) const{
+  const double* p = &probe[0];
+  for (size_t m = begin; m < end; ++m){
+    const double* g = &m_jets[m * m_graph_size];
+    // average Canberra similarity over all nodes and kernels
+    double distance = 0.;
+    for (int i = 0; i < m_graph_size; ++i)
+      distance += std::abs(g[i] - p[i]) / (g[i] + p[i]);
+    scores[m] = 1. - distance / m_graph_size;
+  }
+}
+
+void bob::machine::GaborGraphGallery::scoreDisparities(const std::vector<double>& probe, std::vector<GaborJetSimilarityWorkspace>& workspaces, double* scores, size_t begin, size_t end, size_t thread) const{
+  GaborJetSimilarityWorkspace& workspace = workspaces[thread];
+  const int jet_size = 2 * m_n_kernels;
+  for (size_t m = begin; m < end; ++m){
+    const double* g = &m_jets[m * m_graph_size];
+    double similarity = 0.;
+    for (int n = 0; n < m_n_nodes; ++n){
+      const blitz::Array<double,2> model_jet(const_cast<double*>(g + n * jet_size), blitz::shape(2, m_n_kernels), blitz::neverDeleteData);
+      const blitz::Array<double,2> probe_jet(const_cast<double*>(&probe[n * jet_size]), blitz::shape(2, m_n_kernels), blitz::neverDeleteData);
+      similarity += m_similarity(model_jet, probe_jet, workspace);
+    }
+    scores[m] = similarity / m_n_nodes;
+  }
+}
+
+void bob::machine::GaborGraphGallery::score(const std::vector<double>& probe, blitz::Array<double,1>& scores) const{
+  double* output = scores.data();
+  switch (m_similarity.type()){
+    case GaborJetSimilarity::SCALAR_PRODUCT:
+      bob::core::parallelFor(0, m_n_graphs,
+        boost::bind(&GaborGraphGallery::scoreScalarProducts, this, boost::cref(probe), output, _1, _2, _3),
+        GABOR_GALLERY_BLOCK);
+      break;
+    case GaborJetSimilarity::CANBERRA:
+      bob::core::parallelFor(0, m_n_graphs,
+        boost::bind(&GaborGraphGallery::scoreCanberra, this, boost::cref(probe), output, _1, _2, _3),
+        GABOR_GALLERY_BLOCK);
+      break;
+    default:{
+      // one workspace per thread
+      std::vector<GaborJetSimilarityWorkspace> workspaces(bob::core::getNThreads());
+      bob::core::parallelFor(0, m_n_graphs,
+        boost::bind(&GaborGraphGallery::scoreDisparities, this, boost::cref(probe), boost::ref(workspaces), output, _1, _2, _3));
+    }
+  }
+}
+
+void bob::machine::GaborGraphGallery::similarity(const blitz::Array<double,2>& probe_graph_jets, blitz::Array<double,1>& scores) const{
+  bob::core::array::assertCZeroBaseContiguous(scores);
+  bob::core::array::assertSameDimensionLength(scores.extent(0), m_n_graphs);
+  if (!m_n_graphs) return;
+  std::vector<double> probe;
+  convert(probe_graph_jets, probe);
+  score(probe, scores);
+}
+
+void bob::machine::GaborGraphGallery::similarity(const blitz::Array<double,3>& probe_graph_jets, blitz::Array<double,1>& scores) const{
+  bob::core::array::assertCZeroBaseContiguous(scores);
+  bob::core::array::assertSameDimensionLength(scores.extent(0), m_n_graphs);
+  if (!m_n_graphs) return;
+  std::vector<double> probe;
+  convert(probe_graph_jets, probe);
+  score(probe, scores);
+}
+
+
+// orders the gallery indices by decreasing score, and by increasing index for identical scores
+struct GreaterScore{
+  GreaterScore(const blitz::Array<double,1>& scores) : m_scores(scores) {}
+  bool operator()(int a, int b) const {
+    return m_scores(a) > m_scores(b) || (m_scores(a) == m_scores(b) && a < b);
+  }
+  const blitz::Array<double,1>& m_scores;
+};
+
+void bob::machine::GaborGraphGallery::select(const blitz::Array<double,1>& all_scores, int k, blitz::Array<int,1>& indices, blitz::Array<double,1>& scores) const{
+  if (k < 0)
+    throw std::runtime_error("GaborGraphGallery: the number of most similar graphs should be positive");
+  k = std::min(k, m_n_graphs);
+  std::vector<int> order(m_n_graphs);
+  for (int m = 0; m < m_n_graphs; ++m) order[m] = m;
+  std::partial_sort(order.begin(), order.begin() + k, order.end(), GreaterScore(all_scores));
+
+  indices.resize(k);
+  scores.resize(k);
+  for (int i = 0; i < k; ++i){
+    indices(i) = order[i];
+    scores(i) = all_scores(order[i]);
+  }
+}
+
+void bob::machine::GaborGraphGallery::topK(const blitz::Array<double,2>& probe_graph_jets, int k, blitz::Array<int,1>& indices, blitz::Array<double,1>& scores) const{
+  blitz::Array<double,1> all_scores(m_n_graphs);
+  similarity(probe_graph_jets, all_scores);
+  select(all_scores, k, indices, scores);
+}
+
+void bob::machine::GaborGraphGallery::topK(const blitz::Array<double,3>& probe_graph_jets, int k, blitz::Array<int,1>& indices, blitz::Array<double,1>& scores) const{
+  blitz::Array<double,1> all_scores(m_n_graphs);
+  similarity(probe_graph_jets, all_scores);
+  select(all_scores, k, indices, scores);
+}
@@ -36,11 +36,11 @@ bob::machine::GaborJetSimilarity::GaborJetSimilarity(bob::machine::GaborJetSimil
 static double sqr(double x){return x*x;}
 
 void bob::machine::GaborJetSimilarity::init(){
-  m_disparity = 0.;
-  m_confidences.resize(m_gwt.numberOfKernels());
-  std::fill(m_confidences.begin(), m_confidences.end(), 0.);
-  m_phase_differences.resize(m_gwt.numberOfKernels());
-  std::fill(m_phase_differences.begin(), m_phase_differences.end(), 0.);
+  m_workspace.disparity = 0.;
+  m_workspace.confidences.resize(m_gwt.numberOfKernels());
+  std::fill(m_workspace.confidences.begin(), m_workspace.confidences.end(), 0.);
+  m_workspace.phase_differences.resize(m_gwt.numberOfKernels());
+  std::fill(m_workspace.phase_differences.begin(), m_workspace.phase_differences.end(), 0.);
 
   // used for disparity-like similarity functions only...
   m_wavelet_extends.reserve(m_gwt.numberOfScales());
@@ -77,6 +77,11 @@ double bob::machine::GaborJetSimilarity::operator()(const blitz::Array<double,1>
 
 
 double bob::machine::GaborJetSimilarity::operator()(const blitz::Array<double,2>& jet1, const blitz::Array<double,2>& jet2) const{
+  return operator()(jet1, jet2, m_workspace);
+}
+
+
+double bob::machine::GaborJetSimilarity::operator()(const blitz::Array<double,2>& jet1, const blitz::Array<double,2>& jet2, GaborJetSimilarityWorkspace& workspace) const{
   if (m_type == SCALAR_PRODUCT || m_type == CANBERRA){
     // call the function without phases
     return operator()(jet1(0,blitz::Range::all()), jet2(0,blitz::Range::all()));
@@ -88,19 +93,22 @@ double bob::machine::GaborJetSimilarity::operator()(const blitz::Array<double,2>
   bob::core::array::assertSameShape(jet1,jet2);
 
   // compute confidence vectors
-  compute_confidences(jet1, jet2);
+  compute_confidences(jet1, jet2, workspace);
 
   // now, compute the disparity
-  compute_disparity();
+  compute_disparity(workspace);
 
   const std::vector<blitz::TinyVector<double,2> >& kernels = m_gwt.kernelFrequencies();
+  const std::vector<double>& confidences = workspace.confidences;
+  const std::vector<double>& phase_differences = workspace.phase_differences;
+  const blitz::TinyVector<double,2>& disparity = workspace.disparity;
 
   switch (m_type){
     case DISPARITY:{
       // compute the similarity using the estimated disparity
       double sum = 0.;
-      for (int j = m_confidences.size(); j--;){
-        sum += m_confidences[j] * cos(m_phase_differences[j] - m_disparity[0] * kernels[j][0] - m_disparity[1] * kernels[j][1]);
+      for (int j = confidences.size(); j--;){
+        sum += confidences[j] * cos(phase_differences[j] - disparity[0] * kernels[j][0] - disparity[1] * kernels[j][1]);
       }
       return sum;
     } // DISPARITY
@@ -108,8 +116,8 @@ double bob::machine::GaborJetSimilarity::operator()(const blitz::Array<double,2>
     case PHASE_DIFF:{
       // compute the similarity using the estimated disparity
       double sum = 0.;
-      for (int j = m_phase_differences.size(); j--;){
-        sum += cos(m_phase_differences[j] - m_disparity[0] * kernels[j][0] - m_disparity[1] * kernels[j][1]);
+      for (int j = phase_differences.size(); j--;){
+        sum += cos(phase_differences[j] - disparity[0] * kernels[j][0] - disparity[1] * kernels[j][1]);
       }
       return sum / jet1.shape()[1];
     } // PHASE_DIFF
@@ -117,9 +125,9 @@ double bob::machine::GaborJetSimilarity::operator()(const blitz::Array<double,2>
     case PHASE_DIFF_PLUS_CANBERRA:{
       // compute the similarity using the estimated disparity
       double sum = 0.;
-      for (int j = m_phase_differences.size(); j--;){
+      for (int j = phase_differences.size(); j--;){
         // add disparity term
-        sum += cos(m_phase_differences[j] - m_disparity[0] * kernels[j][0] - m_disparity[1] * kernels[j][1]);
+        sum += cos(phase_differences[j] - disparity[0] * kernels[j][0] - disparity[1] * kernels[j][1]);
         // add Canberra term
         sum += 1. - std::abs(jet1(0,j) - jet2(0,j)) / (jet1(0,j) + jet2(0,j));
       }
@@ -140,29 +148,36 @@ static double adjustPhase(double phase){
   return phase - (2.*M_PI)*round(phase / (2.*M_PI));
 }
 
-void bob::machine::GaborJetSimilarity::compute_confidences(const blitz::Array<double,2>& jet1, const blitz::Array<double,2>& jet2) const{
+void bob::machine::GaborJetSimilarity::compute_confidences(const blitz::Array<double,2>& jet1, const blitz::Array<double,2>& jet2, GaborJetSimilarityWorkspace& workspace) const{
+  std::vector<double>& confidences = workspace.confidences;
+  std::vector<double>& phase_differences = workspace.phase_differences;
+  confidences.resize(m_gwt.numberOfKernels());
+  phase_differences.resize(m_gwt.numberOfKernels());
   // first, fill confidence and phase difference vectors
-  for (int j = m_confidences.size(); j--;){
-    m_confidences[j] = jet1(0,j) * jet2(0,j);
-    m_phase_differences[j] = adjustPhase(jet1(1,j) - jet2(1,j));
+  for (int j = confidences.size(); j--;){
+    confidences[j] = jet1(0,j) * jet2(0,j);
+    phase_differences[j] = adjustPhase(jet1(1,j) - jet2(1,j));
   }
 }
 
-void bob::machine::GaborJetSimilarity::compute_disparity() const{
+void bob::machine::GaborJetSimilarity::compute_disparity(GaborJetSimilarityWorkspace& workspace) const{
+  const std::vector<double>& confidences = workspace.confidences;
+  const std::vector<double>& phase_differences = workspace.phase_differences;
+  blitz::TinyVector<double,2>& disparity = workspace.disparity;
   // approximate the disparity from the phase differences
   double gamma_x_x = 0., gamma_x_y = 0., gamma_y_y = 0., phi_x = 0., phi_y = 0.;
   // initialize the disparity with 0
-  m_disparity = 0.;
+  disparity = 0.;
 
   const std::vector<blitz::TinyVector<double,2> >& kernels = m_gwt.kernelFrequencies();
   // iterate backwards through the vector to start with the lowest frequency wavelets
-  for (int j = m_confidences.size()-1, level = m_gwt.numberOfScales()-1; level >= 0; --level){
+  for (int j = confidences.size()-1, level = m_gwt.numberOfScales()-1; level >= 0; --level){
     for (int direction = m_gwt.numberOfDirections()-1; direction >= 0; --direction, --j){
       double
           kjx = kernels[j][1],
           kjy = kernels[j][0],
-          conf = m_confidences[j],
-          diff = m_phase_differences[j];
+          conf = confidences[j],
+          diff = phase_differences[j];
 
       // totalize gamma matrix
       gamma_x_x += kjx * kjx * conf;
@@ -171,7 +186,7 @@ void bob::machine::GaborJetSimilarity::compute_disparity() const{
 
       // totalize phi vector
       // estimate the number of cycles that we are off
-      double nL = round((diff - m_disparity[1] * kjx - m_disparity[0] * kjy) / (2.*M_PI));
+      double nL = round((diff - disparity[1] * kjx - disparity[0] * kjy) / (2.*M_PI));
       // totalize corrected phi vector elements
       phi_x += (diff - nL * 2. * M_PI) * conf * kjx;
       phi_y += (diff - nL * 2. * M_PI) * conf * kjy;
@@ -179,8 +194,8 @@ void bob::machine::GaborJetSimilarity::compute_disparity() const{
 
     // re-calculate disparity as d=\Gamma^{-1}\Phi of the (low frequency) wavelet scales that we used up to now
     double gamma_det = gamma_x_x * gamma_y_y - sqr(gamma_x_y);
-    m_disparity[1] = (gamma_y_y * phi_x - gamma_x_y * phi_y) / gamma_det;
-    m_disparity[0] = (gamma_x_x * phi_y - gamma_x_y * phi_x) / gamma_det;
+    disparity[1] = (gamma_y_y * phi_x - gamma_x_y * phi_y) / gamma_det;
+    disparity[0] = (gamma_x_x * phi_y - gamma_x_y * phi_x) / gamma_det;
 
   } // for level
 }
@@ -20,11 +20,127 @@
 
 #include <bob/machine/IVectorMachine.h>
 #include <bob/core/array_copy.h>
+#include <bob/core/assert.h>
 #include <bob/core/check.h>
+#include <bob/core/parallel.h>
 #include <bob/math/linear.h>
 #include <bob/math/linsolve.h>
+#include <boost/bind.hpp>
+#include <algorithm>
 
-bob::machine::IVectorMachine::IVectorMachine()
+/**
+ * Maximum number of values of the (packed) precision matrices of a batch
+ * updated while going through the C Gaussians, such that they stay in cache
+ */
+static const size_t IVECTOR_PRECISION_BLOCK = 32768;
+
+/**
+ * Computes \f$(Id + \sum_{c=1}^{C} N_{i,j,c} T^{T} \Sigma_{c}^{-1} T)\f$ for
+ * the n_samples rows of n, given the packed cache (C x rt(rt+1)/2). output is
+ * a C-style contiguous n_samples x rt x rt array. The upper triangles are
+ * updated by blocks of rows, for all the samples and Gaussians, and are then
+ * copied to the lower ones.
+ */
+template <typename T>
+static void accumulatePrecisions(const T* cache, const int C, const int rt,
+  const blitz::Array<double,2>& n, double* output)
+{
+  const int n_samples = n.extent(0);
+  const int K = rt*(rt+1)/2;
+  std::fill(output, output + n_samples*rt*rt, 0.);
+
+  int i0 = 0;
+  int offset0 = 0;
+  while (i0 < rt)
+  {
+    // Rows [i0,i1) of the upper triangles
+    int i1 = i0 + 1;
+    int size = rt - i0;
+    while (i1 < rt && (size_t)((size + rt - i1) * n_samples) <= IVECTOR_PRECISION_BLOCK)
+      size += rt - i1++;
+
+    for (int c=0; c<C; ++c)
+    {
+      const T* cache_c = cache + c*K + offset0;
+      for (int s=0; s<n_samples; ++s)
+      {
+        const double n_sc = n(s,c);
+        if (n_sc == 0.) continue;
+        const T* p = cache_c;
+        for (int i=i0; i<i1; ++i)
+        {
+          double* o = output + (s*rt + i)*rt;
+          for (int j=i; j<rt; ++j, ++p)
+            o[j] += n_sc * *p;
+        }
+      }
+    }
+    offset0 += size;
+    i0 = i1;
+  }
+
+  for (int s=0; s<n_samples; ++s)
+  {
+    double* o = output + s*rt*rt;
+    for (int i=0; i<rt; ++i)
+    {
+      o[i*rt+i] += 1.;
+      for (int j=i+1; j<rt; ++j)
+        o[j*rt+i] = o[i*rt+j];
+    }
+  }
+}
+
+/**
+ * Packs the upper triangle of the symmetric matrix A (row by row)
+ */
+template <typename T>
+static void packUpperTriangle(const blitz::Array<double,2>& A, T* packed)
+{
+  const int rt = A.extent(0);
+  for (int i=0; i<rt; ++i)
+    for (int j=i; j<rt; ++j)
+      *packed++ = static_cast<T>(A(i,j));
+}
+
+bob::machine::IVectorMachineWorkspace::IVectorMachineWorkspace()
+{
+}
+
+bob::machine::IVectorMachineWorkspace::IVectorMachineWorkspace(
+    const size_t dim_d, const size_t dim_rt)
+{
+  resize(dim_d, dim_rt);
+}
+
+void bob::machine::IVectorMachineWorkspace::resize(const size_t dim_d,
+  const size_t dim_rt)
+{
+  if (tmp_d.extent(0) != (int)dim_d)
+    tmp_d.resize(dim_d);
+  if (tmp_t1.extent(0) != (int)dim_rt) {
+    tmp_t1.resize(dim_rt);
+    tmp_t2.resize(dim_rt);
+    tmp_tt.resize(dim_rt, dim_rt);
+  }
+}
+
+void bob::machine::IVectorMachineWorkspace::resizeBatch(const size_t dim_c,
+  const size_t dim_d, const size_t dim_rt, const size_t n_samples)
+{
+  if (tmp_n.extent(0) != (int)n_samples || tmp_n.extent(1) != (int)dim_c ||
+      tmp_fnorm.extent(1) != (int)(dim_c*dim_d) || tmp_rhs.extent(1) != (int)dim_rt)
+  {
+    tmp_n.resize(n_samples, dim_c);
+    tmp_fnorm.resize(n_samples, dim_c*dim_d);
+    tmp_rhs.resize(n_samples, dim_rt);
+    tmp_precision.resize(n_samples, dim_rt, dim_rt);
+  }
+}
+
+
+bob::machine::IVectorMachine::IVectorMachine():
+  m_single_precision_cache(false)
 {
 }
 
@@ -32,7 +148,8 @@ bob::machine::IVectorMachine::IVectorMachine(const boost::shared_ptr<bob::machin
     const size_t rt, const double variance_threshold):
   m_ubm(ubm), m_rt(rt),
   m_T(getDimCD(),rt), m_sigma(getDimCD()), 
-  m_variance_threshold(variance_threshold)
+  m_variance_threshold(variance_threshold),
+  m_single_precision_cache(false)
 {
   resizePrecompute();
 }
@@ -41,12 +158,14 @@ bob::machine::IVectorMachine::IVectorMachine(const bob::machine::IVectorMachine&
   m_ubm(other.m_ubm), m_rt(other.m_rt), 
   m_T(bob::core::array::ccopy(other.m_T)),
   m_sigma(bob::core::array::ccopy(other.m_sigma)),
-  m_variance_threshold(other.m_variance_threshold)
+  m_variance_threshold(other.m_variance_threshold),
+  m_single_precision_cache(other.m_single_precision_cache)
 {
   resizePrecompute();
 }
 
-bob::machine::IVectorMachine::IVectorMachine(bob::io::HDF5File& config)
+bob::machine::IVectorMachine::IVectorMachine(bob::io::HDF5File& config):
+  m_single_precision_cache(false)
 {
   load(config);
 }
@@ -88,6 +207,7 @@ bob::machine::IVectorMachine::operator=(const bob::machine::IVectorMachine& othe
     m_T.reference(bob::core::array::ccopy(other.m_T));
     m_sigma.reference(bob::core::array::ccopy(other.m_sigma));
     m_variance_threshold = other.m_variance_threshold;
+    m_single_precision_cache = other.m_single_precision_cache;
     resizePrecompute();
   }
   return *this;
@@ -148,6 +268,13 @@ void bob::machine::IVectorMachine::setVarianceThreshold(const double thd)
   precompute();
 }
 
+void bob::machine::IVectorMachine::setSinglePrecisionCache(const bool value)
+{
+  m_single_precision_cache = value;
+  resizeCache();
+  precompute();
+}
+
 void bob::machine::IVectorMachine::applyVarianceThreshold()
 {
   // Apply variance flooring threshold
@@ -161,29 +288,40 @@ void bob::machine::IVectorMachine::precompute()
     // Apply variance threshold
     applyVarianceThreshold();
 
+    // sigma^{-1}.T
     blitz::firstIndex i;
     blitz::secondIndex j;
-    blitz::Range rall = blitz::Range::all();
-    const int C = (int)m_ubm->getNGaussians();
-    const int D = (int)m_ubm->getNInputs();
-    // T_{c}^{T}.sigma_{c}^{-1}
-    for (int c=0; c<C; ++c)
-    {
-      blitz::Array<double,2> Tct_sigmacInv = m_cache_Tct_sigmacInv(c, rall, rall);
-      blitz::Array<double,2> Tc = m_T(blitz::Range(c*D,(c+1)*D-1), rall);
-      blitz::Array<double,2> Tct = Tc.transpose(1,0);
-      blitz::Array<double,1> sigma_c = m_sigma(blitz::Range(c*D,(c+1)*D-1));
-      Tct_sigmacInv = Tct(i,j) / sigma_c(j);
-    }
+    m_cache_sigmaInv_T = m_T(i,j) / m_sigma(i);
+
+    // T_{c}^{T}.sigma_{c}^{-1}.T_{c}, computed in parallel over the Gaussians
+    const blitz::Array<double,2> T = bob::core::array::isCZeroBaseContiguous(m_T) ?
+      m_T : bob::core::array::ccopy(m_T);
+    bob::core::parallelFor(0, getDimC(),
+      boost::bind(&bob::machine::IVectorMachine::precomputeGaussians, this,
+        boost::cref(T), _1, _2, _3));
+  }
+}
 
-    // T_{c}^{T}.sigma_{c}^{-1}.T_{c}
-    for (int c=0; c<C; ++c)
-    {
-      blitz::Array<double,2> Tc = m_T(blitz::Range(c*D,(c+1)*D-1), rall);
-      blitz::Array<double,2> Tct_sigmacInv = m_cache_Tct_sigmacInv(c, rall, rall);
-      blitz::Array<double,2> Tct_sigmacInv_Tc = m_cache_Tct_sigmacInv_Tc(c, rall, rall);
-      bob::math::prod(Tct_sigmacInv, Tc, Tct_sigmacInv_Tc);
-    }
+void bob::machine::IVectorMachine::precomputeGaussians(
+  const blitz::Array<double,2>& T, const size_t begin, const size_t end,
+  const size_t thread)
+{
+  // The blocks of the shared arrays are wrapped by their data pointer
+  const int D = (int)getDimD();
+  const int rt = (int)m_rt;
+  const int K = rt*(rt+1)/2;
+  blitz::Array<double,2> Tct_sigmacInv_Tc(rt, rt);
+  for (size_t c=begin; c<end; ++c)
+  {
+    const blitz::Array<double,2> Tc(const_cast<double*>(T.data()) + c*D*rt,
+      blitz::shape(D,rt), blitz::neverDeleteData);
+    const blitz::Array<double,2> sigmacInv_Tc(m_cache_sigmaInv_T.data() + c*D*rt,
+      blitz::shape(D,rt), blitz::neverDeleteData);
+    bob::math::prod_(Tc.transpose(1,0), sigmacInv_Tc, Tct_sigmacInv_Tc);
+    if (m_single_precision_cache)
+      packUpperTriangle(Tct_sigmacInv_Tc, m_cache_Tct_sigmacInv_Tc_single.data() + c*K);
+    else
+      packUpperTriangle(Tct_sigmacInv_Tc, m_cache_Tct_sigmacInv_Tc.data() + c*K);
   }
 }
 
@@ -199,9 +337,18 @@ void bob::machine::IVectorMachine::resizeCache()
   if (m_ubm)
   {
     const int C = (int)m_ubm->getNGaussians();
-    const int D = (int)m_ubm->getNInputs();
-    m_cache_Tct_sigmacInv.resize(C, (int)m_rt, D); 
-    m_cache_Tct_sigmacInv_Tc.resize(C, (int)m_rt, (int)m_rt);
+    const int K = (int)(m_rt*(m_rt+1)/2);
+    m_cache_sigmaInv_T.resize((int)getDimCD(), (int)m_rt);
+    if (m_single_precision_cache)
+    {
+      m_cache_Tct_sigmacInv_Tc.free();
+      m_cache_Tct_sigmacInv_Tc_single.resize(C, K);
+    }
+    else
+    {
+      m_cache_Tct_sigmacInv_Tc_single.free();
+      m_cache_Tct_sigmacInv_Tc.resize(C, K);
+    }
   }
 }
 
@@ -225,27 +372,86 @@ void bob::machine::IVectorMachine::computeIdTtSigmaInvT(
   const bob::machine::GMMStats& gs, blitz::Array<double,2>& output) const
 { 
   // Computes \f$(Id + \sum_{c=1}^{C} N_{i,j,c} T^{T} \Sigma_{c}^{-1} T)\f$
-  blitz::Range rall = blitz::Range::all();
-  bob::math::eye(output);
-  for (int c=0; c<(int)getDimC(); ++c)
-    output += gs.n(c) * m_cache_Tct_sigmacInv_Tc(c, rall, rall);
+  // The zeroth order statistics are seen as a batch of a single sample.
+  const int C = (int)getDimC();
+  const int rt = (int)m_rt;
+  const blitz::Array<double,2> n(const_cast<double*>(gs.n.data()),
+    blitz::shape(1,C), blitz::neverDeleteData);
+  if (bob::core::array::isCZeroBaseContiguous(output))
+  {
+    blitz::Array<double,3> output_(output.data(), blitz::shape(1,rt,rt),
+      blitz::neverDeleteData);
+    computeIdTtSigmaInvT(n, output_);
+  }
+  else
+  {
+    blitz::Array<double,3> output_(1, rt, rt);
+    computeIdTtSigmaInvT(n, output_);
+    output = output_(0, blitz::Range::all(), blitz::Range::all());
+  }
+}
+
+void bob::machine::IVectorMachine::computeIdTtSigmaInvT(
+  const blitz::Array<double,2>& n, blitz::Array<double,3>& output) const
+{
+  // The cache, a C-style contiguous array, is read through its data pointer
+  bob::core::array::assertCZeroBaseContiguous(output);
+  const int C = (int)getDimC();
+  const int rt = (int)m_rt;
+  if (m_single_precision_cache)
+    accumulatePrecisions(m_cache_Tct_sigmacInv_Tc_single.data(), C, rt, n,
+      output.data());
+  else
+    accumulatePrecisions(m_cache_Tct_sigmacInv_Tc.data(), C, rt, n,
+      output.data());
 }
 
 void bob::machine::IVectorMachine::computeTtSigmaInvFnorm(
   const bob::machine::GMMStats& gs, blitz::Array<double,1>& output) const
+{
+  computeTtSigmaInvFnorm(gs, output, m_tmp_d, m_tmp_t2);
+}
+
+void bob::machine::IVectorMachine::computeTtSigmaInvFnorm(
+  const bob::machine::GMMStats& gs, blitz::Array<double,1>& output,
+  bob::machine::IVectorMachineWorkspace& ws) const
+{
+  computeTtSigmaInvFnorm(gs, output, ws.tmp_d, ws.tmp_t2);
+}
+
+void bob::machine::IVectorMachine::computeTtSigmaInvFnorm(
+  const bob::machine::GMMStats& gs, blitz::Array<double,1>& output,
+  blitz::Array<double,1>& tmp_d, blitz::Array<double,1>& tmp_t) const
 {
   // Computes \f$T^{T} \Sigma^{-1} \sum_{c=1}^{C} (F_c - N_c ubmmean_{c})\f$
-  blitz::Range rall = blitz::Range::all();
+  const int rt = (int)m_rt;
+  const int dim_d = (int)getDimD();
+  const double* sigmaInv_T = m_cache_sigmaInv_T.data();
   output = 0;
   for (int c=0; c<(int)getDimC(); ++c)
   {
-    m_tmp_d = gs.sumPx(c,rall) - gs.n(c) * m_ubm->getGaussian(c)->getMean();
-    blitz::Array<double,2> Tct_sigmacInv = m_cache_Tct_sigmacInv(c, rall, rall);
-    bob::math::prod(Tct_sigmacInv, m_tmp_d, m_tmp_t2);
-    output += m_tmp_t2;
+    const blitz::Array<double,1>& mean = m_ubm->getGaussian(c)->getMean();
+    const double n_c = gs.n(c);
+    for (int d=0; d<dim_d; ++d)
+      tmp_d(d) = gs.sumPx(c,d) - n_c * mean(d);
+    const blitz::Array<double,2> sigmacInv_Tc(
+      const_cast<double*>(sigmaInv_T) + c*dim_d*rt,
+      blitz::shape(dim_d,rt), blitz::neverDeleteData);
+    bob::math::prod(tmp_d, sigmacInv_Tc, tmp_t);
+    output += tmp_t;
   }
 }
 
+void bob::machine::IVectorMachine::computeTtSigmaInvFnorm(
+  const blitz::Array<double,2>& fnorm, blitz::Array<double,2>& output) const
+{
+  // Computes \f$F_{norm} \Sigma^{-1} T\f$, with a single matrix product
+  const blitz::Array<double,2> sigmaInv_T(
+    const_cast<double*>(m_cache_sigmaInv_T.data()),
+    m_cache_sigmaInv_T.shape(), blitz::neverDeleteData);
+  bob::math::prod_(fnorm, sigmaInv_T, output);
+}
+
 void bob::machine::IVectorMachine::forward_(const bob::machine::GMMStats& gs, 
   blitz::Array<double,1>& ivector) const
 {
@@ -259,3 +465,101 @@ void bob::machine::IVectorMachine::forward_(const bob::machine::GMMStats& gs,
   bob::math::linsolve(m_tmp_tt, ivector, m_tmp_t1);
 }
 
+void bob::machine::IVectorMachine::forward(const bob::machine::GMMStats& gs,
+  blitz::Array<double,1>& ivector, bob::machine::IVectorMachineWorkspace& ws) const
+{
+  bob::core::array::assertSameDimensionLength(ivector.extent(0), (int)m_rt);
+  ws.resize(getDimD(), m_rt);
+  forward_(gs, ivector, ws);
+}
+
+void bob::machine::IVectorMachine::forward_(const bob::machine::GMMStats& gs, 
+  blitz::Array<double,1>& ivector, bob::machine::IVectorMachineWorkspace& ws) const
+{
+  // Computes \f$(Id + \sum_{c=1}^{C} N_{i,j,c} T^{T} \Sigma_{c}^{-1} T)\f$
+  computeIdTtSigmaInvT(gs, ws.tmp_tt);
+
+  // Computes \f$T^{T} \Sigma^{-1} \sum_{c=1}^{C} (F_c - N_c ubmmean_{c})\f$
+  computeTtSigmaInvFnorm(gs, ws.tmp_t1, ws.tmp_d, ws.tmp_t2);
+
+  // Solves ws.tmp_tt.ivector = ws.tmp_t1
+  bob::math::linsolve(ws.tmp_tt, ivector, ws.tmp_t1);
+}
+
+void bob::machine::IVectorMachine::forward(
+  const std::vector<bob::machine::GMMStats>& input,
+  blitz::Array<double,2>& ivectors) const
+{
+  bob::core::array::assertSameDimensionLength(ivectors.extent(0), (int)input.size());
+  bob::core::array::assertSameDimensionLength(ivectors.extent(1), (int)m_rt);
+
+  // One workspace per thread
+  std::vector<bob::machine::IVectorMachineWorkspace> ws(bob::core::getNThreads());
+  for (size_t t=0; t<ws.size(); ++t)
+  {
+    ws[t].resize(getDimD(), m_rt);
+    ws[t].resizeBatch(getDimC(), getDimD(), m_rt, getBatchSize());
+  }
+  const blitz::Array<double,1>& means = m_ubm->getMeanSupervector();
+  bob::core::parallelFor(0, input.size(),
+    boost::bind(&bob::machine::IVectorMachine::forwardBatch, this,
+      boost::cref(input), boost::cref(means), boost::ref(ivectors),
+      boost::ref(ws), _1, _2, _3),
+    getBatchSize());
+}
+
+void bob::machine::IVectorMachine::computeBatch(
+  const std::vector<bob::machine::GMMStats>& input,
+  const blitz::Array<double,1>& means, const size_t begin, const size_t end,
+  bob::machine::IVectorMachineWorkspace& ws) const
+{
+  const int C = (int)getDimC();
+  const int D = (int)getDimD();
+  const int n_samples = (int)(end - begin);
+
+  // Statistics of the batch: N and F - N.ubmmean
+  for (int s=0; s<n_samples; ++s)
+  {
+    const bob::machine::GMMStats& gs = input[begin+s];
+    for (int c=0; c<C; ++c)
+    {
+      const double n_c = gs.n(c);
+      ws.tmp_n(s,c) = n_c;
+      for (int d=0; d<D; ++d)
+        ws.tmp_fnorm(s,c*D+d) = gs.sumPx(c,d) - n_c * means(c*D+d);
+    }
+  }
+
+  blitz::Range a = blitz::Range::all();
+  blitz::Range r(0, n_samples-1);
+  blitz::Array<double,2> n = ws.tmp_n(r,a);
+  blitz::Array<double,2> fnorm = ws.tmp_fnorm(r,a);
+  blitz::Array<double,2> rhs = ws.tmp_rhs(r,a);
+  blitz::Array<double,3> precision = ws.tmp_precision(r,a,a);
+  computeIdTtSigmaInvT(n, precision);
+  computeTtSigmaInvFnorm(fnorm, rhs);
+}
+
+void bob::machine::IVectorMachine::forwardBatch(
+  const std::vector<bob::machine::GMMStats>& input,
+  const blitz::Array<double,1>& means, blitz::Array<double,2>& ivectors,
+  std::vector<bob::machine::IVectorMachineWorkspace>& ws,
+  const size_t begin, const size_t end, const size_t thread) const
+{
+  bob::machine::IVectorMachineWorkspace& w = ws[thread];
+  const int rt = (int)m_rt;
+  blitz::Range a = blitz::Range::all();
+  for (size_t b=begin; b<end; b+=getBatchSize())
+  {
+    const int n_samples = (int)std::min(getBatchSize(), end-b);
+    computeBatch(input, means, b, b+n_samples, w);
+    for (int s=0; s<n_samples; ++s)
+    {
+      blitz::Array<double,2> precision_s = w.tmp_precision(s,a,a);
+      blitz::Array<double,1> rhs_s = w.tmp_rhs(s,a);
+      bob::math::linsolve(precision_s, w.tmp_t1, rhs_s);
+      for (int i=0; i<rt; ++i)
+        ivectors(b+s,i) = w.tmp_t1(i);
+    }
+  }
+}
@@ -28,6 +28,37 @@
 
 
 //////////////////// FABase ////////////////////
+bob::machine::FAWorkspace::FAWorkspace()
+{
+}
+
+bob::machine::FAWorkspace::FAWorkspace(const size_t dim_c, const size_t dim_d,
+    const size_t dim_ru)
+{
+  resize(dim_c, dim_d, dim_ru);
+}
+
+void bob::machine::FAWorkspace::resize(const size_t dim_c, const size_t dim_d,
+  const size_t dim_ru)
+{
+  const int cd = (int)(dim_c*dim_d);
+  const int ru = (int)dim_ru;
+  if (Fn_x.extent(0) != cd) {
+    Fn_x.resize(cd);
+    Ux.resize(cd);
+  }
+  if (x.extent(0) != ru) {
+    IdPlusUSProdInv.resize(ru, ru);
+    x.resize(ru);
+    tmp_ru.resize(ru);
+    tmp_ruru.resize(ru, ru);
+    tmp_ruru2.resize(ru, ru);
+  }
+  if (tmp_ruD.extent(0) != ru || tmp_ruD.extent(1) != (int)dim_d)
+    tmp_ruD.resize(ru, dim_d);
+}
+
+
 bob::machine::FABase::FABase():
   m_ubm(boost::shared_ptr<bob::machine::GMMMachine>()), m_ru(1), m_rv(1),
   m_U(0,1), m_V(0,1), m_d(0)
@@ -226,6 +257,7 @@ void bob::machine::FABase::resizeTmp()
   m_tmp_ru.resize(getDimRu());
   m_tmp_ruD.resize(getDimRu(), getDimD());
   m_tmp_ruru.resize(getDimRu(), getDimRu());
+  m_tmp_ruru2.resize(getDimRu(), getDimRu());
 }
 
 void bob::machine::FABase::updateCacheUbm()
@@ -253,36 +285,35 @@ void bob::machine::FABase::updateCacheUbmUVD()
 }
 
 void bob::machine::FABase::computeIdPlusUSProdInv(const bob::machine::GMMStats& gmm_stats,
-  blitz::Array<double,2>& output) const
+  blitz::Array<double,2>& output, blitz::Array<double,2>& tmp_ruD,
+  blitz::Array<double,2>& tmp_ruru, blitz::Array<double,2>& tmp_ruru2) const
 {
   // Computes (Id + U^T.Sigma^-1.U.N_{i,h}.U)^-1 =
   // (Id + sum_{c=1..C} N_{i,h}.U_{c}^T.Sigma_{c}^-1.U_{c})^-1
 
-  // Blitz compatibility: ugly fix (const_cast, as old blitz version does not
-  // provide a non-const version of transpose())
-  blitz::Array<double,2> Ut = const_cast<blitz::Array<double,2>&>(m_U).transpose(1,0);
-
-  blitz::firstIndex i;
-  blitz::secondIndex j;
-  blitz::Range rall = blitz::Range::all();
-
-  bob::math::eye(m_tmp_ruru); // m_tmp_ruru = Id
-  // Loop and add N_{i,h}.U_{c}^T.Sigma_{c}^-1.U_{c} to m_tmp_ruru at each iteration
-  const size_t dim_c = getDimC();
-  const size_t dim_d = getDimD();
-  for(size_t c=0; c<dim_c; ++c) {
-    blitz::Range rc(c*dim_d,(c+1)*dim_d-1);
-    blitz::Array<double,2> Ut_c = Ut(rall,rc);
-    blitz::Array<double,1> sigma_c = m_cache_sigma(rc);
-    m_tmp_ruD = Ut_c(i,j) / sigma_c(j); // U_{c}^T.Sigma_{c}^-1
-    blitz::Array<double,2> U_c = m_U(rc,rall);
-    // Use m_cache_IdPlusUSProdInv as an intermediate array
-    bob::math::prod(m_tmp_ruD, U_c, output); // U_{c}^T.Sigma_{c}^-1.U_{c}
-    // Finally, add N_{i,h}.U_{c}^T.Sigma_{c}^-1.U_{c} to m_tmp_ruru
-    m_tmp_ruru += output * gmm_stats.n(c);
+  // m_U is read through its data pointer, as this method may be called
+  // concurrently (see bob::core::parallelFor()). U is a C-style contiguous
+  // CD x ru array (see setU()).
+  const int dim_c = getDimC();
+  const int dim_d = getDimD();
+  const int dim_ru = getDimRu();
+  const double* U = m_U.data();
+
+  bob::math::eye(tmp_ruru); // tmp_ruru = Id
+  // Loop and add N_{i,h}.U_{c}^T.Sigma_{c}^-1.U_{c} to tmp_ruru at each iteration
+  for(int c=0; c<dim_c; ++c) {
+    // tmp_ruD = U_{c}^T.Sigma_{c}^-1
+    for(int r=0; r<dim_ru; ++r)
+      for(int d=0; d<dim_d; ++d)
+        tmp_ruD(r,d) = U[(c*dim_d+d)*dim_ru+r] / m_cache_sigma(c*dim_d+d);
+    const blitz::Array<double,2> U_c(const_cast<double*>(U) + c*dim_d*dim_ru,
+      blitz::shape(dim_d,dim_ru), blitz::neverDeleteData);
+    bob::math::prod(tmp_ruD, U_c, tmp_ruru2); // U_{c}^T.Sigma_{c}^-1.U_{c}
+    // Finally, add N_{i,h}.U_{c}^T.Sigma_{c}^-1.U_{c} to tmp_ruru
+    tmp_ruru += tmp_ruru2 * gmm_stats.n(c);
   }
   // Computes the inverse
-  bob::math::inv(m_tmp_ruru, output);
+  bob::math::inv(tmp_ruru, output);
 }
 
 
@@ -290,33 +321,44 @@ void bob::machine::FABase::computeFn_x(const bob::machine::GMMStats& gmm_stats,
   blitz::Array<double,1>& output) const
 {
   // Compute Fn_x = sum_{sessions h}(N*(o - m) (Normalised first order statistics)
-  blitz::Range rall = blitz::Range::all();
-  const size_t dim_c = getDimC();
-  const size_t dim_d = getDimD();
-  for(size_t c=0; c<dim_c; ++c) {
-    blitz::Range rc(c*dim_d,(c+1)*dim_d-1);
-    blitz::Array<double,1> Fn_x_c = output(rc);
-    blitz::Array<double,1> mean_c = m_cache_mean(rc);
-    Fn_x_c = gmm_stats.sumPx(c,rall) - mean_c*gmm_stats.n(c);
+  const int dim_c = getDimC();
+  const int dim_d = getDimD();
+  for(int c=0; c<dim_c; ++c) {
+    const double n_c = gmm_stats.n(c);
+    for(int d=0; d<dim_d; ++d)
+      output(c*dim_d+d) = gmm_stats.sumPx(c,d) - m_cache_mean(c*dim_d+d)*n_c;
   }
 }
 
 void bob::machine::FABase::estimateX(const blitz::Array<double,2>& IdPlusUSProdInv,
-  const blitz::Array<double,1>& Fn_x, blitz::Array<double,1>& x) const
+  const blitz::Array<double,1>& Fn_x, blitz::Array<double,1>& x,
+  blitz::Array<double,1>& tmp_ru) const
 {
-  // m_tmp_ru = UtSigmaInv * Fn_x = Ut*diag(sigma)^-1 * N*(o - m)
-  bob::math::prod(m_cache_UtSigmaInv, Fn_x, m_tmp_ru);
+  // tmp_ru = UtSigmaInv * Fn_x = Ut*diag(sigma)^-1 * N*(o - m)
+  bob::math::prod(m_cache_UtSigmaInv, Fn_x, tmp_ru);
   // x = IdPlusUSProdInv * m_cache_UtSigmaInv * Fn_x
-  bob::math::prod(IdPlusUSProdInv, m_tmp_ru, x);
+  bob::math::prod(IdPlusUSProdInv, tmp_ru, x);
 }
 
 
 void bob::machine::FABase::estimateX(const bob::machine::GMMStats& gmm_stats, blitz::Array<double,1>& x) const
 {
   if (!m_ubm) throw std::runtime_error("No UBM was set in the JFA machine.");
-  computeIdPlusUSProdInv(gmm_stats, m_tmp_IdPlusUSProdInv); // Computes first term
+  computeIdPlusUSProdInv(gmm_stats, m_tmp_IdPlusUSProdInv, m_tmp_ruD,
+    m_tmp_ruru, m_tmp_ruru2); // Computes first term
   computeFn_x(gmm_stats, m_tmp_Fn_x); // Computes last term
-  estimateX(m_tmp_IdPlusUSProdInv, m_tmp_Fn_x, x); // Estimates the value of x
+  estimateX(m_tmp_IdPlusUSProdInv, m_tmp_Fn_x, x, m_tmp_ru); // Estimates the value of x
+}
+
+void bob::machine::FABase::estimateX(const bob::machine::GMMStats& gmm_stats,
+  blitz::Array<double,1>& x, bob::machine::FAWorkspace& ws) const
+{
+  if (!m_ubm) throw std::runtime_error("No UBM was set in the JFA machine.");
+  ws.resize(getDimC(), getDimD(), getDimRu());
+  computeIdPlusUSProdInv(gmm_stats, ws.IdPlusUSProdInv, ws.tmp_ruD,
+    ws.tmp_ruru, ws.tmp_ruru2); // Computes first term
+  computeFn_x(gmm_stats, ws.Fn_x); // Computes last term
+  estimateX(ws.IdPlusUSProdInv, ws.Fn_x, x, ws.tmp_ru); // Estimates the value of x
 }
 
 
@@ -633,6 +675,28 @@ void bob::machine::JFAMachine::forward_(const bob::machine::GMMStats& input,
             input, m_tmp_Ux, true);
 }
 
+void bob::machine::JFAMachine::forward(const bob::machine::GMMStats& input,
+  double& score, bob::machine::FAWorkspace& ws) const
+{
+  forward_(input, score, ws);
+}
+
+void bob::machine::JFAMachine::forward_(const bob::machine::GMMStats& input,
+  double& score, bob::machine::FAWorkspace& ws) const
+{
+  // Checks that a Base machine has been set
+  if (!m_jfa_base) throw std::runtime_error("No UBM was set in the JFA machine.");
+
+  // Ux and GMMStats (the UBM supervectors cached by the FABase are used, as
+  // they do not need to be lazily computed)
+  const bob::machine::FABase& base = m_jfa_base->getBase();
+  base.estimateX(input, ws.x, ws);
+  bob::math::prod(base.getU(), ws.x, ws.Ux);
+
+  score = bob::machine::linearScoring(m_cache_mVyDz,
+            base.getUbmMean(), base.getUbmVariance(), input, ws.Ux, true);
+}
+
 
 
 //////////////////// ISVMachine ////////////////////
@@ -802,3 +866,25 @@ void bob::machine::ISVMachine::forward_(const bob::machine::GMMStats& input,
             input, m_tmp_Ux, true);
 }
 
+void bob::machine::ISVMachine::forward(const bob::machine::GMMStats& input,
+  double& score, bob::machine::FAWorkspace& ws) const
+{
+  forward_(input, score, ws);
+}
+
+void bob::machine::ISVMachine::forward_(const bob::machine::GMMStats& input,
+  double& score, bob::machine::FAWorkspace& ws) const
+{
+  // Checks that a Base machine has been set
+  if (!m_isv_base) throw std::runtime_error("No UBM was set in the JFA machine.");
+
+  // Ux and GMMStats (the UBM supervectors cached by the FABase are used, as
+  // they do not need to be lazily computed)
+  const bob::machine::FABase& base = m_isv_base->getBase();
+  base.estimateX(input, ws.x, ws);
+  bob::math::prod(base.getU(), ws.x, ws.Ux);
+
+  score = bob::machine::linearScoring(m_cache_mDz,
+            base.getUbmMean(), base.getUbmVariance(), input, ws.Ux, true);
+}
+
@@ -21,13 +21,20 @@
  */
 
 #include <cmath>
+#include <algorithm>
 #include <boost/make_shared.hpp>
 #include <boost/format.hpp>
 
 #include <bob/core/array_copy.h>
+#include <bob/core/assert.h>
 #include <bob/machine/LinearMachine.h>
 #include <bob/math/linear.h>
 
+/**
+ * Number of rows processed at once by the 2D forward
+ */
+static const int LINEAR_BATCH_SIZE = 256;
+
 bob::machine::LinearMachine::LinearMachine(const blitz::Array<double,2>& weight)
   : m_input_sub(weight.extent(0)),
     m_input_div(weight.extent(0)),
@@ -166,8 +173,11 @@ void bob::machine::LinearMachine::forward_
 (const blitz::Array<double,1>& input, blitz::Array<double,1>& output) const {
   m_buffer = (input - m_input_sub) / m_input_div;
   bob::math::prod_(m_buffer, m_weight, output);
-  for (int i=0; i<m_weight.extent(1); ++i)
-    output(i) = m_activation->f(output(i) + m_bias(i));
+  output += m_bias;
+  if (bob::core::array::isCZeroBaseContiguous(output))
+    m_activation->f_inplace(output.data(), output.extent(0));
+  else
+    for (int i=0; i<output.extent(0); ++i) output(i) = m_activation->f(output(i));
 }
 
 void bob::machine::LinearMachine::forward
@@ -185,6 +195,55 @@ void bob::machine::LinearMachine::forward
   forward_(input, output);
 }
 
+void bob::machine::LinearMachine::forward_
+(const blitz::Array<double,2>& input, blitz::Array<double,2>& output) const {
+  const int n_samples = input.extent(0);
+  if (!n_samples) return;
+
+  const int batch_size = std::min(n_samples, LINEAR_BATCH_SIZE);
+  if (m_batch_input.extent(0) < batch_size ||
+      m_batch_input.extent(1) != m_weight.extent(0))
+    m_batch_input.resize(batch_size, m_weight.extent(0));
+  if (m_batch_output.extent(0) < batch_size ||
+      m_batch_output.extent(1) != m_weight.extent(1))
+    m_batch_output.resize(batch_size, m_weight.extent(1));
+
+  blitz::Range all = blitz::Range::all();
+  for (int b=0; b<n_samples; b+=LINEAR_BATCH_SIZE) {
+    const int n = std::min(LINEAR_BATCH_SIZE, n_samples-b);
+    blitz::Range rows(0, n-1);
+
+    blitz::Array<double,2> x = m_batch_input(rows, all);
+    for (int i=0; i<n; ++i)
+      for (int k=0; k<x.extent(1); ++k)
+        x(i,k) = (input(b+i,k) - m_input_sub(k)) / m_input_div(k);
+
+    blitz::Array<double,2> y = m_batch_output(rows, all);
+    bob::math::prod_(x, m_weight, y);
+    for (int i=0; i<n; ++i)
+      for (int k=0; k<y.extent(1); ++k) y(i,k) += m_bias(k);
+    m_activation->f_inplace(y.data(), n * y.extent(1));
+
+    output(blitz::Range(b, b+n-1), all) = y;
+  }
+}
+
+void bob::machine::LinearMachine::forward
+(const blitz::Array<double,2>& input, blitz::Array<double,2>& output) const {
+  if (m_weight.extent(0) != input.extent(1)) { //checks input dimension
+    boost::format m("mismatch on the input dimension: expected a matrix with %d columns, but you input one with %d columns instead");
+    m % m_weight.extent(0) % input.extent(1);
+    throw std::runtime_error(m.str());
+  }
+  if (m_weight.extent(1) != output.extent(1)) { //checks output dimension
+    boost::format m("mismatch on the output dimension: expected a matrix with %d columns, but you input one with %d columns instead");
+    m % m_weight.extent(1) % output.extent(1);
+    throw std::runtime_error(m.str());
+  }
+  bob::core::array::assertSameDimensionLength(input.extent(0), output.extent(0));
+  forward_(input, output);
+}
+
 void bob::machine::LinearMachine::setWeights
 (const blitz::Array<double,2>& weight) {
   if (weight.extent(0) != m_input_sub.extent(0)) { //checks 1st dimension
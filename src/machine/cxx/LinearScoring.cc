@@ -18,70 +18,173 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 #include <bob/machine/LinearScoring.h>
+#include <bob/core/parallel.h>
 #include <bob/math/linear.h>
+#include <boost/bind.hpp>
+#include <algorithm>
+#include <limits>
 
 namespace bob { namespace machine {
 
 namespace detail {
 
+  /**
+   * Number of models scored at once against all the test statistics, which
+   * bounds the memory used by the (normalised) model supervectors
+   */
+  static const int LINEAR_SCORING_MODEL_BLOCK = 128;
+
+  /**
+   * Number of test statistics whose (centered) supervectors are built and
+   * scored at once, as a matrix product, against a block of models
+   */
+  static const int LINEAR_SCORING_TEST_TILE = 64;
+
+  /**
+   * Computes the rows [begin,end[ of the block of (normalised) model 
+   * supervectors A, starting at model first_model (parallel body)
+   */
+  static void normaliseModels(const std::vector<blitz::Array<double,1> >& models,
+                              const size_t first_model,
+                              const blitz::Array<double,1>& ubm_mean,
+                              const blitz::Array<double,1>& ubm_variance,
+                              double* A, size_t begin, size_t end, size_t)
+  {
+    const int CD = ubm_mean.extent(0);
+    for(size_t t=begin; t<end; ++t) {
+      const blitz::Array<double,1>& model = models[first_model+t];
+      double* a = A + t*CD;
+      for(int s=0; s<CD; ++s)
+        a[s] = (model(s) - ubm_mean(s)) / ubm_variance(s);
+    }
+  }
+
+  /**
+   * Computes the scores of the block of models A against the test statistics
+   * [begin,end[, tile by tile: the (centered) supervectors of the statistics
+   * of a tile are built, and multiplied by A (parallel body).
+   */
+  static void scoreTiles(const blitz::Array<double,2>& A,
+                         const blitz::Array<double,1>& ubm_mean,
+                         const std::vector<boost::shared_ptr<const bob::machine::GMMStats> >& test_stats,
+                         const std::vector<blitz::Array<double,1> >* test_channelOffset,
+                         const bool frame_length_normalisation,
+                         blitz::Array<double,2>& scores,
+                         size_t begin, size_t end, size_t)
+  {
+    const int C = test_stats[0]->sumPx.extent(0);
+    const int D = test_stats[0]->sumPx.extent(1);
+    const int CD = C*D;
+    const int n_models = A.extent(0);
+
+    // Thread-local arrays, the shared models being wrapped by their data
+    blitz::Array<double,2> A_(const_cast<double*>(A.data()),
+      blitz::shape(n_models,CD), blitz::neverDeleteData);
+    blitz::Array<double,2> Bt(LINEAR_SCORING_TEST_TILE, CD);
+    blitz::Array<double,2> S(n_models, LINEAR_SCORING_TEST_TILE);
+
+    for(size_t t0=begin; t0<end; t0+=LINEAR_SCORING_TEST_TILE) {
+      const int n = std::min(end-t0, (size_t)LINEAR_SCORING_TEST_TILE);
+
+      // Supervectors of the statistics of the tile, one per row
+      for(int i=0; i<n; ++i) {
+        const bob::machine::GMMStats& stats = *test_stats[t0+i];
+        const blitz::Array<double,1>* offset = (test_channelOffset ? &(*test_channelOffset)[t0+i] : 0);
+        double* b = &Bt(i,0);
+        for(int c=0; c<C; ++c) {
+          const double n_c = stats.n(c);
+          for(int d=0; d<D; ++d) {
+            const int s = c*D+d;
+            if(offset)
+              b[s] = stats.sumPx(c,d) - (n_c * (ubm_mean(s) + (*offset)(s)));
+            else
+              b[s] = stats.sumPx(c,d) - (ubm_mean(s) * n_c);
+          }
+        }
+
+        // Apply the normalisation if needed
+        if(frame_length_normalisation) {
+          const double sum_N = stats.T;
+          if(sum_N <= std::numeric_limits<double>::epsilon() && sum_N >= -std::numeric_limits<double>::epsilon())
+            for(int s=0; s<CD; ++s) b[s] = 0;
+          else
+            for(int s=0; s<CD; ++s) b[s] /= sum_N;
+        }
+      }
+
+      // Scores of the tile
+      blitz::Array<double,2> B = Bt(blitz::Range(0,n-1), blitz::Range::all()).transpose(1,0);
+      blitz::Array<double,2> S_ = S(blitz::Range::all(), blitz::Range(0,n-1));
+      bob::math::prod_(A_, B, S_);
+      for(int m=0; m<n_models; ++m)
+        for(int i=0; i<n; ++i)
+          scores(m,(int)t0+i) = S_(m,i);
+    }
+  }
+
+  /**
+   * Computes the scores block of models by block of models, and writes them
+   * either into the scores matrix or (if given) into the dataset of the file
+   */
   void linearScoring(const std::vector<blitz::Array<double,1> >& models,
                      const blitz::Array<double,1>& ubm_mean,
                      const blitz::Array<double,1>& ubm_variance,
                      const std::vector<boost::shared_ptr<const bob::machine::GMMStats> >& test_stats,
                      const std::vector<blitz::Array<double,1> >* test_channelOffset,
                      const bool frame_length_normalisation,
-                     blitz::Array<double,2>& scores) 
+                     blitz::Array<double,2>& scores,
+                     bob::io::HDF5File* file=0, const std::string& path="")
   {
-    int C = test_stats[0]->sumPx.extent(0);
-    int D = test_stats[0]->sumPx.extent(1);
-    int CD = C*D;
     int Tt = test_stats.size();
     int Tm = models.size();
 
     // Check output size
-    bob::core::array::assertSameDimensionLength(scores.extent(0), models.size());
-    bob::core::array::assertSameDimensionLength(scores.extent(1), test_stats.size());
-
-    blitz::Array<double,2> A(Tm, CD);
-    blitz::Array<double,2> B(CD, Tt);
-
-    // 1) Compute A
-    for(int t=0; t<Tm; ++t) {
-      blitz::Array<double, 1> tmp = A(t, blitz::Range::all());
-      tmp = (models[t] - ubm_mean) / ubm_variance;
+    if(!file) {
+      bob::core::array::assertSameDimensionLength(scores.extent(0), models.size());
+      bob::core::array::assertSameDimensionLength(scores.extent(1), test_stats.size());
     }
+    if(Tt == 0 || Tm == 0) return;
 
-    // 2) Compute B
-    if(test_channelOffset == 0) {
-      for(int t=0; t<Tt; ++t) 
-        for(int s=0; s<CD; ++s)
-          B(s, t) = test_stats[t]->sumPx(s/D, s%D) - (ubm_mean(s) * test_stats[t]->n(s/D));
-    }
-    else {
+    int C = test_stats[0]->sumPx.extent(0);
+    int D = test_stats[0]->sumPx.extent(1);
+    int CD = C*D;
+    bob::core::array::assertSameDimensionLength(ubm_mean.extent(0), CD);
+    bob::core::array::assertSameDimensionLength(ubm_variance.extent(0), CD);
+    if(test_channelOffset != 0) {
       bob::core::array::assertSameDimensionLength((*test_channelOffset).size(), Tt);
-      
-      for(int t=0; t<Tt; ++t) {
+      for(int t=0; t<Tt; ++t)
         bob::core::array::assertSameDimensionLength((*test_channelOffset)[t].extent(0), CD);
-        for(int s=0; s<CD; ++s) 
-          B(s, t) = test_stats[t]->sumPx(s/D, s%D) - (test_stats[t]->n(s/D) * (ubm_mean(s) + (*test_channelOffset)[t](s)));
-      }
     }
 
-    // Apply the normalisation if needed
-    if(frame_length_normalisation) {
-      for(int t=0; t<Tt; ++t) {
-        double sum_N = test_stats[t]->T;
-        blitz::Array<double, 1> v_t = B(blitz::Range::all(),t);
+    // The matrix of the test supervectors is never built as a whole: the
+    // scores of a block of models are computed tile by tile of test
+    // statistics, in parallel
+    blitz::Array<double,2> A(std::min(Tm, LINEAR_SCORING_MODEL_BLOCK), CD);
+    blitz::Array<double,2> block_scores;
+    if(file) block_scores.resize(A.extent(0), Tt);
+    for(int m0=0; m0<Tm; m0+=LINEAR_SCORING_MODEL_BLOCK) {
+      const int n_models = std::min(Tm-m0, LINEAR_SCORING_MODEL_BLOCK);
 
-        if (sum_N <= std::numeric_limits<double>::epsilon() && sum_N >= -std::numeric_limits<double>::epsilon())
-          v_t = 0;
-        else 
-          v_t /= sum_N;
-      }
-    }
+      // 1) Compute A
+      bob::core::parallelFor(0, n_models,
+        boost::bind(&normaliseModels, boost::cref(models), m0,
+          boost::cref(ubm_mean), boost::cref(ubm_variance), A.data(),
+          _1, _2, _3));
+
+      // 2) Compute the LLR against all the test statistics
+      blitz::Range r(0, n_models-1);
+      const blitz::Array<double,2> A_block = A(r, blitz::Range::all());
+      blitz::Array<double,2> out = (file ? block_scores(r, blitz::Range::all()) :
+        scores(blitz::Range(m0, m0+n_models-1), blitz::Range::all()));
+      bob::core::parallelFor(0, Tt,
+        boost::bind(&scoreTiles, boost::cref(A_block), boost::cref(ubm_mean),
+          boost::cref(test_stats), test_channelOffset,
+          frame_length_normalisation, boost::ref(out), _1, _2, _3),
+        LINEAR_SCORING_TEST_TILE);
 
-    // 3) Compute LLR
-    bob::math::prod(A, B, scores);
+      // 3) Append the scores of the block of models to the file
+      if(file) file->appendArrays(path, out);
+    }
   } 
 }
 
@@ -105,6 +208,27 @@ void linearScoring(const std::vector<blitz::Array<double,1> >& models,
   detail::linearScoring(models, ubm_mean, ubm_variance, test_stats, 0, frame_length_normalisation, scores);
 }
 
+void linearScoring(const std::vector<blitz::Array<double,1> >& models,
+                   const blitz::Array<double,1>& ubm_mean, const blitz::Array<double,1>& ubm_variance,
+                   const std::vector<boost::shared_ptr<const bob::machine::GMMStats> >& test_stats,
+                   const std::vector<blitz::Array<double,1> >& test_channelOffset,
+                   const bool frame_length_normalisation,
+                   bob::io::HDF5File& file, const std::string& path)
+{
+  blitz::Array<double,2> no_scores;
+  detail::linearScoring(models, ubm_mean, ubm_variance, test_stats, &test_channelOffset, frame_length_normalisation, no_scores, &file, path);
+}
+
+void linearScoring(const std::vector<blitz::Array<double,1> >& models,
+                   const blitz::Array<double,1>& ubm_mean, const blitz::Array<double,1>& ubm_variance,
+                   const std::vector<boost::shared_ptr<const bob::machine::GMMStats> >& test_stats,
+                   const bool frame_length_normalisation,
+                   bob::io::HDF5File& file, const std::string& path)
+{
+  blitz::Array<double,2> no_scores;
+  detail::linearScoring(models, ubm_mean, ubm_variance, test_stats, 0, frame_length_normalisation, no_scores, &file, path);
+}
+
 void linearScoring(const std::vector<boost::shared_ptr<const bob::machine::GMMMachine> >& models,
                    const bob::machine::GMMMachine& ubm,
                    const std::vector<boost::shared_ptr<const bob::machine::GMMStats> >& test_stats,
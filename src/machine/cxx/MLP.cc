@@ -22,6 +22,7 @@
 
 #include <sys/time.h>
 #include <cmath>
+#include <algorithm>
 #include <boost/format.hpp>
 #include <boost/make_shared.hpp>
 
@@ -31,6 +32,22 @@
 #include <bob/machine/MLP.h>
 #include <bob/math/linear.h>
 
+/**
+ * Number of rows processed at once by the 2D forward
+ */
+static const int MLP_BATCH_SIZE = 256;
+
+/**
+ * Applies the activation to all values of v
+ */
+static void activate(const bob::machine::Activation& a,
+    blitz::Array<double,1>& v) {
+  if (bob::core::array::isCZeroBaseContiguous(v))
+    a.f_inplace(v.data(), v.extent(0));
+  else
+    for (int i=0; i<v.extent(0); ++i) v(i) = a.f(v(i));
+}
+
 bob::machine::MLP::MLP (size_t input, size_t output):
   m_input_sub(input),
   m_input_div(input),
@@ -231,17 +248,13 @@ void bob::machine::MLP::forward_ (const blitz::Array<double,1>& input,
   for (size_t j=1; j<m_weight.size(); ++j) {
     bob::math::prod_(m_buffer[j-1], m_weight[j-1], m_buffer[j]);
     m_buffer[j] += m_bias[j-1];
-    for (int i=0; i<m_buffer[j].extent(0); ++i) {
-      m_buffer[j](i) = m_hidden_activation->f(m_buffer[j](i));
-    }
+    activate(*m_hidden_activation, m_buffer[j]);
   }
 
   //hidden[N-1] -> output
   bob::math::prod_(m_buffer.back(), m_weight.back(), output);
   output += m_bias.back();
-  for (int i=0; i<output.extent(0); ++i) {
-    output(i) = m_output_activation->f(output(i));
-  }
+  activate(*m_output_activation, output);
 }
 
 void bob::machine::MLP::forward (const blitz::Array<double,1>& input,
@@ -261,14 +274,52 @@ void bob::machine::MLP::forward (const blitz::Array<double,1>& input,
   forward_(input, output); 
 }
 
+void bob::machine::MLP::resizeBatchBuffers(int batch_size) {
+  const size_t n_layers = m_weight.size();
+  m_batch_buffer.resize(n_layers+1);
+  for (size_t j=0; j<=n_layers; ++j) {
+    //the input of layer j, the last one being the output of the network
+    const int size = (j < n_layers) ? m_weight[j].extent(0) :
+      m_weight.back().extent(1);
+    if (m_batch_buffer[j].extent(0) < batch_size ||
+        m_batch_buffer[j].extent(1) != size)
+      m_batch_buffer[j].resize(batch_size, size);
+  }
+}
+
 void bob::machine::MLP::forward_ (const blitz::Array<double,2>& input,
     blitz::Array<double,2>& output) {
 
+  const int n_samples = input.extent(0);
+  if (!n_samples) return;
+  resizeBatchBuffers(std::min(n_samples, MLP_BATCH_SIZE));
+
+  const size_t n_layers = m_weight.size();
   blitz::Range all = blitz::Range::all();
-  for (int i=0; i<input.extent(0); ++i) {
-    blitz::Array<double,1> inref(input(i,all));
-    blitz::Array<double,1> outref(output(i,all));
-    forward_(inref, outref);
+  for (int b=0; b<n_samples; b+=MLP_BATCH_SIZE) {
+    const int n = std::min(MLP_BATCH_SIZE, n_samples-b);
+    blitz::Range rows(0, n-1);
+
+    //normalizes the inputs of the mini-batch
+    blitz::Array<double,2> x = m_batch_buffer[0](rows, all);
+    for (int i=0; i<n; ++i)
+      for (int k=0; k<x.extent(1); ++k)
+        x(i,k) = (input(b+i,k) - m_input_sub(k)) / m_input_div(k);
+
+    //each layer is a matrix-matrix product on the whole mini-batch
+    for (size_t j=0; j<n_layers; ++j) {
+      blitz::Array<double,2> y = m_batch_buffer[j+1](rows, all);
+      bob::math::prod_(x, m_weight[j], y);
+      const blitz::Array<double,1>& bias = m_bias[j];
+      for (int i=0; i<n; ++i)
+        for (int k=0; k<y.extent(1); ++k) y(i,k) += bias(k);
+      const bob::machine::Activation& activation = (j+1 < n_layers) ?
+        *m_hidden_activation : *m_output_activation;
+      activation.f_inplace(y.data(), n * y.extent(1));
+      x.reference(y);
+    }
+
+    output(blitz::Range(b, b+n-1), all) = x;
   }
 }
 
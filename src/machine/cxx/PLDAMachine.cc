@@ -23,15 +23,44 @@
 #include <bob/core/assert.h>
 #include <bob/core/check.h>
 #include <bob/core/array_copy.h>
+#include <bob/core/parallel.h>
 #include <bob/machine/PLDAMachine.h>
 #include <bob/math/linear.h>
 #include <bob/math/det.h>
 #include <bob/math/inv.h>
 
+#include <algorithm>
 #include <cmath>
+#include <boost/bind.hpp>
 #include <boost/lexical_cast.hpp>
 #include <string>
 
+bob::machine::PLDAMachineWorkspace::PLDAMachineWorkspace()
+{
+}
+
+bob::machine::PLDAMachineWorkspace::PLDAMachineWorkspace(const size_t dim_d,
+    const size_t dim_f)
+{
+  resize(dim_d, dim_f);
+}
+
+void bob::machine::PLDAMachineWorkspace::resize(const size_t dim_d,
+  const size_t dim_f)
+{
+  if (tmp_d_1.extent(0) != (int)dim_d) {
+    tmp_d_1.resize(dim_d);
+    tmp_d_2.resize(dim_d);
+  }
+  if (tmp_nf_1.extent(0) != (int)dim_f) {
+    gamma.resize(dim_f, dim_f);
+    tmp_nf_1.resize(dim_f);
+    tmp_nf_2.resize(dim_f);
+    tmp_nf_nf_1.resize(dim_f, dim_f);
+  }
+}
+
+
 bob::machine::PLDABase::PLDABase():
   m_variance_threshold(0.)
 {
@@ -492,20 +521,28 @@ void bob::machine::PLDABase::precomputeFtBeta()
 
 void bob::machine::PLDABase::computeGamma(const size_t a, 
   blitz::Array<double,2> res) const
+{
+  computeGamma(a, res, m_tmp_nf_nf_1);
+}
+
+void bob::machine::PLDABase::computeGamma(const size_t a, 
+  blitz::Array<double,2>& res, blitz::Array<double,2>& tmp_nf_nf) const
 {
   // gamma = (Id + a.F^T.beta.F)^-1
 
   // Checks destination size
-  bob::core::array::assertSameShape(res, m_tmp_nf_nf_1);
-  // m_tmp_nf_nf_1 = F^T.beta.F
-  bob::math::prod(m_cache_Ft_beta, m_F, m_tmp_nf_nf_1);
-   // m_tmp_nf_nf_1 = a.F^T.beta.F
-  m_tmp_nf_nf_1 *= static_cast<double>(a);
-  // m_tmp_nf_nf_1 = Id + a.F^T.beta.F
-  for(int i=0; i<m_tmp_nf_nf_1.extent(0); ++i) m_tmp_nf_nf_1(i,i) += 1;
+  const blitz::TinyVector<int,2> shape(m_dim_f, m_dim_f);
+  bob::core::array::assertSameShape(res, shape);
+  bob::core::array::assertSameShape(tmp_nf_nf, shape);
+  // tmp_nf_nf = F^T.beta.F
+  bob::math::prod(m_cache_Ft_beta, m_F, tmp_nf_nf);
+   // tmp_nf_nf = a.F^T.beta.F
+  tmp_nf_nf *= static_cast<double>(a);
+  // tmp_nf_nf = Id + a.F^T.beta.F
+  for(int i=0; i<tmp_nf_nf.extent(0); ++i) tmp_nf_nf(i,i) += 1;
 
   // res = (Id + a.F^T.beta.F)^-1
-  bob::math::inv(m_tmp_nf_nf_1, res);
+  bob::math::inv(tmp_nf_nf, res);
 }
 
 void bob::machine::PLDABase::precomputeLogDetAlpha()
@@ -561,6 +598,54 @@ void bob::machine::PLDABase::clearMaps()
   m_cache_loglike_constterm.clear();
 }
 
+void bob::machine::PLDABase::precomputeGammaLogLike(const std::vector<size_t>& a)
+{
+  // Inserts the missing entries first, such that the maps are not modified
+  // by the threads
+  std::vector<size_t> missing;
+  std::vector<bool> compute_gamma;
+  std::vector<blitz::Array<double,2>*> gamma;
+  for (size_t k=0; k<a.size(); ++k)
+  {
+    if (hasLogLikeConstTerm(a[k]) ||
+        std::find(missing.begin(), missing.end(), a[k]) != missing.end())
+      continue;
+    missing.push_back(a[k]);
+    compute_gamma.push_back(!hasGamma(a[k]));
+    if (compute_gamma.back())
+      m_cache_gamma[a[k]].reference(blitz::Array<double,2>(m_dim_f, m_dim_f));
+    gamma.push_back(&m_cache_gamma[a[k]]);
+  }
+  if (missing.empty()) return;
+
+  // One working array per thread
+  std::vector<double> constterm(missing.size());
+  std::vector<blitz::Array<double,2> > tmp_nf_nf(bob::core::getNThreads());
+  for (size_t t=0; t<tmp_nf_nf.size(); ++t)
+    tmp_nf_nf[t].resize(m_dim_f, m_dim_f);
+  bob::core::parallelFor(0, missing.size(),
+    boost::bind(&bob::machine::PLDABase::computeGammaLogLike, this,
+      boost::cref(missing), boost::cref(compute_gamma), boost::cref(gamma),
+      boost::ref(constterm), boost::ref(tmp_nf_nf), _1, _2, _3), 1);
+
+  for (size_t k=0; k<missing.size(); ++k)
+    m_cache_loglike_constterm[missing[k]] = constterm[k];
+}
+
+void bob::machine::PLDABase::computeGammaLogLike(const std::vector<size_t>& a,
+  const std::vector<bool>& compute_gamma,
+  const std::vector<blitz::Array<double,2>*>& gamma,
+  std::vector<double>& constterm,
+  std::vector<blitz::Array<double,2> >& tmp_nf_nf,
+  size_t begin, size_t end, size_t thread) const
+{
+  for (size_t k=begin; k<end; ++k)
+  {
+    if (compute_gamma[k]) computeGamma(a[k], *gamma[k], tmp_nf_nf[thread]);
+    constterm[k] = computeLogLikeConstTerm(a[k], *gamma[k]);
+  }
+}
+
 double bob::machine::PLDABase::computeLogLikelihoodPointEstimate(
   const blitz::Array<double,1>& xij, const blitz::Array<double,1>& hi, 
   const blitz::Array<double,1>& wij) const
@@ -952,6 +1037,120 @@ double bob::machine::PLDAMachine::computeLogLikelihood(const blitz::Array<double
   return log_likelihood;
 }
 
+void bob::machine::PLDAMachine::forward(const blitz::Array<double,1>& sample,
+  double& score, bob::machine::PLDAMachineWorkspace& ws) const
+{
+  // Computes the log likelihood ratio
+  score = computeLogLikelihood(sample, true, ws) - // match
+          (computeLogLikelihood(sample, false, ws) + m_loglikelihood); // no match
+}
+
+void bob::machine::PLDAMachine::forward(const blitz::Array<double,2>& samples,
+  double& score, bob::machine::PLDAMachineWorkspace& ws) const
+{
+  // Computes the log likelihood ratio
+  score = computeLogLikelihood(samples, true, ws) - // match
+          (computeLogLikelihood(samples, false, ws) + m_loglikelihood); // no match
+}
+
+double bob::machine::PLDAMachine::computeLogLikelihood(const blitz::Array<double,1>& sample,
+  bool enrol, bob::machine::PLDAMachineWorkspace& ws) const
+{
+  if (!m_plda_base) throw std::runtime_error("No PLDABase set to this machine");
+  // Check dimensionality
+  bob::core::array::assertSameDimensionLength(sample.extent(0), getDimD());
+  ws.resize(getDimD(), getDimF());
+
+  const size_t n_samples = 1 + (enrol?m_n_samples:0);
+  const blitz::Array<double,2>& beta = m_plda_base->getBeta();
+  const blitz::Array<double,2>& Ft_beta = m_plda_base->getFtBeta();
+  const blitz::Array<double,1>& mu = m_plda_base->getMu();
+  double terma = (enrol?m_nh_sum_xit_beta_xi:0.);
+  // sumWeighted
+  if (enrol && m_n_samples > 0) ws.tmp_nf_1 = m_weighted_sum;
+  else ws.tmp_nf_1 = 0;
+
+  // terma += -1 / 2. * (xi^t*beta*xi)
+  // (the sample is read by element, as it may be shared between threads)
+  for (int d=0; d<ws.tmp_d_1.extent(0); ++d) ws.tmp_d_1(d) = sample(d) - mu(d);
+  bob::math::prod(beta, ws.tmp_d_1, ws.tmp_d_2);
+  terma += -1 / 2. * (blitz::sum(ws.tmp_d_1*ws.tmp_d_2));
+
+  // sumWeighted
+  bob::math::prod(Ft_beta, ws.tmp_d_1, ws.tmp_nf_2);
+  ws.tmp_nf_1 += ws.tmp_nf_2;
+
+  return finalizeLogLikelihood(n_samples, terma, ws);
+}
+
+double bob::machine::PLDAMachine::computeLogLikelihood(const blitz::Array<double,2>& samples,
+  bool enrol, bob::machine::PLDAMachineWorkspace& ws) const
+{
+  if (!m_plda_base) throw std::runtime_error("No PLDABase set to this machine");
+  // Check dimensionality
+  bob::core::array::assertSameDimensionLength(samples.extent(1), getDimD());
+  ws.resize(getDimD(), getDimF());
+
+  const size_t n_samples = samples.extent(0) + (enrol?m_n_samples:0);
+  const blitz::Array<double,2>& beta = m_plda_base->getBeta();
+  const blitz::Array<double,2>& Ft_beta = m_plda_base->getFtBeta();
+  const blitz::Array<double,1>& mu = m_plda_base->getMu();
+  double terma = (enrol?m_nh_sum_xit_beta_xi:0.);
+  // sumWeighted
+  if (enrol && m_n_samples > 0) ws.tmp_nf_1 = m_weighted_sum;
+  else ws.tmp_nf_1 = 0;
+  for (int k=0; k<samples.extent(0); ++k)
+  {
+    for (int d=0; d<ws.tmp_d_1.extent(0); ++d)
+      ws.tmp_d_1(d) = samples(k,d) - mu(d);
+    // terma += -1 / 2. * (xi^t*beta*xi)
+    bob::math::prod(beta, ws.tmp_d_1, ws.tmp_d_2);
+    terma += -1 / 2. * (blitz::sum(ws.tmp_d_1*ws.tmp_d_2));
+
+    // sumWeighted
+    bob::math::prod(Ft_beta, ws.tmp_d_1, ws.tmp_nf_2);
+    ws.tmp_nf_1 += ws.tmp_nf_2;
+  }
+
+  return finalizeLogLikelihood(n_samples, terma, ws);
+}
+
+double bob::machine::PLDAMachine::finalizeLogLikelihood(const size_t n_samples,
+  const double terma, bob::machine::PLDAMachineWorkspace& ws) const
+{
+  // gamma_a is looked up in the base machine and in this machine, and is
+  // computed into the workspace otherwise (none of the maps is updated)
+  const blitz::Array<double,2>* gamma_a;
+  if (m_plda_base->hasGamma(n_samples))
+    gamma_a = &m_plda_base->getGamma(n_samples);
+  else if (hasGamma(n_samples))
+    gamma_a = &(m_cache_gamma.find(n_samples)->second);
+  else
+  {
+    m_plda_base->computeGamma(n_samples, ws.gamma, ws.tmp_nf_nf_1);
+    gamma_a = &ws.gamma;
+  }
+  bob::math::prod(*gamma_a, ws.tmp_nf_1, ws.tmp_nf_2);
+  double termb = 1 / 2. * (blitz::sum(ws.tmp_nf_1*ws.tmp_nf_2));
+
+  // 1/2/ Constant term of the log likelihood (see above)
+  double log_likelihood;
+  if (m_plda_base->hasLogLikeConstTerm(n_samples))
+    log_likelihood = m_plda_base->getLogLikeConstTerm(n_samples);
+  else if (hasLogLikeConstTerm(n_samples))
+    log_likelihood = m_cache_loglike_constterm.find(n_samples)->second;
+  else
+  {
+    // The determinant is computed on a copy owned by the workspace, as
+    // bob::math::det() creates views of its input
+    if (gamma_a != &ws.gamma) ws.gamma = *gamma_a;
+    log_likelihood = m_plda_base->computeLogLikeConstTerm(n_samples, ws.gamma);
+  }
+
+  log_likelihood += terma + termb;
+  return log_likelihood;
+}
+
 void bob::machine::PLDAMachine::resize(const size_t dim_d, const size_t dim_f, 
   const size_t dim_g)
 {
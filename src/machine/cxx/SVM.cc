@@ -26,14 +26,18 @@
 #include <boost/algorithm/string.hpp>
 #include <boost/filesystem.hpp>
 #include <bob/machine/SVM.h>
+#include <bob/core/assert.h>
 #include <bob/core/check.h>
 #include <bob/core/logging.h>
+#include <bob/core/parallel.h>
+#include <boost/bind.hpp>
 #include <cstdio>
 #include <cstdlib>
 #include <fstream>
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <algorithm>
+#include <vector>
 
 static bool is_colon(char i) { return i == ':'; }
 
@@ -224,13 +228,99 @@ void bob::machine::SupportVector::reset() {
     }
   }
 
-  //create and reset cache
-  m_input_cache.reset(new svm_node[1 + m_input_size]);
-
   m_input_sub.resize(inputSize());
   m_input_sub = 0.0;
   m_input_div.resize(inputSize());
   m_input_div = 1.0;
+
+  packModel();
+}
+
+void bob::machine::SupportVector::packModel() {
+  const int l = m_model->l;
+  const int d = m_input_size;
+  const int nr_class = m_model->nr_class;
+  const bool classification = (machineType() == C_SVC ||
+      machineType() == NU_SVC);
+  m_n_decisions = classification ? nr_class*(nr_class-1)/2 : 1;
+  //with more than 3 classes, there are more decision values than scores:
+  //the scores only keep the first outputSize() decision values
+  m_n_scores = outputSize();
+  if (m_n_scores > m_n_decisions) {
+    boost::format s("this SVM has %d outputs, but only %d decision values");
+    s % m_n_scores % m_n_decisions;
+    throw std::runtime_error(s.str());
+  }
+
+  //precomputed kernels cannot be evaluated from the support vectors
+  if (kernelType() == PRECOMPUTED) {
+    m_sv.resize(0, 0);
+    m_sv_start.resize(0);
+    m_linear_weights.resize(0, 0);
+    m_linear_bound.resize(0);
+    return;
+  }
+
+  //support vectors, one per row
+  m_sv.resize(l, d);
+  m_sv = 0.;
+  for (int k=0; k<l; ++k) {
+    for (const svm_node* node = m_model->SV[k]; node->index != -1; ++node)
+      m_sv(k, node->index-1) = node->value;
+  }
+
+  //first support vector of each class (classification only)
+  m_sv_start.resize(classification ? nr_class+1 : 0);
+  if (classification) {
+    m_sv_start(0) = 0;
+    for (int i=0; i<nr_class; ++i)
+      m_sv_start(i+1) = m_sv_start(i) + m_model->nSV[i];
+  }
+
+  if (kernelType() != LINEAR) {
+    m_linear_weights.resize(0, 0);
+    m_linear_bound.resize(0);
+    return;
+  }
+
+  //collapses the linear decision functions into one weight vector each.
+  //The bound is the sum of the magnitudes of the terms of a decision
+  //function for a unit-norm input, which gives the rounding error of both
+  //the collapsed and the libsvm computations.
+  blitz::Array<double,1> sv_norm(l);
+  for (int k=0; k<l; ++k) {
+    double sum = 0.;
+    for (int j=0; j<d; ++j) sum += m_sv(k,j) * m_sv(k,j);
+    sv_norm(k) = std::sqrt(sum);
+  }
+  m_linear_weights.resize(m_n_decisions, d);
+  m_linear_weights = 0.;
+  m_linear_bound.resize(m_n_decisions);
+  m_linear_bound = 0.;
+  if (classification) {
+    int p = 0;
+    for (int i=0; i<nr_class; ++i) {
+      for (int j=i+1; j<nr_class; ++j, ++p) {
+        const double* coef1 = m_model->sv_coef[j-1];
+        const double* coef2 = m_model->sv_coef[i];
+        for (int k=m_sv_start(i); k<m_sv_start(i+1); ++k) {
+          for (int c=0; c<d; ++c) m_linear_weights(p,c) += coef1[k] * m_sv(k,c);
+          m_linear_bound(p) += std::fabs(coef1[k]) * sv_norm(k);
+        }
+        for (int k=m_sv_start(j); k<m_sv_start(j+1); ++k) {
+          for (int c=0; c<d; ++c) m_linear_weights(p,c) += coef2[k] * m_sv(k,c);
+          m_linear_bound(p) += std::fabs(coef2[k]) * sv_norm(k);
+        }
+      }
+    }
+  }
+  else {
+    const double* coef = m_model->sv_coef[0];
+    for (int k=0; k<l; ++k) {
+      for (int c=0; c<d; ++c) m_linear_weights(0,c) += coef[k] * m_sv(k,c);
+      m_linear_bound(0) += std::fabs(coef[k]) * sv_norm(k);
+    }
+  }
 }
 
 bob::machine::SupportVector::SupportVector(const std::string& model_file):
@@ -339,30 +429,247 @@ void bob::machine::SupportVector::setInputDivision(const blitz::Array<double,1>&
 }
 
 /**
- * Copies the user input to a locally pre-allocated cache. Apply normalization
- * at the same occasion.
+ * Number of inputs whose kernel values are computed together
  */
-static inline void copy(const blitz::Array<double,1>& input,
-    boost::shared_array<svm_node>& cache, const blitz::Array<double,1>& sub,
-    const blitz::Array<double,1>& div) {
+static const int SVM_TILE_SIZE = 16;
 
-  size_t cur = 0; ///< currently used index
+/**
+ * Minimum number of inputs processed by each thread in the batch predictions
+ */
+static const size_t SVM_BATCH_SIZE = 64;
+
+/**
+ * Relative tolerance on the decision values of the collapsed linear model.
+ * Decision values smaller than this (relatively to the magnitude of their
+ * terms) might not have the same sign as the ones of libsvm, and are
+ * recomputed from the support vectors.
+ */
+static const double SVM_LINEAR_TOLERANCE = 1e-9;
+
+/**
+ * Same as libsvm's powi(), used by the polynomial kernel
+ */
+static inline double powi(double base, int times) {
+  double tmp = base, ret = 1.0;
+  for (int t=times; t>0; t/=2) {
+    if (t%2 == 1) ret *= tmp;
+    tmp = tmp * tmp;
+  }
+  return ret;
+}
 
-  for (size_t k=0; k<(size_t)input.extent(0); ++k) {
-    double tmp = (input(k) - sub(k))/div(k);
-    if (!tmp) continue;
-    cache[cur].index = k+1;
-    cache[cur].value = tmp;
+/**
+ * Converts a dense (scaled) input to the sparse libsvm format. Zero values
+ * are skipped.
+ */
+static void to_nodes(const double* x, const int d,
+    std::vector<svm_node>& nodes) {
+  nodes.resize(d+1);
+  size_t cur = 0; ///< currently used index
+  for (int k=0; k<d; ++k) {
+    if (!x[k]) continue;
+    nodes[cur].index = k+1;
+    nodes[cur].value = x[k];
     ++cur;
   }
+  nodes[cur].index = -1; //libsvm detects end of input if index==-1
+}
+
+void bob::machine::SupportVector::scaleInput
+(const blitz::Array<double,1>& input, double* x) const {
+  const int lb = input.lbound(0);
+  for (int k=0; k<(int)m_input_size; ++k)
+    x[k] = (input(lb+k) - m_input_sub(k)) / m_input_div(k);
+}
+
+void bob::machine::SupportVector::scaleInput
+(const blitz::Array<double,2>& input, const int row, double* x) const {
+  for (int k=0; k<(int)m_input_size; ++k)
+    x[k] = (input(row,k) - m_input_sub(k)) / m_input_div(k);
+}
+
+void bob::machine::SupportVector::kernelValues
+(const double* x, const int n, double* kvalue) const {
+  const int l = m_model->l;
+  const int d = m_input_size;
+  const bool rbf = (kernelType() == RBF);
+
+  // Squared distances (RBF) or dot products (other kernels). The terms are
+  // summed by increasing index, as libsvm does (the zero terms it skips do
+  // not change the sums). Each support vector is loaded once for four
+  // inputs.
+  const double* sv = m_sv.data();
+  for (int s=0; s<l; ++s, sv+=d) {
+    int i = 0;
+    for (; i+4<=n; i+=4) {
+      const double* x0 = x + i*d;
+      const double* x1 = x0 + d;
+      const double* x2 = x1 + d;
+      const double* x3 = x2 + d;
+      double a0 = 0., a1 = 0., a2 = 0., a3 = 0.;
+      if (rbf) {
+        for (int j=0; j<d; ++j) {
+          const double t0 = x0[j] - sv[j];
+          const double t1 = x1[j] - sv[j];
+          const double t2 = x2[j] - sv[j];
+          const double t3 = x3[j] - sv[j];
+          a0 += t0*t0; a1 += t1*t1; a2 += t2*t2; a3 += t3*t3;
+        }
+      }
+      else {
+        for (int j=0; j<d; ++j) {
+          a0 += x0[j]*sv[j]; a1 += x1[j]*sv[j];
+          a2 += x2[j]*sv[j]; a3 += x3[j]*sv[j];
+        }
+      }
+      kvalue[i*l+s] = a0;
+      kvalue[(i+1)*l+s] = a1;
+      kvalue[(i+2)*l+s] = a2;
+      kvalue[(i+3)*l+s] = a3;
+    }
+    for (; i<n; ++i) {
+      const double* xi = x + i*d;
+      double a = 0.;
+      if (rbf) {
+        for (int j=0; j<d; ++j) {
+          const double t = xi[j] - sv[j];
+          a += t*t;
+        }
+      }
+      else {
+        for (int j=0; j<d; ++j) a += xi[j]*sv[j];
+      }
+      kvalue[i*l+s] = a;
+    }
+  }
+
+  // Kernel functions
+  const int size = n*l;
+  const double gamma = m_model->param.gamma;
+  const double coef0 = m_model->param.coef0;
+  const int degree = m_model->param.degree;
+  switch (kernelType()) {
+    case POLY:
+      for (int k=0; k<size; ++k)
+        kvalue[k] = powi(gamma*kvalue[k]+coef0, degree);
+      break;
+    case RBF:
+      for (int k=0; k<size; ++k) kvalue[k] = std::exp(-gamma*kvalue[k]);
+      break;
+    case SIGMOID:
+      for (int k=0; k<size; ++k) kvalue[k] = std::tanh(gamma*kvalue[k]+coef0);
+      break;
+    default: //LINEAR
+      break;
+  }
+}
+
+double bob::machine::SupportVector::decide
+(const double* kvalue, double* dec) const {
+  if (machineType() != C_SVC && machineType() != NU_SVC) {
+    const double* coef = m_model->sv_coef[0];
+    double sum = 0.;
+    for (int k=0; k<m_model->l; ++k) sum += coef[k] * kvalue[k];
+    sum -= m_model->rho[0];
+    dec[0] = sum;
+    if (machineType() == ONE_CLASS) return (sum > 0) ? 1 : -1;
+    return sum;
+  }
+
+  const int nr_class = m_model->nr_class;
+  std::vector<int> vote(nr_class, 0);
+  int p = 0;
+  for (int i=0; i<nr_class; ++i) {
+    for (int j=i+1; j<nr_class; ++j, ++p) {
+      const double* coef1 = m_model->sv_coef[j-1];
+      const double* coef2 = m_model->sv_coef[i];
+      double sum = 0.;
+      for (int k=m_sv_start(i); k<m_sv_start(i+1); ++k)
+        sum += coef1[k] * kvalue[k];
+      for (int k=m_sv_start(j); k<m_sv_start(j+1); ++k)
+        sum += coef2[k] * kvalue[k];
+      sum -= m_model->rho[p];
+      dec[p] = sum;
+      if (sum > 0) ++vote[i];
+      else ++vote[j];
+    }
+  }
+  int vote_max_idx = 0;
+  for (int i=1; i<nr_class; ++i)
+    if (vote[i] > vote[vote_max_idx]) vote_max_idx = i;
+  return m_model->label[vote_max_idx];
+}
+
+bool bob::machine::SupportVector::decideLinear
+(const double* x, double* dec, double& retval) const {
+  const int d = m_input_size;
+  double norm = 0.;
+  for (int j=0; j<d; ++j) norm += x[j]*x[j];
+  norm = std::sqrt(norm);
+
+  const bool classification = (machineType() == C_SVC ||
+      machineType() == NU_SVC);
+  for (int p=0; p<(int)m_n_decisions; ++p) {
+    const double* w = &m_linear_weights(p,0);
+    double sum = 0.;
+    for (int j=0; j<d; ++j) sum += w[j]*x[j];
+    const double rho = m_model->rho[p];
+    sum -= rho;
+    // The regression output has no sign to preserve
+    if (machineType() != EPSILON_SVR && machineType() != NU_SVR &&
+        std::fabs(sum) <= SVM_LINEAR_TOLERANCE *
+          (norm * m_linear_bound(p) + std::fabs(rho)))
+      return false;
+    dec[p] = sum;
+  }
+
+  if (!classification) {
+    retval = (machineType() == ONE_CLASS) ? ((dec[0] > 0) ? 1 : -1) : dec[0];
+    return true;
+  }
+
+  const int nr_class = m_model->nr_class;
+  std::vector<int> vote(nr_class, 0);
+  int p = 0;
+  for (int i=0; i<nr_class; ++i) {
+    for (int j=i+1; j<nr_class; ++j, ++p) {
+      if (dec[p] > 0) ++vote[i];
+      else ++vote[j];
+    }
+  }
+  int vote_max_idx = 0;
+  for (int i=1; i<nr_class; ++i)
+    if (vote[i] > vote[vote_max_idx]) vote_max_idx = i;
+  retval = m_model->label[vote_max_idx];
+  return true;
+}
+
+double bob::machine::SupportVector::predict
+(const double* x, double* kvalue, double* dec) const {
+  if (kernelType() == PRECOMPUTED) {
+    std::vector<svm_node> nodes;
+    to_nodes(x, m_input_size, nodes);
+#if LIBSVM_VERSION > 290
+    return svm_predict_values(m_model.get(), &nodes[0], dec);
+#else
+    svm_predict_values(m_model.get(), &nodes[0], dec);
+    return svm_predict(m_model.get(), &nodes[0]);
+#endif
+  }
 
-  cache[cur].index = -1; //libsvm detects end of input if index==-1
+  double retval;
+  if (kernelType() == LINEAR && decideLinear(x, dec, retval)) return retval;
+  kernelValues(x, 1, kvalue);
+  return decide(kvalue, dec);
 }
 
 int bob::machine::SupportVector::predictClass_
 (const blitz::Array<double,1>& input) const {
-  copy(input, m_input_cache, m_input_sub, m_input_div);
-  int retval = round(svm_predict(m_model.get(), m_input_cache.get()));
+  std::vector<double> x(m_input_size);
+  std::vector<double> kvalue(m_model->l);
+  std::vector<double> dec(m_n_decisions);
+  scaleInput(input, &x[0]);
+  int retval = round(predict(&x[0], &kvalue[0], &dec[0]));
   return retval;
 }
 
@@ -381,13 +688,12 @@ int bob::machine::SupportVector::predictClass
 int bob::machine::SupportVector::predictClassAndScores_
 (const blitz::Array<double,1>& input,
  blitz::Array<double,1>& scores) const {
-  copy(input, m_input_cache, m_input_sub, m_input_div);
-#if LIBSVM_VERSION > 290
-  int retval = round(svm_predict_values(m_model.get(), m_input_cache.get(), scores.data()));
-#else
-  svm_predict_values(m_model.get(), m_input_cache.get(), scores.data());
-  int retval = round(svm_predict(m_model.get(), m_input_cache.get()));
-#endif
+  std::vector<double> x(m_input_size);
+  std::vector<double> kvalue(m_model->l);
+  std::vector<double> dec(m_n_decisions);
+  scaleInput(input, &x[0]);
+  int retval = round(predict(&x[0], &kvalue[0], &dec[0]));
+  std::copy(dec.begin(), dec.begin() + m_n_scores, scores.data());
   return retval;
 }
 
@@ -417,8 +723,11 @@ int bob::machine::SupportVector::predictClassAndScores
 int bob::machine::SupportVector::predictClassAndProbabilities_
 (const blitz::Array<double,1>& input,
  blitz::Array<double,1>& probabilities) const {
-  copy(input, m_input_cache, m_input_sub, m_input_div);
-  int retval = round(svm_predict_probability(m_model.get(), m_input_cache.get(), probabilities.data()));
+  std::vector<double> x(m_input_size);
+  std::vector<svm_node> nodes;
+  scaleInput(input, &x[0]);
+  to_nodes(&x[0], m_input_size, nodes);
+  int retval = round(svm_predict_probability(m_model.get(), &nodes[0], probabilities.data()));
   return retval;
 }
 
@@ -449,6 +758,89 @@ int bob::machine::SupportVector::predictClassAndProbabilities
   return predictClassAndProbabilities_(input, probabilities);
 }
 
+void bob::machine::SupportVector::predictRows
+(const blitz::Array<double,2>& input, blitz::Array<int,1>& labels,
+ blitz::Array<double,2>& scores, const bool with_scores, size_t begin,
+ size_t end, size_t thread_idx) const {
+  const int d = m_input_size;
+  const int l = m_model->l;
+  const int n_scores = with_scores ? (int)m_n_scores : 0;
+  // Thread-local buffers
+  std::vector<double> x(SVM_TILE_SIZE*d);
+  std::vector<double> kvalue(SVM_TILE_SIZE*l);
+  std::vector<double> dec(m_n_decisions);
+  // The kernel values of a tile of inputs are computed together, except for
+  // the models which do not need them
+  const bool tiled = (kernelType() != LINEAR && kernelType() != PRECOMPUTED);
+
+  for (size_t b=begin; b<end; b+=SVM_TILE_SIZE) {
+    const int n = std::min(end-b, (size_t)SVM_TILE_SIZE);
+    for (int i=0; i<n; ++i) scaleInput(input, (int)b+i, &x[i*d]);
+    if (tiled) kernelValues(&x[0], n, &kvalue[0]);
+    for (int i=0; i<n; ++i) {
+      const int r = (int)b+i;
+      const double retval = tiled ?
+        decide(&kvalue[i*l], &dec[0]) : predict(&x[i*d], &kvalue[0], &dec[0]);
+      labels(r) = round(retval);
+      for (int k=0; k<n_scores; ++k) scores(r,k) = dec[k];
+    }
+  }
+}
+
+void bob::machine::SupportVector::predictClass_
+(const blitz::Array<double,2>& input, blitz::Array<int,1>& labels) const {
+  blitz::Array<double,2> scores;
+  bob::core::parallelFor(0, input.extent(0),
+    boost::bind(&bob::machine::SupportVector::predictRows, this,
+      boost::cref(input), boost::ref(labels), boost::ref(scores), false,
+      _1, _2, _3),
+    SVM_BATCH_SIZE);
+}
+
+void bob::machine::SupportVector::predictClass
+(const blitz::Array<double,2>& input, blitz::Array<int,1>& labels) const {
+  bob::core::array::assertZeroBase(input);
+  bob::core::array::assertZeroBase(labels);
+  if ((size_t)input.extent(1) != inputSize()) {
+    boost::format s("input for this SVM should have %d columns, but you provided an array with %d columns instead");
+    s % inputSize() % input.extent(1);
+    throw std::runtime_error(s.str());
+  }
+  bob::core::array::assertSameDimensionLength(labels.extent(0),
+    input.extent(0));
+
+  predictClass_(input, labels);
+}
+
+void bob::machine::SupportVector::predictClassAndScores_
+(const blitz::Array<double,2>& input, blitz::Array<int,1>& labels,
+ blitz::Array<double,2>& scores) const {
+  bob::core::parallelFor(0, input.extent(0),
+    boost::bind(&bob::machine::SupportVector::predictRows, this,
+      boost::cref(input), boost::ref(labels), boost::ref(scores), true,
+      _1, _2, _3),
+    SVM_BATCH_SIZE);
+}
+
+void bob::machine::SupportVector::predictClassAndScores
+(const blitz::Array<double,2>& input, blitz::Array<int,1>& labels,
+ blitz::Array<double,2>& scores) const {
+  bob::core::array::assertZeroBase(input);
+  bob::core::array::assertZeroBase(labels);
+  bob::core::array::assertZeroBase(scores);
+  if ((size_t)input.extent(1) != inputSize()) {
+    boost::format s("input for this SVM should have %d columns, but you provided an array with %d columns instead");
+    s % inputSize() % input.extent(1);
+    throw std::runtime_error(s.str());
+  }
+  bob::core::array::assertSameDimensionLength(labels.extent(0),
+    input.extent(0));
+  const blitz::TinyVector<int,2> shape(input.extent(0), outputSize());
+  bob::core::array::assertSameShape(scores, shape);
+
+  predictClassAndScores_(input, labels, scores);
+}
+
 void bob::machine::SupportVector::save(const std::string& filename) const {
   if (svm_save_model(filename.c_str(), m_model.get())) {
     boost::format s("cannot save SVM model to file '%s'");
@@ -21,12 +21,57 @@
 
 #include <bob/machine/ZTNorm.h>
 #include <bob/core/assert.h>
+#include <bob/core/parallel.h>
+#include <boost/bind.hpp>
+#include <boost/format.hpp>
+#include <algorithm>
+#include <functional>
 #include <limits>
+#include <stdexcept>
 
 namespace bob { 
 namespace machine {
 
 namespace detail {
+  /**
+   * Number of scores read at once from a dataset of scores, which bounds
+   * the memory used when streaming score files
+   */
+  static const size_t ZTNORM_FILE_BLOCK = 1 << 22;
+
+  /**
+   * Standard deviations below this value are considered as 0, and replaced
+   * by 1
+   */
+  static const double ZTNORM_EPSILON = std::numeric_limits<double>::min();
+
+  /**
+   * Returns the number of arrays and their length of a dataset of 1D arrays
+   */
+  static void describeScores(bob::io::HDF5File& file, const std::string& path,
+                             size_t& n_rows, size_t& n_columns)
+  {
+    const std::vector<bob::io::HDF5Descriptor>& descriptors = file.describe(path);
+    for (size_t k=0; k<descriptors.size(); ++k) {
+      if (descriptors[k].type.shape().n() == 1) {
+        n_rows = descriptors[k].size;
+        n_columns = descriptors[k].type.shape()[0];
+        return;
+      }
+    }
+    boost::format m("ZTNormalizer: the dataset '%s' of file '%s' does not contain arrays of scores");
+    m % path % file.filename();
+    throw std::runtime_error(m.str());
+  }
+
+  /**
+   * Number of rows of a dataset of scores read at once
+   */
+  static size_t rowsPerBlock(const size_t n_columns)
+  {
+    return std::max((size_t)1, ZTNORM_FILE_BLOCK / std::max((size_t)1, n_columns));
+  }
+
   void ztNorm(const blitz::Array<double,2>& rawscores_probes_vs_models,
               const blitz::Array<double,2>* rawscores_zprobes_vs_models,
               const blitz::Array<double,2>* rawscores_probes_vs_tmodels,
@@ -75,88 +120,338 @@ namespace detail {
     bob::core::array::assertSameDimensionLength(scores.extent(0), size_eval);
     bob::core::array::assertSameDimensionLength(scores.extent(1), size_enrol);
 
-    // Declare needed IndexPlaceholder
-    blitz::firstIndex ii;
-    blitz::secondIndex jj;
-
-    // Constant to check if the std is close to 0. 
-    const double eps = std::numeric_limits<double>::min();
-    
-    // zA
-    blitz::Array<double,2> zA(A.shape());
-    if (B && size_znorm > 0) {
-      // Znorm  -->      zA  = (A - mean(B) ) / std(B)    [znorm on oringinal scores]
-      // mean(B)
-      blitz::Array<double,1> mean_B(blitz::mean(*B, jj));
-      // std(B)
-      blitz::Array<double,2> B2n(B->shape());
-      B2n = blitz::pow2((*B)(ii, jj) - mean_B(ii));
-      blitz::Array<double,1> std_B(B->extent(0));
-      if(size_znorm>1)
-        std_B = blitz::sqrt(blitz::sum(B2n, jj) / (size_znorm - 1));
-      else // 1 single value -> std = 0
-        std_B = 0; 
-      std_B = blitz::where( std_B <= eps, 1., std_B);
-
-      zA = (A(ii, jj) - mean_B(ii)) / std_B(ii);
+    // Accumulate the cohort statistics and normalize the scores, without
+    // any temporary of the size of the score matrices
+    ZTNormalizer normalizer(size_eval, size_enrol);
+    if (B && size_znorm > 0)
+      normalizer.accumulateZNorm(*B);
+    if (D && size_tnorm > 0 && size_znorm > 0) {
+      if (mask_zprobes_vs_tmodels_istruetrial)
+        normalizer.accumulateZTNorm(*D, *mask_zprobes_vs_tmodels_istruetrial);
+      else
+        normalizer.accumulateZTNorm(*D);
     }
-    else
-      zA = A;
+    if (C && size_tnorm > 0)
+      normalizer.accumulateTNorm(*C);
+    normalizer.normalize(A, 0, 0, scores);
+  }
+}
 
-    blitz::Array<double,2> zC(size_tnorm, size_enrol);
-    if (D && size_tnorm > 0 && size_znorm > 0) {
-      blitz::Array<double,1> mean_Dimp(size_tnorm);
-      blitz::Array<double,1> std_Dimp(size_tnorm);
-
-      // Compute mean_Dimp and std_Dimp = D only with impostors
-      for (int i = 0; i < size_tnorm; ++i) {
-        double sum = 0;
-        double sumsq = 0;
-        double count = 0;
-        for (int j = 0; j < size_znorm; ++j) {
-          bool keep;
-          // The second part is never executed if mask_zprobes_vs_tmodels_istruetrial==NULL
-          keep = (mask_zprobes_vs_tmodels_istruetrial == NULL) || !(*mask_zprobes_vs_tmodels_istruetrial)(i, j); //tnorm_models_spk_ids(i) != znorm_tests_spk_ids(j);
-          
-          double value = keep * (*D)(i, j);
-          sum += value;
-          sumsq += value*value;
-          count += keep;
-        }
-
-        double mean = sum / count;
-        mean_Dimp(i) = mean;
-        if (count > 1)
-          std_Dimp(i) = sqrt((sumsq - count * mean * mean) / (count -1));
-        else // 1 single value -> std = 0
-          std_Dimp(i) = 0;
-      }
+ZTNormalizer::ZTNormalizer(const size_t n_models, const size_t n_probes,
+    const size_t top_n):
+  m_n_models(n_models),
+  m_n_probes(n_probes),
+  m_top_n(top_n)
+{
+  reset();
+}
+
+void ZTNormalizer::reset()
+{
+  m_z.resize(0, m_top_n);
+  m_zt.resize(0, 0);
+  m_t.resize(0, m_top_n);
+  m_z.resize(m_n_models, m_top_n);
+  m_t.resize(m_n_probes, m_top_n);
+  m_has_z = m_has_zt = m_has_t = false;
+  m_updated = false;
+}
+
+void ZTNormalizer::Statistics::resize(const size_t n, const size_t top_n_)
+{
+  count.resize(n, 0.);
+  running_mean.resize(n, 0.);
+  m2.resize(n, 0.);
+  top_n = top_n_;
+  best.resize(top_n ? n : 0);
+}
+
+void ZTNormalizer::Statistics::add(const size_t i, const double score)
+{
+  if (top_n) {
+    // Keeps the top_n highest scores in a min-heap
+    std::vector<double>& heap = best[i];
+    if (heap.size() < top_n) {
+      heap.push_back(score);
+      std::push_heap(heap.begin(), heap.end(), std::greater<double>());
+    }
+    else if (score > heap.front()) {
+      std::pop_heap(heap.begin(), heap.end(), std::greater<double>());
+      heap.back() = score;
+      std::push_heap(heap.begin(), heap.end(), std::greater<double>());
+    }
+    return;
+  }
+  // Welford's update of the mean and of the sum of squared deviations
+  count[i] += 1.;
+  const double delta = score - running_mean[i];
+  running_mean[i] += delta / count[i];
+  m2[i] += delta * (score - running_mean[i]);
+}
 
-      // zC  = (C - mean(D)) / std(D)     [znorm the tnorm scores]
-      std_Dimp = blitz::where( std_Dimp <= eps, 1., std_Dimp);
-      zC = ((*C)(ii, jj) - mean_Dimp(ii)) / std_Dimp(ii);
+double ZTNormalizer::Statistics::mean(const size_t i) const
+{
+  // The mean of an empty distribution (e.g. if all the scores are masked)
+  // is NaN, as computed by ztNorm() before the streamed statistics
+  if (!top_n)
+    return (count[i] > 0. ? running_mean[i] : std::numeric_limits<double>::quiet_NaN());
+  const std::vector<double>& heap = best[i];
+  if (heap.empty()) return std::numeric_limits<double>::quiet_NaN();
+  double sum = 0.;
+  for (size_t k=0; k<heap.size(); ++k) sum += heap[k];
+  return sum / heap.size();
+}
+
+double ZTNormalizer::Statistics::std(const size_t i) const
+{
+  double deviation = 0.;
+  if (!top_n) {
+    // 1 single value -> std = 0
+    if (count[i] > 1.) deviation = sqrt(m2[i] / (count[i] - 1.));
+  }
+  else {
+    const std::vector<double>& heap = best[i];
+    if (heap.size() > 1) {
+      const double m = mean(i);
+      double sum = 0.;
+      for (size_t k=0; k<heap.size(); ++k) sum += (heap[k] - m) * (heap[k] - m);
+      deviation = sqrt(sum / (heap.size() - 1));
     }
-    else if (C && size_tnorm > 0)
-      zC = *C;
+  }
+  return (deviation <= detail::ZTNORM_EPSILON ? 1. : deviation);
+}
 
-    if (C && size_tnorm > 0)
-    {
-      blitz::Array<double,1> mean_zC(size_enrol);
-      blitz::Array<double,1> std_zC(size_enrol);
-      
-      // ztA = (zA - mean(zC)) / std(zC)  [ztnorm on eval scores]
-      mean_zC = blitz::mean(zC(jj, ii), jj);
-      if (size_tnorm > 1)
-        std_zC = sqrt(blitz::sum(pow(zC(jj, ii) - mean_zC(ii), 2) , jj) / (size_tnorm - 1));
-      else // 1 single value -> std = 0
-        std_zC = 0;
-      std_zC = blitz::where( std_zC <= eps, 1., std_zC);
-
-      // Normalised scores
-      scores = (zA(ii, jj) - mean_zC(jj)) /  std_zC(jj);
+void ZTNormalizer::Statistics::get(blitz::Array<double,1>& mean_,
+  blitz::Array<double,1>& std_) const
+{
+  mean_.resize(count.size());
+  std_.resize(count.size());
+  for (size_t i=0; i<count.size(); ++i) {
+    mean_(i) = mean(i);
+    std_(i) = std(i);
+  }
+}
+
+void ZTNormalizer::accumulateZRows(const blitz::Array<double,2>& scores,
+  const size_t first_model, size_t begin, size_t end, size_t)
+{
+  for (size_t r=begin; r<end; ++r)
+    for (int c=0; c<scores.extent(1); ++c)
+      m_z.add(first_model + r, scores(r,c));
+}
+
+void ZTNormalizer::accumulateZNorm(const blitz::Array<double,2>& scores,
+  const size_t first_model)
+{
+  if (first_model + scores.extent(0) > m_n_models) {
+    boost::format m("ZTNormalizer: the scores of the models %d to %d are given, whereas there are %d models");
+    m % first_model % (first_model + scores.extent(0)) % m_n_models;
+    throw std::runtime_error(m.str());
+  }
+  bob::core::parallelFor(0, scores.extent(0),
+    boost::bind(&ZTNormalizer::accumulateZRows, this, boost::cref(scores),
+      first_model, _1, _2, _3));
+  m_has_z = true;
+  m_updated = false;
+}
+
+void ZTNormalizer::accumulateZTRows(const blitz::Array<double,2>& scores,
+  const blitz::Array<bool,2>* mask, const size_t first_tmodel,
+  size_t begin, size_t end, size_t)
+{
+  for (size_t r=begin; r<end; ++r)
+    for (int c=0; c<scores.extent(1); ++c)
+      if (!mask || !(*mask)(r,c))
+        m_zt.add(first_tmodel + r, scores(r,c));
+}
+
+void ZTNormalizer::accumulateZTNorm(const blitz::Array<double,2>& scores,
+  const size_t first_tmodel)
+{
+  if (m_has_t)
+    throw std::runtime_error("ZTNormalizer: the scores of the T-norm models against the Z-norm probes should be accumulated before the T-norm scores");
+  if (m_zt.count.size() < first_tmodel + scores.extent(0))
+    m_zt.resize(first_tmodel + scores.extent(0), 0);
+  bob::core::parallelFor(0, scores.extent(0),
+    boost::bind(&ZTNormalizer::accumulateZTRows, this, boost::cref(scores),
+      (const blitz::Array<bool,2>*)0, first_tmodel, _1, _2, _3));
+  m_has_zt = true;
+}
+
+void ZTNormalizer::accumulateZTNorm(const blitz::Array<double,2>& scores,
+  const blitz::Array<bool,2>& mask_istruetrial, const size_t first_tmodel)
+{
+  bob::core::array::assertSameShape(scores, mask_istruetrial);
+  if (m_has_t)
+    throw std::runtime_error("ZTNormalizer: the scores of the T-norm models against the Z-norm probes should be accumulated before the T-norm scores");
+  if (m_zt.count.size() < first_tmodel + scores.extent(0))
+    m_zt.resize(first_tmodel + scores.extent(0), 0);
+  bob::core::parallelFor(0, scores.extent(0),
+    boost::bind(&ZTNormalizer::accumulateZTRows, this, boost::cref(scores),
+      &mask_istruetrial, first_tmodel, _1, _2, _3));
+  m_has_zt = true;
+}
+
+void ZTNormalizer::accumulateTColumns(const blitz::Array<double,2>& scores,
+  const size_t first_tmodel, const size_t first_probe,
+  size_t begin, size_t end, size_t)
+{
+  for (int r=0; r<scores.extent(0); ++r) {
+    // Z-normalizes the scores of the T-norm model first, if required
+    double zt_mean = 0., zt_std = 1.;
+    if (m_has_zt) {
+      zt_mean = m_zt.mean(first_tmodel + r);
+      zt_std = m_zt.std(first_tmodel + r);
+    }
+    for (size_t c=begin; c<end; ++c)
+      m_t.add(first_probe + c, (scores(r,c) - zt_mean) / zt_std);
+  }
+}
+
+void ZTNormalizer::accumulateTNorm(const blitz::Array<double,2>& scores,
+  const size_t first_tmodel, const size_t first_probe)
+{
+  if (first_probe + scores.extent(1) > m_n_probes) {
+    boost::format m("ZTNormalizer: the scores of the probes %d to %d are given, whereas there are %d probes");
+    m % first_probe % (first_probe + scores.extent(1)) % m_n_probes;
+    throw std::runtime_error(m.str());
+  }
+  if (m_has_zt && first_tmodel + scores.extent(0) > m_zt.count.size()) {
+    boost::format m("ZTNormalizer: the scores of the T-norm models %d to %d are given, whereas the scores of %d T-norm models against the Z-norm probes were accumulated");
+    m % first_tmodel % (first_tmodel + scores.extent(0)) % m_zt.count.size();
+    throw std::runtime_error(m.str());
+  }
+  // The statistics of the probes are updated by ranges of columns
+  bob::core::parallelFor(0, scores.extent(1),
+    boost::bind(&ZTNormalizer::accumulateTColumns, this, boost::cref(scores),
+      first_tmodel, first_probe, _1, _2, _3));
+  m_has_t = true;
+  m_updated = false;
+}
+
+void ZTNormalizer::accumulateZNorm(bob::io::HDF5File& file,
+  const std::string& path)
+{
+  size_t n_rows, n_columns;
+  detail::describeScores(file, path, n_rows, n_columns);
+  const size_t n_block = detail::rowsPerBlock(n_columns);
+  blitz::Array<double,2> block;
+  for (size_t r=0; r<n_rows; r+=n_block) {
+    block.resize(std::min(n_block, n_rows - r), n_columns);
+    file.readArrays(path, r, block);
+    accumulateZNorm(block, r);
+  }
+}
+
+void ZTNormalizer::accumulateZTNorm(bob::io::HDF5File& file,
+  const std::string& path)
+{
+  size_t n_rows, n_columns;
+  detail::describeScores(file, path, n_rows, n_columns);
+  const size_t n_block = detail::rowsPerBlock(n_columns);
+  blitz::Array<double,2> block;
+  for (size_t r=0; r<n_rows; r+=n_block) {
+    block.resize(std::min(n_block, n_rows - r), n_columns);
+    file.readArrays(path, r, block);
+    accumulateZTNorm(block, r);
+  }
+}
+
+void ZTNormalizer::accumulateTNorm(bob::io::HDF5File& file,
+  const std::string& path)
+{
+  size_t n_rows, n_columns;
+  detail::describeScores(file, path, n_rows, n_columns);
+  const size_t n_block = detail::rowsPerBlock(n_columns);
+  blitz::Array<double,2> block;
+  for (size_t r=0; r<n_rows; r+=n_block) {
+    block.resize(std::min(n_block, n_rows - r), n_columns);
+    file.readArrays(path, r, block);
+    accumulateTNorm(block, r, 0);
+  }
+}
+
+void ZTNormalizer::updateStatistics()
+{
+  if (m_updated) return;
+  if (m_has_z) m_z.get(m_z_mean, m_z_std);
+  if (m_has_t) m_t.get(m_t_mean, m_t_std);
+  m_updated = true;
+}
+
+void ZTNormalizer::normalizeRows(const blitz::Array<double,2>& scores,
+  const size_t first_model, const size_t first_probe, const bool symmetric,
+  blitz::Array<double,2>& normalized, size_t begin, size_t end, size_t) const
+{
+  for (size_t r=begin; r<end; ++r) {
+    double z_mean = 0., z_std = 1.;
+    if (m_has_z) {
+      z_mean = m_z_mean(first_model + r);
+      z_std = m_z_std(first_model + r);
+    }
+    for (int c=0; c<scores.extent(1); ++c) {
+      const double score = scores(r,c);
+      if (symmetric)
+        normalized(r,c) = 0.5 * ((score - z_mean) / z_std +
+          (score - m_t_mean(first_probe + c)) / m_t_std(first_probe + c));
+      else if (m_has_t)
+        normalized(r,c) = ((score - z_mean) / z_std -
+          m_t_mean(first_probe + c)) / m_t_std(first_probe + c);
+      else
+        normalized(r,c) = (score - z_mean) / z_std;
     }
-    else
-      scores = zA;
+  }
+}
+
+void ZTNormalizer::normalize(const blitz::Array<double,2>& scores,
+  const size_t first_model, const size_t first_probe, const bool symmetric,
+  blitz::Array<double,2>& normalized)
+{
+  bob::core::array::assertSameShape(scores, normalized);
+  if (first_model + scores.extent(0) > m_n_models ||
+      first_probe + scores.extent(1) > m_n_probes) {
+    boost::format m("ZTNormalizer: the scores of the models %d to %d against the probes %d to %d are given, whereas there are %d models and %d probes");
+    m % first_model % (first_model + scores.extent(0)) % first_probe % (first_probe + scores.extent(1)) % m_n_models % m_n_probes;
+    throw std::runtime_error(m.str());
+  }
+  if (symmetric && !(m_has_z && m_has_t))
+    throw std::runtime_error("ZTNormalizer: the symmetric normalization requires both Z-norm and T-norm statistics");
+
+  updateStatistics();
+  bob::core::parallelFor(0, scores.extent(0),
+    boost::bind(&ZTNormalizer::normalizeRows, this, boost::cref(scores),
+      first_model, first_probe, symmetric, boost::ref(normalized),
+      _1, _2, _3));
+}
+
+void ZTNormalizer::normalize(const blitz::Array<double,2>& scores,
+  const size_t first_model, const size_t first_probe,
+  blitz::Array<double,2>& normalized)
+{
+  normalize(scores, first_model, first_probe, false, normalized);
+}
+
+void ZTNormalizer::symmetricNormalize(const blitz::Array<double,2>& scores,
+  const size_t first_model, const size_t first_probe,
+  blitz::Array<double,2>& normalized)
+{
+  normalize(scores, first_model, first_probe, true, normalized);
+}
+
+void ZTNormalizer::normalize(bob::io::HDF5File& input_file,
+  const std::string& input_path, bob::io::HDF5File& output_file,
+  const std::string& output_path, const bool symmetric)
+{
+  size_t n_rows, n_columns;
+  detail::describeScores(input_file, input_path, n_rows, n_columns);
+  const size_t n_block = detail::rowsPerBlock(n_columns);
+  blitz::Array<double,2> block, normalized;
+  for (size_t r=0; r<n_rows; r+=n_block) {
+    block.resize(std::min(n_block, n_rows - r), n_columns);
+    normalized.resize(block.shape());
+    input_file.readArrays(input_path, r, block);
+    normalize(block, r, 0, symmetric, normalized);
+    output_file.appendArrays(output_path, normalized);
   }
 }
 
@@ -0,0 +1,116 @@
+/**
+ * @file machine/cxx/benchmark/ivector.cc
+ * @date Sat Oct 17 20:41:07 CEST 2026
+ * @author Laurent El Shafey <Laurent.El-Shafey@idiap.ch>
+ *
+ * @brief Benchmark the throughput (in ivectors per second) of the ivector
+ * extraction, sample by sample and by batches
+ *
+ * Copyright (C) 2011-2013 Idiap Research Institute, Martigny, Switzerland
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <bob/machine/IVectorMachine.h>
+#include <bob/core/parallel.h>
+
+#include <boost/random.hpp>
+#include <boost/make_shared.hpp>
+#include <boost/date_time/posix_time/posix_time.hpp>
+#include <iostream>
+#include <vector>
+
+static double ivectorsPerSecond(const int n_ivectors,
+  const boost::posix_time::time_duration& diff)
+{
+  return n_ivectors / (diff.total_microseconds() / 1e6);
+}
+
+/**
+ * Extraction of n_stats ivectors of rank rt, with a UBM of C Gaussians of
+ * dimension D
+ */
+void benchmark_ivector(const int C, const int D, const int rt,
+  const int n_stats)
+{
+  boost::mt19937 rng;
+  boost::uniform_real<double> dist(-1., 1.);
+  boost::shared_ptr<bob::machine::GMMMachine> ubm =
+    boost::make_shared<bob::machine::GMMMachine>(C, D);
+  blitz::Array<double,2> means(C, D), variances(C, D);
+  for (int c=0; c<C; ++c)
+    for (int d=0; d<D; ++d) {
+      means(c,d) = dist(rng);
+      variances(c,d) = 1.5 + dist(rng);
+    }
+  ubm->setMeans(means);
+  ubm->setVariances(variances);
+
+  bob::machine::IVectorMachine machine(ubm, rt);
+  blitz::Array<double,2> T(C*D, rt);
+  blitz::Array<double,1> sigma(C*D);
+  for (int i=0; i<C*D; ++i) {
+    sigma(i) = 1.5 + dist(rng);
+    for (int r=0; r<rt; ++r) T(i,r) = dist(rng);
+  }
+  machine.setT(T);
+  machine.setSigma(sigma);
+
+  std::vector<bob::machine::GMMStats> stats;
+  for (int t=0; t<n_stats; ++t) {
+    bob::machine::GMMStats s(C, D);
+    for (int c=0; c<C; ++c) {
+      s.n(c) = 10. * (1. + dist(rng));
+      for (int d=0; d<D; ++d) s.sumPx(c,d) = dist(rng);
+    }
+    stats.push_back(s);
+  }
+  blitz::Array<double,1> ivector(rt);
+  blitz::Array<double,2> ivectors(n_stats, rt);
+  boost::posix_time::ptime t1;
+  boost::posix_time::ptime t2;
+  boost::posix_time::time_duration diff;
+
+  std::cout << "Extraction of " << n_stats << " ivectors of rank " << rt << " (" << C << " Gaussians of dimension " << D << ")..." << std::endl;
+
+  t1 = boost::posix_time::microsec_clock::local_time();
+  for (int t=0; t<n_stats; ++t)
+    machine.forward(stats[t], ivector);
+  t2 = boost::posix_time::microsec_clock::local_time();
+  diff = t2 - t1;
+  std::cout << "  forward, sample by sample (ivectors/second) " << ivectorsPerSecond(n_stats, diff) << std::endl;
+
+  for (int k=0; k<2; ++k)
+  {
+    machine.setSinglePrecisionCache(k == 1);
+    const size_t n_threads[4] = {1, 2, 4, 8};
+    for (int l=0; l<4; ++l)
+    {
+      bob::core::setNThreads(n_threads[l]);
+      t1 = boost::posix_time::microsec_clock::local_time();
+      machine.forward(stats, ivectors);
+      t2 = boost::posix_time::microsec_clock::local_time();
+      diff = t2 - t1;
+      std::cout << "  forward, by batches, " << (k == 1 ? "single" : "double") << " precision cache, with " << n_threads[l] << " thread(s) (ivectors/second) " << ivectorsPerSecond(n_stats, diff) << std::endl;
+    }
+  }
+  bob::core::setNThreads(0);
+}
+
+int main()
+{
+  benchmark_ivector(256, 60, 100, 1000);
+  benchmark_ivector(512, 60, 400, 500);
+
+  return 0;
+}
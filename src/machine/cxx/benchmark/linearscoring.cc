@@ -0,0 +1,96 @@
+/**
+ * @file machine/cxx/benchmark/linearscoring.cc
+ * @date Sat Oct 17 19:58:23 CEST 2026
+ * @author Laurent El Shafey <Laurent.El-Shafey@idiap.ch>
+ *
+ * @brief Benchmark the throughput (in scores per second) of the linear
+ * scoring of GMM supervectors
+ *
+ * Copyright (C) 2011-2013 Idiap Research Institute, Martigny, Switzerland
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <bob/machine/LinearScoring.h>
+#include <bob/core/parallel.h>
+
+#include <boost/random.hpp>
+#include <boost/make_shared.hpp>
+#include <boost/date_time/posix_time/posix_time.hpp>
+#include <iostream>
+#include <vector>
+
+static double scoresPerSecond(const int n_scores,
+  const boost::posix_time::time_duration& diff)
+{
+  return n_scores / (diff.total_microseconds() / 1e6);
+}
+
+/**
+ * Linear scoring of n_models models against n_stats statistics of GMMs with
+ * C Gaussians of dimension D, with an increasing number of threads
+ */
+void benchmark_linear_scoring(const int C, const int D, const int n_models,
+  const int n_stats)
+{
+  boost::mt19937 rng;
+  boost::uniform_real<double> dist(-1., 1.);
+  const int CD = C*D;
+  blitz::Array<double,1> ubm_mean(CD), ubm_variance(CD);
+  for (int s=0; s<CD; ++s) {
+    ubm_mean(s) = dist(rng);
+    ubm_variance(s) = 1.5 + dist(rng);
+  }
+  std::vector<blitz::Array<double,1> > models;
+  for (int m=0; m<n_models; ++m) {
+    blitz::Array<double,1> model(CD);
+    for (int s=0; s<CD; ++s) model(s) = dist(rng);
+    models.push_back(model);
+  }
+  std::vector<boost::shared_ptr<const bob::machine::GMMStats> > stats;
+  for (int t=0; t<n_stats; ++t) {
+    boost::shared_ptr<bob::machine::GMMStats> s = boost::make_shared<bob::machine::GMMStats>(C, D);
+    for (int c=0; c<C; ++c) {
+      s->n(c) = 10. * (1. + dist(rng));
+      for (int d=0; d<D; ++d) s->sumPx(c,d) = dist(rng);
+    }
+    s->T = (size_t)blitz::sum(s->n);
+    stats.push_back(s);
+  }
+  blitz::Array<double,2> scores(n_models, n_stats);
+  boost::posix_time::ptime t1;
+  boost::posix_time::ptime t2;
+  boost::posix_time::time_duration diff;
+
+  std::cout << "Linear scoring of " << n_models << " models against " << n_stats << " statistics (" << C << " Gaussians of dimension " << D << ")..." << std::endl;
+
+  const size_t n_threads[4] = {1, 2, 4, 8};
+  for (int k=0; k<4; ++k)
+  {
+    bob::core::setNThreads(n_threads[k]);
+    t1 = boost::posix_time::microsec_clock::local_time();
+    bob::machine::linearScoring(models, ubm_mean, ubm_variance, stats, true, scores);
+    t2 = boost::posix_time::microsec_clock::local_time();
+    diff = t2 - t1;
+    std::cout << "  linearScoring with " << n_threads[k] << " thread(s) (scores/second) " << scoresPerSecond(n_models*n_stats, diff) << std::endl;
+  }
+  bob::core::setNThreads(0);
+}
+
+int main()
+{
+  benchmark_linear_scoring(256, 60, 200, 2000);
+  benchmark_linear_scoring(512, 60, 500, 5000);
+
+  return 0;
+}
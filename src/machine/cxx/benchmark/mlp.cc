@@ -0,0 +1,87 @@
+/**
+ * @file machine/cxx/benchmark/mlp.cc
+ * @date Sat Oct 17 17:03:41 CEST 2026
+ * @author Laurent El Shafey <Laurent.El-Shafey@idiap.ch>
+ *
+ * @brief Benchmark the forward pass of MLPs, one sample at a time or by
+ * mini-batches of samples
+ *
+ * Copyright (C) 2011-2013 Idiap Research Institute, Martigny, Switzerland
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <bob/machine/MLP.h>
+
+#include <boost/date_time/posix_time/posix_time.hpp>
+#include <boost/make_shared.hpp>
+#include <iostream>
+#include <vector>
+
+void benchmark(const std::vector<size_t>& shape, const int n_samples)
+{
+  bob::machine::MLP machine(shape);
+  boost::mt19937 rng(0);
+  machine.randomize(rng);
+  machine.setOutputActivation(boost::make_shared<bob::machine::LogisticActivation>());
+
+  blitz::Array<double,2> input(n_samples, shape.front());
+  input = blitz::tensor::i * 0.001 - blitz::tensor::j * 0.002;
+  blitz::Array<double,2> output(n_samples, shape.back());
+
+  boost::posix_time::ptime t1;
+  boost::posix_time::ptime t2;
+  boost::posix_time::time_duration diff;
+
+  std::cout << "MLP (" << shape[0];
+  for (size_t k=1; k<shape.size(); ++k) std::cout << ", " << shape[k];
+  std::cout << ") on " << n_samples << " samples..." << std::endl;
+
+  t1 = boost::posix_time::microsec_clock::local_time();
+  blitz::Range all = blitz::Range::all();
+  for (int i=0; i<n_samples; ++i) {
+    blitz::Array<double,1> in = input(i, all);
+    blitz::Array<double,1> out = output(i, all);
+    machine.forward(in, out);
+  }
+  t2 = boost::posix_time::microsec_clock::local_time();
+  diff = t2 - t1;
+  std::cout << "  One sample at a time (samples/s) " << n_samples / (diff.total_microseconds() * 1e-6) << std::endl;
+
+  t1 = boost::posix_time::microsec_clock::local_time();
+  machine.forward(input, output);
+  t2 = boost::posix_time::microsec_clock::local_time();
+  diff = t2 - t1;
+  std::cout << "  Mini-batches (samples/s) " << n_samples / (diff.total_microseconds() * 1e-6) << std::endl;
+}
+
+int main()
+{
+  // Typical shapes of MLPs scoring face features: a small network on a
+  // score fusion or a few PCA components, and larger ones on LBP histograms
+  const size_t shapes[][4] = {
+    {  20,  10,  1, 0},
+    { 200, 100,  1, 0},
+    {1024, 256,  2, 0},
+    {2891, 512, 64, 1},
+  };
+  const int n_samples[] = {100000, 20000, 5000, 2000};
+
+  for (int k=0; k<4; ++k) {
+    std::vector<size_t> shape;
+    for (int l=0; l<4 && shapes[k][l]; ++l) shape.push_back(shapes[k][l]);
+    benchmark(shape, n_samples[k]);
+  }
+
+  return 0;
+}
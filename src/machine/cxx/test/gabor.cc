@@ -26,12 +26,15 @@
 
 #include <boost/test/unit_test.hpp>
 #include <boost/filesystem.hpp>
+#include <boost/random.hpp>
 #include <blitz/array.h>
 
 #include "bob/machine/GaborGraphMachine.h"
+#include "bob/machine/GaborGraphGallery.h"
 #include "bob/machine/GaborJetSimilarities.h"
 
 #include "bob/core/logging.h"
+#include "bob/core/parallel.h"
 #include "bob/io/utils.h"
 
 
@@ -123,3 +126,79 @@ BOOST_AUTO_TEST_CASE( test_gabor_graph_machine )
     BOOST_CHECK_CLOSE(similarity, 1., epsilon);
   }
 }
+
+
+BOOST_AUTO_TEST_CASE( test_gabor_graph_gallery )
+{
+  // random Gabor graphs with normalized jets
+  bob::ip::GaborWaveletTransform gwt;
+  const int n_graphs = 37, n_nodes = 10, n_kernels = gwt.numberOfKernels();
+  boost::mt19937 rng;
+  boost::uniform_real<double> abs_dist(0.01, 1.), phase_dist(-M_PI, M_PI);
+  blitz::Array<double,4> graphs(n_graphs + 1, n_nodes, 2, n_kernels);
+  for (int m = 0; m <= n_graphs; ++m)
+    for (int n = 0; n < n_nodes; ++n){
+      double norm = 0.;
+      for (int j = 0; j < n_kernels; ++j){
+        graphs(m,n,0,j) = abs_dist(rng);
+        graphs(m,n,1,j) = phase_dist(rng);
+        norm += graphs(m,n,0,j) * graphs(m,n,0,j);
+      }
+      for (int j = 0; j < n_kernels; ++j)
+        graphs(m,n,0,j) /= sqrt(norm);
+    }
+  blitz::Range all = blitz::Range::all();
+  // the last graph is the probe
+  blitz::Array<double,3> probe = graphs(n_graphs, all, all, all);
+
+  bob::machine::GaborJetSimilarity::SimilarityType types[5] = {
+    bob::machine::GaborJetSimilarity::SCALAR_PRODUCT,
+    bob::machine::GaborJetSimilarity::CANBERRA,
+    bob::machine::GaborJetSimilarity::DISPARITY,
+    bob::machine::GaborJetSimilarity::PHASE_DIFF,
+    bob::machine::GaborJetSimilarity::PHASE_DIFF_PLUS_CANBERRA
+  };
+
+  bob::machine::GaborGraphMachine machine;
+  for (int t = 0; t < 5; ++t){
+    bob::machine::GaborJetSimilarity similarity(types[t], gwt);
+    bob::machine::GaborGraphGallery gallery(types[t], gwt);
+    gallery.add(graphs(0, all, all, all));
+    gallery.reserve(n_graphs);
+    for (int m = 1; m < n_graphs; ++m)
+      gallery.add(graphs(m, all, all, all));
+    BOOST_CHECK_EQUAL(gallery.size(), n_graphs);
+    BOOST_CHECK_EQUAL(gallery.numberOfNodes(), n_nodes);
+
+    // compare the gallery scores to the ones of the graph machine, with one and several threads
+    blitz::Array<double,1> scores(n_graphs);
+    for (int threads = 1; threads <= 3; threads += 2){
+      bob::core::setNThreads(threads);
+      scores = 0.;
+      gallery.similarity(probe, scores);
+      for (int m = 0; m < n_graphs; ++m){
+        blitz::Array<double,3> model = graphs(m, all, all, all);
+        BOOST_CHECK_SMALL(scores(m) - machine.similarity(model, probe, similarity), epsilon);
+      }
+    }
+    bob::core::setNThreads(0);
+
+    // the k best graphs, sorted by decreasing similarity
+    blitz::Array<int,1> indices;
+    blitz::Array<double,1> best;
+    gallery.topK(probe, 5, indices, best);
+    BOOST_CHECK_EQUAL(indices.extent(0), 5);
+    BOOST_CHECK_EQUAL(best(0), blitz::max(scores));
+    for (int i = 0; i < 5; ++i){
+      BOOST_CHECK_EQUAL(best(i), scores(indices(i)));
+      if (i) BOOST_CHECK(best(i-1) >= best(i));
+    }
+    gallery.topK(probe, 2 * n_graphs, indices, best);
+    BOOST_CHECK_EQUAL(indices.extent(0), n_graphs);
+  }
+
+  // graphs without phases cannot be compared with disparities
+  bob::machine::GaborGraphGallery gallery(bob::machine::GaborJetSimilarity::DISPARITY, gwt);
+  blitz::Array<double,2> abs_graph = graphs(0, all, 0, all);
+  BOOST_CHECK_THROW(gallery.add(abs_graph), std::runtime_error);
+}
@@ -28,6 +28,7 @@
 #include <boost/make_shared.hpp>
 #include <blitz/array.h>
 #include <stdint.h>
+#include <cmath>
 
 #include "bob/machine/LinearMachine.h"
 #include "bob/core/logging.h"
@@ -171,3 +172,39 @@ BOOST_AUTO_TEST_CASE( test_correctness )
     BOOST_CHECK(blitz::all(blitz::abs(presumed(in(i,a)) - output) < maxerr));
   }
 }
+
+BOOST_AUTO_TEST_CASE( test_batch_forward )
+{
+  blitz::Array<double,2> weights(3,2);
+  weights = 0.4, 0.1, 0.4, 0.2, 0.2, 0.7;
+  bob::machine::LinearMachine M(weights);
+  blitz::Array<double,1> biases(2);
+  biases = 0.3, -3.0;
+  M.setBiases(biases);
+  blitz::Array<double,1> isub(3);
+  isub = 0, 0.5, 0.5;
+  M.setInputSubtraction(isub);
+  blitz::Array<double,1> idiv(3);
+  idiv = 0.5, 1.0, 1.0;
+  M.setInputDivision(idiv);
+  M.setActivation(boost::make_shared<bob::machine::HyperbolicTangentActivation>());
+
+  // More rows than a single mini-batch
+  const int n_samples = 1000;
+  blitz::Array<double,2> in(n_samples,3);
+  for (int i=0; i<n_samples; ++i)
+    for (int j=0; j<3; ++j) in(i,j) = std::sin(0.1*i + j);
+
+  blitz::Array<double,2> output(n_samples,2);
+  M.forward(in, output);
+
+  blitz::Range a = blitz::Range::all();
+  blitz::Array<double,1> ref(2);
+  for (int i=0; i<n_samples; ++i) {
+    M.forward(in(i,a), ref);
+    BOOST_CHECK(blitz::all(blitz::abs(output(i,a) - ref) < 1e-12));
+  }
+
+  blitz::Array<double,2> bad(n_samples-1,2);
+  BOOST_CHECK_THROW(M.forward(in, bad), std::runtime_error);
+}
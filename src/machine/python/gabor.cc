@@ -26,6 +26,7 @@
 
 #include <bob/ip/GaborWaveletTransform.h>
 #include <bob/machine/GaborGraphMachine.h>
+#include <bob/machine/GaborGraphGallery.h>
 #include <bob/machine/GaborJetSimilarities.h>
 
 static void bob_extract(bob::machine::GaborGraphMachine& self, bob::python::const_ndarray input_jet_image, bob::python::ndarray output_graph){
@@ -111,6 +112,63 @@ static double bob_jet_sim(const bob::machine::GaborJetSimilarity& self, bob::pyt
   }
 }
 
+static void bob_gallery_add(bob::machine::GaborGraphGallery& self, bob::python::const_ndarray graph_jets){
+  switch (graph_jets.type().nd){
+    case 2:{
+      self.add(graph_jets.bz<double,2>());
+      break;
+    }
+    case 3:{
+      self.add(graph_jets.bz<double,3>());
+      break;
+    }
+    default:
+      PYTHON_ERROR(RuntimeError, "parameter `graph_jets' should be 2 or 3 dimensional, but you passed a " SIZE_T_FMT " dimensional array.", graph_jets.type().nd);
+  }
+}
+
+static bob::python::ndarray bob_gallery_similarity(const bob::machine::GaborGraphGallery& self, bob::python::const_ndarray probe_graph){
+  bob::python::ndarray output_scores(bob::core::array::t_float64, self.size());
+  blitz::Array<double,1> scores = output_scores.bz<double,1>();
+  switch (probe_graph.type().nd){
+    case 2:{
+      self.similarity(probe_graph.bz<double,2>(), scores);
+      break;
+    }
+    case 3:{
+      self.similarity(probe_graph.bz<double,3>(), scores);
+      break;
+    }
+    default:
+      PYTHON_ERROR(RuntimeError, "parameter `probe_graph' should be 2 or 3 dimensional, but you passed a " SIZE_T_FMT " dimensional array.", probe_graph.type().nd);
+  }
+  return output_scores;
+}
+
+static boost::python::tuple bob_gallery_top_k(const bob::machine::GaborGraphGallery& self, bob::python::const_ndarray probe_graph, int k){
+  blitz::Array<int,1> indices;
+  blitz::Array<double,1> scores;
+  switch (probe_graph.type().nd){
+    case 2:{
+      self.topK(probe_graph.bz<double,2>(), k, indices, scores);
+      break;
+    }
+    case 3:{
+      self.topK(probe_graph.bz<double,3>(), k, indices, scores);
+      break;
+    }
+    default:
+      PYTHON_ERROR(RuntimeError, "parameter `probe_graph' should be 2 or 3 dimensional, but you passed a " SIZE_T_FMT " dimensional array.", probe_graph.type().nd);
+  }
+  bob::python::ndarray output_indices(bob::core::array::t_int32, indices.extent(0));
+  blitz::Array<int32_t,1> indices_ = output_indices.bz<int32_t,1>();
+  indices_ = indices;
+  bob::python::ndarray output_scores(bob::core::array::t_float64, scores.extent(0));
+  blitz::Array<double,1> scores_ = output_scores.bz<double,1>();
+  scores_ = scores;
+  return boost::python::make_tuple(output_indices, output_scores);
+}
+
 void bind_machine_gabor(){
   /////////////////////////////////////////////////////////////////////////////////////////
   //////////////// Gabor jet similarities
@@ -261,4 +319,72 @@ void bind_machine_gabor(){
       "Computes the similarity between the given probe graph and the gallery, which might be a single graph or a collection of graphs"
   );
 
+
+  //////////////// Gabor graph gallery
+  boost::python::class_<bob::machine::GaborGraphGallery, boost::shared_ptr<bob::machine::GaborGraphGallery> >(
+      "GaborGraphGallery",
+      "This class stores a gallery of Gabor graphs (of the same topology) in one contiguous memory block, and compares a probe Gabor graph to all graphs of the gallery at once, using several threads (see bob.core.set_n_threads). "
+      "The similarity of two graphs is the average Gabor jet similarity over the nodes, as computed by GaborGraphMachine.similarity. "
+      "For the SCALAR_PRODUCT similarity, the jets are normalized to unit length, which gives the same similarities for normalized Gabor jets.",
+      boost::python::no_init
+    )
+
+    .def(
+      boost::python::init<bob::machine::GaborJetSimilarity::SimilarityType, const bob::ip::GaborWaveletTransform&>(
+        (
+          boost::python::arg("self"),
+          boost::python::arg("type"),
+          boost::python::arg("gwt") = bob::ip::GaborWaveletTransform()
+        ),
+        "Generates an empty gallery, whose graphs are compared with the Gabor jet similarity function of the given type. The parameters of the given transform are used for disparity-like similarity functions only."
+      )
+    )
+
+    .def(
+      "add",
+      &bob_gallery_add,
+      (boost::python::arg("self"), boost::python::arg("graph_jets")),
+      "Adds the given Gabor graph to the gallery. Disparity-like similarity functions require Gabor graphs including phases."
+    )
+
+    .def(
+      "reserve",
+      &bob::machine::GaborGraphGallery::reserve,
+      (boost::python::arg("self"), boost::python::arg("n_graphs")),
+      "Reserves the memory for the given number of graphs (once a graph has been added)."
+    )
+
+    .def(
+      "clear",
+      &bob::machine::GaborGraphGallery::clear,
+      (boost::python::arg("self")),
+      "Removes all graphs from the gallery."
+    )
+
+    .def(
+      "__len__",
+      &bob::machine::GaborGraphGallery::size,
+      (boost::python::arg("self")),
+      "The number of graphs in the gallery"
+    )
+
+    .add_property(
+      "number_of_nodes",
+      &bob::machine::GaborGraphGallery::numberOfNodes,
+      "The number of nodes of the graphs of the gallery"
+    )
+
+    .def(
+      "similarity",
+      &bob_gallery_similarity,
+      (boost::python::arg("self"), boost::python::arg("probe_graph_jets")),
+      "Computes and returns the similarities of the given probe graph to all graphs of the gallery."
+    )
+
+    .def(
+      "top_k",
+      &bob_gallery_top_k,
+      (boost::python::arg("self"), boost::python::arg("probe_graph_jets"), boost::python::arg("k")),
+      "Returns the indices and the similarities of the k gallery graphs that are the most similar to the given probe graph, sorted by decreasing similarity."
+  );
 }
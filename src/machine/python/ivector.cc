@@ -23,6 +23,7 @@
 #include <boost/shared_ptr.hpp>
 #include <bob/python/exception.h>
 #include <bob/machine/IVectorMachine.h>
+#include <boost/python/stl_iterator.hpp>
 
 using namespace boost::python;
 
@@ -93,6 +94,16 @@ static object py_iv_forward2(const bob::machine::IVectorMachine& machine,
   return ivector.self();
 }
 
+static object py_iv_forward3(const bob::machine::IVectorMachine& machine,
+  object data)
+{
+  stl_input_iterator<bob::machine::GMMStats> dbegin(data), dend;
+  std::vector<bob::machine::GMMStats> vdata(dbegin, dend);
+  bob::python::ndarray ivectors(bob::core::array::t_float64, vdata.size(), machine.getDimRt());
+  blitz::Array<double,2> ivectors_ = ivectors.bz<double,2>();
+  machine.forward(vdata, ivectors_);
+  return ivectors.self();
+}
 
 void bind_machine_ivector()
 {
@@ -111,6 +122,7 @@ void bind_machine_ivector()
     .add_property("t", make_function(&bob::machine::IVectorMachine::getT, return_value_policy<copy_const_reference>()), &py_iv_setT, "The subspace T (Total Variability matrix)")
     .add_property("sigma", make_function(&bob::machine::IVectorMachine::getSigma, return_value_policy<copy_const_reference>()), &py_iv_setSigma, "The residual matrix of the model sigma")
     .add_property("variance_threshold", &bob::machine::IVectorMachine::getVarianceThreshold, &bob::machine::IVectorMachine::setVarianceThreshold, "Threshold for the variance contained in sigma")
+    .add_property("single_precision_cache", &bob::machine::IVectorMachine::getSinglePrecisionCache, &bob::machine::IVectorMachine::setSinglePrecisionCache, "Tells whether the cache of the T_{c}^{T} Sigma_{c}^{-1} T_{c} matrices (packed, C x rt(rt+1)/2 values) is stored in single precision, which halves its memory")
     .add_property("dim_c", &bob::machine::IVectorMachine::getDimC, "The number of Gaussian components")
     .add_property("dim_d", &bob::machine::IVectorMachine::getDimD, "The dimensionality of the feature space")
     .add_property("dim_cd", &bob::machine::IVectorMachine::getDimCD, "The dimensionality of the supervector space")
@@ -119,6 +131,7 @@ void bind_machine_ivector()
     .def("__compute_Id_TtSigmaInvT__", &py_computeIdTtSigmaInvT2, (arg("self"), arg("gmmstats")), "Computes (Id + sum_{c=1}^{C} N_{i,j,c} T^{T} Sigma_{c}^{-1} T)")
     .def("__compute_TtSigmaInvFnorm__", &py_computeTtSigmaInvFnorm1, (arg("self"), arg("gmmstats"), arg("output")), "Computes T^{T} Sigma^{-1} sum_{c=1}^{C} (F_c - N_c mean(c))")
     .def("__compute_TtSigmaInvFnorm__", &py_computeTtSigmaInvFnorm2, (arg("self"), arg("gmmstats")), "Computes T^{T} Sigma^{-1} sum_{c=1}^{C} (F_c - N_c mean(c))")
+    .def("forward", &py_iv_forward3, (arg("self"), arg("gmmstats")), "Executes the machine on a list of GMMStats, which are processed by batches and in parallel (see bob.core.set_n_threads()). The ivectors are returned as the rows of a 2D array.")
     .def("__call__", &py_iv_forward1_, (arg("self"), arg("gmmstats"), arg("ivector")), "Executes the machine on the GMMStats, and updates the ivector array. NO CHECK is performed.")
     .def("__call__", &py_iv_forward2, (arg("self"), arg("gmmstats")), "Executes the machine on the GMMStats. The ivector is allocated an returned.")
     .def("forward", &py_iv_forward1, (arg("self"), arg("gmmstats"), arg("ivector")), "Executes the machine on the GMMStats, and updates the ivector array.")
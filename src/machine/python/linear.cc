@@ -41,14 +41,8 @@ static object forward(const bob::machine::LinearMachine& m,
     case 2:
       {
         bob::python::ndarray output(bob::core::array::t_float64, info.shape[0], m.outputSize());
-        blitz::Array<double,2> input_ = input.bz<double,2>();
         blitz::Array<double,2> output_ = output.bz<double,2>();
-        blitz::Range all = blitz::Range::all();
-        for (size_t k=0; k<info.shape[0]; ++k) {
-          blitz::Array<double,1> i_ = input_(k,all);
-          blitz::Array<double,1> o_ = output_(k,all);
-          m.forward(i_, o_);
-        }
+        m.forward(input.bz<double,2>(), output_);
         return output.self();
       }
     default:
@@ -70,14 +64,8 @@ static void forward2(const bob::machine::LinearMachine& m,
       break;
     case 2:
       {
-        blitz::Array<double,2> input_ = input.bz<double,2>();
         blitz::Array<double,2> output_ = output.bz<double,2>();
-        blitz::Range all = blitz::Range::all();
-        for (size_t k=0; k<info.shape[0]; ++k) {
-          blitz::Array<double,1> i_ = input_(k,all);
-          blitz::Array<double,1> o_ = output_(k,all);
-          m.forward(i_, o_);
-        }
+        m.forward(input.bz<double,2>(), output_);
       }
       break;
     default:
@@ -117,9 +117,35 @@ static double linearScoring3(bob::python::const_ndarray model,
           ubm_var.bz<double,1>(), test_stats, test_channelOffset.bz<double,1>(), frame_length_normalisation);
 }
 
+static void linearScoring4(object models,
+    bob::python::const_ndarray ubm_mean, bob::python::const_ndarray ubm_variance,
+    object test_stats, bob::io::HDF5File& file, const std::string& path,
+    object test_channelOffset = list(), // Empty list
+    bool frame_length_normalisation = false) 
+{
+  blitz::Array<double,1> ubm_mean_ = ubm_mean.bz<double,1>();
+  blitz::Array<double,1> ubm_variance_ = ubm_variance.bz<double,1>();
+
+  std::vector<blitz::Array<double,1> > models_c;
+  convertGMMMeanList(models, models_c);
+
+  std::vector<boost::shared_ptr<const bob::machine::GMMStats> > test_stats_c;
+  convertGMMStatsList(test_stats, test_stats_c);
+
+  if (test_channelOffset.ptr() == Py_None || len(test_channelOffset) == 0) { //list is empty
+    bob::machine::linearScoring(models_c, ubm_mean_, ubm_variance_, test_stats_c, frame_length_normalisation, file, path);
+  }
+  else { 
+    std::vector<blitz::Array<double,1> > test_channelOffset_c;
+    convertChannelOffsetList(test_channelOffset, test_channelOffset_c);
+    bob::machine::linearScoring(models_c, ubm_mean_, ubm_variance_, test_stats_c, test_channelOffset_c, frame_length_normalisation, file, path);
+  }
+}
+
 BOOST_PYTHON_FUNCTION_OVERLOADS(linearScoring1_overloads, linearScoring1, 4, 6)
 BOOST_PYTHON_FUNCTION_OVERLOADS(linearScoring2_overloads, linearScoring2, 3, 5)
 BOOST_PYTHON_FUNCTION_OVERLOADS(linearScoring3_overloads, linearScoring3, 5, 6)
+BOOST_PYTHON_FUNCTION_OVERLOADS(linearScoring4_overloads, linearScoring4, 6, 8)
 
 void bind_machine_linear_scoring() {
   def("linear_scoring", linearScoring1, linearScoring1_overloads(args("models", "ubm_mean", "ubm_variance", "test_stats", "test_channelOffset", "frame_length_normalisation"),
@@ -157,4 +183,18 @@ void bind_machine_linear_scoring() {
     "test_channelOffset -- \n"
     "frame_length_normlisation -- perform a normalisation by the number of feature vectors\n"
     ));
+  def("linear_scoring_to_file", linearScoring4, linearScoring4_overloads(args("models", "ubm_mean", "ubm_variance", "test_stats", "file", "path", "test_channelOffset", "frame_length_normalisation"),
+    "Compute a matrix of scores using linear scoring, and append it to a dataset of an HDF5 file, one array of scores per model (i.e. the row m of the dataset contains the scores of model m against all the statistics). Only the scores of a block of models are held in memory.\n"
+    "\n"
+    "Warning Each GMM must have the same size.\n"
+    "\n"
+    "models       -- list of mean supervectors for the client models\n"
+    "ubm_mean     -- mean supervector for the world model\n"
+    "ubm_variance -- variance supervector for the world model\n"
+    "test_stats   -- list of accumulate statistics for each test trial\n"
+    "file         -- HDF5 file opened for writing\n"
+    "path         -- dataset to which the scores are appended\n"
+    "test_channelOffset -- \n"
+    "frame_length_normlisation -- perform a normalisation by the number of feature vectors\n"
+    ));
 }
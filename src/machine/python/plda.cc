@@ -22,6 +22,7 @@
 
 #include <bob/python/ndarray.h>
 #include <boost/shared_ptr.hpp>
+#include <boost/python/stl_iterator.hpp>
 #include <bob/python/exception.h>
 #include <bob/machine/PLDAMachine.h>
 
@@ -104,6 +105,14 @@ static double plda_forward_sample(bob::machine::PLDAMachine& m,
   }
 }
 
+static void py_precompute_gamma_loglike(bob::machine::PLDABase& plda,
+  object a)
+{
+  stl_input_iterator<size_t> dbegin(a), dend;
+  std::vector<size_t> a_(dbegin, dend);
+  plda.precomputeGammaLogLike(a_);
+}
+
 static double py_log_likelihood_point_estimate(bob::machine::PLDABase& plda,
   bob::python::const_ndarray xij, bob::python::const_ndarray hi,
   bob::python::const_ndarray wij)
@@ -144,6 +153,7 @@ void bind_machine_plda()
     .def("compute_log_like_const_term", (double (bob::machine::PLDABase::*)(const size_t, const blitz::Array<double,2>&) const)&bob::machine::PLDABase::computeLogLikeConstTerm, (arg("self"), arg("a"), arg("gamma")), "Computes the log likelihood constant term for the given number of samples.")
     .def("get_add_log_like_const_term", &bob::machine::PLDABase::getAddLogLikeConstTerm, (arg("self"), arg("a")), "Computes the log likelihood constant term for the given number of samples, and adds it to the machine (as well as gamma), if it does not already exist.")
     .def("get_log_like_const_term", &bob::machine::PLDABase::getLogLikeConstTerm, (arg("self"), arg("a")), "Returns the log likelihood constant term for the given number of samples if it has already been put in cache. Throws an exception otherwise.")
+    .def("precompute_gamma_log_like", &py_precompute_gamma_loglike, (arg("self"), arg("a")), "Computes in parallel the gamma matrices and the log likelihood constant terms for all the given numbers of samples, and adds them to the machine if they do not already exist.")
     .def("clear_maps", &bob::machine::PLDABase::clearMaps, (arg("self")), "Clear the maps containing the gamma's as well as the log likelihood constant term for few number of samples. These maps are used to make likelihood computations faster.")
     .def("compute_log_likelihood_point_estimate", &py_log_likelihood_point_estimate, (arg("self"), arg("xij"), arg("hi"), arg("wij")), "Computes the log-likelihood of a sample given the latent variables hi and wij (point estimate rather than Bayesian-like full integration).")
     .def(self_ns::str(self_ns::self))
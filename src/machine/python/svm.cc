@@ -45,12 +45,10 @@ static object predict_class_n(const bob::machine::SupportVector& m,
   if ((size_t)i_.extent(1) != m.inputSize()) {
     PYTHON_ERROR(RuntimeError, "Input array should have " SIZE_T_FMT " columns, but you have given me one with %d instead", m.inputSize(), i_.extent(1));
   }
-  blitz::Range all = blitz::Range::all();
+  blitz::Array<int,1> labels(i_.extent(0));
+  m.predictClass_(i_, labels);
   list retval;
-  for (int k=0; k<i_.extent(0); ++k) {
-    blitz::Array<double,1> tmp = i_(k,all);
-    retval.append(m.predictClass_(tmp));
-  }
+  for (int k=0; k<labels.extent(0); ++k) retval.append(labels(k));
   return tuple(retval);
 }
 
@@ -92,13 +90,16 @@ static object predict_class_and_scores_n(const bob::machine::SupportVector& m,
   if ((size_t)i_.extent(1) != m.inputSize()) {
     PYTHON_ERROR(RuntimeError, "Input array should have " SIZE_T_FMT " columns, but you have given me one with %d instead", m.inputSize(), i_.extent(1));
   }
+  blitz::Array<int,1> labels(i_.extent(0));
+  blitz::Array<double,2> s_(i_.extent(0), m.outputSize());
+  m.predictClassAndScores_(i_, labels, s_);
   blitz::Range all = blitz::Range::all();
   list classes, scores;
   for (int k=0; k<i_.extent(0); ++k) {
-    blitz::Array<double,1> tmp = i_(k,all);
     bob::python::ndarray s(bob::core::array::t_float64, m.outputSize());
-    blitz::Array<double,1> s_ = s.bz<double,1>();
-    classes.append(m.predictClassAndScores_(tmp, s_));
+    blitz::Array<double,1> s_k = s.bz<double,1>();
+    s_k = s_(k,all);
+    classes.append(labels(k));
     scores.append(s.self());
   }
   return make_tuple(tuple(classes), tuple(scores));
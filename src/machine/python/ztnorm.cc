@@ -22,6 +22,7 @@
  */
 
 #include <bob/python/ndarray.h>
+#include <bob/io/HDF5File.h>
 
 #include <boost/python.hpp>
 #include <bob/machine/ZTNorm.h>
@@ -128,6 +129,80 @@ static object znorm(
   return ret.self();
 }
 
+static void ztn_accumulate_znorm(bob::machine::ZTNormalizer& self,
+  bob::python::const_ndarray scores, const size_t first_model)
+{
+  self.accumulateZNorm(scores.bz<double,2>(), first_model);
+}
+
+static void ztn_accumulate_ztnorm(bob::machine::ZTNormalizer& self,
+  bob::python::const_ndarray scores, const size_t first_tmodel)
+{
+  self.accumulateZTNorm(scores.bz<double,2>(), first_tmodel);
+}
+
+static void ztn_accumulate_ztnorm_mask(bob::machine::ZTNormalizer& self,
+  bob::python::const_ndarray scores, bob::python::const_ndarray mask,
+  const size_t first_tmodel)
+{
+  self.accumulateZTNorm(scores.bz<double,2>(), mask.bz<bool,2>(), first_tmodel);
+}
+
+static void ztn_accumulate_tnorm(bob::machine::ZTNormalizer& self,
+  bob::python::const_ndarray scores, const size_t first_tmodel,
+  const size_t first_probe)
+{
+  self.accumulateTNorm(scores.bz<double,2>(), first_tmodel, first_probe);
+}
+
+static void ztn_accumulate_znorm_file(bob::machine::ZTNormalizer& self,
+  bob::io::HDF5File& file, const std::string& path)
+{
+  self.accumulateZNorm(file, path);
+}
+
+static void ztn_accumulate_ztnorm_file(bob::machine::ZTNormalizer& self,
+  bob::io::HDF5File& file, const std::string& path)
+{
+  self.accumulateZTNorm(file, path);
+}
+
+static void ztn_accumulate_tnorm_file(bob::machine::ZTNormalizer& self,
+  bob::io::HDF5File& file, const std::string& path)
+{
+  self.accumulateTNorm(file, path);
+}
+
+static object ztn_normalize(bob::machine::ZTNormalizer& self,
+  bob::python::const_ndarray scores, const size_t first_model,
+  const size_t first_probe)
+{
+  const blitz::Array<double,2> scores_ = scores.bz<double,2>();
+  bob::python::ndarray ret(bob::core::array::t_float64, scores_.extent(0), scores_.extent(1));
+  blitz::Array<double,2> ret_ = ret.bz<double,2>();
+  self.normalize(scores_, first_model, first_probe, ret_);
+  return ret.self();
+}
+
+static object ztn_symmetric_normalize(bob::machine::ZTNormalizer& self,
+  bob::python::const_ndarray scores, const size_t first_model,
+  const size_t first_probe)
+{
+  const blitz::Array<double,2> scores_ = scores.bz<double,2>();
+  bob::python::ndarray ret(bob::core::array::t_float64, scores_.extent(0), scores_.extent(1));
+  blitz::Array<double,2> ret_ = ret.bz<double,2>();
+  self.symmetricNormalize(scores_, first_model, first_probe, ret_);
+  return ret.self();
+}
+
+static void ztn_normalize_file(bob::machine::ZTNormalizer& self,
+  bob::io::HDF5File& input_file, const std::string& input_path,
+  bob::io::HDF5File& output_file, const std::string& output_path,
+  const bool symmetric)
+{
+  self.normalize(input_file, input_path, output_file, output_path, symmetric);
+}
+
 void bind_machine_ztnorm() 
 {
   def("ztnorm",
@@ -163,4 +238,22 @@ void bind_machine_ztnorm()
       "Normalise raw scores with Z-Norm."
      );
 
+  class_<bob::machine::ZTNormalizer, boost::shared_ptr<bob::machine::ZTNormalizer> >("ZTNormalizer",
+      "Z-, T-, ZT- and symmetric normalization of scores, from cohort statistics accumulated over blocks of cohort scores (e.g. streamed from HDF5 files). The mean and standard deviation of the cohort scores of each model (Z-norm) and of each probe (T-norm) are accumulated in a single pass, and the raw scores are then normalized in parallel (see bob.core.set_n_threads()). If top_n is non zero, only the top_n highest cohort scores of each model and probe are used (adaptive cohort selection, e.g. for AS-norm).",
+      init<const size_t, const size_t, const size_t>((arg("self"), arg("n_models"), arg("n_probes"), arg("top_n")=0), "Creates a normalizer for the given number of models and probes."))
+    .add_property("n_models", &bob::machine::ZTNormalizer::getNModels, "The number of models")
+    .add_property("n_probes", &bob::machine::ZTNormalizer::getNProbes, "The number of probes")
+    .add_property("top_n", &bob::machine::ZTNormalizer::getTopN, "The size of the adaptive cohorts (0 if disabled)")
+    .def("reset", &bob::machine::ZTNormalizer::reset, (arg("self")), "Forgets all the accumulated statistics.")
+    .def("accumulate_znorm", &ztn_accumulate_znorm, (arg("self"), arg("rawscores_zprobes_vs_models"), arg("first_model")=0), "Accumulates the scores of the models [first_model, first_model+rawscores_zprobes_vs_models.shape[0][ against some Z-norm probes.")
+    .def("accumulate_ztnorm", &ztn_accumulate_ztnorm, (arg("self"), arg("rawscores_zprobes_vs_tmodels"), arg("first_tmodel")=0), "Accumulates the scores of the T-norm models [first_tmodel, first_tmodel+rawscores_zprobes_vs_tmodels.shape[0][ against some Z-norm probes. These scores should be accumulated before the T-norm scores.")
+    .def("accumulate_ztnorm", &ztn_accumulate_ztnorm_mask, (arg("self"), arg("rawscores_zprobes_vs_tmodels"), arg("mask_zprobes_vs_tmodels_istruetrial"), arg("first_tmodel")=0), "Accumulates the scores of the T-norm models [first_tmodel, first_tmodel+rawscores_zprobes_vs_tmodels.shape[0][ against some Z-norm probes, skipping the true trials given by the mask.")
+    .def("accumulate_tnorm", &ztn_accumulate_tnorm, (arg("self"), arg("rawscores_probes_vs_tmodels"), arg("first_tmodel")=0, arg("first_probe")=0), "Accumulates the scores of the T-norm models [first_tmodel, first_tmodel+rawscores_probes_vs_tmodels.shape[0][ against the probes [first_probe, first_probe+rawscores_probes_vs_tmodels.shape[1][.")
+    .def("accumulate_znorm_from_file", &ztn_accumulate_znorm_file, (arg("self"), arg("file"), arg("path")), "Accumulates the scores of the models against the Z-norm probes, stored as one array per model in the given dataset of the HDF5 file. The dataset is read by blocks.")
+    .def("accumulate_ztnorm_from_file", &ztn_accumulate_ztnorm_file, (arg("self"), arg("file"), arg("path")), "Accumulates the scores of the T-norm models against the Z-norm probes, stored as one array per T-norm model in the given dataset of the HDF5 file. The dataset is read by blocks.")
+    .def("accumulate_tnorm_from_file", &ztn_accumulate_tnorm_file, (arg("self"), arg("file"), arg("path")), "Accumulates the scores of the T-norm models against the probes, stored as one array per T-norm model in the given dataset of the HDF5 file. The dataset is read by blocks.")
+    .def("normalize", &ztn_normalize, (arg("self"), arg("rawscores_probes_vs_models"), arg("first_model")=0, arg("first_probe")=0), "Normalizes the raw scores of the models [first_model, first_model+rawscores_probes_vs_models.shape[0][ against the probes [first_probe, first_probe+rawscores_probes_vs_models.shape[1][ with the accumulated statistics, and returns the normalized scores.")
+    .def("symmetric_normalize", &ztn_symmetric_normalize, (arg("self"), arg("rawscores_probes_vs_models"), arg("first_model")=0, arg("first_probe")=0), "Normalizes the raw scores with the symmetric normalization (S-norm, or AS-norm if top_n is non zero), which averages the Z-normalized and T-normalized scores, and returns the normalized scores. Both Z-norm and T-norm statistics are required.")
+    .def("normalize_file", &ztn_normalize_file, (arg("self"), arg("input_file"), arg("input_path"), arg("output_file"), arg("output_path"), arg("symmetric")=false), "Normalizes the raw scores stored as one array per model in the given dataset of the input HDF5 file, and appends the normalized scores to the given dataset of the output HDF5 file, by blocks.")
+  ;
 }
@@ -0,0 +1,135 @@
+/**
+ * @file math/cxx/benchmark/prod.cc
+ * @date Sat Oct 17 11:48:02 CEST 2026
+ * @author Laurent El Shafey <Laurent.El-Shafey@idiap.ch>
+ *
+ * @brief Benchmark of the matrix-matrix and matrix-vector products: blitz
+ * expression template, built-in blocked kernel and BLAS
+ *
+ * Copyright (C) 2011-2013 Idiap Research Institute, Martigny, Switzerland
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <bob/core/array_random.h>
+#include <bob/math/linear.h>
+
+#include <boost/random.hpp>
+#include <boost/date_time/posix_time/posix_time.hpp>
+#include <iostream>
+#include <algorithm>
+
+void benchmark_gemm(const blitz::Array<double,2>& A, 
+  const blitz::Array<double,2>& B, const int n_calls)
+{
+  const int M = A.extent(0);
+  const int K = A.extent(1);
+  const int N = B.extent(1);
+  blitz::Array<double,2> C(M, N);
+  boost::posix_time::ptime t1;
+  boost::posix_time::ptime t2;
+  boost::posix_time::time_duration diff;
+
+  std::cout << "Matrix-matrix product " << M << "x" << K << " * " << K << "x" << N << " (" << n_calls << " calls)..." << std::endl;
+
+  // blitz expression template
+  t1 = boost::posix_time::microsec_clock::local_time();
+  for (int i=0; i<n_calls; ++i) bob::math::prod_<double,double,double>(A, B, C);
+  t2 = boost::posix_time::microsec_clock::local_time();
+  diff = t2 - t1;
+  std::cout << "  Expression template (microseconds/call) " << diff.total_microseconds() / (double)n_calls << std::endl;
+
+  // built-in blocked kernel
+  t1 = boost::posix_time::microsec_clock::local_time();
+  for (int i=0; i<n_calls; ++i) bob::math::detail::prodBlocked_(A, B, C);
+  t2 = boost::posix_time::microsec_clock::local_time();
+  diff = t2 - t1;
+  std::cout << "  Blocked kernel (microseconds/call) " << diff.total_microseconds() / (double)n_calls << std::endl;
+
+  // BLAS
+  t1 = boost::posix_time::microsec_clock::local_time();
+  for (int i=0; i<n_calls; ++i) bob::math::detail::prodBlas_(A, B, C);
+  t2 = boost::posix_time::microsec_clock::local_time();
+  diff = t2 - t1;
+  std::cout << "  BLAS dgemm (microseconds/call) " << diff.total_microseconds() / (double)n_calls << std::endl;
+
+  // automatic dispatch
+  t1 = boost::posix_time::microsec_clock::local_time();
+  for (int i=0; i<n_calls; ++i) bob::math::prod_(A, B, C);
+  t2 = boost::posix_time::microsec_clock::local_time();
+  diff = t2 - t1;
+  std::cout << "  Dispatched prod_ (microseconds/call) " << diff.total_microseconds() / (double)n_calls << std::endl;
+}
+
+void benchmark_gemv(const blitz::Array<double,2>& A,
+  const blitz::Array<double,1>& b, const int n_calls)
+{
+  const int M = A.extent(0);
+  const int N = A.extent(1);
+  blitz::Array<double,1> c(M);
+  boost::posix_time::ptime t1;
+  boost::posix_time::ptime t2;
+  boost::posix_time::time_duration diff;
+
+  std::cout << "Matrix-vector product " << M << "x" << N << " * " << N << " (" << n_calls << " calls)..." << std::endl;
+
+  // blitz expression template
+  t1 = boost::posix_time::microsec_clock::local_time();
+  for (int i=0; i<n_calls; ++i) bob::math::prod_<double,double,double>(A, b, c);
+  t2 = boost::posix_time::microsec_clock::local_time();
+  diff = t2 - t1;
+  std::cout << "  Expression template (microseconds/call) " << diff.total_microseconds() / (double)n_calls << std::endl;
+
+  // built-in kernel
+  t1 = boost::posix_time::microsec_clock::local_time();
+  for (int i=0; i<n_calls; ++i) bob::math::detail::prodBlocked_(A, b, c);
+  t2 = boost::posix_time::microsec_clock::local_time();
+  diff = t2 - t1;
+  std::cout << "  Built-in kernel (microseconds/call) " << diff.total_microseconds() / (double)n_calls << std::endl;
+
+  // BLAS
+  t1 = boost::posix_time::microsec_clock::local_time();
+  for (int i=0; i<n_calls; ++i) bob::math::detail::prodBlas_(A, b, c);
+  t2 = boost::posix_time::microsec_clock::local_time();
+  diff = t2 - t1;
+  std::cout << "  BLAS dgemv (microseconds/call) " << diff.total_microseconds() / (double)n_calls << std::endl;
+}
+
+int main()
+{
+  boost::mt19937 rng(0);
+
+  int dims[6] = {8, 16, 64, 128, 256, 512};
+  for(int i=0; i<6; ++i)
+  {
+    const int M = dims[i];
+    blitz::Array<double,2> A(M,M), B(M,M);
+    bob::core::array::randn(rng, A);
+    bob::core::array::randn(rng, B);
+    // Benchmark
+    benchmark_gemm(A, B, std::max(1, (1<<24) / (M*M*M)));
+  }
+
+  for(int i=0; i<6; ++i)
+  {
+    const int M = dims[i];
+    blitz::Array<double,2> A(M,M);
+    blitz::Array<double,1> b(M);
+    bob::core::array::randn(rng, A);
+    bob::core::array::randn(rng, b);
+    // Benchmark
+    benchmark_gemv(A, b, std::max(1, (1<<24) / (M*M)));
+  }
+
+  return 0;
+}
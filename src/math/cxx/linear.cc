@@ -0,0 +1,415 @@
+/**
+ * @file math/cxx/linear.cc
+ * @date Sat Oct 17 11:02:45 CEST 2026
+ * @author Laurent El Shafey <Laurent.El-Shafey@idiap.ch>
+ *
+ * @brief Double precision matrix-matrix and matrix-vector products, using
+ * BLAS or a built-in cache-blocked kernel.
+ *
+ * Copyright (C) 2011-2013 Idiap Research Institute, Martigny, Switzerland
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <bob/math/linear.h>
+#include <vector>
+#include <algorithm>
+#include <cstddef>
+#include <cstdlib>
+
+// Declaration of the external BLAS functions
+// General matrix-matrix multiplication (dgemm)
+extern "C" void dgemm_(const char *transa, const char *transb, const int *M,
+  const int *N, const int *K, const double *alpha, const double *A,
+  const int *lda, const double *B, const int *ldb, const double *beta,
+  double *C, const int *ldc);
+// General matrix-vector multiplication (dgemv)
+extern "C" void dgemv_(const char *trans, const int *M, const int *N,
+  const double *alpha, const double *A, const int *lda, const double *x,
+  const int *incx, const double *beta, double *y, const int *incy);
+
+namespace {
+
+  /**
+   * Below these numbers of multiply-adds, the BLAS call overhead is not
+   * amortized and the built-in kernels are used instead.
+   */
+  const double BLAS_GEMM_MIN_SIZE = 32.*32.*32.;
+  const double BLAS_GEMV_MIN_SIZE = 32.*32.;
+
+  /**
+   * Blocking parameters of the built-in kernel: the MRxNR block of C is
+   * kept in registers, a MCxKC block of A fits in the L2 cache and a KCxNR
+   * panel of B in the L1 cache.
+   */
+  const int MR = 4;
+  const int NR = 4;
+  const int MC = 128;
+  const int KC = 256;
+  const int NC = 4096;
+
+  /**
+   * Tells how (Fortran) BLAS can see a r x c matrix with strides s0 and s1.
+   * If row_major is set, the buffer holds the transpose of the matrix in
+   * column-major order, otherwise it holds the matrix itself in
+   * column-major order. ld is the leading dimension. Returns false if BLAS
+   * cannot handle the layout (e.g. both strides differ from one or are
+   * negative).
+   */
+  bool blasLayout(const int r, const int c, const std::ptrdiff_t s0,
+    const std::ptrdiff_t s1, bool& row_major, int& ld)
+  {
+    if ((c == 1 || s1 == 1) && (r == 1 || s0 >= std::max(1,c))) {
+      row_major = true;
+      ld = (r == 1 ? std::max(1,c) : (int)s0);
+      return true;
+    }
+    if ((r == 1 || s0 == 1) && (c == 1 || s1 >= std::max(1,r))) {
+      row_major = false;
+      ld = (c == 1 ? std::max(1,r) : (int)s1);
+      return true;
+    }
+    return false;
+  }
+
+  bool blasLayout(const blitz::Array<double,2>& A, bool& row_major, int& ld)
+  {
+    return blasLayout(A.extent(0), A.extent(1), A.stride(0), A.stride(1),
+      row_major, ld);
+  }
+
+  /**
+   * Returns a positive increment usable by BLAS for a vector of n elements
+   * with stride s, or 0 if there is none.
+   */
+  int blasIncrement(const int n, const std::ptrdiff_t s)
+  {
+    if (n <= 1) return 1;
+    return (s > 0 ? (int)s : 0);
+  }
+
+  /**
+   * Memory range spanned by an array
+   */
+  template <int N>
+  void memoryRange(const blitz::Array<double,N>& a, const double*& lo,
+    const double*& hi)
+  {
+    lo = hi = a.data();
+    for (int d=0; d<N; ++d) {
+      const std::ptrdiff_t offset =
+        (std::ptrdiff_t)(a.extent(d)-1) * a.stride(d);
+      if (offset < 0) lo += offset;
+      else hi += offset;
+    }
+  }
+
+  template <int N1, int N2>
+  bool overlap(const blitz::Array<double,N1>& a,
+    const blitz::Array<double,N2>& b)
+  {
+    if (a.size() == 0 || b.size() == 0) return false;
+    const double *a_lo, *a_hi, *b_lo, *b_hi;
+    memoryRange(a, a_lo, a_hi);
+    memoryRange(b, b_lo, b_hi);
+    return !(a_hi < b_lo || b_hi < a_lo);
+  }
+
+  /**
+   * Copies a mc x kc block of A into consecutive panels of MR rows, stored
+   * column after column. The last panel is padded with zeros.
+   */
+  void packA(const int mc, const int kc, const double* A,
+    const std::ptrdiff_t sa0, const std::ptrdiff_t sa1, double* buf)
+  {
+    for (int i=0; i<mc; i+=MR) {
+      const int mr = std::min(MR, mc-i);
+      const double* a = A + i*sa0;
+      for (int k=0; k<kc; ++k, buf+=MR) {
+        int ii=0;
+        for (; ii<mr; ++ii) buf[ii] = a[ii*sa0 + k*sa1];
+        for (; ii<MR; ++ii) buf[ii] = 0.;
+      }
+    }
+  }
+
+  /**
+   * Copies a kc x nc block of B into consecutive panels of NR columns,
+   * stored row after row. The last panel is padded with zeros.
+   */
+  void packB(const int kc, const int nc, const double* B,
+    const std::ptrdiff_t sb0, const std::ptrdiff_t sb1, double* buf)
+  {
+    for (int j=0; j<nc; j+=NR) {
+      const int nr = std::min(NR, nc-j);
+      const double* b = B + j*sb1;
+      for (int k=0; k<kc; ++k, buf+=NR) {
+        int jj=0;
+        for (; jj<nr; ++jj) buf[jj] = b[k*sb0 + jj*sb1];
+        for (; jj<NR; ++jj) buf[jj] = 0.;
+      }
+    }
+  }
+
+  /**
+   * Accumulates the product of a packed A panel and a packed B panel into
+   * the mr x nr top-left part of the MRxNR block of C. The fixed-size
+   * accumulator and inner loops are unrolled and vectorized by the
+   * compiler.
+   */
+  void microKernel(const int kc, const double* a, const double* b,
+    double* C, const std::ptrdiff_t sc0, const std::ptrdiff_t sc1,
+    const int mr, const int nr)
+  {
+    double acc[MR][NR];
+    for (int ii=0; ii<MR; ++ii)
+      for (int jj=0; jj<NR; ++jj)
+        acc[ii][jj] = 0.;
+
+    for (int k=0; k<kc; ++k, a+=MR, b+=NR)
+      for (int ii=0; ii<MR; ++ii)
+        for (int jj=0; jj<NR; ++jj)
+          acc[ii][jj] += a[ii] * b[jj];
+
+    for (int ii=0; ii<mr; ++ii)
+      for (int jj=0; jj<nr; ++jj)
+        C[ii*sc0 + jj*sc1] += acc[ii][jj];
+  }
+
+  /**
+   * Cache-blocked C=A*B for arbitrary strides
+   */
+  void gemmBlocked(const int M, const int N, const int K,
+    const double* A, const std::ptrdiff_t sa0, const std::ptrdiff_t sa1,
+    const double* B, const std::ptrdiff_t sb0, const std::ptrdiff_t sb1,
+    double* C, const std::ptrdiff_t sc0, const std::ptrdiff_t sc1)
+  {
+    for (int i=0; i<M; ++i)
+      for (int j=0; j<N; ++j)
+        C[i*sc0 + j*sc1] = 0.;
+    if (M == 0 || N == 0 || K == 0) return;
+
+    const int kc_max = std::min(KC, K);
+    const int mc_max = std::min(MC, (M+MR-1)/MR*MR);
+    const int nc_max = std::min(NC, (N+NR-1)/NR*NR);
+    std::vector<double> bufA(mc_max*kc_max);
+    std::vector<double> bufB(kc_max*nc_max);
+
+    for (int jc=0; jc<N; jc+=NC) {
+      const int nc = std::min(NC, N-jc);
+      for (int pc=0; pc<K; pc+=KC) {
+        const int kc = std::min(KC, K-pc);
+        packB(kc, nc, B + pc*sb0 + jc*sb1, sb0, sb1, &bufB[0]);
+        for (int ic=0; ic<M; ic+=MC) {
+          const int mc = std::min(MC, M-ic);
+          packA(mc, kc, A + ic*sa0 + pc*sa1, sa0, sa1, &bufA[0]);
+          for (int jr=0; jr<nc; jr+=NR)
+            for (int ir=0; ir<mc; ir+=MR)
+              microKernel(kc, &bufA[ir*kc], &bufB[jr*kc],
+                C + (ic+ir)*sc0 + (jc+jr)*sc1, sc0, sc1,
+                std::min(MR, mc-ir), std::min(NR, nc-jr));
+        }
+      }
+    }
+  }
+
+  /**
+   * c=A*b for arbitrary strides. The traversal order follows the smallest
+   * stride of A.
+   */
+  void gemvStrided(const int M, const int N,
+    const double* A, const std::ptrdiff_t sa0, const std::ptrdiff_t sa1,
+    const double* b, const std::ptrdiff_t sb, double* c,
+    const std::ptrdiff_t sc)
+  {
+    if (std::abs(sa1) <= std::abs(sa0)) {
+      // dot products along the rows of A, with independent accumulators
+      for (int i=0; i<M; ++i) {
+        const double* a = A + i*sa0;
+        double acc[4] = {0., 0., 0., 0.};
+        int j=0;
+        for (; j+3<N; j+=4) {
+          acc[0] += a[j*sa1] * b[j*sb];
+          acc[1] += a[(j+1)*sa1] * b[(j+1)*sb];
+          acc[2] += a[(j+2)*sa1] * b[(j+2)*sb];
+          acc[3] += a[(j+3)*sa1] * b[(j+3)*sb];
+        }
+        for (; j<N; ++j) acc[0] += a[j*sa1] * b[j*sb];
+        c[i*sc] = (acc[0] + acc[1]) + (acc[2] + acc[3]);
+      }
+    }
+    else {
+      // linear combination of the columns of A
+      for (int i=0; i<M; ++i) c[i*sc] = 0.;
+      for (int j=0; j<N; ++j) {
+        const double* a = A + j*sa1;
+        const double bj = b[j*sb];
+        for (int i=0; i<M; ++i) c[i*sc] += a[i*sa0] * bj;
+      }
+    }
+  }
+
+  /**
+   * c=A*b with BLAS, for a M x N matrix A given by its strides. Returns
+   * false if BLAS cannot handle the layout of the arrays.
+   */
+  bool gemvBlas(const int M, const int N,
+    const double* A, const std::ptrdiff_t sa0, const std::ptrdiff_t sa1,
+    const double* b, const std::ptrdiff_t sb, double* c,
+    const std::ptrdiff_t sc)
+  {
+    bool a_row;
+    int lda;
+    const int incb = blasIncrement(N, sb);
+    const int incc = blasIncrement(M, sc);
+    if (!blasLayout(M, N, sa0, sa1, a_row, lda) || incb == 0 || incc == 0)
+      return false;
+
+    if (M == 0) return true;
+    if (N == 0) {
+      for (int i=0; i<M; ++i) c[i*sc] = 0.;
+      return true;
+    }
+
+    const double alpha = 1.;
+    const double beta = 0.;
+    if (a_row) {
+      // The buffer of A holds A^T in column-major order
+      const char trans = 'T';
+      dgemv_(&trans, &N, &M, &alpha, A, &lda, b, &incb, &beta, c, &incc);
+    }
+    else {
+      const char trans = 'N';
+      dgemv_(&trans, &M, &N, &alpha, A, &lda, b, &incb, &beta, c, &incc);
+    }
+    return true;
+  }
+
+}
+
+bool bob::math::detail::prodBlas_(const blitz::Array<double,2>& A,
+  const blitz::Array<double,2>& B, blitz::Array<double,2>& C)
+{
+  bool a_row, b_row, c_row;
+  int lda, ldb, ldc;
+  if (!blasLayout(A, a_row, lda) || !blasLayout(B, b_row, ldb) ||
+      !blasLayout(C, c_row, ldc))
+    return false;
+
+  const int M = A.extent(0);
+  const int N = B.extent(1);
+  const int K = A.extent(1);
+  if (M == 0 || N == 0) return true;
+  if (K == 0) {
+    C = 0.;
+    return true;
+  }
+
+  const double alpha = 1.;
+  const double beta = 0.;
+  if (c_row) {
+    // The buffer of C holds C^T in column-major order: compute C^T=B^T*A^T
+    const char transa = (a_row ? 'N' : 'T');
+    const char transb = (b_row ? 'N' : 'T');
+    dgemm_(&transb, &transa, &N, &M, &K, &alpha, B.data(), &ldb, A.data(),
+      &lda, &beta, C.data(), &ldc);
+  }
+  else {
+    const char transa = (a_row ? 'T' : 'N');
+    const char transb = (b_row ? 'T' : 'N');
+    dgemm_(&transa, &transb, &M, &N, &K, &alpha, A.data(), &lda, B.data(),
+      &ldb, &beta, C.data(), &ldc);
+  }
+  return true;
+}
+
+void bob::math::detail::prodBlocked_(const blitz::Array<double,2>& A,
+  const blitz::Array<double,2>& B, blitz::Array<double,2>& C)
+{
+  gemmBlocked(A.extent(0), B.extent(1), A.extent(1),
+    A.data(), A.stride(0), A.stride(1),
+    B.data(), B.stride(0), B.stride(1),
+    C.data(), C.stride(0), C.stride(1));
+}
+
+bool bob::math::detail::prodBlas_(const blitz::Array<double,2>& A,
+  const blitz::Array<double,1>& b, blitz::Array<double,1>& c)
+{
+  return gemvBlas(A.extent(0), A.extent(1), A.data(), A.stride(0),
+    A.stride(1), b.data(), b.stride(0), c.data(), c.stride(0));
+}
+
+void bob::math::detail::prodBlocked_(const blitz::Array<double,2>& A,
+  const blitz::Array<double,1>& b, blitz::Array<double,1>& c)
+{
+  gemvStrided(A.extent(0), A.extent(1), A.data(), A.stride(0), A.stride(1),
+    b.data(), b.stride(0), c.data(), c.stride(0));
+}
+
+void bob::math::prod_(const blitz::Array<double,2>& A,
+  const blitz::Array<double,2>& B, blitz::Array<double,2>& C)
+{
+  // Computes in a temporary array if the output overlaps one of the inputs
+  if (overlap(A, C) || overlap(B, C)) {
+    blitz::Array<double,2> tmp(C.extent(0), C.extent(1));
+    bob::math::prod_(A, B, tmp);
+    C = tmp;
+    return;
+  }
+
+  const double size = (double)A.extent(0) * A.extent(1) * B.extent(1);
+  if (size >= BLAS_GEMM_MIN_SIZE && bob::math::detail::prodBlas_(A, B, C))
+    return;
+  bob::math::detail::prodBlocked_(A, B, C);
+}
+
+void bob::math::prod_(const blitz::Array<double,2>& A,
+  const blitz::Array<double,1>& b, blitz::Array<double,1>& c)
+{
+  // Computes in a temporary array if the output overlaps one of the inputs
+  if (overlap(A, c) || overlap(b, c)) {
+    blitz::Array<double,1> tmp(c.extent(0));
+    bob::math::prod_(A, b, tmp);
+    c = tmp;
+    return;
+  }
+
+  const double size = (double)A.extent(0) * A.extent(1);
+  if (size >= BLAS_GEMV_MIN_SIZE && bob::math::detail::prodBlas_(A, b, c))
+    return;
+  bob::math::detail::prodBlocked_(A, b, c);
+}
+
+void bob::math::prod_(const blitz::Array<double,1>& a,
+  const blitz::Array<double,2>& B, blitz::Array<double,1>& c)
+{
+  // Computes in a temporary array if the output overlaps one of the inputs
+  if (overlap(B, c) || overlap(a, c)) {
+    blitz::Array<double,1> tmp(c.extent(0));
+    bob::math::prod_(a, B, tmp);
+    c = tmp;
+    return;
+  }
+
+  // c = a*B = B^T*a, where B^T is seen through the swapped extents and
+  // strides of B rather than through a view, such that B may be shared by
+  // the threads of a parallel loop
+  const int M = B.extent(1);
+  const int N = B.extent(0);
+  const double size = (double)M * N;
+  if (size >= BLAS_GEMV_MIN_SIZE && gemvBlas(M, N, B.data(), B.stride(1),
+        B.stride(0), a.data(), a.stride(0), c.data(), c.stride(0)))
+    return;
+  gemvStrided(M, N, B.data(), B.stride(1), B.stride(0), a.data(),
+    a.stride(0), c.data(), c.stride(0));
+}
@@ -25,6 +25,8 @@
 #define BOOST_TEST_MAIN
 #include <boost/test/unit_test.hpp>
 #include <bob/math/linear.h>
+#include <bob/core/array_random.h>
+#include <boost/random.hpp>
 
 
 struct T {
@@ -189,4 +191,77 @@ BOOST_AUTO_TEST_CASE( test_diag_bis )
   checkBlitzClose(dsol_diag_44, sol4, eps);
 }
 
+BOOST_AUTO_TEST_CASE( test_matrix_matrix_prod_backends )
+{
+  // Compares the BLAS and blocked backends with the expression template
+  // for C-ordered, transposed and strided operands of various sizes
+  boost::mt19937 rng(0);
+  const int dims[4][3] = {{1,1,1}, {5,7,3}, {37,65,130}, {130,33,257}};
+  for (int d=0; d<4; ++d) {
+    const int M = dims[d][0], K = dims[d][1], N = dims[d][2];
+    blitz::Array<double,2> A(M,K), Bt(N,2*K), C_ref(M,N), C(M,N), Ct(N,M);
+    bob::core::array::randn(rng, A);
+    bob::core::array::randn(rng, Bt);
+    // B is a transposed and strided view
+    blitz::Array<double,2> B = Bt(blitz::Range::all(), blitz::Range(0,2*K-1,2)).transpose(1,0);
+    bob::math::prod_<double,double,double>(A, B, C_ref);
+
+    bob::math::detail::prodBlocked_(A, B, C);
+    checkBlitzClose(C_ref, C, eps);
+
+    bob::math::prod(A, B, C);
+    checkBlitzClose(C_ref, C, eps);
+
+    // BLAS cannot handle the strided view, but can handle its copy
+    BOOST_CHECK(!bob::math::detail::prodBlas_(A, B, C));
+    blitz::Array<double,2> B_copy = B.copy();
+    C = 0.;
+    BOOST_CHECK(bob::math::detail::prodBlas_(A, B_copy, C));
+    checkBlitzClose(C_ref, C, eps);
+
+    // Column-major output
+    blitz::Array<double,2> C_t = Ct.transpose(1,0);
+    BOOST_CHECK(bob::math::detail::prodBlas_(A.transpose(1,0).copy().transpose(1,0), B_copy, C_t));
+    checkBlitzClose(C_ref, C_t, eps);
+  }
+}
+
+BOOST_AUTO_TEST_CASE( test_matrix_vector_prod_backends )
+{
+  boost::mt19937 rng(0);
+  const int dims[3][2] = {{1,1}, {5,7}, {130,65}};
+  for (int d=0; d<3; ++d) {
+    const int M = dims[d][0], N = dims[d][1];
+    blitz::Array<double,2> A(M,N);
+    blitz::Array<double,1> b(N), c_ref(M), c(M), d_ref(N), d_(N), a(M);
+    bob::core::array::randn(rng, A);
+    bob::core::array::randn(rng, b);
+    bob::core::array::randn(rng, a);
+    bob::math::prod_<double,double,double>(A, b, c_ref);
+    bob::math::prod_<double,double,double>(a, A, d_ref);
+
+    bob::math::detail::prodBlocked_(A, b, c);
+    checkBlitzClose(c_ref, c, eps);
+    BOOST_CHECK(bob::math::detail::prodBlas_(A, b, c));
+    checkBlitzClose(c_ref, c, eps);
+    bob::math::prod(A, b, c);
+    checkBlitzClose(c_ref, c, eps);
+    bob::math::prod(a, A, d_);
+    checkBlitzClose(d_ref, d_, eps);
+    // Column-major matrix
+    blitz::Array<double,2> A_t = A.transpose(1,0).copy().transpose(1,0);
+    bob::math::prod(a, A_t, d_);
+    checkBlitzClose(d_ref, d_, eps);
+  }
+}
+
+BOOST_AUTO_TEST_CASE( test_matrix_matrix_prod_inplace )
+{
+  // The output may overlap the inputs
+  blitz::Array<double,2> A(Asol_eye_44.copy());
+  blitz::Array<double,2> B(Asol_44.copy());
+  bob::math::prod(A, B, B);
+  checkBlitzClose(Asol_44, B, eps);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,101 @@
+/**
+ * @file measure/cxx/benchmark/error.cc
+ * @date Sat Oct 17 16:05:37 CEST 2026
+ * @author Laurent El Shafey <Laurent.El-Shafey@idiap.ch>
+ *
+ * @brief Benchmark the computation of ROC curves and thresholds on large
+ * synthetic score sets, with a scan of the scores per threshold and with
+ * sorted scores
+ *
+ * Copyright (C) 2011-2013 Idiap Research Institute, Martigny, Switzerland
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <bob/core/array_random.h>
+#include <bob/core/parallel.h>
+#include <bob/measure/error.h>
+
+#include <boost/random.hpp>
+#include <boost/date_time/posix_time/posix_time.hpp>
+#include <iostream>
+#include <cstdlib>
+
+void benchmark_roc(const blitz::Array<double,1>& negatives,
+  const blitz::Array<double,1>& positives, const size_t points)
+{
+  boost::posix_time::ptime t1;
+  boost::posix_time::ptime t2;
+  boost::posix_time::time_duration diff;
+
+  std::cout << "ROC of " << points << " points on " << negatives.extent(0) << " negatives and " << positives.extent(0) << " positives..." << std::endl;
+
+  // scan of all the scores for each threshold (timed on a few thresholds
+  // only, as the cost is the same for all of them)
+  const int n_scans = 10;
+  t1 = boost::posix_time::microsec_clock::local_time();
+  for (int i=0; i<n_scans; ++i) bob::measure::farfrr(negatives, positives, i*0.1);
+  t2 = boost::posix_time::microsec_clock::local_time();
+  diff = t2 - t1;
+  std::cout << "  Scan per threshold, extrapolated (microseconds/call) " << diff.total_microseconds() * (double)points / n_scans << std::endl;
+
+  // sort once, binary search per threshold
+  t1 = boost::posix_time::microsec_clock::local_time();
+  bob::measure::roc(negatives, positives, points);
+  t2 = boost::posix_time::microsec_clock::local_time();
+  diff = t2 - t1;
+  std::cout << "  Sorted scores (microseconds/call) " << diff.total_microseconds() << std::endl;
+
+  // sort only
+  t1 = boost::posix_time::microsec_clock::local_time();
+  bob::measure::SortedScores scores(negatives, positives);
+  t2 = boost::posix_time::microsec_clock::local_time();
+  diff = t2 - t1;
+  std::cout << "  Sort of the scores (microseconds/call) " << diff.total_microseconds() << std::endl;
+
+  // curves and thresholds on the already sorted scores
+  t1 = boost::posix_time::microsec_clock::local_time();
+  bob::measure::roc(scores, points);
+  bob::measure::eerThreshold(scores);
+  bob::measure::minHterThreshold(scores);
+  bob::measure::farThreshold(scores, 0.001);
+  bob::measure::frrThreshold(scores, 0.001);
+  t2 = boost::posix_time::microsec_clock::local_time();
+  diff = t2 - t1;
+  std::cout << "  ROC, EER, min-HTER, FAR and FRR thresholds on sorted scores (microseconds/call) " << diff.total_microseconds() << std::endl;
+}
+
+/**
+ * Usage: bob_measure_error [max_negatives]
+ * The number of negatives goes from 10^6 up to max_negatives (default:
+ * 10^7; use 100000000 to reach 10^8, which needs about 2GB of memory). There
+ * are 100 times less positives.
+ */
+int main(int argc, char** argv)
+{
+  const size_t max_negatives = argc > 1 ? strtoul(argv[1], 0, 10) : 10000000;
+  boost::mt19937 rng(0);
+
+  std::cout << "Using " << bob::core::getNThreads() << " threads to sort" << std::endl;
+  for (size_t n=1000000; n<=max_negatives; n*=10)
+  {
+    blitz::Array<double,1> negatives(n), positives(n/100);
+    bob::core::array::randn(rng, negatives);
+    bob::core::array::randn(rng, positives);
+    positives += 2.;
+    // Benchmark
+    benchmark_roc(negatives, positives, 1000);
+  }
+
+  return 0;
+}
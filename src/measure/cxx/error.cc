@@ -29,6 +29,7 @@
 #include <bob/core/cast.h>
 #include <bob/math/pavx.h>
 #include <bob/math/linsolve.h>
+#include <bob/core/parallel.h>
 
 std::pair<double, double> bob::measure::farfrr(const blitz::Array<double,1>& negatives,
     const blitz::Array<double,1>& positives, double threshold) {
@@ -42,6 +43,139 @@ std::pair<double, double> bob::measure::farfrr(const blitz::Array<double,1>& neg
       false_rejects/(double)total_positives);
 }
 
+/**
+ * Below this number of scores, sorting is not worth being parallelized
+ */
+static const size_t PARALLEL_SORT_MIN = 1 << 16;
+
+/**
+ * Sorts the chunks [bounds[k], bounds[k+1]) of a vector
+ */
+struct SortChunks {
+  SortChunks(std::vector<double>& v, const std::vector<size_t>& bounds):
+    m_v(v), m_bounds(bounds) {}
+
+  void operator()(size_t begin, size_t end, size_t) const {
+    for (size_t k=begin; k<end; ++k)
+      std::sort(m_v.begin()+m_bounds[k], m_v.begin()+m_bounds[k+1]);
+  }
+
+  std::vector<double>& m_v;
+  const std::vector<size_t>& m_bounds;
+};
+
+/**
+ * Merges pairs of consecutive sorted runs of <width> chunks each
+ */
+struct MergeChunks {
+  MergeChunks(std::vector<double>& v, const std::vector<size_t>& bounds,
+      size_t width):
+    m_v(v), m_bounds(bounds), m_width(width) {}
+
+  void operator()(size_t begin, size_t end, size_t) const {
+    const size_t n_chunks = m_bounds.size()-1;
+    for (size_t k=begin; k<end; ++k) {
+      const size_t first = 2*k*m_width;
+      const size_t middle = std::min(first + m_width, n_chunks);
+      const size_t last = std::min(first + 2*m_width, n_chunks);
+      std::inplace_merge(m_v.begin()+m_bounds[first],
+          m_v.begin()+m_bounds[middle], m_v.begin()+m_bounds[last]);
+    }
+  }
+
+  std::vector<double>& m_v;
+  const std::vector<size_t>& m_bounds;
+  size_t m_width;
+};
+
+/**
+ * Copies and sorts scores in ascending order. Large sets are split in one
+ * chunk per thread, which are sorted and then merged pairwise in parallel.
+ * NaN scores, which cannot be ordered, are left out.
+ */
+static void sortScores(const blitz::Array<double,1>& scores,
+    std::vector<double>& sorted) {
+  sorted.clear();
+  sorted.reserve(scores.extent(0));
+  for (int k=0; k<scores.extent(0); ++k)
+    if (scores(k) == scores(k)) sorted.push_back(scores(k));
+  const size_t n = sorted.size();
+  if (!n) return;
+
+  const size_t n_chunks = n < PARALLEL_SORT_MIN ? 1 :
+    std::min(bob::core::getNThreads(), n / (PARALLEL_SORT_MIN/2));
+  if (n_chunks < 2) {
+    std::sort(sorted.begin(), sorted.end());
+    return;
+  }
+
+  std::vector<size_t> bounds(n_chunks+1);
+  for (size_t k=0; k<=n_chunks; ++k) bounds[k] = (n*k) / n_chunks;
+  bob::core::parallelFor(0, n_chunks, SortChunks(sorted, bounds), 1);
+  for (size_t width=1; width<n_chunks; width*=2) {
+    const size_t n_merges = (n_chunks + 2*width - 1) / (2*width);
+    bob::core::parallelFor(0, n_merges, MergeChunks(sorted, bounds, width), 1);
+  }
+}
+
+bob::measure::SortedScores::SortedScores(
+    const blitz::Array<double,1>& negatives,
+    const blitz::Array<double,1>& positives):
+  m_total_negatives(negatives.extent(0)),
+  m_total_positives(positives.extent(0)) {
+  sortScores(negatives, m_negatives);
+  sortScores(positives, m_positives);
+}
+
+double bob::measure::SortedScores::getMin() const {
+  double min = std::numeric_limits<double>::max();
+  if (!m_negatives.empty()) min = std::min(min, m_negatives.front());
+  if (!m_positives.empty()) min = std::min(min, m_positives.front());
+  return min;
+}
+
+double bob::measure::SortedScores::getMax() const {
+  double max = -std::numeric_limits<double>::max();
+  if (!m_negatives.empty()) max = std::max(max, m_negatives.back());
+  if (!m_positives.empty()) max = std::max(max, m_positives.back());
+  return max;
+}
+
+size_t bob::measure::SortedScores::falseAccepts(double threshold) const {
+  if (threshold != threshold) return 0; //NaN: no comparison holds
+  return m_negatives.end() -
+    std::lower_bound(m_negatives.begin(), m_negatives.end(), threshold);
+}
+
+size_t bob::measure::SortedScores::falseRejects(double threshold) const {
+  if (threshold != threshold) return 0; //NaN: no comparison holds
+  return std::lower_bound(m_positives.begin(), m_positives.end(), threshold) -
+    m_positives.begin();
+}
+
+std::pair<double, double> bob::measure::SortedScores::farfrr(double threshold) const {
+  size_t total_negatives = m_total_negatives;
+  size_t total_positives = m_total_positives;
+  size_t false_accepts = falseAccepts(threshold);
+  size_t false_rejects = falseRejects(threshold);
+  if (!total_negatives) total_negatives = 1; //avoids division by zero
+  if (!total_positives) total_positives = 1; //avoids division by zero
+  return std::make_pair(false_accepts/(double)total_negatives,
+      false_rejects/(double)total_positives);
+}
+
+std::pair<double, double> bob::measure::SortedScores::precision_recall(double threshold) const {
+  size_t total_positives = m_total_positives;
+  size_t false_positives = falseAccepts(threshold);
+  size_t true_positives = (threshold != threshold) ? 0 :
+    m_positives.size() - falseRejects(threshold);
+  size_t total_classified_positives = true_positives + false_positives;
+  if (!total_classified_positives) total_classified_positives = 1; //avoids division by zero
+  if (!total_positives) total_positives = 1; //avoids division by zero
+  return std::make_pair(true_positives/(double)(total_classified_positives),
+      true_positives/(double)(total_positives));
+}
+
 std::pair<double, double> bob::measure::precision_recall(const blitz::Array<double,1>& negatives,
     const blitz::Array<double,1>& positives, double threshold) {
   blitz::sizeType total_positives = positives.extent(blitz::firstDim);
@@ -73,7 +207,11 @@ double eer_predicate(double far, double frr) {
 
 double bob::measure::eerThreshold(const blitz::Array<double,1>& negatives,
     const blitz::Array<double,1>& positives) {
-  return bob::measure::minimizingThreshold(negatives, positives, eer_predicate);
+  return bob::measure::eerThreshold(SortedScores(negatives, positives));
+}
+
+double bob::measure::eerThreshold(const SortedScores& scores) {
+  return bob::measure::minimizingThreshold(scores, eer_predicate);
 }
 
 double bob::measure::eerRocch(const blitz::Array<double,1>& negatives,
@@ -83,21 +221,24 @@ double bob::measure::eerRocch(const blitz::Array<double,1>& negatives,
 
 double bob::measure::farThreshold(const blitz::Array<double,1>& negatives,
   const blitz::Array<double,1>&, double far_value) {
+  return bob::measure::farThreshold(
+      SortedScores(negatives, blitz::Array<double,1>()), far_value);
+}
+
+double bob::measure::farThreshold(const SortedScores& scores,
+  double far_value) {
   // check the parameters are valid
   if (far_value < 0. || far_value > 1.) {
     boost::format m("the argument for `far_value' cannot take the value %f - the value must be in the interval [0.,1.]");
     m % far_value;
     throw std::runtime_error(m.str());
   }
-  if (negatives.size() < 2) {
+  // negative scores sorted ascendingly
+  const std::vector<double>& negatives_ = scores.getNegatives();
+  if (negatives_.size() < 2) {
     throw std::runtime_error("the number of negative scores must be at least 2");
   }
 
-  // sort negative scores ascendingly
-  std::vector<double> negatives_(negatives.shape()[0]);
-  std::copy(negatives.begin(), negatives.end(), negatives_.begin());
-  std::sort(negatives_.begin(), negatives_.end(), std::less<double>());
-
   // compute position of the threshold
   double crr = 1.-far_value; // (Correct Rejection Rate; = 1 - FAR)
   double crr_index = crr * negatives_.size();
@@ -120,8 +261,26 @@ double bob::measure::farThreshold(const blitz::Array<double,1>& negatives,
   return negatives_[index] - correction;
 }
 
+/**
+ * Gives a descending view of scores sorted ascendingly
+ */
+struct ReverseScores {
+  ReverseScores(const std::vector<double>& v): m_v(v) {}
+  double operator[](size_t i) const { return m_v[m_v.size()-1-i]; }
+  size_t size() const { return m_v.size(); }
+  double front() const { return m_v.back(); }
+  double back() const { return m_v.front(); }
+  const std::vector<double>& m_v;
+};
+
 double bob::measure::frrThreshold(const blitz::Array<double,1>&,
   const blitz::Array<double,1>& positives, double frr_value) {
+  return bob::measure::frrThreshold(
+      SortedScores(blitz::Array<double,1>(), positives), frr_value);
+}
+
+double bob::measure::frrThreshold(const SortedScores& scores,
+  double frr_value) {
 
   // check the parameters are valid
   if (frr_value < 0. || frr_value > 1.) {
@@ -129,14 +288,12 @@ double bob::measure::frrThreshold(const blitz::Array<double,1>&,
     m % frr_value;
     throw std::runtime_error(m.str());
   }
-  if (positives.size() < 2) {
+  if (scores.getPositives().size() < 2) {
     throw std::runtime_error("the number of positive scores must be at least 2");
   }
 
-  // sort positive scores descendingly
-  std::vector<double> positives_(positives.shape()[0]);
-  std::copy(positives.begin(), positives.end(), positives_.begin());
-  std::sort(positives_.begin(), positives_.end(), std::greater<double>());
+  // positive scores sorted descendingly
+  const ReverseScores positives_(scores.getPositives());
 
   // compute position of the threshold
   double car = 1.-frr_value; // (Correct Acceptance Rate; = 1 - FRR)
@@ -184,19 +341,29 @@ class weighted_error {
 double bob::measure::minWeightedErrorRateThreshold
 (const blitz::Array<double,1>& negatives,
  const blitz::Array<double,1>& positives, double cost) {
+  return bob::measure::minWeightedErrorRateThreshold(
+      SortedScores(negatives, positives), cost);
+}
+
+double bob::measure::minWeightedErrorRateThreshold(const SortedScores& scores,
+    double cost) {
   weighted_error predicate(cost);
-  return bob::measure::minimizingThreshold(negatives, positives, predicate);
+  return bob::measure::minimizingThreshold(scores, predicate);
 }
 
 blitz::Array<double,2> bob::measure::roc(const blitz::Array<double,1>& negatives,
  const blitz::Array<double,1>& positives, size_t points) {
-  double min = std::min(blitz::min(negatives), blitz::min(positives));
-  double max = std::max(blitz::max(negatives), blitz::max(positives));
+  return bob::measure::roc(SortedScores(negatives, positives), points);
+}
+
+blitz::Array<double,2> bob::measure::roc(const SortedScores& scores,
+    size_t points) {
+  double min = scores.getMin();
+  double max = scores.getMax();
   double step = (max-min)/((double)points-1.0);
   blitz::Array<double,2> retval(2, points);
   for (int i=0; i<(int)points; ++i) {
-    std::pair<double, double> ratios =
-      bob::measure::farfrr(negatives, positives, min + i*step);
+    std::pair<double, double> ratios = scores.farfrr(min + i*step);
     //note: inversion to preserve X x Y ordering (FRR x FAR)
     retval(0,i) = ratios.second;
     retval(1,i) = ratios.first;
@@ -206,13 +373,18 @@ blitz::Array<double,2> bob::measure::roc(const blitz::Array<double,1>& negatives
 
 blitz::Array<double,2> bob::measure::precision_recall_curve(const blitz::Array<double,1>& negatives,
  const blitz::Array<double,1>& positives, size_t points) {
-  double min = std::min(blitz::min(negatives), blitz::min(positives));
-  double max = std::max(blitz::max(negatives), blitz::max(positives));
+  return bob::measure::precision_recall_curve(
+      SortedScores(negatives, positives), points);
+}
+
+blitz::Array<double,2> bob::measure::precision_recall_curve(
+    const SortedScores& scores, size_t points) {
+  double min = scores.getMin();
+  double max = scores.getMax();
   double step = (max-min)/((double)points-1.0);
   blitz::Array<double,2> retval(2, points);
   for (int i=0; i<(int)points; ++i) {
-    std::pair<double, double> ratios =
-      bob::measure::precision_recall(negatives, positives, min + i*step);
+    std::pair<double, double> ratios = scores.precision_recall(min + i*step);
     retval(0,i) = ratios.first;
     retval(1,i) = ratios.second;
   }
@@ -369,16 +541,16 @@ double bob::measure::rocch2eer(const blitz::Array<double,2>& pmiss_pfa)
  */
 blitz::Array<double,2> bob::measure::roc_for_far(const blitz::Array<double,1>& negatives,
  const blitz::Array<double,1>& positives, const blitz::Array<double,1>& far_list) {
+  return bob::measure::roc_for_far(SortedScores(negatives, positives), far_list);
+}
+
+blitz::Array<double,2> bob::measure::roc_for_far(const SortedScores& scores,
+ const blitz::Array<double,1>& far_list) {
   int n_points = far_list.extent(0);
 
-  // sort negative scores ascendingly
-  std::vector<double> negatives_(negatives.extent(0));;
-  std::copy(negatives.begin(), negatives.end(), negatives_.begin());
-  std::sort(negatives_.begin(), negatives_.end());
-  // sort positive scores ascendingly
-  std::vector<double> positives_(positives.extent(0));;
-  std::copy(positives.begin(), positives.end(), positives_.begin());
-  std::sort(positives_.begin(), positives_.end());
+  // negative and positive scores sorted ascendingly
+  const std::vector<double>& negatives_ = scores.getNegatives();
+  const std::vector<double>& positives_ = scores.getPositives();
 
   // do some magic to compute the FRR list
   blitz::Array<double,2> retval(2, n_points);
@@ -509,8 +681,13 @@ double bob::measure::ppndf (double value) { return _ppndf(value); }
 
 blitz::Array<double,2> bob::measure::det(const blitz::Array<double,1>& negatives,
     const blitz::Array<double,1>& positives, size_t points) {
+  return bob::measure::det(SortedScores(negatives, positives), points);
+}
+
+blitz::Array<double,2> bob::measure::det(const SortedScores& scores,
+    size_t points) {
   blitz::Array<double,2> retval(2, points);
-  retval = blitz::_ppndf(bob::measure::roc(negatives, positives, points));
+  retval = blitz::_ppndf(bob::measure::roc(scores, points));
   return retval;
 }
 
@@ -519,15 +696,20 @@ blitz::Array<double,2> bob::measure::epc
  const blitz::Array<double,1>& dev_positives,
  const blitz::Array<double,1>& test_negatives,
  const blitz::Array<double,1>& test_positives, size_t points) {
+  return bob::measure::epc(SortedScores(dev_negatives, dev_positives),
+      SortedScores(test_negatives, test_positives), points);
+}
+
+blitz::Array<double,2> bob::measure::epc(const SortedScores& dev_scores,
+    const SortedScores& test_scores, size_t points) {
   double step = 1.0/((double)points-1.0);
   blitz::Array<double,2> retval(2, points);
   for (int i=0; i<(int)points; ++i) {
     double alpha = (double)i*step;
     retval(0,i) = alpha;
-    double threshold = bob::measure::minWeightedErrorRateThreshold(dev_negatives,
-        dev_positives, alpha);
-    std::pair<double, double> ratios =
-      bob::measure::farfrr(test_negatives, test_positives, threshold);
+    double threshold = bob::measure::minWeightedErrorRateThreshold(dev_scores,
+        alpha);
+    std::pair<double, double> ratios = test_scores.farfrr(threshold);
     retval(1,i) = (ratios.first + ratios.second) / 2;
   }
   return retval;
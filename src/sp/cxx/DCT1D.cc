@@ -23,7 +23,7 @@
 
 #include <bob/sp/DCT1D.h>
 #include <bob/core/assert.h>
-#include <fftw3.h>
+#include <bob/sp/FFTWCache.h>
 
 bob::sp::DCT1DAbstract::DCT1DAbstract(const size_t length):
   m_length(length)
@@ -125,12 +125,11 @@ void bob::sp::DCT1D::operator()(const blitz::Array<double,1>& src,
   double* src_ = const_cast<double*>(src.data());
   double* dst_ = dst.data();
   
-  fftw_plan p;
-  // FFTW_ESTIMATE -> The planner is computed quickly but may not be optimized 
-  // for large arrays
-  p = fftw_plan_r2r_1d(src.extent(0), src_, dst_, FFTW_REDFT10, FFTW_ESTIMATE);
-  fftw_execute(p);
-  fftw_destroy_plan(p);
+  // Gets a plan from the cache (created on the first call only)
+  const int n = src.extent(0);
+  const fftw_r2r_kind kind = FFTW_REDFT10;
+  fftw_plan p = bob::sp::detail::planR2R(1, &n, &kind, src_, dst_);
+  fftw_execute_r2r(p, src_, dst_);
 
   // Normalize
   dst(0) *= m_sqrt_1byl/2.;
@@ -183,11 +182,10 @@ void bob::sp::IDCT1D::operator()(const blitz::Array<double,1>& src,
   // Reinterpret cast to fftw format
   double* dst_ = dst.data();
  
-  fftw_plan p;
-  // FFTW_ESTIMATE -> The planner is computed quickly but may not be optimized 
-  // for large arrays
-  p = fftw_plan_r2r_1d(src.extent(0), dst_, dst_, FFTW_REDFT01, FFTW_ESTIMATE);
-  fftw_execute(p);
-  fftw_destroy_plan(p);
+  // Gets a plan from the cache (created on the first call only)
+  const int n = src.extent(0);
+  const fftw_r2r_kind kind = FFTW_REDFT01;
+  fftw_plan p = bob::sp::detail::planR2R(1, &n, &kind, dst_, dst_);
+  fftw_execute_r2r(p, dst_, dst_);
 }
 
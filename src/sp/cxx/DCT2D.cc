@@ -23,7 +23,7 @@
 
 #include <bob/sp/DCT2D.h>
 #include <bob/core/assert.h>
-#include <fftw3.h>
+#include <bob/sp/FFTWCache.h>
 
 
 bob::sp::DCT2DAbstract::DCT2DAbstract(const size_t height, const size_t width):
@@ -134,12 +134,11 @@ void bob::sp::DCT2D::operator()(const blitz::Array<double,2>& src,
   double* src_ = const_cast<double*>(src.data());
   double* dst_ = dst.data();
   
-  fftw_plan p;
-  // FFTW_ESTIMATE -> The planner is computed quickly but may not be optimized 
-  // for large arrays
-  p = fftw_plan_r2r_2d(src.extent(0), src.extent(1), src_, dst_, FFTW_REDFT10, FFTW_REDFT10, FFTW_ESTIMATE);
-  fftw_execute(p);
-  fftw_destroy_plan(p);
+  // Gets a plan from the cache (created on the first call only)
+  const int n[2] = {src.extent(0), src.extent(1)};
+  const fftw_r2r_kind kind[2] = {FFTW_REDFT10, FFTW_REDFT10};
+  fftw_plan p = bob::sp::detail::planR2R(2, n, kind, src_, dst_);
+  fftw_execute_r2r(p, src_, dst_);
 
   // Rescale the result
   for (int i=0; i<(int)m_height; ++i)
@@ -188,12 +187,11 @@ void bob::sp::IDCT2D::operator()(const blitz::Array<double,2>& src,
   // Reinterpret cast to fftw format
   double* dst_ = dst.data();
   
-  fftw_plan p;
-  // FFTW_ESTIMATE -> The planner is computed quickly but may not be optimized 
-  // for large arrays
-  p = fftw_plan_r2r_2d(src.extent(0), src.extent(1), dst_, dst_, FFTW_REDFT01, FFTW_REDFT01, FFTW_ESTIMATE);
-  fftw_execute(p);
-  fftw_destroy_plan(p);
+  // Gets a plan from the cache (created on the first call only)
+  const int n[2] = {src.extent(0), src.extent(1)};
+  const fftw_r2r_kind kind[2] = {FFTW_REDFT01, FFTW_REDFT01};
+  fftw_plan p = bob::sp::detail::planR2R(2, n, kind, dst_, dst_);
+  fftw_execute_r2r(p, dst_, dst_);
   
   // Rescale the result by the size of the input 
   // (as this is not performed by FFW)
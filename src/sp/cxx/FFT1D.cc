@@ -23,7 +23,7 @@
 
 #include <bob/sp/FFT1D.h>
 #include <bob/core/assert.h>
-#include <fftw3.h>
+#include <bob/sp/FFTWCache.h>
 
 
 bob::sp::FFT1DAbstract::FFT1DAbstract(const size_t length):
@@ -104,12 +104,10 @@ void bob::sp::FFT1D::operator()(const blitz::Array<std::complex<double>,1>& src,
   fftw_complex* src_ = reinterpret_cast<fftw_complex*>(const_cast<std::complex<double>* >(src.data()));
   fftw_complex* dst_ = reinterpret_cast<fftw_complex*>(dst.data());
   
-  fftw_plan p;
-  // FFTW_ESTIMATE -> The planner is computed quickly but may not be optimized 
-  // for large arrays
-  p = fftw_plan_dft_1d(src.extent(0), src_, dst_, FFTW_FORWARD, FFTW_ESTIMATE);
-  fftw_execute(p);
-  fftw_destroy_plan(p);
+  // Gets a plan from the cache (created on the first call only)
+  const int n = src.extent(0);
+  fftw_plan p = bob::sp::detail::planDFT(1, &n, FFTW_FORWARD, src_, dst_);
+  fftw_execute_dft(p, src_, dst_);
 }
 
 
@@ -146,12 +144,10 @@ void bob::sp::IFFT1D::operator()(const blitz::Array<std::complex<double>,1>& src
   fftw_complex* src_ = reinterpret_cast<fftw_complex*>(const_cast<std::complex<double>* >(src.data()));
   fftw_complex* dst_ = reinterpret_cast<fftw_complex*>(dst.data());
   
-  fftw_plan p;
-  // FFTW_ESTIMATE -> The planner is computed quickly but may not be optimized 
-  // for large arrays
-  p = fftw_plan_dft_1d(src.extent(0), src_, dst_, FFTW_BACKWARD, FFTW_ESTIMATE);
-  fftw_execute(p); /* repeat as needed */
-  fftw_destroy_plan(p);
+  // Gets a plan from the cache (created on the first call only)
+  const int n = src.extent(0);
+  fftw_plan p = bob::sp::detail::planDFT(1, &n, FFTW_BACKWARD, src_, dst_);
+  fftw_execute_dft(p, src_, dst_);
 
   // Rescale as FFTW is not doing it
   dst /= static_cast<double>(m_length);
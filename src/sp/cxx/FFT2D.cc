@@ -23,7 +23,7 @@
 
 #include <bob/sp/FFT2D.h>
 #include <bob/core/assert.h>
-#include <fftw3.h>
+#include <bob/sp/FFTWCache.h>
 
 bob::sp::FFT2DAbstract::FFT2DAbstract(const size_t height, const size_t width):
   m_height(height), m_width(width)
@@ -98,12 +98,10 @@ void bob::sp::FFT2D::operator()(const blitz::Array<std::complex<double>,2>& src,
   fftw_complex* src_ = reinterpret_cast<fftw_complex*>(const_cast<std::complex<double>* >(src.data()));
   fftw_complex* dst_ = reinterpret_cast<fftw_complex*>(dst.data());
   
-  fftw_plan p;
-  // FFTW_ESTIMATE -> The planner is computed quickly but may not be optimized 
-  // for large arrays
-  p = fftw_plan_dft_2d(src.extent(0), src.extent(1), src_, dst_, FFTW_FORWARD, FFTW_ESTIMATE);
-  fftw_execute(p);
-  fftw_destroy_plan(p);
+  // Gets a plan from the cache (created on the first call only)
+  const int n[2] = {src.extent(0), src.extent(1)};
+  fftw_plan p = bob::sp::detail::planDFT(2, n, FFTW_FORWARD, src_, dst_);
+  fftw_execute_dft(p, src_, dst_);
 }
 
 
@@ -115,12 +113,10 @@ void bob::sp::FFT2D::operator()(blitz::Array<std::complex<double>,2>& src_dst) c
   // Reinterpret cast to fftw format
   fftw_complex* src_dst_ = reinterpret_cast<fftw_complex*>(src_dst.data());
 
-  fftw_plan p;
-  // FFTW_ESTIMATE -> The planner is computed quickly but may not be optimized
-  // for large arrays
-  p = fftw_plan_dft_2d(src_dst.extent(0), src_dst.extent(1), src_dst_, src_dst_, FFTW_FORWARD, FFTW_ESTIMATE);
-  fftw_execute(p);
-  fftw_destroy_plan(p);
+  // Gets a plan from the cache (created on the first call only)
+  const int n[2] = {src_dst.extent(0), src_dst.extent(1)};
+  fftw_plan p = bob::sp::detail::planDFT(2, n, FFTW_FORWARD, src_dst_, src_dst_);
+  fftw_execute_dft(p, src_dst_, src_dst_);
 }
 
 
@@ -157,12 +153,10 @@ void bob::sp::IFFT2D::operator()(const blitz::Array<std::complex<double>,2>& src
   fftw_complex* src_ = reinterpret_cast<fftw_complex*>(const_cast<std::complex<double>* >(src.data()));
   fftw_complex* dst_ = reinterpret_cast<fftw_complex*>(dst.data());
   
-  fftw_plan p;
-  // FFTW_ESTIMATE -> The planner is computed quickly but may not be optimized 
-  // for large arrays
-  p = fftw_plan_dft_2d(src.extent(0), src.extent(1), src_, dst_, FFTW_BACKWARD, FFTW_ESTIMATE);
-  fftw_execute(p);
-  fftw_destroy_plan(p);
+  // Gets a plan from the cache (created on the first call only)
+  const int n[2] = {src.extent(0), src.extent(1)};
+  fftw_plan p = bob::sp::detail::planDFT(2, n, FFTW_BACKWARD, src_, dst_);
+  fftw_execute_dft(p, src_, dst_);
 
   // Rescale the result by the size of the input 
   // (as this is not performed by FFTW)
@@ -177,12 +171,10 @@ void bob::sp::IFFT2D::operator()(blitz::Array<std::complex<double>,2>& src_dst)
   // Reinterpret cast to fftw format
   fftw_complex* src_dst_ = reinterpret_cast<fftw_complex*>(src_dst.data());
 
-  fftw_plan p;
-  // FFTW_ESTIMATE -> The planner is computed quickly but may not be optimized
-  // for large arrays
-  p = fftw_plan_dft_2d(src_dst.extent(0), src_dst.extent(1), src_dst_, src_dst_, FFTW_BACKWARD, FFTW_ESTIMATE);
-  fftw_execute(p);
-  fftw_destroy_plan(p);
+  // Gets a plan from the cache (created on the first call only)
+  const int n[2] = {src_dst.extent(0), src_dst.extent(1)};
+  fftw_plan p = bob::sp::detail::planDFT(2, n, FFTW_BACKWARD, src_dst_, src_dst_);
+  fftw_execute_dft(p, src_dst_, src_dst_);
 
   // Rescale the result by the size of the input
   // (as this is not performed by FFTW)
@@ -0,0 +1,312 @@
+/**
+ * @file sp/cxx/FFTWCache.cc
+ * @date Sat Oct 17 10:12:31 CEST 2026
+ * @author Laurent El Shafey <Laurent.El-Shafey@idiap.ch>
+ *
+ * @brief Process-wide cache of FFTW plans shared by the FFT/DCT classes
+ *
+ * Copyright (C) 2011-2013 Idiap Research Institute, Martigny, Switzerland
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <bob/sp/FFTWCache.h>
+#include <boost/thread/mutex.hpp>
+#include <boost/format.hpp>
+#include <stdexcept>
+#include <vector>
+#include <map>
+
+namespace {
+
+  /**
+   * Identifies the family of transform a cached plan belongs to
+   */
+  typedef enum {
+    TRANSFORM_DFT = 0,
+    TRANSFORM_R2R,
+    TRANSFORM_R2C,
+    TRANSFORM_C2R
+  } TransformType;
+
+  /**
+   * A plan is identified by the transform type, its rank and shape, the
+   * direction/kinds, whether it is in-place, whether the arrays are SIMD
+   * aligned and the planner rigor.
+   */
+  typedef std::vector<int> PlanKey;
+
+  /**
+   * The cache itself. FFTW planner calls are not thread-safe and are
+   * therefore serialized by the mutex. Executing a plan with the new-array
+   * interface (fftw_execute_dft(), fftw_execute_r2r()) is thread-safe, so
+   * that the returned plans may be used concurrently.
+   */
+  struct PlanCache {
+    PlanCache(): rigor(bob::sp::PLANNER_ESTIMATE) { }
+
+    ~PlanCache() { clear(); }
+
+    void clear() {
+      for (std::map<PlanKey,fftw_plan>::iterator it=plans.begin();
+          it!=plans.end(); ++it)
+        fftw_destroy_plan(it->second);
+      plans.clear();
+    }
+
+    boost::mutex mutex;
+    std::map<PlanKey,fftw_plan> plans;
+    bob::sp::PlannerRigor rigor;
+  };
+
+  PlanCache& cache() {
+    static PlanCache s_cache;
+    return s_cache;
+  }
+
+  unsigned rigorFlags(const bob::sp::PlannerRigor rigor) {
+    switch (rigor) {
+      case bob::sp::PLANNER_MEASURE: return FFTW_MEASURE;
+      case bob::sp::PLANNER_PATIENT: return FFTW_PATIENT;
+      case bob::sp::PLANNER_EXHAUSTIVE: return FFTW_EXHAUSTIVE;
+      case bob::sp::PLANNER_ESTIMATE:
+      default: return FFTW_ESTIMATE;
+    }
+  }
+
+  /**
+   * Plans are created on scratch buffers allocated with fftw_malloc(), as
+   * the measuring rigors overwrite the arrays. Such plans can only be
+   * reused on arrays with the same (SIMD) alignment, which is the case of
+   * arrays with alignment 0. Other arrays get a plan that is created with
+   * FFTW_UNALIGNED.
+   */
+  bool isAligned(const double* in, const double* out) {
+    return fftw_alignment_of(const_cast<double*>(in)) == 0 &&
+      fftw_alignment_of(const_cast<double*>(out)) == 0;
+  }
+
+  PlanKey makeKey(const TransformType type, const int rank, const int* n,
+    const int* dir, const bool inplace, const bool aligned,
+    const bob::sp::PlannerRigor rigor)
+  {
+    PlanKey key;
+    key.reserve(2*rank+5);
+    key.push_back(type);
+    key.push_back(rank);
+    for (int i=0; i<rank; ++i) key.push_back(n[i]);
+    for (int i=0; i<rank; ++i) key.push_back(dir[i]);
+    key.push_back(inplace);
+    key.push_back(aligned);
+    key.push_back(rigor);
+    return key;
+  }
+
+  size_t totalSize(const int rank, const int* n) {
+    size_t size = 1;
+    for (int i=0; i<rank; ++i) size *= n[i];
+    return size;
+  }
+
+  /**
+   * Number of elements of the complex side of a real-to-complex transform
+   */
+  size_t halfComplexSize(const int rank, const int* n) {
+    size_t size = n[rank-1]/2 + 1;
+    for (int i=0; i<rank-1; ++i) size *= n[i];
+    return size;
+  }
+
+  void checkPlan(const fftw_plan p, const int rank, const int* n) {
+    if (!p) {
+      boost::format m("FFTW could not create a plan of rank %d for an array of %lu elements");
+      m % rank % totalSize(rank, n);
+      throw std::runtime_error(m.str());
+    }
+  }
+
+}
+
+void bob::sp::setPlannerRigor(const bob::sp::PlannerRigor rigor)
+{
+  PlanCache& c = cache();
+  boost::mutex::scoped_lock lock(c.mutex);
+  c.rigor = rigor;
+}
+
+bob::sp::PlannerRigor bob::sp::getPlannerRigor()
+{
+  PlanCache& c = cache();
+  boost::mutex::scoped_lock lock(c.mutex);
+  return c.rigor;
+}
+
+bool bob::sp::importWisdom(const std::string& filename)
+{
+  PlanCache& c = cache();
+  boost::mutex::scoped_lock lock(c.mutex);
+  return fftw_import_wisdom_from_filename(filename.c_str()) != 0;
+}
+
+void bob::sp::exportWisdom(const std::string& filename)
+{
+  PlanCache& c = cache();
+  boost::mutex::scoped_lock lock(c.mutex);
+  if (!fftw_export_wisdom_to_filename(filename.c_str())) {
+    boost::format m("cannot export FFTW wisdom to file '%s'");
+    m % filename;
+    throw std::runtime_error(m.str());
+  }
+}
+
+void bob::sp::forgetWisdom()
+{
+  PlanCache& c = cache();
+  boost::mutex::scoped_lock lock(c.mutex);
+  fftw_forget_wisdom();
+}
+
+void bob::sp::clearPlanCache()
+{
+  PlanCache& c = cache();
+  boost::mutex::scoped_lock lock(c.mutex);
+  c.clear();
+}
+
+size_t bob::sp::getPlanCacheSize()
+{
+  PlanCache& c = cache();
+  boost::mutex::scoped_lock lock(c.mutex);
+  return c.plans.size();
+}
+
+fftw_plan bob::sp::detail::planDFT(const int rank, const int* n,
+  const int sign, fftw_complex* in, fftw_complex* out)
+{
+  const bool inplace = (in == out);
+  const bool aligned = isAligned(reinterpret_cast<double*>(in),
+      reinterpret_cast<double*>(out));
+  std::vector<int> dir(rank, sign);
+
+  PlanCache& c = cache();
+  boost::mutex::scoped_lock lock(c.mutex);
+  const PlanKey key = makeKey(TRANSFORM_DFT, rank, n, &dir[0], inplace,
+      aligned, c.rigor);
+  std::map<PlanKey,fftw_plan>::const_iterator it = c.plans.find(key);
+  if (it != c.plans.end()) return it->second;
+
+  // Creates the plan on scratch buffers
+  const size_t size = totalSize(rank, n);
+  fftw_complex* in_ = fftw_alloc_complex(size);
+  fftw_complex* out_ = inplace ? in_ : fftw_alloc_complex(size);
+  unsigned flags = rigorFlags(c.rigor);
+  if (!aligned) flags |= FFTW_UNALIGNED;
+  fftw_plan p = fftw_plan_dft(rank, n, in_, out_, sign, flags);
+  if (!inplace) fftw_free(out_);
+  fftw_free(in_);
+  checkPlan(p, rank, n);
+
+  c.plans[key] = p;
+  return p;
+}
+
+fftw_plan bob::sp::detail::planR2R(const int rank, const int* n,
+  const fftw_r2r_kind* kind, double* in, double* out)
+{
+  const bool inplace = (in == out);
+  const bool aligned = isAligned(in, out);
+  std::vector<int> dir(kind, kind+rank);
+
+  PlanCache& c = cache();
+  boost::mutex::scoped_lock lock(c.mutex);
+  const PlanKey key = makeKey(TRANSFORM_R2R, rank, n, &dir[0], inplace,
+      aligned, c.rigor);
+  std::map<PlanKey,fftw_plan>::const_iterator it = c.plans.find(key);
+  if (it != c.plans.end()) return it->second;
+
+  // Creates the plan on scratch buffers
+  const size_t size = totalSize(rank, n);
+  double* in_ = fftw_alloc_real(size);
+  double* out_ = inplace ? in_ : fftw_alloc_real(size);
+  unsigned flags = rigorFlags(c.rigor);
+  if (!aligned) flags |= FFTW_UNALIGNED;
+  fftw_plan p = fftw_plan_r2r(rank, n, in_, out_, kind, flags);
+  if (!inplace) fftw_free(out_);
+  fftw_free(in_);
+  checkPlan(p, rank, n);
+
+  c.plans[key] = p;
+  return p;
+}
+
+fftw_plan bob::sp::detail::planR2C(const int rank, const int* n,
+  double* in, fftw_complex* out)
+{
+  const bool inplace = (in == reinterpret_cast<double*>(out));
+  const bool aligned = isAligned(in, reinterpret_cast<double*>(out));
+  std::vector<int> dir(rank, FFTW_FORWARD);
+
+  PlanCache& c = cache();
+  boost::mutex::scoped_lock lock(c.mutex);
+  const PlanKey key = makeKey(TRANSFORM_R2C, rank, n, &dir[0], inplace,
+      aligned, c.rigor);
+  std::map<PlanKey,fftw_plan>::const_iterator it = c.plans.find(key);
+  if (it != c.plans.end()) return it->second;
+
+  // Creates the plan on scratch buffers (an in-place transform requires
+  // the padding of the real array to the size of the complex one)
+  fftw_complex* out_ = fftw_alloc_complex(halfComplexSize(rank, n));
+  double* in_ = inplace ? reinterpret_cast<double*>(out_) :
+    fftw_alloc_real(totalSize(rank, n));
+  unsigned flags = rigorFlags(c.rigor);
+  if (!aligned) flags |= FFTW_UNALIGNED;
+  fftw_plan p = fftw_plan_dft_r2c(rank, n, in_, out_, flags);
+  if (!inplace) fftw_free(in_);
+  fftw_free(out_);
+  checkPlan(p, rank, n);
+
+  c.plans[key] = p;
+  return p;
+}
+
+fftw_plan bob::sp::detail::planC2R(const int rank, const int* n,
+  fftw_complex* in, double* out)
+{
+  const bool inplace = (reinterpret_cast<double*>(in) == out);
+  const bool aligned = isAligned(reinterpret_cast<double*>(in), out);
+  std::vector<int> dir(rank, FFTW_BACKWARD);
+
+  PlanCache& c = cache();
+  boost::mutex::scoped_lock lock(c.mutex);
+  const PlanKey key = makeKey(TRANSFORM_C2R, rank, n, &dir[0], inplace,
+      aligned, c.rigor);
+  std::map<PlanKey,fftw_plan>::const_iterator it = c.plans.find(key);
+  if (it != c.plans.end()) return it->second;
+
+  // Creates the plan on scratch buffers. By default, FFTW overwrites the
+  // input of complex-to-real transforms, which is therefore explicitly
+  // preserved (only possible for out-of-place transforms of rank 1).
+  fftw_complex* in_ = fftw_alloc_complex(halfComplexSize(rank, n));
+  double* out_ = inplace ? reinterpret_cast<double*>(in_) :
+    fftw_alloc_real(totalSize(rank, n));
+  unsigned flags = rigorFlags(c.rigor);
+  if (!aligned) flags |= FFTW_UNALIGNED;
+  if (!inplace && rank == 1) flags |= FFTW_PRESERVE_INPUT;
+  fftw_plan p = fftw_plan_dft_c2r(rank, n, in_, out_, flags);
+  if (!inplace) fftw_free(out_);
+  fftw_free(in_);
+  checkPlan(p, rank, n);
+
+  c.plans[key] = p;
+  return p;
+}
@@ -0,0 +1,157 @@
+/**
+ * @file sp/cxx/RFFT1D.cc
+ * @date Sat Oct 17 17:04:31 CEST 2026
+ * @author Laurent El Shafey <Laurent.El-Shafey@idiap.ch>
+ *
+ * @brief Implement a blitz-based 1D Fast Fourier Transform of real signals
+ * using FFTW functions
+ *
+ * Copyright (C) 2011-2013 Idiap Research Institute, Martigny, Switzerland
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <bob/sp/RFFT1D.h>
+#include <bob/core/assert.h>
+#include <bob/sp/FFTWCache.h>
+
+
+bob::sp::RFFT1DAbstract::RFFT1DAbstract(const size_t length):
+  m_length(length)
+{
+}
+
+bob::sp::RFFT1DAbstract::RFFT1DAbstract(const bob::sp::RFFT1DAbstract& other):
+  m_length(other.m_length)
+{
+}
+
+bob::sp::RFFT1DAbstract::~RFFT1DAbstract()
+{
+}
+
+bob::sp::RFFT1DAbstract&
+bob::sp::RFFT1DAbstract::operator=(const RFFT1DAbstract& other)
+{
+  if (this != &other) {
+    reset(other.m_length);
+  }
+  return *this;
+}
+
+bool bob::sp::RFFT1DAbstract::operator==(const bob::sp::RFFT1DAbstract& b) const
+{
+  return (this->m_length == b.m_length);
+}
+
+bool bob::sp::RFFT1DAbstract::operator!=(const bob::sp::RFFT1DAbstract& b) const
+{
+  return !(this->operator==(b));
+}
+
+void bob::sp::RFFT1DAbstract::reset(const size_t length)
+{
+  // Update the length
+  m_length = length;
+}
+
+void bob::sp::RFFT1DAbstract::setLength(const size_t length)
+{
+  reset(length);
+}
+
+
+bob::sp::RFFT1D::RFFT1D():
+  bob::sp::RFFT1DAbstract(0)
+{
+}
+
+bob::sp::RFFT1D::RFFT1D(const size_t length):
+  bob::sp::RFFT1DAbstract(length)
+{
+}
+
+bob::sp::RFFT1D::RFFT1D(const bob::sp::RFFT1D& other):
+  bob::sp::RFFT1DAbstract(other)
+{
+}
+
+bob::sp::RFFT1D::~RFFT1D()
+{
+}
+
+void bob::sp::RFFT1D::operator()(const blitz::Array<double,1>& src,
+  blitz::Array<std::complex<double>,1>& dst) const
+{
+  // check input
+  bob::core::array::assertCZeroBaseContiguous(src);
+  bob::core::array::assertSameDimensionLength(src.extent(0), m_length);
+
+  // Check output
+  bob::core::array::assertCZeroBaseContiguous(dst);
+  bob::core::array::assertSameDimensionLength(dst.extent(0), m_length/2+1);
+
+  // Reinterpret cast to fftw format
+  double* src_ = const_cast<double*>(src.data());
+  fftw_complex* dst_ = reinterpret_cast<fftw_complex*>(dst.data());
+
+  // Gets a plan from the cache (created on the first call only)
+  const int n = src.extent(0);
+  fftw_plan p = bob::sp::detail::planR2C(1, &n, src_, dst_);
+  fftw_execute_dft_r2c(p, src_, dst_);
+}
+
+
+bob::sp::IRFFT1D::IRFFT1D():
+  bob::sp::RFFT1DAbstract(0)
+{
+}
+
+bob::sp::IRFFT1D::IRFFT1D(const size_t length):
+  bob::sp::RFFT1DAbstract(length)
+{
+}
+
+bob::sp::IRFFT1D::IRFFT1D(const bob::sp::IRFFT1D& other):
+  bob::sp::RFFT1DAbstract(other)
+{
+}
+
+bob::sp::IRFFT1D::~IRFFT1D()
+{
+}
+
+void bob::sp::IRFFT1D::operator()(const blitz::Array<std::complex<double>,1>& src,
+  blitz::Array<double,1>& dst) const
+{
+  // check input
+  bob::core::array::assertCZeroBaseContiguous(src);
+  bob::core::array::assertSameDimensionLength(src.extent(0), m_length/2+1);
+
+  // Check output
+  bob::core::array::assertCZeroBaseContiguous(dst);
+  bob::core::array::assertSameDimensionLength(dst.extent(0), m_length);
+
+  // Reinterpret cast to fftw format
+  fftw_complex* src_ = reinterpret_cast<fftw_complex*>(const_cast<std::complex<double>* >(src.data()));
+  double* dst_ = dst.data();
+
+  // Gets a plan from the cache (created on the first call only). The plan
+  // preserves the input.
+  const int n = dst.extent(0);
+  fftw_plan p = bob::sp::detail::planC2R(1, &n, src_, dst_);
+  fftw_execute_dft_c2r(p, src_, dst_);
+
+  // Rescale as FFTW is not doing it
+  dst /= static_cast<double>(m_length);
+}
@@ -30,6 +30,7 @@
 #include <bob/sp/DCT1DNaive.h>
 #include <bob/sp/DCT2D.h>
 #include <bob/sp/DCT2DNaive.h>
+#include <bob/sp/FFTWCache.h>
 
 #include <boost/random.hpp>
 #include <boost/date_time/posix_time/posix_time.hpp>
@@ -146,6 +147,51 @@ void benchmark_fft2D(const blitz::Array<std::complex<double>,2> t)
   std::cout << "  DFT duration in (microseconds) " << diff.total_microseconds() << std::endl;
 }
 
+void benchmark_fft1D_per_call(const blitz::Array<std::complex<double>,1> t,
+  const int n_calls)
+{
+  const int M = t.extent(0);
+  blitz::Array<std::complex<double>,1> t_fft(M);
+  boost::posix_time::ptime t1;
+  boost::posix_time::ptime t2;
+  boost::posix_time::time_duration diff;
+
+  std::cout << "1D FFT per-call latency on an array of dimension " << M << " (" << n_calls << " calls)..." << std::endl;
+
+  // process by creating and destroying a plan at each call (legacy behaviour)
+  fftw_complex* src_ = reinterpret_cast<fftw_complex*>(const_cast<std::complex<double>* >(t.data()));
+  fftw_complex* dst_ = reinterpret_cast<fftw_complex*>(t_fft.data());
+  t1 = boost::posix_time::microsec_clock::local_time();
+  for (int i=0; i<n_calls; ++i) {
+    fftw_plan p = fftw_plan_dft_1d(M, src_, dst_, FFTW_FORWARD, FFTW_ESTIMATE);
+    fftw_execute(p);
+    fftw_destroy_plan(p);
+  }
+  t2 = boost::posix_time::microsec_clock::local_time();
+  diff = t2 - t1;
+  std::cout << "  Plan per call (microseconds/call) " << diff.total_microseconds() / (double)n_calls << std::endl;
+
+  // process using the plan cache with the given rigors
+  const bob::sp::PlannerRigor rigors[2] = {bob::sp::PLANNER_ESTIMATE, bob::sp::PLANNER_MEASURE};
+  const char* names[2] = {"ESTIMATE", "MEASURE"};
+  for (int r=0; r<2; ++r) {
+    bob::sp::setPlannerRigor(rigors[r]);
+    bob::sp::FFT1D fft(M);
+    t1 = boost::posix_time::microsec_clock::local_time();
+    fft(t, t_fft);
+    t2 = boost::posix_time::microsec_clock::local_time();
+    diff = t2 - t1;
+    std::cout << "  Cached plan " << names[r] << ", first call (microseconds) " << diff.total_microseconds() << std::endl;
+
+    t1 = boost::posix_time::microsec_clock::local_time();
+    for (int i=0; i<n_calls; ++i) fft(t, t_fft);
+    t2 = boost::posix_time::microsec_clock::local_time();
+    diff = t2 - t1;
+    std::cout << "  Cached plan " << names[r] << ", next calls (microseconds/call) " << diff.total_microseconds() / (double)n_calls << std::endl;
+  }
+  bob::sp::setPlannerRigor(bob::sp::PLANNER_ESTIMATE);
+}
+
 /*************** FCT Tests *****************/
 int main()
 {
@@ -194,5 +240,16 @@ int main()
     benchmark_fft2D(t_2d);
   }
 
+  for(int i=0; i<5; ++i)
+  {
+    const int M = dims[i];
+    // 1D array
+    blitz::Array<double,1> t_d_1d(M);
+    bob::core::array::randn(rng, t_d_1d);
+    blitz::Array<std::complex<double>,1> t_1d = bob::core::array::cast<std::complex<double> >(t_d_1d);
+    // Benchmark
+    benchmark_fft1D_per_call(t_1d, 10000);
+  }
+
   return 0;
 }
@@ -30,12 +30,14 @@
 #include <bob/sp/fftshift.h>
 #include <bob/sp/FFT1D.h>
 #include <bob/sp/FFT1DNaive.h>
+#include <bob/sp/RFFT1D.h>
 #include <bob/sp/FFT2D.h>
 #include <bob/sp/FFT2DNaive.h>
 #include <bob/sp/DCT1D.h>
 #include <bob/sp/DCT1DNaive.h>
 #include <bob/sp/DCT2D.h>
 #include <bob/sp/DCT2DNaive.h>
+#include <bob/sp/FFTWCache.h>
 // Random number
 #include <cstdlib>
 
@@ -152,6 +154,36 @@ void test_fft1D( const blitz::Array<std::complex<double>,1> t, double eps)
     BOOST_CHECK_SMALL( abs(t_fft_ifft(i)-t(i)), eps);
 }
 
+void test_rfft1D( const blitz::Array<double,1> t, double eps) 
+{
+  // process using the real FFT
+  const int N = t.extent(0);
+  blitz::Array<std::complex<double>,1> t_rfft(N/2+1), t_c(N), t_fft(N);
+  bob::sp::RFFT1D rfft(N);
+  BOOST_CHECK_EQUAL(rfft.getComplexLength(), (size_t)(N/2+1));
+  rfft(t, t_rfft);
+
+  // compare with the first part of the complex FFT
+  for (int i=0; i < N; ++i)
+    t_c(i) = std::complex<double>(t(i), 0.);
+  bob::sp::FFT1D fft(N);
+  fft(t_c, t_fft);
+  for (int i=0; i < N/2+1; ++i)
+    BOOST_CHECK_SMALL( abs(t_rfft(i)-t_fft(i)), eps);
+
+  // process using the inverse real FFT, which preserves its input
+  blitz::Array<std::complex<double>,1> t_rfft_copy(t_rfft.copy());
+  blitz::Array<double,1> t_rfft_irfft(N);
+  bob::sp::IRFFT1D irfft(N);
+  irfft(t_rfft, t_rfft_irfft);
+  for (int i=0; i < N/2+1; ++i)
+    BOOST_CHECK_EQUAL( t_rfft(i), t_rfft_copy(i));
+
+  // Compare to original
+  for (int i=0; i < N; ++i)
+    BOOST_CHECK_SMALL( fabs(t_rfft_irfft(i)-t(i)), eps);
+}
+
 
 void test_fft2D( const blitz::Array<std::complex<double>,2> t, double eps) 
 {
@@ -354,6 +386,37 @@ BOOST_AUTO_TEST_CASE( test_fft1D_range1to2048_random )
   }
 }
 
+BOOST_AUTO_TEST_CASE( test_rfft1D_1to64_set )
+{
+  // size of the data (odd and even lengths)
+  for (int N=1; N <65 ; ++N) {
+    // set up simple 1D tensor
+    blitz::Array<double,1> t(N);
+    for (int i=0; i<N; ++i)
+      t(i) = 1.0+i;
+
+    // call the test function
+    test_rfft1D( t, eps);
+  }
+}
+
+BOOST_AUTO_TEST_CASE( test_rfft1D_range1to2048_random )
+{
+  // This tests the 1D real FFT using 10 random vectors
+  for (int loop=0; loop < 10; ++loop) {
+    // size of the data
+    int N = (rand() % 2048 + 1);
+
+    // set up simple 1D random tensor 
+    blitz::Array<double,1> t(N);
+    for (int i=0; i<N; ++i)
+      t(i) = (rand()/(double)RAND_MAX)*10.;
+
+    // call the test function
+    test_rfft1D( t, eps);
+  }
+}
+
 BOOST_AUTO_TEST_CASE( test_fft2D_1x1to8x8_set )
 {
   // size of the data
@@ -489,4 +552,41 @@ BOOST_AUTO_TEST_CASE( test_fftshift2D_random )
   }
 }
 
+BOOST_AUTO_TEST_CASE( test_fftw_plan_cache )
+{
+  // This tests that plans are created once and reused, including on
+  // array views with an offset and with a measuring planner
+  bob::sp::clearPlanCache();
+  const int M = 60;
+  blitz::Array<std::complex<double>,1> buffer(M+1), t_fft(M), t_dft(M);
+  for (int i=0; i < M+1; ++i)
+    buffer(i) = std::complex<double>((rand()/(double)RAND_MAX)*10.,0);
+  // view with an offset on the buffer
+  blitz::Array<std::complex<double>,1> t = buffer(blitz::Range(1,M));
+
+  bob::sp::FFT1D fft(M);
+  bob::sp::detail::FFT1DNaive dft(M);
+  dft(t, t_dft);
+  fft(t, t_fft);
+  const size_t n_plans = bob::sp::getPlanCacheSize();
+  BOOST_CHECK_EQUAL(n_plans, (size_t)1);
+  for (int loop=0; loop < 10; ++loop) {
+    fft(t, t_fft);
+    for (int i=0; i < M; ++i)
+      BOOST_CHECK_SMALL( abs(t_fft(i)-t_dft(i)), eps);
+  }
+  BOOST_CHECK_EQUAL(bob::sp::getPlanCacheSize(), n_plans);
+
+  // a new rigor leads to a new plan
+  bob::sp::setPlannerRigor(bob::sp::PLANNER_MEASURE);
+  fft(t, t_fft);
+  for (int i=0; i < M; ++i)
+    BOOST_CHECK_SMALL( abs(t_fft(i)-t_dft(i)), eps);
+  BOOST_CHECK_EQUAL(bob::sp::getPlanCacheSize(), n_plans+1);
+  bob::sp::setPlannerRigor(bob::sp::PLANNER_ESTIMATE);
+
+  bob::sp::clearPlanCache();
+  BOOST_CHECK_EQUAL(bob::sp::getPlanCacheSize(), (size_t)0);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
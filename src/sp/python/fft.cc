@@ -24,10 +24,12 @@
 #include <bob/python/ndarray.h>
 
 #include <bob/sp/FFT1D.h>
+#include <bob/sp/RFFT1D.h>
 #include <bob/sp/FFT2D.h>
 #include <bob/sp/FFT1DNaive.h>
 #include <bob/sp/FFT2DNaive.h>
 #include <bob/sp/fftshift.h>
+#include <bob/sp/FFTWCache.h>
 
 
 using namespace boost::python;
@@ -35,6 +37,8 @@ using namespace boost::python;
 // documentation for classes
 static const char* FFT1D_DOC = "Objects of this class, after configuration, can compute the direct FFT of a 1D array/signal.";
 static const char* IFFT1D_DOC = "Objects of this class, after configuration, can compute the inverse FFT of a 1D array/signal.";
+static const char* RFFT1D_DOC = "Objects of this class, after configuration, can compute the direct FFT of a real 1D array/signal. Only the length/2+1 first coefficients of the (Hermitian symmetric) transform are computed.";
+static const char* IRFFT1D_DOC = "Objects of this class, after configuration, can compute the real 1D array/signal whose FFT has the given length/2+1 first coefficients.";
 static const char* FFT2D_DOC = "Objects of this class, after configuration, can compute the direct FFT of a 2D array/signal.";
 static const char* IFFT2D_DOC = "Objects of this class, after configuration, can compute the inverse FFT of a 2D array/signal.";
  
@@ -45,6 +49,8 @@ static const char* IFFT_DOC = "Compute the inverse FFT of a 1 or 2D array/signal
 static const char* FFTSHIFT_DOC = "If a 1D complex128 array is passed, inverses the two halves of that array and returns the result as a new array. If a 2D complex128 array is passed, swaps the four quadrants of the array and returns the result as a new array.";
 static const char* IFFTSHIFT_DOC = "This method undo what fftshift() does. Accepts 1 or 2D array of type complex128.";
 
+static const char* PLANNER_RIGOR_DOC = "Rigor of the FFTW planner used when a transform of a given size is computed for the first time. Plans are cached and reused by all the FFT/DCT classes.";
+
 
 static void py_fft1d_c(bob::sp::FFT1D& op, bob::python::const_ndarray src,
   bob::python::ndarray dst) 
@@ -76,6 +82,36 @@ static object py_ifft1d_p(bob::sp::IFFT1D& op, bob::python::const_ndarray src)
   return dst.self();
 }
 
+static void py_rfft1d_c(bob::sp::RFFT1D& op, bob::python::const_ndarray src,
+  bob::python::ndarray dst) 
+{
+  blitz::Array<std::complex<double>,1> dst_ = dst.bz<std::complex<double>,1>();
+  op(src.bz<double,1>(), dst_);
+}
+
+static object py_rfft1d_p(bob::sp::RFFT1D& op, bob::python::const_ndarray src)
+{
+  bob::python::ndarray dst(bob::core::array::t_complex128, op.getComplexLength());
+  blitz::Array<std::complex<double>,1> dst_ = dst.bz<std::complex<double>,1>();
+  op(src.bz<double,1>(), dst_);
+  return dst.self();
+}
+
+static void py_irfft1d_c(bob::sp::IRFFT1D& op, bob::python::const_ndarray src,
+  bob::python::ndarray dst) 
+{
+  blitz::Array<double,1> dst_ = dst.bz<double,1>();
+  op(src.bz<std::complex<double>,1>(), dst_);
+}
+
+static object py_irfft1d_p(bob::sp::IRFFT1D& op, bob::python::const_ndarray src)
+{
+  bob::python::ndarray dst(bob::core::array::t_float64, op.getLength());
+  blitz::Array<double,1> dst_ = dst.bz<double,1>();
+  op(src.bz<std::complex<double>,1>(), dst_);
+  return dst.self();
+}
+
 
 static void py_fft2d_c(bob::sp::FFT2D& op, bob::python::const_ndarray src,
   bob::python::ndarray dst) 
@@ -280,6 +316,28 @@ void bind_sp_fft()
       .def("__call__", &py_ifft1d_p, (arg("self"), arg("input")), "Compute the inverse FFT of the input 1D array/signal. The output is allocated and returned.")
     ;
 
+  class_<bob::sp::RFFT1DAbstract, boost::noncopyable>("RFFT1DAbstract", "Abstract class for RFFT1D", no_init)
+    .def("reset", (void (bob::sp::RFFT1D::*)(const size_t))&bob::sp::RFFT1D::reset, (arg("self"),arg("length")), "Reset the length of the real signals.")
+    .add_property("length", &bob::sp::RFFT1D::getLength, "The length of the real signals")
+    .add_property("complex_length", &bob::sp::RFFT1D::getComplexLength, "The number of coefficients of the transforms (length/2+1)")
+    ;
+
+  class_<bob::sp::RFFT1D, boost::shared_ptr<bob::sp::RFFT1D>, bases<bob::sp::RFFT1DAbstract> >("RFFT1D", RFFT1D_DOC, init<const size_t>((arg("self"), arg("length"))))
+      .def(init<bob::sp::RFFT1D&>((arg("self"), arg("other"))))
+      .def(self == self)
+      .def(self != self)
+      .def("__call__", &py_rfft1d_c, (arg("self"), arg("input"), arg("output")), "Compute the FFT of the input real 1D array/signal. The output should have the expected size (length/2+1) and type (numpy.complex128).")
+      .def("__call__", &py_rfft1d_p, (arg("self"), arg("input")), "Compute the FFT of the input real 1D array/signal. The output is allocated and returned.")
+    ;
+
+  class_<bob::sp::IRFFT1D, boost::shared_ptr<bob::sp::IRFFT1D>, bases<bob::sp::RFFT1DAbstract> >("IRFFT1D", IRFFT1D_DOC, init<const size_t>((arg("self"), arg("length"))))
+      .def(init<bob::sp::IRFFT1D&>((arg("self"), arg("other"))))
+      .def(self == self)
+      .def(self != self)
+      .def("__call__", &py_irfft1d_c, (arg("self"), arg("input"), arg("output")), "Compute the real 1D array/signal from the length/2+1 first coefficients of its FFT. The output should have the expected size (length) and type (numpy.float64).")
+      .def("__call__", &py_irfft1d_p, (arg("self"), arg("input")), "Compute the real 1D array/signal from the length/2+1 first coefficients of its FFT. The output is allocated and returned.")
+    ;
+
   class_<bob::sp::FFT2DAbstract, boost::noncopyable>("FFT2DAbstract", "Abstract class for FFT2D", no_init)
     .def("reset", (void (bob::sp::FFT2D::*)(const size_t, const size_t))&bob::sp::FFT2D::reset, (arg("self"), arg("height"), arg("width")), "Reset the dimension of the expected input signals.")
     .add_property("height", &bob::sp::FFT2D::getHeight)
@@ -313,4 +371,20 @@ void bind_sp_fft()
 
   def("fftshift", &py_fftshift, (arg("input"),arg("output")), FFTSHIFT_DOC);
   def("ifftshift", &py_ifftshift, (arg("input"),arg("output")), IFFTSHIFT_DOC);
+
+  // FFTW plan cache and wisdom
+  enum_<bob::sp::PlannerRigor>("PlannerRigor", PLANNER_RIGOR_DOC)
+    .value("ESTIMATE", bob::sp::PLANNER_ESTIMATE)
+    .value("MEASURE", bob::sp::PLANNER_MEASURE)
+    .value("PATIENT", bob::sp::PLANNER_PATIENT)
+    .value("EXHAUSTIVE", bob::sp::PLANNER_EXHAUSTIVE)
+    ;
+
+  def("set_planner_rigor", &bob::sp::setPlannerRigor, (arg("rigor")), "Sets the rigor of the FFTW planner for the plans created from now on.");
+  def("get_planner_rigor", &bob::sp::getPlannerRigor, "Gets the rigor of the FFTW planner.");
+  def("import_wisdom", &bob::sp::importWisdom, (arg("filename")), "Imports FFTW wisdom from the given file. Returns True on success.");
+  def("export_wisdom", &bob::sp::exportWisdom, (arg("filename")), "Exports the FFTW wisdom accumulated so far to the given file.");
+  def("forget_wisdom", &bob::sp::forgetWisdom, "Forgets the FFTW wisdom accumulated so far.");
+  def("clear_plan_cache", &bob::sp::clearPlanCache, "Destroys all the cached FFTW plans. This must not be called while a transform is running.");
+  def("plan_cache_size", &bob::sp::getPlanCacheSize, "Returns the number of FFTW plans currently cached.");
 }
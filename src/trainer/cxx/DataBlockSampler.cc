@@ -0,0 +1,346 @@
+/**
+ * @file trainer/cxx/DataBlockSampler.cc
+ * @date Sat Oct 17 19:12:40 CEST 2026
+ * @author Laurent El Shafey <Laurent.El-Shafey@idiap.ch>
+ *
+ * @brief Streams the samples stored in a list of files, one block of samples
+ * at a time
+ *
+ * Copyright (C) 2011-2013 Idiap Research Institute, Martigny, Switzerland
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <bob/trainer/DataBlockSampler.h>
+#include <boost/bind.hpp>
+#include <boost/format.hpp>
+#include <algorithm>
+#include <stdexcept>
+
+namespace {
+
+  /**
+   * Reads the consecutive arrays [pos,pos+shape(0)[ of a dataset into the
+   * (C-contiguous) output, converting their elements
+   */
+  template <typename T, int N>
+  void readConvertedArrays(bob::io::HDF5File& file, const std::string& path,
+    const size_t pos, const blitz::TinyVector<int,N>& shape, double* output)
+  {
+    blitz::Array<T,N> arrays(shape);
+    file.readArrays(path, pos, arrays);
+    std::copy(arrays.data(), arrays.data() + arrays.numElements(), output);
+  }
+
+  /**
+   * Reads the consecutive arrays [pos,pos+shape(0)[ of a dataset of the
+   * given type into the (C-contiguous) output, in a single operation. Arrays
+   * of doubles are read in place.
+   */
+  template <int N>
+  void readArrays(bob::io::HDF5File& file, const std::string& path,
+    const bob::core::array::ElementType dtype, const size_t pos,
+    const blitz::TinyVector<int,N>& shape, double* output)
+  {
+    switch (dtype)
+    {
+      case bob::core::array::t_float64:
+        {
+          blitz::Array<double,N> arrays(output, shape, blitz::neverDeleteData);
+          file.readArrays(path, pos, arrays);
+        }
+        break;
+      case bob::core::array::t_float32:
+        readConvertedArrays<float,N>(file, path, pos, shape, output); break;
+      case bob::core::array::t_int8:
+        readConvertedArrays<int8_t,N>(file, path, pos, shape, output); break;
+      case bob::core::array::t_int16:
+        readConvertedArrays<int16_t,N>(file, path, pos, shape, output); break;
+      case bob::core::array::t_int32:
+        readConvertedArrays<int32_t,N>(file, path, pos, shape, output); break;
+      case bob::core::array::t_int64:
+        readConvertedArrays<int64_t,N>(file, path, pos, shape, output); break;
+      case bob::core::array::t_uint8:
+        readConvertedArrays<uint8_t,N>(file, path, pos, shape, output); break;
+      case bob::core::array::t_uint16:
+        readConvertedArrays<uint16_t,N>(file, path, pos, shape, output); break;
+      case bob::core::array::t_uint32:
+        readConvertedArrays<uint32_t,N>(file, path, pos, shape, output); break;
+      case bob::core::array::t_uint64:
+        readConvertedArrays<uint64_t,N>(file, path, pos, shape, output); break;
+      default:
+        {
+          boost::format m("DataBlockSampler: cannot convert the elements of type '%s' of the dataset '%s' to double");
+          m % bob::core::array::stringize(dtype) % path;
+          throw std::runtime_error(m.str());
+        }
+    }
+  }
+
+}
+
+bob::trainer::DataBlockSampler::DataBlockSampler(
+    const std::vector<boost::shared_ptr<bob::io::HDF5File> >& files,
+    const size_t block_size, const bool prefetch):
+  m_files(files),
+  m_block_size(block_size),
+  m_prefetch(prefetch)
+{
+  initialize();
+}
+
+bob::trainer::DataBlockSampler::DataBlockSampler(
+    const std::vector<std::string>& filenames, const size_t block_size,
+    const bool prefetch):
+  m_block_size(block_size),
+  m_prefetch(prefetch)
+{
+  for (size_t i=0; i<filenames.size(); ++i)
+    m_files.push_back(boost::shared_ptr<bob::io::HDF5File>(
+      new bob::io::HDF5File(filenames[i], bob::io::HDF5File::in)));
+  initialize();
+}
+
+bob::trainer::DataBlockSampler::~DataBlockSampler()
+{
+  stop();
+}
+
+void bob::trainer::DataBlockSampler::initialize()
+{
+  if (m_files.empty())
+    throw std::runtime_error("DataBlockSampler: no file to read the samples from");
+  if (m_block_size == 0)
+    throw std::runtime_error("DataBlockSampler: the size of the blocks should be strictly positive");
+
+  // The first dataset of each file either contains samples (1D arrays) or
+  // sets of samples (2D arrays) of the same dimensionality
+  m_paths.resize(m_files.size());
+  m_types.resize(m_files.size());
+  m_sizes.resize(m_files.size());
+  for (size_t i=0; i<m_files.size(); ++i)
+  {
+    std::vector<std::string> paths;
+    m_files[i]->paths(paths);
+    if (paths.empty())
+    {
+      boost::format m("DataBlockSampler: the file '%s' does not contain any dataset");
+      m % m_files[i]->filename();
+      throw std::runtime_error(m.str());
+    }
+    m_paths[i] = paths[0];
+    const bob::io::HDF5Descriptor& descr = m_files[i]->describe(m_paths[i])[0];
+    descr.type.copy_to(m_types[i]);
+    m_sizes[i] = descr.size;
+
+    const bob::core::array::typeinfo& type = m_types[i];
+    if (type.nd != 1 && type.nd != 2)
+    {
+      boost::format m("DataBlockSampler: the file '%s' contains arrays of type '%s', whereas 1D or 2D arrays are expected");
+      m % m_files[i]->filename() % type.str();
+      throw std::runtime_error(m.str());
+    }
+    const size_t n_inputs = type.shape[type.nd-1];
+    if (i == 0) m_n_inputs = n_inputs;
+    else if (n_inputs != m_n_inputs)
+    {
+      boost::format m("DataBlockSampler: the samples of the file '%s' have %d features, whereas %d are expected");
+      m % m_files[i]->filename() % n_inputs % m_n_inputs;
+      throw std::runtime_error(m.str());
+    }
+  }
+
+  for (int i=0; i<2; ++i)
+  {
+    m_buffer[i].resize(m_block_size, m_n_inputs);
+    m_buffer_data[i] = m_buffer[i].data();
+  }
+  m_stop = false;
+  reset();
+}
+
+void bob::trainer::DataBlockSampler::stop()
+{
+  if (!m_thread) return;
+  {
+    boost::lock_guard<boost::mutex> lock(m_mutex);
+    m_stop = true;
+  }
+  m_condition.notify_all();
+  m_thread->join();
+  m_thread.reset();
+  m_stop = false;
+}
+
+void bob::trainer::DataBlockSampler::reset()
+{
+  stop();
+
+  m_file = 0;
+  m_array = 0;
+  m_row = 0;
+  m_buffer_full[0] = m_buffer_full[1] = false;
+  m_current = -1;
+  m_next = 0;
+  m_done = false;
+  m_error.clear();
+
+  if (m_prefetch)
+    m_thread.reset(new boost::thread(boost::bind(
+      &bob::trainer::DataBlockSampler::prefetchBlocks, this)));
+}
+
+size_t bob::trainer::DataBlockSampler::readBlock(double* block)
+{
+  size_t n = 0;
+  while (n < m_block_size && m_file < m_files.size())
+  {
+    if (m_array >= m_sizes[m_file])
+    {
+      ++m_file;
+      m_array = 0;
+      continue;
+    }
+
+    bob::io::HDF5File& file = *m_files[m_file];
+    const std::string& path = m_paths[m_file];
+    const bob::core::array::typeinfo& type = m_types[m_file];
+    const int n_inputs = (int)m_n_inputs;
+    double* row = block + n*m_n_inputs;
+    if (type.nd == 1)
+    {
+      // Samples, read in place up to the end of the block
+      const size_t n_read = std::min(m_block_size - n,
+        m_sizes[m_file] - m_array);
+      readArrays<2>(file, path, type.dtype, m_array,
+        blitz::shape((int)n_read, n_inputs), row);
+      m_array += n_read;
+      n += n_read;
+    }
+    else
+    {
+      const int n_rows = (int)type.shape[0];
+      if (m_row == 0 && (size_t)n_rows <= m_block_size - n)
+      {
+        // Sets of samples fitting in the block, read in place
+        const size_t n_read = std::min((m_block_size - n) / n_rows,
+          m_sizes[m_file] - m_array);
+        readArrays<3>(file, path, type.dtype, m_array,
+          blitz::shape((int)n_read, n_rows, n_inputs), row);
+        m_array += n_read;
+        n += n_read * n_rows;
+      }
+      else
+      {
+        // Set of samples overlapping the end of the block, whose rows are
+        // copied into the successive blocks
+        if (m_row == 0)
+        {
+          m_array_cache.resize(n_rows, n_inputs);
+          readArrays<3>(file, path, type.dtype, m_array,
+            blitz::shape(1, n_rows, n_inputs), m_array_cache.data());
+        }
+        const int n_copy = std::min((int)(m_block_size - n), n_rows - m_row);
+        const double* data = m_array_cache.data() + m_row*m_n_inputs;
+        std::copy(data, data + n_copy*m_n_inputs, row);
+        m_row += n_copy;
+        n += n_copy;
+        if (m_row == n_rows)
+        {
+          m_row = 0;
+          ++m_array;
+        }
+      }
+    }
+  }
+  return n;
+}
+
+void bob::trainer::DataBlockSampler::prefetchBlocks()
+{
+  try
+  {
+    for (int b=0; ; b=1-b)
+    {
+      // Waits until the consumer is done with the buffer
+      {
+        boost::unique_lock<boost::mutex> lock(m_mutex);
+        while (m_buffer_full[b] && !m_stop) m_condition.wait(lock);
+        if (m_stop) return;
+      }
+
+      const size_t n = readBlock(m_buffer_data[b]);
+
+      {
+        boost::lock_guard<boost::mutex> lock(m_mutex);
+        if (n == 0) m_done = true;
+        else
+        {
+          m_buffer_rows[b] = n;
+          m_buffer_full[b] = true;
+        }
+      }
+      m_condition.notify_all();
+      if (n == 0) return;
+    }
+  }
+  catch (std::exception& e)
+  {
+    {
+      boost::lock_guard<boost::mutex> lock(m_mutex);
+      m_error = e.what();
+      m_done = true;
+    }
+    m_condition.notify_all();
+  }
+}
+
+bool bob::trainer::DataBlockSampler::next(blitz::Array<double,2>& block)
+{
+  blitz::Range a = blitz::Range::all();
+  if (!m_prefetch)
+  {
+    const size_t n = readBlock(m_buffer_data[0]);
+    if (n == 0) return false;
+    block.reference(m_buffer[0](blitz::Range(0,(int)n-1), a));
+    return true;
+  }
+
+  boost::unique_lock<boost::mutex> lock(m_mutex);
+  // Releases the block returned by the previous call
+  if (m_current >= 0)
+  {
+    m_buffer_full[m_current] = false;
+    m_current = -1;
+    m_condition.notify_all();
+  }
+
+  // The buffers are filled in turn
+  while (!m_buffer_full[m_next] && !m_done) m_condition.wait(lock);
+  if (!m_buffer_full[m_next])
+  {
+    if (!m_error.empty())
+    {
+      boost::format m("DataBlockSampler: cannot read the samples: %s");
+      m % m_error;
+      throw std::runtime_error(m.str());
+    }
+    return false;
+  }
+
+  m_current = m_next;
+  m_next = 1 - m_next;
+  block.reference(m_buffer[m_current](
+    blitz::Range(0,(int)m_buffer_rows[m_current]-1), a));
+  return true;
+}
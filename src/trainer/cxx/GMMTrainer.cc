@@ -21,6 +21,7 @@
 #include <bob/trainer/GMMTrainer.h>
 #include <bob/core/assert.h>
 #include <bob/core/check.h>
+#include <boost/bind.hpp>
 
 bob::trainer::GMMTrainer::GMMTrainer(const bool update_means, 
     const bool update_variances, const bool update_weights,
@@ -28,7 +29,7 @@ bob::trainer::GMMTrainer::GMMTrainer(const bool update_means,
   bob::trainer::EMTrainer<bob::machine::GMMMachine, blitz::Array<double,2> >(), 
   m_update_means(update_means), m_update_variances(update_variances),
   m_update_weights(update_weights), 
-  m_mean_var_update_responsibilities_threshold(mean_var_update_responsibilities_threshold) 
+  m_mean_var_update_responsibilities_threshold(mean_var_update_responsibilities_threshold)
 {
 }
 
@@ -43,6 +44,23 @@ bob::trainer::GMMTrainer::~GMMTrainer()
 {
 }
 
+void bob::trainer::GMMTrainer::train(bob::machine::GMMMachine& gmm,
+  bob::trainer::DataBlockSampler& sampler)
+{
+  bob::core::info << "# " << name() << ":" << std::endl;
+
+  // Initialization
+  initialize(gmm, sampler);
+  // Do the Expectation-Maximization algorithm, the E-step streaming the
+  // blocks of the sampler
+  void (bob::trainer::GMMTrainer::*e_step)(bob::machine::GMMMachine&,
+    bob::trainer::DataBlockSampler&) = &bob::trainer::GMMTrainer::eStep;
+  const blitz::Array<double,2> no_data;
+  iterate(gmm, boost::bind(e_step, this, _1, boost::ref(sampler)), no_data);
+  // Finalization
+  finalize(gmm, no_data);
+}
+
 void bob::trainer::GMMTrainer::initialize(bob::machine::GMMMachine& gmm,
   const blitz::Array<double,2>& data)
 {
@@ -50,6 +68,14 @@ void bob::trainer::GMMTrainer::initialize(bob::machine::GMMMachine& gmm,
   m_ss.resize(gmm.getNGaussians(),gmm.getNInputs());
 }
 
+void bob::trainer::GMMTrainer::initialize(bob::machine::GMMMachine& gmm,
+  bob::trainer::DataBlockSampler& sampler)
+{
+  bob::core::array::assertSameDimensionLength(sampler.getNInputs(),
+    gmm.getNInputs());
+  initialize(gmm, blitz::Array<double,2>());
+}
+
 void bob::trainer::GMMTrainer::eStep(bob::machine::GMMMachine& gmm,
   const blitz::Array<double,2>& data) 
 {
@@ -58,6 +84,20 @@ void bob::trainer::GMMTrainer::eStep(bob::machine::GMMMachine& gmm,
   gmm.accStatistics(data, m_ss);
 }
 
+void bob::trainer::GMMTrainer::eStep(bob::machine::GMMMachine& gmm,
+  bob::trainer::DataBlockSampler& sampler)
+{
+  bob::core::array::assertSameDimensionLength(sampler.getNInputs(),
+    gmm.getNInputs());
+
+  m_ss.init();
+  // Accumulates the sufficient statistics of the blocks in m_ss
+  blitz::Array<double,2> block;
+  sampler.reset();
+  while (sampler.next(block))
+    gmm.accStatistics(block, m_ss);
+}
+
 double bob::trainer::GMMTrainer::computeLikelihood(bob::machine::GMMMachine& gmm)
 {
   return m_ss.log_likelihood / m_ss.T;
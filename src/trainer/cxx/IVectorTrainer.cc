@@ -24,11 +24,20 @@
 #include <bob/core/array_copy.h>
 #include <bob/core/array_random.h>
 #include <bob/core/check.h>
+#include <bob/core/parallel.h>
 #include <bob/math/inv.h>
 #include <bob/math/linear.h>
 #include <bob/math/linsolve.h>
 #include <boost/shared_ptr.hpp>
 #include <boost/random.hpp>
+#include <boost/bind.hpp>
+#include <algorithm>
+
+/**
+ * Number of samples whose posteriors are kept before updating the
+ * accumulators in the E-step
+ */
+static const size_t IVECTOR_ESTEP_BLOCK = 128;
 
 bob::trainer::IVectorTrainer::IVectorTrainer(const bool update_sigma,
     const double convergence_threshold,
@@ -50,14 +59,8 @@ bob::trainer::IVectorTrainer::IVectorTrainer(const bob::trainer::IVectorTrainer&
   m_acc_Nij.reference(bob::core::array::ccopy(other.m_acc_Nij));
   m_acc_Snormij.reference(bob::core::array::ccopy(other.m_acc_Snormij));
 
-  m_tmp_wij.reference(bob::core::array::ccopy(other.m_tmp_wij));
-  m_tmp_wij2.reference(bob::core::array::ccopy(other.m_tmp_wij2));
   m_tmp_d1.reference(bob::core::array::ccopy(other.m_tmp_d1));
-  m_tmp_t1.reference(bob::core::array::ccopy(other.m_tmp_t1));
   m_tmp_dd1.reference(bob::core::array::ccopy(other.m_tmp_dd1));
-  m_tmp_dt1.reference(bob::core::array::ccopy(other.m_tmp_dt1));
-  m_tmp_tt1.reference(bob::core::array::ccopy(other.m_tmp_tt1));
-  m_tmp_tt2.reference(bob::core::array::ccopy(other.m_tmp_tt2));
 }
 
 bob::trainer::IVectorTrainer::~IVectorTrainer() 
@@ -82,13 +85,7 @@ void bob::trainer::IVectorTrainer::initialize(
   }
 
   // Tmp
-  m_tmp_wij.resize(Rt);
-  m_tmp_wij2.resize(Rt,Rt);
   m_tmp_d1.resize(D);
-  m_tmp_t1.resize(Rt);
-  m_tmp_dt1.resize(D,Rt);
-  m_tmp_tt1.resize(Rt,Rt);
-  m_tmp_tt2.resize(Rt,Rt);
   if (m_update_sigma)
     m_tmp_dd1.resize(D,D);
 
@@ -104,8 +101,9 @@ void bob::trainer::IVectorTrainer::eStep(
   bob::machine::IVectorMachine& machine,
   const std::vector<bob::machine::GMMStats>& data)
 {
-  blitz::Range rall = blitz::Range::all();
   const int C = machine.getDimC();
+  const int D = machine.getDimD();
+  const int Rt = machine.getDimRt();
 
   // Reinitializes accumulators to 0
   m_acc_Nij_wij2 = 0.;
@@ -115,44 +113,129 @@ void bob::trainer::IVectorTrainer::eStep(
     m_acc_Nij = 0.;
     m_acc_Snormij = 0.;
   }
-  for (std::vector<bob::machine::GMMStats>::const_iterator it = data.begin();
-       it != data.end(); ++it)
+
+  const size_t block = std::min(IVECTOR_ESTEP_BLOCK, data.size());
+  if (m_tmp_Ewij.extent(0) != (int)block || m_tmp_Ewij.extent(1) != Rt)
+  {
+    m_tmp_Ewij.resize(block, Rt);
+    m_tmp_Ewij2.resize(block, Rt*(Rt+1)/2);
+  }
+  // One workspace per thread
+  std::vector<bob::machine::IVectorMachineWorkspace> ws(bob::core::getNThreads());
+  for (size_t t=0; t<ws.size(); ++t)
   {
-    // Computes E{wij} and E{wij.wij^{T}}
+    ws[t].resize(D, Rt);
+    ws[t].resizeBatch(C, D, Rt, machine.getBatchSize());
+  }
+  const blitz::Array<double,1>& means = machine.getUbm()->getMeanSupervector();
+
+  for (size_t offset=0; offset<data.size(); offset+=block)
+  {
+    const size_t n_samples = std::min(block, data.size()-offset);
+    // Computes E{wij} and E{wij.wij^{T}} for each sample of the block
+    bob::core::parallelFor(0, n_samples,
+      boost::bind(&bob::trainer::IVectorTrainer::eStepPosteriors, this,
+        boost::cref(machine), boost::cref(data), boost::cref(means), offset,
+        boost::ref(ws), _1, _2, _3),
+      machine.getBatchSize());
+    // Updates the accumulators, by ranges of Gaussian components
+    bob::core::parallelFor(0, C,
+      boost::bind(&bob::trainer::IVectorTrainer::eStepAccumulate, this,
+        boost::cref(data), boost::cref(means), offset, n_samples, _1, _2, _3));
+  }
+
+  // Only the upper triangles of Nijc . E{wij.wij^{T}} were accumulated
+  for (int c=0; c<C; ++c)
+    for (int i=0; i<Rt; ++i)
+      for (int j=i+1; j<Rt; ++j)
+        m_acc_Nij_wij2(c,j,i) = m_acc_Nij_wij2(c,i,j);
+}
+
+void bob::trainer::IVectorTrainer::eStepPosteriors(
+  const bob::machine::IVectorMachine& machine,
+  const std::vector<bob::machine::GMMStats>& data,
+  const blitz::Array<double,1>& means, const size_t offset,
+  std::vector<bob::machine::IVectorMachineWorkspace>& ws,
+  const size_t begin, const size_t end, const size_t thread)
+{
+  // The rows of the shared arrays are written through raw pointers
+  bob::machine::IVectorMachineWorkspace& w = ws[thread];
+  const int Rt = machine.getDimRt();
+  const int K = Rt*(Rt+1)/2;
+  const size_t batch_size = machine.getBatchSize();
+  blitz::Range a = blitz::Range::all();
+  for (size_t b=begin; b<end; b+=batch_size)
+  {
+    const int n_samples = (int)std::min(batch_size, end-b);
     // a. Computes \f$T^{T} \Sigma^{-1} F_{norm}\f$
-    machine.computeTtSigmaInvFnorm(*it, m_tmp_t1);
     // b. Computes \f$Id + T^{T} \Sigma^{-1} T\f$
-    machine.computeIdTtSigmaInvT(*it, m_tmp_tt1);
-    // c. Computes \f$(Id + T^{T} \Sigma^{-1} T)^{-1}\f$
-    bob::math::inv(m_tmp_tt1, m_tmp_tt2);
-    // d. Computes \f$E{wij} = (Id + T^{T} \Sigma^{-1} T)^{-1} T^{T} \Sigma^{-1} F_{norm}\f$
-    bob::math::prod(m_tmp_tt2, m_tmp_t1, m_tmp_wij); // E{wij}
-    // e.  Computes \f$E{wij}.E{wij^{T}}\f$
-    bob::math::prod(m_tmp_wij, m_tmp_wij, m_tmp_wij2);
-    // f. Computes \f$E{wij.wij^{T}} = (Id + T^{T} \Sigma^{-1} T)^{-1} + E{wij}.E{wij^{T}}\f$
-    m_tmp_wij2 += m_tmp_tt2; // E{wij.wij^{T}}
+    machine.computeBatch(data, means, offset+b, offset+b+n_samples, w);
 
-    if (m_update_sigma)
-      m_acc_Nij += (*it).n;
+    for (int s=0; s<n_samples; ++s)
+    {
+      // c. Computes \f$(Id + T^{T} \Sigma^{-1} T)^{-1}\f$
+      blitz::Array<double,2> precision_s = w.tmp_precision(s,a,a);
+      bob::math::inv(precision_s, w.tmp_tt);
+      // d. Computes \f$E{wij} = (Id + T^{T} \Sigma^{-1} T)^{-1} T^{T} \Sigma^{-1} F_{norm}\f$
+      blitz::Array<double,1> rhs_s = w.tmp_rhs(s,a);
+      bob::math::prod(w.tmp_tt, rhs_s, w.tmp_t1);
+      // e. Computes \f$E{wij.wij^{T}} = (Id + T^{T} \Sigma^{-1} T)^{-1} + E{wij}.E{wij^{T}}\f$
+      double* Ewij = m_tmp_Ewij.data() + (b+s)*Rt;
+      double* Ewij2 = m_tmp_Ewij2.data() + (b+s)*K;
+      for (int i=0; i<Rt; ++i)
+      {
+        Ewij[i] = w.tmp_t1(i);
+        for (int j=i; j<Rt; ++j)
+          *Ewij2++ = w.tmp_tt(i,j) + w.tmp_t1(i) * w.tmp_t1(j);
+      }
+    }
+  }
+}
 
-    for (int c=0; c<C; ++c)
+void bob::trainer::IVectorTrainer::eStepAccumulate(
+  const std::vector<bob::machine::GMMStats>& data,
+  const blitz::Array<double,1>& means, const size_t offset,
+  const size_t n_samples, const size_t begin, const size_t end,
+  const size_t thread)
+{
+  // Each thread updates the accumulators of its own Gaussian components
+  const int D = m_acc_Fnormij_wij.extent(1);
+  const int Rt = m_tmp_Ewij.extent(1);
+  const int K = Rt*(Rt+1)/2;
+  for (size_t c=begin; c<end; ++c)
+  {
+    double* acc_Nij_wij2_c = m_acc_Nij_wij2.data() + c*Rt*Rt;
+    double* acc_Fnormij_wij_c = m_acc_Fnormij_wij.data() + c*D*Rt;
+    for (size_t s=0; s<n_samples; ++s)
     {
-      blitz::Array<double,2> acc_Nij_wij2_c = m_acc_Nij_wij2(c,rall,rall);
-      blitz::Array<double,2> acc_Fnormij_wij = m_acc_Fnormij_wij(c,rall,rall);
-      // acc_Nij_wij2_c += Nijc . E{wij.wij^{T}}
-      acc_Nij_wij2_c += (*it).n(c) * m_tmp_wij2;
-      blitz::Array<double,1> mc = machine.getUbm()->getGaussian(c)->getMean();
-      // m_tmp_d1 = Fijc - Nijc * ubmmean_{c}
-      m_tmp_d1 = (*it).sumPx(c,rall) - (*it).n(c)*mc; // Fnorm_c
-      // m_tmp_dt1 = (Fijc - Nijc * ubmmean_{c}).E{wij}^{T}
-      bob::math::prod(m_tmp_d1, m_tmp_wij, m_tmp_dt1); 
-      // acc_Fnormij_wij += (Fijc - Nijc * ubmmean_{c}).E{wij}^{T}
-      acc_Fnormij_wij += m_tmp_dt1;
-      if (m_update_sigma)
+      const bob::machine::GMMStats& gs = data[offset+s];
+      const double n_c = gs.n(c);
+      const double* Ewij = m_tmp_Ewij.data() + s*Rt;
+      // acc_Nij_wij2_c += Nijc . E{wij.wij^{T}} (upper triangle)
+      if (n_c != 0.)
+      {
+        const double* Ewij2 = m_tmp_Ewij2.data() + s*K;
+        for (int i=0; i<Rt; ++i)
+        {
+          double* acc = acc_Nij_wij2_c + i*Rt;
+          for (int j=i; j<Rt; ++j, ++Ewij2)
+            acc[j] += n_c * *Ewij2;
+        }
+      }
+      for (int d=0; d<D; ++d)
       {
-        blitz::Array<double,1> acc_Snormij_c = m_acc_Snormij(c,rall);
-        acc_Snormij_c += (*it).sumPxx(c,rall) - mc*((*it).sumPx(c,rall) + m_tmp_d1);
+        // Fnorm_c = Fijc - Nijc * ubmmean_{c}
+        const double mcd = means(c*D+d);
+        const double fnorm = gs.sumPx(c,d) - n_c * mcd;
+        // acc_Fnormij_wij += (Fijc - Nijc * ubmmean_{c}).E{wij}^{T}
+        double* acc = acc_Fnormij_wij_c + d*Rt;
+        for (int i=0; i<Rt; ++i)
+          acc[i] += fnorm * Ewij[i];
+        if (m_update_sigma)
+          m_acc_Snormij(c,d) += gs.sumPxx(c,d) - mcd * (gs.sumPx(c,d) + fnorm);
       }
+      if (m_update_sigma)
+        m_acc_Nij(c) += n_c;
     }
   }
 }
@@ -219,14 +302,8 @@ bob::trainer::IVectorTrainer& bob::trainer::IVectorTrainer::operator=
     m_acc_Nij.reference(bob::core::array::ccopy(other.m_acc_Nij));
     m_acc_Snormij.reference(bob::core::array::ccopy(other.m_acc_Snormij));
 
-    m_tmp_wij.reference(bob::core::array::ccopy(other.m_tmp_wij));
-    m_tmp_wij2.reference(bob::core::array::ccopy(other.m_tmp_wij2));
     m_tmp_d1.reference(bob::core::array::ccopy(other.m_tmp_d1));
-    m_tmp_t1.reference(bob::core::array::ccopy(other.m_tmp_t1));
     m_tmp_dd1.reference(bob::core::array::ccopy(other.m_tmp_dd1));
-    m_tmp_dt1.reference(bob::core::array::ccopy(other.m_tmp_dt1));
-    m_tmp_tt1.reference(bob::core::array::ccopy(other.m_tmp_tt1));
-    m_tmp_tt2.reference(bob::core::array::ccopy(other.m_tmp_tt2)); 
   }
   return *this;
 }
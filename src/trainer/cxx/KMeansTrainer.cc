@@ -21,17 +21,44 @@
 
 #include <bob/trainer/KMeansTrainer.h>
 #include <bob/core/array_copy.h>
+#include <bob/core/assert.h>
+#include <bob/core/parallel.h>
+#include <bob/math/linear.h>
 #include <boost/random.hpp>
+#include <boost/bind.hpp>
+#include <boost/format.hpp>
+#include <algorithm>
+#include <limits>
+#include <vector>
 
 #if BOOST_VERSION >= 104700
 #include <boost/random/discrete_distribution.hpp>
 #endif
 
+/**
+ * Number of samples whose distances to the means are computed at once (as a
+ * matrix product) in the E-step
+ */
+static const size_t KMEANS_BATCH_SIZE = 256;
+
+/**
+ * Copies the means of the machine into a contiguous array, and computes their
+ * squared norms
+ */
+static void contiguousMeans(const bob::machine::KMeansMachine& kmeans,
+  blitz::Array<double,2>& means, blitz::Array<double,1>& means_norm)
+{
+  means.reference(bob::core::array::ccopy(kmeans.getMeans()));
+  means_norm.resize(means.extent(0));
+  for(int k=0; k<means.extent(0); ++k)
+    means_norm(k) = blitz::sum(blitz::pow2(means(k,blitz::Range::all())));
+}
+
 bob::trainer::KMeansTrainer::KMeansTrainer(double convergence_threshold,
     size_t max_iterations, bool compute_likelihood, InitializationMethod i_m):
   bob::trainer::EMTrainer<bob::machine::KMeansMachine, blitz::Array<double,2> >(
     convergence_threshold, max_iterations, compute_likelihood), 
-  m_initialization_method(i_m),
+  m_initialization_method(i_m), m_mini_batch_size(0),
   m_rng(new boost::mt19937()), m_average_min_distance(0),
   m_zeroethOrderStats(0), m_firstOrderStats(0,0)
 {
@@ -41,6 +68,7 @@ bob::trainer::KMeansTrainer::KMeansTrainer(const bob::trainer::KMeansTrainer& ot
   bob::trainer::EMTrainer<bob::machine::KMeansMachine, blitz::Array<double,2> >(
     other.m_convergence_threshold, other.m_max_iterations, other.m_compute_likelihood), 
   m_initialization_method(other.m_initialization_method),
+  m_mini_batch_size(other.m_mini_batch_size),
   m_rng(other.m_rng), m_average_min_distance(other.m_average_min_distance),
   m_zeroethOrderStats(bob::core::array::ccopy(other.m_zeroethOrderStats)), 
   m_firstOrderStats(bob::core::array::ccopy(other.m_firstOrderStats))
@@ -54,6 +82,7 @@ bob::trainer::KMeansTrainer& bob::trainer::KMeansTrainer::operator=
   {
     EMTrainer<bob::machine::KMeansMachine, blitz::Array<double,2> >::operator=(other);
     m_initialization_method = other.m_initialization_method;
+    m_mini_batch_size = other.m_mini_batch_size;
     m_rng = other.m_rng;
     m_average_min_distance = other.m_average_min_distance;
     m_zeroethOrderStats.reference(bob::core::array::ccopy(other.m_zeroethOrderStats));
@@ -65,6 +94,7 @@ bob::trainer::KMeansTrainer& bob::trainer::KMeansTrainer::operator=
 bool bob::trainer::KMeansTrainer::operator==(const bob::trainer::KMeansTrainer& b) const {
   return EMTrainer<bob::machine::KMeansMachine, blitz::Array<double,2> >::operator==(b) &&
          m_initialization_method == b.m_initialization_method &&
+         m_mini_batch_size == b.m_mini_batch_size &&
          *m_rng == *(b.m_rng) && m_average_min_distance == b.m_average_min_distance &&
          bob::core::array::hasSameShape(m_zeroethOrderStats, b.m_zeroethOrderStats) &&
          bob::core::array::hasSameShape(m_firstOrderStats, b.m_firstOrderStats) &&
@@ -76,6 +106,23 @@ bool bob::trainer::KMeansTrainer::operator!=(const bob::trainer::KMeansTrainer&
   return !(this->operator==(b));
 }
  
+void bob::trainer::KMeansTrainer::train(bob::machine::KMeansMachine& kmeans,
+  bob::trainer::DataBlockSampler& sampler)
+{
+  bob::core::info << "# " << name() << ":" << std::endl;
+
+  // Initialization
+  initialize(kmeans, sampler);
+  // Do the Expectation-Maximization algorithm, the E-step streaming the
+  // blocks of the sampler
+  void (bob::trainer::KMeansTrainer::*e_step)(bob::machine::KMeansMachine&,
+    bob::trainer::DataBlockSampler&) = &bob::trainer::KMeansTrainer::eStep;
+  const blitz::Array<double,2> no_data;
+  iterate(kmeans, boost::bind(e_step, this, _1, boost::ref(sampler)), no_data);
+  // Finalization
+  finalize(kmeans, no_data);
+}
+
 void bob::trainer::KMeansTrainer::initialize(bob::machine::KMeansMachine& kmeans,
   const blitz::Array<double,2>& ar) 
 {
@@ -151,23 +198,20 @@ void bob::trainer::KMeansTrainer::initialize(bob::machine::KMeansMachine& kmeans
     kmeans.setMean(0, mean);
 
     // 1.b. Loops, computes probability distribution and select samples accordingly
+    // The distance of each sample to its closest mean is kept up to date
+    // as the means are selected.
+    blitz::Array<double,1> min_distances(n_data);
     blitz::Array<double,1> weights(n_data);
     for(size_t m=1; m<kmeans.getNMeans(); ++m) 
     {
-      // For each sample, puts the distance to the closest mean in the weight vector
-      for(size_t s=0; s<n_data; ++s)
-      {
-        blitz::Array<double,1> s_cur = ar(s,a);
-        double& w_cur = weights(s);
-        // Initializes with the distance to first mean
-        w_cur = kmeans.getDistanceFromMean(s_cur, 0);
-        // Loops over the remaining mean and update the mean distance if required
-        for(size_t i=1; i<m; ++i)
-          w_cur = std::min(w_cur, kmeans.getDistanceFromMean(s_cur, i));
-      }
+      // Updates the distances with the last selected mean
+      bob::core::parallelFor(0, n_data,
+        boost::bind(&bob::trainer::KMeansTrainer::updateMinDistances, this,
+          boost::cref(ar), boost::cref(kmeans.getMeans()), m-1,
+          boost::ref(min_distances), _1, _2, _3));
       // Square and normalize the weights vectors such that
       // \f$weights[x] = D(x)^{2} \sum_{y} D(y)^{2}\f$
-      weights = blitz::pow2(weights);
+      weights = blitz::pow2(min_distances);
       weights /= blitz::sum(weights);
 
       // Takes a sample according to the weights distribution
@@ -184,31 +228,289 @@ void bob::trainer::KMeansTrainer::initialize(bob::machine::KMeansMachine& kmeans
   m_firstOrderStats.resize(kmeans.getNMeans(), kmeans.getNInputs());
 }
 
+void bob::trainer::KMeansTrainer::initialize(bob::machine::KMeansMachine& kmeans,
+  bob::trainer::DataBlockSampler& sampler)
+{
+  bob::core::array::assertSameDimensionLength(sampler.getNInputs(),
+    kmeans.getNInputs());
+
+  // Reservoir sampling: the i-th sample replaces one of the means (selected
+  // at random) with probability n_means/i, which makes each sample equally
+  // likely to be selected
+  const size_t n_means = kmeans.getNMeans();
+  blitz::Array<double,2>& means = kmeans.updateMeans();
+  blitz::Range a = blitz::Range::all();
+  uint64_t n_samples = 0;
+  blitz::Array<double,2> block;
+  sampler.reset();
+  while(sampler.next(block))
+  {
+    for(int s=0; s<block.extent(0); ++s)
+    {
+      uint64_t index = n_samples;
+      if(n_samples >= n_means)
+      {
+        boost::uniform_int<uint64_t> range(0, n_samples);
+        boost::variate_generator<boost::mt19937&, boost::uniform_int<uint64_t> > die(*m_rng, range);
+        index = die();
+      }
+      if(index >= n_means)
+      {
+        ++n_samples;
+        continue;
+      }
+
+      // Checks that the selected sample is different than the other means
+      blitz::Array<double,1> sample = block(s,a);
+      if(m_initialization_method == RANDOM_NO_DUPLICATE)
+      {
+        bool duplicate = false;
+        for(uint64_t j=0; j<std::min(n_samples,(uint64_t)n_means) && !duplicate; ++j)
+          duplicate = (j != index && blitz::all(means((int)j,a) == sample));
+        if(duplicate)
+        {
+          // Duplicates are not counted while the means are filled in
+          if(n_samples >= n_means) ++n_samples;
+          continue;
+        }
+      }
+      ++n_samples;
+      means((int)index,a) = sample;
+    }
+  }
+
+  // Initialization fails
+  if(n_samples < n_means)
+  {
+    boost::format m("initialization failure: the data contains %u (distinct) samples, whereas %u means are required");
+    m % n_samples % n_means;
+    throw std::runtime_error(m.str());
+  }
+
+  // Resize the accumulator
+  m_zeroethOrderStats.resize(kmeans.getNMeans());
+  m_firstOrderStats.resize(kmeans.getNMeans(), kmeans.getNInputs());
+
+  // Refines the initial means with mini-batch k-means if required
+  if(m_mini_batch_size > 0)
+    miniBatchStep(kmeans, sampler);
+}
+
+void bob::trainer::KMeansTrainer::miniBatchStep(
+  bob::machine::KMeansMachine& kmeans, bob::trainer::DataBlockSampler& sampler)
+{
+  if(m_mini_batch_size == 0)
+    throw std::runtime_error("the size of the mini-batches should be strictly positive");
+
+  const int n_means = kmeans.getNMeans();
+  const int n_inputs = kmeans.getNInputs();
+  blitz::Array<double,2> means;
+  blitz::Array<double,1> means_norm;
+  contiguousMeans(kmeans, means, means_norm);
+  blitz::Array<double,2> means_t = means.transpose(1,0);
+  // Number of samples assigned to each mean so far
+  blitz::Array<double,1> counts(n_means);
+  counts = 0.;
+  blitz::Array<double,2> products((int)m_mini_batch_size, n_means);
+  std::vector<int> closest_mean(m_mini_batch_size);
+
+  blitz::Range a = blitz::Range::all();
+  blitz::Array<double,2> block;
+  sampler.reset();
+  while(sampler.next(block))
+  {
+    for(int b=0; b<block.extent(0); b+=m_mini_batch_size)
+    {
+      const int n = std::min(block.extent(0)-b, (int)m_mini_batch_size);
+      blitz::Array<double,2> x = block(blitz::Range(b,b+n-1),a);
+
+      // Closest means of the samples of the mini-batch, which minimize
+      // ||mu||^2 - 2 x.mu
+      blitz::Array<double,2> xm = products(blitz::Range(0,n-1),a);
+      bob::math::prod_(x, means_t, xm);
+      for(int i=0; i<n; ++i)
+      {
+        double min_score = std::numeric_limits<double>::max();
+        for(int k=0; k<n_means; ++k)
+        {
+          const double score = means_norm(k) - 2.*xm(i,k);
+          if(score < min_score)
+          {
+            min_score = score;
+            closest_mean[i] = k;
+          }
+        }
+      }
+
+      // Moves the means towards their samples
+      for(int i=0; i<n; ++i)
+      {
+        const int k = closest_mean[i];
+        counts(k) += 1.;
+        const double eta = 1. / counts(k);
+        for(int j=0; j<n_inputs; ++j)
+          means(k,j) += eta * (x(i,j) - means(k,j));
+      }
+      for(int k=0; k<n_means; ++k)
+        means_norm(k) = blitz::sum(blitz::pow2(means(k,a)));
+    }
+  }
+  kmeans.setMeans(means);
+}
+
+void bob::trainer::KMeansTrainer::updateMinDistances(
+  const blitz::Array<double,2>& ar, const blitz::Array<double,2>& means,
+  const size_t i, blitz::Array<double,1>& min_distances, size_t begin,
+  size_t end, size_t thread_idx) const
+{
+  const int n_inputs = means.extent(1);
+  for(size_t s=begin; s<end; ++s)
+  {
+    // Same computation as KMeansMachine::getDistanceFromMean()
+    double distance = 0.;
+    for(int j=0; j<n_inputs; ++j)
+    {
+      const double d = means(i,j) - ar(s,j);
+      distance += d * d;
+    }
+    if(i == 0 || distance < min_distances(s))
+      min_distances(s) = distance;
+  }
+}
+
+void bob::trainer::KMeansTrainer::eStepRows(const blitz::Array<double,2>& ar,
+  const blitz::Array<double,2>& means, const blitz::Array<double,1>& means_norm,
+  blitz::Array<double,2>& stats, size_t begin, size_t end,
+  size_t thread_idx) const
+{
+  const int n_means = means.extent(0);
+  const int n_inputs = means.extent(1);
+  // Statistics of this thread: first order, zeroeth order, sum of the
+  // distances
+  double* first = &stats(thread_idx,0);
+  double* zeroeth = first + n_means*n_inputs;
+  double& distances = zeroeth[n_means];
+
+  // Thread-local arrays, the shared means being wrapped by their data
+  const double* mu = means.data();
+  const double* mu_norm = means_norm.data();
+  blitz::Array<double,2> means_(const_cast<double*>(mu),
+    blitz::shape(n_means,n_inputs), blitz::neverDeleteData);
+  blitz::Array<double,2> means_t = means_.transpose(1,0);
+  std::vector<double> samples(KMEANS_BATCH_SIZE*n_inputs);
+  std::vector<double> products(KMEANS_BATCH_SIZE*n_means);
+
+  for(size_t b=begin; b<end; b+=KMEANS_BATCH_SIZE)
+  {
+    const int n = std::min(end-b, KMEANS_BATCH_SIZE);
+    for(int i=0; i<n; ++i)
+      for(int j=0; j<n_inputs; ++j)
+        samples[i*n_inputs+j] = ar((int)b+i,j);
+
+    // Scalar products between the samples and the means
+    blitz::Array<double,2> x(&samples[0], blitz::shape(n,n_inputs),
+      blitz::neverDeleteData);
+    blitz::Array<double,2> xm(&products[0], blitz::shape(n,n_means),
+      blitz::neverDeleteData);
+    bob::math::prod_(x, means_t, xm);
+
+    for(int i=0; i<n; ++i)
+    {
+      // The closest mean minimizes ||mu||^2 - 2 x.mu
+      const double* xi = &samples[i*n_inputs];
+      const double* xmi = &products[i*n_means];
+      int closest_mean = 0;
+      double min_score = std::numeric_limits<double>::max();
+      for(int k=0; k<n_means; ++k)
+      {
+        const double score = mu_norm[k] - 2.*xmi[k];
+        if(score < min_score)
+        {
+          min_score = score;
+          closest_mean = k;
+        }
+      }
+
+      // The distance itself is computed directly, which is more accurate
+      const double* m = mu + closest_mean*n_inputs;
+      double min_distance = 0.;
+      for(int j=0; j<n_inputs; ++j)
+      {
+        const double d = m[j] - xi[j];
+        min_distance += d * d;
+      }
+
+      // accumulate the stats
+      distances += min_distance;
+      ++zeroeth[closest_mean];
+      double* f = first + closest_mean*n_inputs;
+      for(int j=0; j<n_inputs; ++j) f[j] += xi[j];
+    }
+  }
+}
+
+void bob::trainer::KMeansTrainer::accumulate(const blitz::Array<double,2>& ar,
+  const blitz::Array<double,2>& means, const blitz::Array<double,1>& means_norm)
+{
+  // Accumulates the statistics of the samples processed by each thread in
+  // a separate row
+  const int n_means = means.extent(0);
+  const int n_inputs = means.extent(1);
+  const size_t n_threads = bob::core::getNThreads();
+  blitz::Array<double,2> stats(n_threads, n_means*(n_inputs+1)+1);
+  stats = 0.;
+  bob::core::parallelFor(0, ar.extent(0),
+    boost::bind(&bob::trainer::KMeansTrainer::eStepRows, this,
+      boost::cref(ar), boost::cref(means), boost::cref(means_norm),
+      boost::ref(stats), _1, _2, _3),
+    KMEANS_BATCH_SIZE);
+
+  // Sums the statistics of the threads
+  for(size_t t=0; t<n_threads; ++t)
+  {
+    for(int k=0; k<n_means; ++k)
+    {
+      for(int j=0; j<n_inputs; ++j)
+        m_firstOrderStats(k,j) += stats(t,k*n_inputs+j);
+      m_zeroethOrderStats(k) += stats(t,n_means*n_inputs+k);
+    }
+    m_average_min_distance += stats(t,n_means*(n_inputs+1));
+  }
+}
+
 void bob::trainer::KMeansTrainer::eStep(bob::machine::KMeansMachine& kmeans, 
   const blitz::Array<double,2>& ar)
 {
   // initialise the accumulators
   resetAccumulators(kmeans);
 
-  // iterate over data samples
-  blitz::Range a = blitz::Range::all();
-  for(int i=0; i<ar.extent(0); ++i) {
-    // get example
-    blitz::Array<double, 1> x(ar(i,a));
-
-    // find closest mean, and distance from that mean
-    size_t closest_mean = 0;
-    double min_distance = 0;
-    kmeans.getClosestMean(x,closest_mean,min_distance);
-
-    // accumulate the stats
-    m_average_min_distance += min_distance;
-    ++m_zeroethOrderStats(closest_mean);
-    m_firstOrderStats(closest_mean,blitz::Range::all()) += x;
-  }
+  blitz::Array<double,2> means;
+  blitz::Array<double,1> means_norm;
+  contiguousMeans(kmeans, means, means_norm);
+  accumulate(ar, means, means_norm);
   m_average_min_distance /= static_cast<double>(ar.extent(0));
 }
 
+void bob::trainer::KMeansTrainer::eStep(bob::machine::KMeansMachine& kmeans,
+  bob::trainer::DataBlockSampler& sampler)
+{
+  // initialise the accumulators
+  resetAccumulators(kmeans);
+
+  blitz::Array<double,2> means;
+  blitz::Array<double,1> means_norm;
+  contiguousMeans(kmeans, means, means_norm);
+  size_t n_samples = 0;
+  blitz::Array<double,2> block;
+  sampler.reset();
+  while(sampler.next(block))
+  {
+    accumulate(block, means, means_norm);
+    n_samples += block.extent(0);
+  }
+  m_average_min_distance /= static_cast<double>(n_samples);
+}
+
 void bob::trainer::KMeansTrainer::mStep(bob::machine::KMeansMachine& kmeans, 
   const blitz::Array<double,2>&) 
 {
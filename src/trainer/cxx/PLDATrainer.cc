@@ -23,10 +23,12 @@
 #include <bob/trainer/PLDATrainer.h>
 #include <bob/core/array_copy.h>
 #include <bob/core/array_random.h>
+#include <bob/core/parallel.h>
 #include <bob/math/linear.h>
 #include <bob/math/inv.h>
 #include <bob/math/svd.h>
 #include <algorithm>
+#include <boost/bind.hpp>
 #include <boost/random.hpp>
 #include <vector>
 #include <limits>
@@ -43,11 +45,12 @@ bob::trainer::PLDATrainer::PLDATrainer(const size_t max_iterations,
   m_initSigma_ratio(1.),
   m_cache_S(0,0), 
   m_cache_z_first_order(0), m_cache_sum_z_second_order(0,0), m_cache_z_second_order(0),
-  m_cache_n_samples_per_id(0), m_cache_n_samples_in_training(), m_cache_B(0,0),
-  m_cache_Ft_isigma_G(0,0), m_cache_eta(0,0), m_cache_zeta(), m_cache_iota(),
-  m_tmp_nf_1(0), m_tmp_nf_2(0), m_tmp_ng_1(0),
-  m_tmp_D_1(0), m_tmp_D_2(0), 
-  m_tmp_nfng_nfng(0,0), m_tmp_D_nfng_1(0,0), m_tmp_D_nfng_2(0,0)
+  m_cache_n_samples_per_id(0), m_cache_n_samples_in_training(0), 
+  m_cache_n_samples_index_per_id(0), m_cache_B(0,0),
+  m_cache_Ft_isigma_G(0,0), m_cache_eta(0,0), m_cache_gamma(0), 
+  m_cache_zeta(0), m_cache_iota(0),
+  m_tmp_nf_1(0), m_tmp_D_1(0), m_tmp_D_2(0), 
+  m_tmp_nfng_nfng(0,0), m_tmp_D_nfng_1(0,0)
 {
 }
 
@@ -66,12 +69,14 @@ bob::trainer::PLDATrainer::PLDATrainer(const bob::trainer::PLDATrainer& other):
   m_cache_z_second_order(),
   m_cache_n_samples_per_id(other.m_cache_n_samples_per_id),
   m_cache_n_samples_in_training(other.m_cache_n_samples_in_training), 
+  m_cache_n_samples_index_per_id(other.m_cache_n_samples_index_per_id), 
   m_cache_B(bob::core::array::ccopy(other.m_cache_B)), 
   m_cache_Ft_isigma_G(bob::core::array::ccopy(other.m_cache_Ft_isigma_G)), 
   m_cache_eta(bob::core::array::ccopy(other.m_cache_eta)) 
 {
   bob::core::array::ccopy(other.m_cache_z_first_order, m_cache_z_first_order);
   bob::core::array::ccopy(other.m_cache_z_second_order, m_cache_z_second_order);
+  bob::core::array::ccopy(other.m_cache_gamma, m_cache_gamma);
   bob::core::array::ccopy(other.m_cache_zeta, m_cache_zeta);
   bob::core::array::ccopy(other.m_cache_iota, m_cache_iota);
   // Resize working arrays
@@ -103,9 +108,12 @@ bob::trainer::PLDATrainer& bob::trainer::PLDATrainer::operator=
     bob::core::array::ccopy(other.m_cache_z_second_order, m_cache_z_second_order);
     m_cache_n_samples_per_id = other.m_cache_n_samples_per_id;
     m_cache_n_samples_in_training = other.m_cache_n_samples_in_training;
+    m_cache_n_samples_index_per_id = other.m_cache_n_samples_index_per_id;
     m_cache_B = bob::core::array::ccopy(other.m_cache_B); 
     m_cache_Ft_isigma_G = bob::core::array::ccopy(other.m_cache_Ft_isigma_G); 
     m_cache_eta = bob::core::array::ccopy(other.m_cache_eta); 
+    bob::core::array::ccopy(other.m_cache_gamma, m_cache_gamma);
+    bob::core::array::ccopy(other.m_cache_zeta, m_cache_zeta);
     bob::core::array::ccopy(other.m_cache_iota, m_cache_iota);
     // Resize working arrays
     resizeTmp();
@@ -138,6 +146,7 @@ bool bob::trainer::PLDATrainer::operator==
          bob::core::array::isEqual(m_cache_B, other.m_cache_B) &&
          bob::core::array::isEqual(m_cache_Ft_isigma_G, other.m_cache_Ft_isigma_G) &&
          bob::core::array::isEqual(m_cache_eta, other.m_cache_eta) &&
+         bob::core::array::isEqual(m_cache_gamma, other.m_cache_gamma) &&
          bob::core::array::isEqual(m_cache_zeta, other.m_cache_zeta) &&
          bob::core::array::isEqual(m_cache_iota, other.m_cache_iota);
 }
@@ -175,6 +184,7 @@ bool bob::trainer::PLDATrainer::is_similar_to
          bob::core::array::isClose(m_cache_B, other.m_cache_B, r_epsilon, a_epsilon) &&
          bob::core::array::isClose(m_cache_Ft_isigma_G, other.m_cache_Ft_isigma_G, r_epsilon, a_epsilon) &&
          bob::core::array::isClose(m_cache_eta, other.m_cache_eta, r_epsilon, a_epsilon) &&
+         bob::core::array::isClose(m_cache_gamma, other.m_cache_gamma, r_epsilon, a_epsilon) &&
          bob::core::array::isClose(m_cache_zeta, other.m_cache_zeta, r_epsilon, a_epsilon) &&
          bob::core::array::isClose(m_cache_iota, other.m_cache_iota, r_epsilon, a_epsilon);
 }
@@ -241,6 +251,9 @@ void bob::trainer::PLDATrainer::initMembers(const std::vector<blitz::Array<doubl
   m_cache_S.resize(n_features, n_features);
   m_cache_sum_z_second_order.resize(m_dim_f+m_dim_g, m_dim_f+m_dim_g);
 
+  m_cache_z_first_order.clear();
+  m_cache_z_second_order.clear();
+  m_cache_n_samples_per_id.clear();
   // Loops over the identities
   for (size_t i=0; i<n_identities; ++i) 
   {
@@ -258,19 +271,32 @@ void bob::trainer::PLDATrainer::initMembers(const std::vector<blitz::Array<doubl
 
     // m_cache_n_samples_per_id
     m_cache_n_samples_per_id.push_back(n_i);
-    
-    // Maps dependent on the number of samples per identity
-    std::map<size_t,bool>::iterator it;
-    it = m_cache_n_samples_in_training.find(n_i);
-    if (it == m_cache_n_samples_in_training.end())
-    {
-      // Indicates if there are identities with n_i training samples and if
-      // corresponding matrices are up to date.
-      m_cache_n_samples_in_training[n_i] = false;
-      // Allocates arrays for identities with n_i training samples
-      m_cache_zeta[n_i].reference(blitz::Array<double,2>(m_dim_g, m_dim_g));
-      m_cache_iota[n_i].reference(blitz::Array<double,2>(m_dim_f, m_dim_g));
-    }
+  }
+
+  // Distinct numbers of samples per identity, and tables of the matrices
+  // that depend on them
+  m_cache_n_samples_in_training = m_cache_n_samples_per_id;
+  std::sort(m_cache_n_samples_in_training.begin(), 
+    m_cache_n_samples_in_training.end());
+  m_cache_n_samples_in_training.erase(std::unique(
+    m_cache_n_samples_in_training.begin(), 
+    m_cache_n_samples_in_training.end()), 
+    m_cache_n_samples_in_training.end());
+  m_cache_n_samples_index_per_id.resize(n_identities);
+  for (size_t i=0; i<n_identities; ++i)
+    m_cache_n_samples_index_per_id[i] = std::lower_bound(
+      m_cache_n_samples_in_training.begin(), 
+      m_cache_n_samples_in_training.end(), m_cache_n_samples_per_id[i]) - 
+      m_cache_n_samples_in_training.begin();
+  const size_t n_counts = m_cache_n_samples_in_training.size();
+  m_cache_gamma.resize(n_counts);
+  m_cache_zeta.resize(n_counts);
+  m_cache_iota.resize(n_counts);
+  for (size_t k=0; k<n_counts; ++k)
+  {
+    m_cache_gamma[k].resize(m_dim_f, m_dim_f);
+    m_cache_zeta[k].resize(m_dim_g, m_dim_g);
+    m_cache_iota[k].resize(m_dim_f, m_dim_g);
   }
 
   m_cache_B.resize(n_features, m_dim_f+m_dim_g);
@@ -284,13 +310,31 @@ void bob::trainer::PLDATrainer::initMembers(const std::vector<blitz::Array<doubl
 void bob::trainer::PLDATrainer::resizeTmp()
 {
   m_tmp_nf_1.resize(m_dim_f);
-  m_tmp_nf_2.resize(m_dim_f);
-  m_tmp_ng_1.resize(m_dim_g);
   m_tmp_D_1.resize(m_dim_d);
   m_tmp_D_2.resize(m_dim_d);
   m_tmp_nfng_nfng.resize(m_dim_f+m_dim_g, m_dim_f+m_dim_g);
   m_tmp_D_nfng_1.resize(m_dim_d, m_dim_f+m_dim_g);
-  m_tmp_D_nfng_2.resize(m_dim_d, m_dim_f+m_dim_g);
+}
+
+void bob::trainer::PLDATrainer::Workspace::resize(const size_t dim_d,
+  const size_t dim_f, const size_t dim_g)
+{
+  if (tmp_D_1.extent(0) == (int)dim_d && tmp_nf_1.extent(0) == (int)dim_f &&
+      tmp_ng_1.extent(0) == (int)dim_g)
+    return;
+  tmp_nf_1.resize(dim_f);
+  tmp_nf_2.resize(dim_f);
+  tmp_ng_1.resize(dim_g);
+  tmp_D_1.resize(dim_d);
+  tmp_D_2.resize(dim_d);
+  tmp_nf_nf.resize(dim_f, dim_f);
+}
+
+void bob::trainer::PLDATrainer::resizeWorkspaces()
+{
+  m_tmp_ws.resize(bob::core::getNThreads());
+  for (size_t t=0; t<m_tmp_ws.size(); ++t)
+    m_tmp_ws[t].resize(m_dim_d, m_dim_f, m_dim_g);
 }
 
 void bob::trainer::PLDATrainer::computeMeanVariance(bob::machine::PLDABase& machine, 
@@ -512,101 +556,125 @@ void bob::trainer::PLDATrainer::initSigma(bob::machine::PLDABase& machine,
   machine.applyVarianceThreshold();
 }
 
+double bob::trainer::PLDATrainer::zSecondOrder(const size_t k,
+  const blitz::Array<double,2>& z_i, const int j, const int p, 
+  const int q) const
+{
+  // E{z_ij.z_ij^T} = [gamma_a  iota_a ] + E{z_ij}.E{z_ij}^T
+  //                  [iota_a^T zeta_a ]
+  const int nf = m_dim_f;
+  double cov;
+  if (p < nf) cov = (q < nf ? m_cache_gamma[k](p,q) : m_cache_iota[k](p,q-nf));
+  else cov = (q < nf ? m_cache_iota[k](q,p-nf) : m_cache_zeta[k](p-nf,q-nf));
+  return cov + z_i(j,p) * z_i(j,q);
+}
+
 void bob::trainer::PLDATrainer::eStep(bob::machine::PLDABase& machine, 
   const std::vector<blitz::Array<double,2> >& v_ar)
 {  
   // Precomputes useful variables using current estimates of F,G, and sigma
   precomputeFromFGSigma(machine);
-  // Gets the mean mu from the machine
+
+  // Computes the statistics of the identities in parallel
+  resizeWorkspaces();
+  bob::core::parallelFor(0, v_ar.size(),
+    boost::bind(&bob::trainer::PLDATrainer::eStepIdentities, this,
+      boost::cref(machine), boost::cref(v_ar), _1, _2, _3));
+
+  // Sums the second order statistics, each thread updating its own rows in
+  // the order of the samples (such that the result does not depend on the
+  // number of threads)
+  m_cache_sum_z_second_order = 0.;
+  bob::core::parallelFor(0, m_dim_f+m_dim_g,
+    boost::bind(&bob::trainer::PLDATrainer::eStepSumSecondOrder, this,
+      _1, _2, _3));
+}
+
+void bob::trainer::PLDATrainer::eStepIdentities(
+  const bob::machine::PLDABase& machine,
+  const std::vector<blitz::Array<double,2> >& v_ar, size_t begin,
+  size_t end, size_t thread)
+{
+  // The shared arrays are only read, by element or through
+  // bob::math::prod(). The statistics of an identity are written by a
+  // single thread.
+  Workspace& w = m_tmp_ws[thread];
   const blitz::Array<double,1>& mu = machine.getMu();
   const blitz::Array<double,2>& alpha = machine.getAlpha();
   const blitz::Array<double,2>& F = machine.getF();
   const blitz::Array<double,2>& FtBeta = machine.getFtBeta();
   const blitz::Array<double,2>& GtISigma = machine.getGtISigma();
-  blitz::Range a = blitz::Range::all();
+  const int D = m_dim_d;
+  const int nf = m_dim_f;
+  const int nfng = m_dim_f + m_dim_g;
+  blitz::Range r2(m_dim_f, m_dim_f+m_dim_g-1);
 
-  // blitz indices
-  blitz::firstIndex bi;
-  blitz::secondIndex bj;
-  // Initializes sum of z second order statistics to 0
-  m_cache_sum_z_second_order = 0.;
-  for (size_t i=0; i<v_ar.size(); ++i)
+  for (size_t i=begin; i<end; ++i)
   {
+    const blitz::Array<double,2>& x_i = v_ar[i];
+    blitz::Array<double,2>& z_i = m_cache_z_first_order[i];
+
     // Computes expectation of z_ij = [h_i w_ij]
     // 1/a/ Computes expectation of h_i
     // Loop over the samples
-    m_tmp_nf_1 = 0.;
-    for (int j=0; j<v_ar[i].extent(0); ++j)
+    w.tmp_nf_1 = 0.;
+    for (int j=0; j<x_i.extent(0); ++j)
     {
-      // m_tmp_D_1 = x_sj-mu
-      m_tmp_D_1 = v_ar[i](j,a) - mu;
-
-      // m_tmp_nf_2 = F^T.beta.(x_sj-mu)
-      bob::math::prod(FtBeta, m_tmp_D_1, m_tmp_nf_2);
-      // m_tmp_nf_1 = sum_j F^T.beta.(x_sj-mu)
-      m_tmp_nf_1 += m_tmp_nf_2;
+      // tmp_D_1 = x_sj-mu
+      for (int d=0; d<D; ++d) w.tmp_D_1(d) = x_i(j,d) - mu(d);
+      // tmp_nf_2 = F^T.beta.(x_sj-mu)
+      bob::math::prod(FtBeta, w.tmp_D_1, w.tmp_nf_2);
+      // tmp_nf_1 = sum_j F^T.beta.(x_sj-mu)
+      w.tmp_nf_1 += w.tmp_nf_2;
     }
-    const blitz::Array<double,2>& gamma_a = machine.getAddGamma(v_ar[i].extent(0));
-    blitz::Range r_hi(0, m_dim_f-1);
-    // m_tmp_nf_2 = E(h_i) = gamma_A  sum_j F^T.beta.(x_sj-mu)
-    bob::math::prod(gamma_a, m_tmp_nf_1, m_tmp_nf_2);
+    // tmp_nf_2 = E(h_i) = gamma_A  sum_j F^T.beta.(x_sj-mu)
+    const size_t k = m_cache_n_samples_index_per_id[i];
+    bob::math::prod(m_cache_gamma[k], w.tmp_nf_1, w.tmp_nf_2);
 
-    // 1/b/ Precomputes: m_tmp_D_2 = F.E{h_i}
-    bob::math::prod(F, m_tmp_nf_2, m_tmp_D_2);
+    // 1/b/ Precomputes: tmp_D_2 = F.E{h_i}
+    bob::math::prod(F, w.tmp_nf_2, w.tmp_D_2);
 
     // 2/ First and second order statistics of z
-    // Precomputed values 
-    blitz::Array<double,2>& zeta_a = m_cache_zeta[v_ar[i].extent(0)];
-    blitz::Array<double,2>& iota_a = m_cache_iota[v_ar[i].extent(0)];
-    blitz::Array<double,2> iotat_a = iota_a.transpose(1,0);
-
     // Extracts statistics of z_ij = [h_i w_ij] from y_i = [h_i w_i1 ... w_iJ]
-    blitz::Range r1(0, m_dim_f-1);
-    blitz::Range r2(m_dim_f, m_dim_f+m_dim_g-1);
-    for (int j=0; j<v_ar[i].extent(0); ++j)
+    for (int j=0; j<x_i.extent(0); ++j)
     {
       // 1/ First order statistics of z
-      blitz::Array<double,1> z_first_order_ij_1 = m_cache_z_first_order[i](j,r1);
-      z_first_order_ij_1 = m_tmp_nf_2; // E{h_i}
-      // m_tmp_D_1 = x_sj - mu - F.E{h_i}
-      m_tmp_D_1 = v_ar[i](j,a) - mu - m_tmp_D_2;
-      // m_tmp_ng_1 = G^T.sigma^-1.(x_sj-mu-fhi)
-      bob::math::prod(GtISigma, m_tmp_D_1, m_tmp_ng_1);
+      for (int f=0; f<nf; ++f) z_i(j,f) = w.tmp_nf_2(f); // E{h_i}
+      // tmp_D_1 = x_sj - mu - F.E{h_i}
+      for (int d=0; d<D; ++d) w.tmp_D_1(d) = x_i(j,d) - mu(d) - w.tmp_D_2(d);
+      // tmp_ng_1 = G^T.sigma^-1.(x_sj-mu-fhi)
+      bob::math::prod(GtISigma, w.tmp_D_1, w.tmp_ng_1);
       // z_first_order_ij_2 = (Id+G^T.sigma^-1.G)^-1.G^T.sigma^-1.(x_sj-mu) = E{w_ij}
-      blitz::Array<double,1> z_first_order_ij_2 = m_cache_z_first_order[i](j,r2);
-      bob::math::prod(alpha, m_tmp_ng_1, z_first_order_ij_2); 
+      blitz::Array<double,1> z_first_order_ij_2 = z_i(j,r2);
+      bob::math::prod(alpha, w.tmp_ng_1, z_first_order_ij_2); 
 
       // 2/ Second order statistics of z
-      blitz::Array<double,2> z_sum_so_11 = m_cache_sum_z_second_order(r1,r1);
-      blitz::Array<double,2> z_sum_so_12 = m_cache_sum_z_second_order(r1,r2);
-      blitz::Array<double,2> z_sum_so_21 = m_cache_sum_z_second_order(r2,r1);
-      blitz::Array<double,2> z_sum_so_22 = m_cache_sum_z_second_order(r2,r2);
-      if (m_use_sum_second_order)
-      {
-        z_sum_so_11 += gamma_a + z_first_order_ij_1(bi) * z_first_order_ij_1(bj);
-        z_sum_so_12 += iota_a + z_first_order_ij_1(bi) * z_first_order_ij_2(bj);
-        z_sum_so_21 += iotat_a + z_first_order_ij_2(bi) * z_first_order_ij_1(bj);
-        z_sum_so_22 += zeta_a + z_first_order_ij_2(bi) * z_first_order_ij_2(bj);
-      }
-      else
+      if (!m_use_sum_second_order)
       {
-        blitz::Array<double,2> z_so_11 = m_cache_z_second_order[i](j,r1,r1);
-        z_so_11 = gamma_a + z_first_order_ij_1(bi) * z_first_order_ij_1(bj);
-        z_sum_so_11 += z_so_11;
-        blitz::Array<double,2> z_so_12 = m_cache_z_second_order[i](j,r1,r2);
-        z_so_12 = iota_a + z_first_order_ij_1(bi) * z_first_order_ij_2(bj);
-        z_sum_so_12 += z_so_12;
-        blitz::Array<double,2> z_so_21 = m_cache_z_second_order[i](j,r2,r1);
-        z_so_21 = iotat_a + z_first_order_ij_2(bi) * z_first_order_ij_1(bj);
-        z_sum_so_21 += z_so_21;
-        blitz::Array<double,2> z_so_22 = m_cache_z_second_order[i](j,r2,r2);
-        z_so_22 = zeta_a + z_first_order_ij_2(bi) * z_first_order_ij_2(bj);
-        z_sum_so_22 += z_so_22;
+        blitz::Array<double,3>& z2_i = m_cache_z_second_order[i];
+        for (int p=0; p<nfng; ++p)
+          for (int q=0; q<nfng; ++q)
+            z2_i(j,p,q) = zSecondOrder(k, z_i, j, p, q);
       }
     }
   }
 }
 
+void bob::trainer::PLDATrainer::eStepSumSecondOrder(size_t begin, size_t end,
+  size_t thread)
+{
+  const int nfng = m_dim_f + m_dim_g;
+  for (size_t i=0; i<m_cache_z_first_order.size(); ++i)
+  {
+    const blitz::Array<double,2>& z_i = m_cache_z_first_order[i];
+    const size_t k = m_cache_n_samples_index_per_id[i];
+    for (int j=0; j<z_i.extent(0); ++j)
+      for (size_t p=begin; p<end; ++p)
+        for (int q=0; q<nfng; ++q)
+          m_cache_sum_z_second_order(p,q) += zSecondOrder(k, z_i, j, p, q);
+  }
+}
+
 void bob::trainer::PLDATrainer::precomputeFromFGSigma(bob::machine::PLDABase& machine)
 {
   // Blitz compatibility: ugly fix (const_cast, as old blitz version does not  
@@ -622,30 +690,32 @@ void bob::trainer::PLDATrainer::precomputeFromFGSigma(bob::machine::PLDABase& ma
   bob::math::prod(m_cache_Ft_isigma_G, alpha, m_cache_eta); 
   blitz::Array<double,2> etat = m_cache_eta.transpose(1,0);
 
-  // Reinitializes all the zeta_a and iota_a
-  std::map<size_t,bool>::iterator it;
-  for (it=m_cache_n_samples_in_training.begin(); it!=m_cache_n_samples_in_training.end(); 
-      ++it)
-    it->second = false;
+  // Precomputes gamma, zeta and iota for all the numbers of samples per
+  // identity of the training set, in parallel
+  resizeWorkspaces();
+  bob::core::parallelFor(0, m_cache_n_samples_in_training.size(),
+    boost::bind(&bob::trainer::PLDATrainer::precomputeZetaIota, this,
+      boost::cref(machine), boost::cref(etat), _1, _2, _3), 1);
+}
 
-  for (it=m_cache_n_samples_in_training.begin(); it!=m_cache_n_samples_in_training.end(); 
-      ++it)
+void bob::trainer::PLDATrainer::precomputeZetaIota(
+  const bob::machine::PLDABase& machine, const blitz::Array<double,2>& etat,
+  size_t begin, size_t end, size_t thread)
+{
+  Workspace& w = m_tmp_ws[thread];
+  const blitz::Array<double,2>& alpha = machine.getAlpha();
+  for (size_t k=begin; k<end; ++k)
   {
-    size_t n_i = it->first;
-    // Precomputes zeta and iota for identities with q_i training samples,
-    // if not already done
-    if (!it->second)
-    {
-      const blitz::Array<double,2>& gamma_a = machine.getAddGamma(n_i);
-      blitz::Array<double,2>& zeta_a = m_cache_zeta[n_i];
-      blitz::Array<double,2>& iota_a = m_cache_iota[n_i];
-      bob::math::prod(gamma_a, m_cache_eta, iota_a);
-      bob::math::prod(etat, iota_a, zeta_a);
-      zeta_a += alpha;
-      iota_a = - iota_a;
-      // Now up to date
-      it->second = true;
-    }
+    blitz::Array<double,2>& gamma_a = m_cache_gamma[k];
+    blitz::Array<double,2>& zeta_a = m_cache_zeta[k];
+    blitz::Array<double,2>& iota_a = m_cache_iota[k];
+    machine.computeGamma(m_cache_n_samples_in_training[k], gamma_a, w.tmp_nf_nf);
+    bob::math::prod(gamma_a, m_cache_eta, iota_a);
+    bob::math::prod(etat, iota_a, zeta_a);
+    for (int p=0; p<zeta_a.extent(0); ++p)
+      for (int q=0; q<zeta_a.extent(1); ++q)
+        zeta_a(p,q) += alpha(p,q);
+    iota_a = - iota_a;
   }
 }
 
@@ -655,15 +725,9 @@ void bob::trainer::PLDATrainer::precomputeLogLike(bob::machine::PLDABase& machin
   // Precomputes the log determinant of alpha and sigma
   machine.precomputeLogLike();
 
-  // Precomputes the log likelihood constant term
-  std::map<size_t,bool>::iterator it;
-  for (it=m_cache_n_samples_in_training.begin(); 
-       it!=m_cache_n_samples_in_training.end(); ++it)
-  {
-    // Precomputes the log likelihood constant term for identities with q_i 
-    // training samples, if not already done
-    machine.getAddLogLikeConstTerm(it->first);
-  }
+  // Precomputes the log likelihood constant term (and gamma_a) for all the
+  // numbers of samples per identity of the training set, in parallel
+  machine.precomputeGammaLogLike(m_cache_n_samples_in_training);
 }
 
 
@@ -692,27 +756,17 @@ void bob::trainer::PLDATrainer::updateFG(bob::machine::PLDABase& machine,
   // Gets the mean mu from the machine
   const blitz::Array<double,1>& mu = machine.getMu();
   blitz::Range a = blitz::Range::all();
-  m_tmp_D_nfng_2 = 0.;
-  for (size_t i=0; i<v_ar.size(); ++i)
-  {
-    // Loop over the samples
-    for (int j=0; j<v_ar[i].extent(0); ++j)
-    {
-      // m_tmp_D_1 = x_sj-mu
-      m_tmp_D_1 = v_ar[i](j,a) - mu;
-      // z_first_order_ij = E{z_ij}
-      blitz::Array<double,1> z_first_order_ij = m_cache_z_first_order[i](j, a);
-      // m_tmp_D_nfng_1 = (x_sj-mu).E{z_ij}^T
-      bob::math::prod(m_tmp_D_1, z_first_order_ij, m_tmp_D_nfng_1);
-      m_tmp_D_nfng_2 += m_tmp_D_nfng_1;
-    }
-  }
+  // Each thread updates its own rows, in the order of the samples
+  m_tmp_D_nfng_1 = 0.;
+  bob::core::parallelFor(0, m_dim_d,
+    boost::bind(&bob::trainer::PLDATrainer::updateFGRows, this,
+      boost::cref(mu), boost::cref(v_ar), _1, _2, _3));
 
   // 2/ Computes the denominator inv(sum_ij E{z_i.z_i^T})
   bob::math::inv(m_cache_sum_z_second_order, m_tmp_nfng_nfng);
 
   // 3/ Computes numerator / denominator
-  bob::math::prod(m_tmp_D_nfng_2, m_tmp_nfng_nfng, m_cache_B);
+  bob::math::prod(m_tmp_D_nfng_1, m_tmp_nfng_nfng, m_cache_B);
 
   // 4/ Updates the machine 
   blitz::Array<double, 2>& F = machine.updateF();
@@ -721,6 +775,29 @@ void bob::trainer::PLDATrainer::updateFG(bob::machine::PLDABase& machine,
   G = m_cache_B(a, blitz::Range(m_dim_f, m_dim_f+m_dim_g-1));
 }
 
+void bob::trainer::PLDATrainer::updateFGRows(
+  const blitz::Array<double,1>& mu,
+  const std::vector<blitz::Array<double,2> >& v_ar, size_t begin,
+  size_t end, size_t thread)
+{
+  const int nfng = m_dim_f + m_dim_g;
+  for (size_t i=0; i<v_ar.size(); ++i)
+  {
+    const blitz::Array<double,2>& x_i = v_ar[i];
+    const blitz::Array<double,2>& z_i = m_cache_z_first_order[i];
+    for (int j=0; j<x_i.extent(0); ++j)
+    {
+      // m_tmp_D_nfng_1 += (x_ij-mu).E{z_ij}^T
+      for (size_t d=begin; d<end; ++d)
+      {
+        const double x_d = x_i(j,d) - mu(d);
+        for (int q=0; q<nfng; ++q)
+          m_tmp_D_nfng_1(d,q) += x_d * z_i(j,q);
+      }
+    }
+  }
+}
+
 void bob::trainer::PLDATrainer::updateSigma(bob::machine::PLDABase& machine,
   const std::vector<blitz::Array<double,2> >& v_ar)
 {
@@ -730,35 +807,49 @@ void bob::trainer::PLDATrainer::updateSigma(bob::machine::PLDABase& machine,
   // Gets the mean mu and the matrix sigma from the machine
   blitz::Array<double,1>& sigma = machine.updateSigma();
   const blitz::Array<double,1>& mu = machine.getMu();
-  blitz::Range a = blitz::Range::all();
 
   sigma = 0.;
+  // Each thread updates its own dimensions, in the order of the samples
+  bob::core::parallelFor(0, m_dim_d,
+    boost::bind(&bob::trainer::PLDATrainer::updateSigmaRows, this,
+      boost::cref(mu), boost::cref(v_ar), boost::ref(sigma), _1, _2, _3));
   size_t n_IJ=0; /// counts the number of samples
   for (size_t i=0; i<v_ar.size(); ++i)
-  {
-    // Loop over the samples
-    for (int j=0; j<v_ar[i].extent(0); ++j)
-    {
-      // m_tmp_D_1 = x_ij-mu
-      m_tmp_D_1 = v_ar[i](j,a) - mu;
-      // sigma += Diag{(x_ij-mu).(x_ij-mu)^T}
-      sigma += blitz::pow2(m_tmp_D_1);
-
-      // z_first_order_ij = E{z_ij}
-      blitz::Array<double,1> z_first_order_ij = m_cache_z_first_order[i](j,a);
-      // m_tmp_D_2 = B.E{z_ij}
-      bob::math::prod(m_cache_B, z_first_order_ij, m_tmp_D_2);
-      // sigma -= Diag{B.E{z_ij}.(x_ij-mu)
-      sigma -= (m_tmp_D_1 * m_tmp_D_2);
-      ++n_IJ;
-    }
-  }
+    n_IJ += v_ar[i].extent(0);
   // Normalizes by the number of samples
   sigma /= static_cast<double>(n_IJ);
   // Apply variance threshold
   machine.applyVarianceThreshold();
 }
 
+void bob::trainer::PLDATrainer::updateSigmaRows(
+  const blitz::Array<double,1>& mu,
+  const std::vector<blitz::Array<double,2> >& v_ar,
+  blitz::Array<double,1>& sigma, size_t begin, size_t end, size_t thread)
+{
+  const int nfng = m_dim_f + m_dim_g;
+  for (size_t i=0; i<v_ar.size(); ++i)
+  {
+    const blitz::Array<double,2>& x_i = v_ar[i];
+    const blitz::Array<double,2>& z_i = m_cache_z_first_order[i];
+    for (int j=0; j<x_i.extent(0); ++j)
+    {
+      for (size_t d=begin; d<end; ++d)
+      {
+        // x_d = x_ij-mu
+        const double x_d = x_i(j,d) - mu(d);
+        // Bz_d = B.E{z_ij}
+        double Bz_d = 0.;
+        for (int q=0; q<nfng; ++q)
+          Bz_d += m_cache_B(d,q) * z_i(j,q);
+        // sigma += Diag{(x_ij-mu).(x_ij-mu)^T - B.E{z_ij}.(x_ij-mu)^T}
+        sigma(d) += x_d * x_d;
+        sigma(d) -= x_d * Bz_d;
+      }
+    }
+  }
+}
+
 double bob::trainer::PLDATrainer::computeLikelihood(bob::machine::PLDABase& machine)
 {
   double llh = 0.;
@@ -23,8 +23,14 @@
 #include <boost/format.hpp>
 #include <boost/make_shared.hpp>
 #include <boost/algorithm/string.hpp>
+#include <boost/bind.hpp>
+#include <boost/thread/mutex.hpp>
 #include <bob/trainer/SVMTrainer.h>
+#include <bob/core/array_copy.h>
 #include <bob/core/logging.h>
+#include <bob/core/parallel.h>
+#include <algorithm>
+#include <cmath>
 
 #ifdef BOB_DEBUG
 //remove newline
@@ -39,6 +45,19 @@ static void debug_libsvm(const char* s) {
   TDEBUG1("[libsvm-" << libsvm_version << "] " << strip(s));
 }
 
+/**
+ * Redirects the libsvm messages to the debug stream
+ */
+static void set_print_function() {
+#if LIBSVM_VERSION >= 291
+  svm_set_print_string_function(debug_libsvm);
+#else
+  boost::format m("libsvm-%d does not support debugging stream setting");
+  m % libsvm_version;
+  debug_libsvm(m.str().c_str());
+#endif
+}
+
 bob::trainer::SVMTrainer::SVMTrainer(
     bob::machine::SupportVector::svm_t svm_type,
     bob::machine::SupportVector::kernel_t kernel_type,
@@ -75,59 +94,37 @@ bob::trainer::SVMTrainer::SVMTrainer(
 
 bob::trainer::SVMTrainer::~SVMTrainer() { }
 
-/**
- * Erases an SVM problem:
- *
- * struct svm_problem {
- *   int l; //number of entries
- *   double* y; //labels
- *   svm_node** x; //each set terminated with a -1 index entry
- * };
- *
- * At svm-train the nodes for each entry are allocated globally, what is
- * probably more efficient from the allocation perspective. It still requires
- * libsvm to scan the data twice to understand how many nodes need to be
- * allocated globally.
- */
-static void delete_problem(svm_problem* p) {
-  delete[] p->y; //all labels
-  delete[] p->x[0]; //all entries
-  delete[] p->x; //entry pointers
-  delete p;
+bob::trainer::SVMProblem::SVMProblem
+(const std::vector<blitz::Array<double,2> >& data)
+{
+  if (data.size()) {
+    m_input_sub.resize(data[0].extent(blitz::secondDim));
+    m_input_sub = 0.;
+    m_input_div.resize(data[0].extent(blitz::secondDim));
+    m_input_div = 1.;
+  }
+  convert(data);
 }
 
-/**
- * Allocates an svm_problem matrix
- */
-static svm_problem* new_problem(size_t entries) {
-  svm_problem* retval = new svm_problem;
-  retval->l = (int)entries;
-  retval->y = new double[entries];
-  typedef svm_node* svm_node_ptr;
-  retval->x = new svm_node_ptr[entries];
-  for (size_t k=0; k<entries; ++k) retval->x[k] = 0;
-  return retval;
+bob::trainer::SVMProblem::SVMProblem
+(const std::vector<blitz::Array<double,2> >& data,
+ const blitz::Array<double,1>& input_subtract,
+ const blitz::Array<double,1>& input_division):
+  m_input_sub(bob::core::array::ccopy(input_subtract)),
+  m_input_div(bob::core::array::ccopy(input_division))
+{
+  convert(data);
 }
 
+bob::trainer::SVMProblem::~SVMProblem() { }
+
 /**
- * Converts the input arrayset data into an svm_problem matrix, used by libsvm
- * training routines. Updates "gamma" at the svm_parameter's.
+ * Converts the input arrayset data into the libsvm format. All nodes are
+ * allocated in a single vector, a la svm-train, and each sample is
+ * terminated by a node with index -1.
  */
-static boost::shared_ptr<svm_problem> data2problem
-(const std::vector<blitz::Array<double, 2> >& data,
- const blitz::Array<double,1>& sub, const blitz::Array<double,1>& div,
- svm_parameter& param) {
-
-  //counts the number of samples required
-  size_t entries = 0;
-  for (size_t k=0; k<data.size(); ++k)
-    entries += data[k].extent(blitz::firstDim);
-
-  //allocates the container that will represent the problem; at this stage, we
-  //allocate entries for each vector, but not the space in which feature will
-  //be put at. This will come next.
-  boost::shared_ptr<svm_problem> problem(new_problem(entries),
-      std::ptr_fun(delete_problem));
+void bob::trainer::SVMProblem::convert
+(const std::vector<blitz::Array<double,2> >& data) {
 
   //choose labels.
   if ((data.size() <= 1) | (data.size() > 16)) {
@@ -136,79 +133,74 @@ static boost::shared_ptr<svm_problem> data2problem
     throw std::runtime_error(m.str());
   }
 
-  std::vector<double> labels;
-  labels.reserve(data.size());
+  //sanity check of input arraysets
+  const int n_features = data[0].extent(blitz::secondDim);
+  for (size_t cl=0; cl<data.size(); ++cl) {
+    if (data[cl].extent(blitz::secondDim) != n_features) {
+      boost::format m("number of features (columns) of array for class %u (%d) does not match that of array for class 0 (%d)");
+      m % cl % data[cl].extent(blitz::secondDim) % n_features;
+      throw std::runtime_error(m.str());
+    }
+  }
+  if (m_input_sub.extent(0) != n_features ||
+      m_input_div.extent(0) != n_features) {
+    boost::format m("scaling parameters have %d and %d components, whereas the data has %d features");
+    m % m_input_sub.extent(0) % m_input_div.extent(0) % n_features;
+    throw std::runtime_error(m.str());
+  }
+
+  m_labels.clear();
   if (data.size() == 2) {
     //keep libsvm ordering
-    labels.push_back(+1.);
-    labels.push_back(-1.);
+    m_labels.push_back(+1.);
+    m_labels.push_back(-1.);
   }
   else { //data.size() == 3, 4, ..., 16
-    for (size_t k=0; k<data.size(); ++k) labels.push_back(k+1);
+    for (size_t k=0; k<data.size(); ++k) m_labels.push_back(k+1);
   }
 
-  //just count how many nodes we need; unfortunately we have no other choice
-  //than doing a 2-pass instantiation here as libsvm has a very weird way to
-  //optimize data access in which it requires all nodes to be allocated in a
-  //single shot.
-  size_t nodes = 0; //total number of nodes to be allocated
-  blitz::Range all=blitz::Range::all();
-  int n_features = data[0].extent(blitz::secondDim);
-  blitz::Array<double,1> d(n_features); //for temporary feature manipulation
-
+  size_t entries = 0;
+  m_start.assign(1, 0);
   for (size_t k=0; k<data.size(); ++k) {
-    for (int i=0; i<data[k].extent(blitz::firstDim); ++i) {
-      d = (data[k](i,all)-sub)/div; //eval and copy in 1 instruction
-      for (int p=0; p<d.extent(blitz::firstDim); ++p) {
-        if (d(p)) {
-          ++nodes;
-        }
-      }
-      ++nodes; //one extra for the termination node "index == -1"
-    }
+    entries += data[k].extent(blitz::firstDim);
+    m_start.push_back(entries);
   }
 
-  //allocates all the nodes, set first entry, a la libsvm
-  svm_node* all_nodes = new svm_node[nodes];
-
-  //iterates over each class data and fills the svm_node's
-  int max_index = 0; //data width
+  //fills in the nodes, and remembers where each sample starts, as the
+  //vector may be reallocated in between
+  std::vector<size_t> offset(entries);
+  m_nodes.clear();
+  m_y.resize(entries);
+  m_max_index = 0;
   size_t sample = 0; //sample counter
-  size_t node = 0; //node counter
-
   for (size_t k=0; k<data.size(); ++k) {
-    for (int i=0; i<data[k].extent(blitz::firstDim); ++i) {
-      problem->x[sample] = &all_nodes[node]; //setup current sample base pointer
-      d = (data[k](i,all)-sub)/div; //eval and copy in 1 instruction
-      for (blitz::sizeType p=0; p<d.size(); ++p) {
-        if (d(p)) {
-          int index = p+1; //starts indexing at 1
-          all_nodes[node].index = index;
-          all_nodes[node].value = d(p);
-          if ( index > max_index ) max_index = index;
-          ++node; //index within the current sample
+    for (int i=0; i<data[k].extent(blitz::firstDim); ++i, ++sample) {
+      offset[sample] = m_nodes.size();
+      for (int p=0; p<n_features; ++p) {
+        const double value = (data[k](i,p) - m_input_sub(p)) / m_input_div(p);
+        if (value) {
+          svm_node node;
+          node.index = p+1; //starts indexing at 1
+          node.value = value;
+          m_nodes.push_back(node);
+          if (node.index > m_max_index) m_max_index = node.index;
         }
       }
       //marks end of sequence
-      all_nodes[node].index = -1;
-      all_nodes[node].value = 0;
-      problem->y[sample] = labels[k];
-      ++node;
-      ++sample;
+      svm_node end;
+      end.index = -1;
+      end.value = 0;
+      m_nodes.push_back(end);
+      m_y[sample] = m_labels[k];
     }
   }
 
-  //extracted from svm-train.c
-  if (param.gamma == 0. && max_index > 0) {
-    param.gamma = 1.0/max_index;
-  }
-
-  //do not support pre-computed kernels...
-  if (param.kernel_type == PRECOMPUTED) {
-    throw std::runtime_error("We currently dod not support PRECOMPUTED kernels in these bindings to libsvm");
-  }
+  m_x.resize(entries);
+  for (size_t i=0; i<entries; ++i) m_x[i] = &m_nodes[offset[i]];
 
-  return problem;
+  m_problem.l = (int)entries;
+  m_problem.y = &m_y[0];
+  m_problem.x = &m_x[0];
 }
 
 /**
@@ -222,73 +214,255 @@ static void svm_model_free(svm_model*& m) {
 #endif
 }
 
-boost::shared_ptr<bob::machine::SupportVector> bob::trainer::SVMTrainer::train
-(const std::vector<blitz::Array<double, 2> >& data,
- const blitz::Array<double,1>& input_subtraction,
- const blitz::Array<double,1>& input_division) const {
+/**
+ * A multi-class model assembled from the models of its one-versus-one
+ * sub-problems, along with the memory it points to. The support vectors
+ * point to the nodes of the problem.
+ */
+struct multiclass_model {
+  svm_model model;
+  std::vector<svm_node*> sv;
+  std::vector<std::vector<double> > coef;
+  std::vector<double*> coef_ptr;
+  std::vector<double> rho;
+  std::vector<int> label;
+  std::vector<int> n_sv;
+};
 
-  //sanity check of input arraysets
-  int n_features = data[0].extent(blitz::secondDim);
+/**
+ * Serializes the pickling of the models, which goes through temporary files
+ */
+static boost::mutex s_pickle_mutex;
 
-  for (size_t cl=0; cl<data.size(); ++cl) {
-    if (data[cl].extent(blitz::secondDim) != n_features) {
-      boost::format m("number of features (columns) of array for class %u (%d) does not match that of array for class 0 (%d)");
-      m % cl % data[cl].extent(blitz::secondDim) % n_features;
-      throw std::runtime_error(m.str());
+/**
+ * Builds a machine from a trained model. The model is saved and reloaded to
+ * get rid of memory dependencies due to the poorly implemented memory model
+ * in libsvm.
+ */
+static boost::shared_ptr<bob::machine::SupportVector> make_machine
+(const boost::shared_ptr<svm_model> model,
+ const bob::trainer::SVMProblem& problem) {
+  boost::shared_ptr<svm_model> new_model;
+  {
+    boost::mutex::scoped_lock lock(s_pickle_mutex);
+    new_model = bob::machine::svm_unpickle(bob::machine::svm_pickle(model));
+  }
+
+  boost::shared_ptr<bob::machine::SupportVector> retval =
+    boost::make_shared<bob::machine::SupportVector>(new_model);
+
+  //sets up the scaling parameters of the problem
+  retval->setInputSubtraction(problem.getInputSubtraction());
+  retval->setInputDivision(problem.getInputDivision());
+
+  return retval;
+}
+
+void bob::trainer::SVMTrainer::trainPairs(const SVMProblem& problem,
+  const svm_parameter& param, const std::vector<std::pair<int,int> >& pairs,
+  std::vector<boost::shared_ptr<svm_model> >& models, size_t begin,
+  size_t end, size_t thread_idx) const {
+  svm_node** x = problem.get()->x;
+  for (size_t p=begin; p<end; ++p) {
+    //samples of the first class are positive, as in libsvm's svm_train()
+    const int i = pairs[p].first;
+    const int j = pairs[p].second;
+    std::vector<svm_node*> sub_x;
+    std::vector<double> sub_y;
+    for (size_t k=problem.classStart(i); k<problem.classStart(i+1); ++k) {
+      sub_x.push_back(x[k]);
+      sub_y.push_back(+1.);
+    }
+    for (size_t k=problem.classStart(j); k<problem.classStart(j+1); ++k) {
+      sub_x.push_back(x[k]);
+      sub_y.push_back(-1.);
     }
+    svm_problem sub_prob;
+    sub_prob.l = (int)sub_x.size();
+    sub_prob.x = &sub_x[0];
+    sub_prob.y = &sub_y[0];
+    models[p].reset(svm_train(&sub_prob, &param),
+        std::ptr_fun(svm_model_free));
   }
+}
 
-  //converts the input arraysets into something libsvm can digest
-  double save_gamma = m_param.gamma; ///< the next method may update it!
-  boost::shared_ptr<svm_problem> problem =
-    data2problem(data, input_subtraction, input_division,
-        const_cast<svm_parameter&>(m_param) ///< temporary cast
-        );
+boost::shared_ptr<svm_model> bob::trainer::SVMTrainer::trainModel
+(const SVMProblem& problem, svm_parameter param, const bool parallel) const {
 
   //checks parametrization to make sure all is alright.
-  const char* error_msg = svm_check_parameter(problem.get(), &m_param);
-
+  const char* error_msg = svm_check_parameter(problem.get(), &param);
   if (error_msg) {
-    const_cast<double&>(m_param.gamma) = save_gamma;
     boost::format m("libsvm-%d reports: %s");
     m % libsvm_version % error_msg;
-    std::runtime_error(m.str());
+    throw std::runtime_error(m.str());
+  }
+
+  //libsvm trains the models of probability estimates with its random
+  //number generator, which has to be called in a fixed order
+  const int nr_class = problem.numberOfClasses();
+  if (!parallel || nr_class <= 2 || param.probability ||
+      (param.svm_type != C_SVC && param.svm_type != NU_SVC)) {
+    return boost::shared_ptr<svm_model>(svm_train(problem.get(), &param),
+        std::ptr_fun(svm_model_free));
+  }
+
+  //trains the one-versus-one sub-problems in parallel, with the same
+  //sub-problems as libsvm's svm_train()
+  std::vector<std::pair<int,int> > pairs;
+  for (int i=0; i<nr_class; ++i)
+    for (int j=i+1; j<nr_class; ++j) pairs.push_back(std::make_pair(i,j));
+  const size_t n_concurrent = std::min(pairs.size(), bob::core::getNThreads());
+  svm_parameter pair_param = param;
+  pair_param.cache_size = param.cache_size / n_concurrent;
+  std::vector<boost::shared_ptr<svm_model> > models(pairs.size());
+  bob::core::parallelFor(0, pairs.size(),
+    boost::bind(&bob::trainer::SVMTrainer::trainPairs, this,
+      boost::cref(problem), boost::cref(pair_param), boost::cref(pairs),
+      boost::ref(models), _1, _2, _3), 1);
+
+  //coefficients of each sample in each sub-problem (0 if the sample is not
+  //a support vector of the sub-problem)
+  const svm_problem* prob = problem.get();
+  std::vector<std::vector<double> > alpha(pairs.size());
+  std::vector<bool> nonzero(prob->l, false);
+  for (size_t p=0; p<pairs.size(); ++p) {
+    const svm_model* m = models[p].get();
+    const size_t si = problem.classStart(pairs[p].first);
+    const size_t ci = problem.classStart(pairs[p].first+1) - si;
+    const size_t sj = problem.classStart(pairs[p].second);
+    const size_t cj = problem.classStart(pairs[p].second+1) - sj;
+    alpha[p].assign(ci+cj, 0.);
+    int q = 0; //the support vectors are in the order of the sub-problem
+    for (size_t k=0; k<ci+cj; ++k) {
+      const size_t sample = (k < ci) ? si+k : sj+k-ci;
+      if (q < m->l && m->SV[q] == prob->x[sample]) {
+        alpha[p][k] = m->sv_coef[0][q++];
+        if (std::fabs(alpha[p][k]) > 0) nonzero[sample] = true;
+      }
+    }
+  }
+
+  //assembles the model as libsvm's svm_train() does
+  boost::shared_ptr<multiclass_model> mc = boost::make_shared<multiclass_model>();
+  std::vector<int> nz_start(nr_class+1, 0);
+  for (int i=0; i<nr_class; ++i) {
+    int count = 0;
+    for (size_t k=problem.classStart(i); k<problem.classStart(i+1); ++k) {
+      if (nonzero[k]) {
+        mc->sv.push_back(prob->x[k]);
+        ++count;
+      }
+    }
+    mc->label.push_back((int)problem.classLabel(i));
+    mc->n_sv.push_back(count);
+    nz_start[i+1] = nz_start[i] + count;
+  }
+  const int total_sv = mc->sv.size();
+  mc->coef.assign(nr_class-1, std::vector<double>(total_sv, 0.));
+  for (size_t p=0; p<pairs.size(); ++p) {
+    const int i = pairs[p].first;
+    const int j = pairs[p].second;
+    const size_t si = problem.classStart(i);
+    const size_t ci = problem.classStart(i+1) - si;
+    const size_t sj = problem.classStart(j);
+    const size_t cj = problem.classStart(j+1) - sj;
+    int q = nz_start[i];
+    for (size_t k=0; k<ci; ++k)
+      if (nonzero[si+k]) mc->coef[j-1][q++] = alpha[p][k];
+    q = nz_start[j];
+    for (size_t k=0; k<cj; ++k)
+      if (nonzero[sj+k]) mc->coef[i][q++] = alpha[p][ci+k];
+    mc->rho.push_back(models[p]->rho[0]);
+  }
+  for (int i=0; i<nr_class-1; ++i) mc->coef_ptr.push_back(&mc->coef[i][0]);
+
+  mc->model = svm_model();
+  mc->model.param = param;
+  mc->model.nr_class = nr_class;
+  mc->model.l = total_sv;
+  mc->model.SV = total_sv ? &mc->sv[0] : 0;
+  mc->model.sv_coef = &mc->coef_ptr[0];
+  mc->model.rho = &mc->rho[0];
+  mc->model.probA = 0;
+  mc->model.probB = 0;
+  mc->model.label = &mc->label[0];
+  mc->model.nSV = &mc->n_sv[0];
+  mc->model.free_sv = 0;
+  return boost::shared_ptr<svm_model>(mc, &mc->model);
+}
+
+boost::shared_ptr<bob::machine::SupportVector> bob::trainer::SVMTrainer::train
+(const SVMProblem& problem) const {
+
+  //extracted from svm-train.c
+  svm_parameter param = m_param;
+  if (param.gamma == 0. && problem.maxIndex() > 0) {
+    param.gamma = 1.0/problem.maxIndex();
+  }
+
+  //do not support pre-computed kernels...
+  if (param.kernel_type == PRECOMPUTED) {
+    throw std::runtime_error("We currently dod not support PRECOMPUTED kernels in these bindings to libsvm");
   }
 
   //do the training, returns the new machine
-#if LIBSVM_VERSION >= 291
-  svm_set_print_string_function(debug_libsvm);
-#else
-  boost::format m("libsvm-%d does not support debugging stream setting");
-  m % libsvm_version;
-  debug_libsvm(m.str().c_str());
-#endif
-  boost::shared_ptr<svm_model> model(svm_train(problem.get(), &m_param),
-      std::ptr_fun(svm_model_free));
+  set_print_function();
+  return make_machine(trainModel(problem, param, true), problem);
+}
 
-  const_cast<double&>(m_param.gamma) = save_gamma;
+void bob::trainer::SVMTrainer::trainGridPoints(const SVMProblem& problem,
+  const svm_parameter& param, const std::vector<double>& costs,
+  const std::vector<double>& gammas,
+  std::vector<boost::shared_ptr<bob::machine::SupportVector> >& machines,
+  size_t begin, size_t end, size_t thread_idx) const {
+  for (size_t p=begin; p<end; ++p) {
+    svm_parameter point = param;
+    point.C = costs[p / gammas.size()];
+    point.gamma = gammas[p % gammas.size()];
+    machines[p] = make_machine(trainModel(problem, point, false), problem);
+  }
+}
 
-  //save newly created machine to file, reload from there to get rid of memory
-  //dependencies due to the poorly implemented memory model in libsvm
-  boost::shared_ptr<svm_model> new_model =
-    bob::machine::svm_unpickle(bob::machine::svm_pickle(model));
+std::vector<boost::shared_ptr<bob::machine::SupportVector> >
+bob::trainer::SVMTrainer::trainGrid(const SVMProblem& problem,
+  const std::vector<double>& costs, const std::vector<double>& gammas) const {
 
-  boost::shared_ptr<bob::machine::SupportVector> retval =
-    boost::make_shared<bob::machine::SupportVector>(new_model);
+  if (m_param.kernel_type == PRECOMPUTED) {
+    throw std::runtime_error("We currently dod not support PRECOMPUTED kernels in these bindings to libsvm");
+  }
 
-  //sets up the scaling parameters given as input
-  retval->setInputSubtraction(input_subtraction);
-  retval->setInputDivision(input_division);
+  const size_t n_points = costs.size() * gammas.size();
+  std::vector<boost::shared_ptr<bob::machine::SupportVector> >
+    machines(n_points);
+  if (!n_points) return machines;
 
-  return retval;
+  set_print_function();
+  svm_parameter param = m_param;
+  if (param.probability) {
+    trainGridPoints(problem, param, costs, gammas, machines, 0, n_points, 0);
+  }
+  else {
+    const size_t n_concurrent = std::min(n_points, bob::core::getNThreads());
+    param.cache_size = m_param.cache_size / n_concurrent;
+    bob::core::parallelFor(0, n_points,
+      boost::bind(&bob::trainer::SVMTrainer::trainGridPoints, this,
+        boost::cref(problem), boost::cref(param), boost::cref(costs),
+        boost::cref(gammas), boost::ref(machines), _1, _2, _3), 1);
+  }
+  return machines;
+}
+
+boost::shared_ptr<bob::machine::SupportVector> bob::trainer::SVMTrainer::train
+(const std::vector<blitz::Array<double, 2> >& data,
+ const blitz::Array<double,1>& input_subtraction,
+ const blitz::Array<double,1>& input_division) const {
+  //converts the input arraysets into something libsvm can digest
+  SVMProblem problem(data, input_subtraction, input_division);
+  return train(problem);
 }
 
 boost::shared_ptr<bob::machine::SupportVector> bob::trainer::SVMTrainer::train
 (const std::vector<blitz::Array<double,2> >& data) const {
-  int n_features = data[0].extent(blitz::secondDim);
-  blitz::Array<double,1> sub(n_features);
-  sub = 0.;
-  blitz::Array<double,1> div(n_features);
-  div = 1.;
-  return train(data, sub, div);
+  SVMProblem problem(data);
+  return train(problem);
 }
@@ -0,0 +1,87 @@
+/**
+ * @file trainer/cxx/benchmark/kmeans.cc
+ * @date Sat Oct 17 20:12:45 CEST 2026
+ * @author Laurent El Shafey <Laurent.El-Shafey@idiap.ch>
+ *
+ * @brief Benchmark the throughput (in samples per second) of the E-step of
+ * the k-means trainer, and the time of the k-means++ initialization
+ *
+ * Copyright (C) 2011-2013 Idiap Research Institute, Martigny, Switzerland
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <bob/trainer/KMeansTrainer.h>
+#include <bob/core/parallel.h>
+
+#include <boost/random.hpp>
+#include <boost/date_time/posix_time/posix_time.hpp>
+#include <iostream>
+
+static double samplesPerSecond(const int n_samples,
+  const boost::posix_time::time_duration& diff)
+{
+  return n_samples / (diff.total_microseconds() / 1e6);
+}
+
+/**
+ * E-step of the k-means trainer with n_means means on n_samples random
+ * samples of dimension n_inputs, with an increasing number of threads
+ */
+void benchmark_kmeans(const int n_means, const int n_inputs,
+  const int n_samples)
+{
+  boost::mt19937 rng;
+  boost::normal_distribution<double> dist;
+  blitz::Array<double,2> data(n_samples, n_inputs);
+  for (int i=0; i<n_samples; ++i)
+    for (int j=0; j<n_inputs; ++j)
+      data(i,j) = dist(rng);
+  boost::posix_time::ptime t1;
+  boost::posix_time::ptime t2;
+  boost::posix_time::time_duration diff;
+
+  std::cout << "K-means with " << n_means << " means of dimension " << n_inputs << " (" << n_samples << " samples)..." << std::endl;
+
+  bob::machine::KMeansMachine machine(n_means, n_inputs);
+  bob::trainer::KMeansTrainer trainer;
+#if BOOST_VERSION >= 104700
+  trainer.setInitializationMethod(bob::trainer::KMeansTrainer::KMEANS_PLUS_PLUS);
+#endif
+  t1 = boost::posix_time::microsec_clock::local_time();
+  trainer.initialize(machine, data);
+  t2 = boost::posix_time::microsec_clock::local_time();
+  diff = t2 - t1;
+  std::cout << "  Initialization (seconds) " << diff.total_microseconds() / 1e6 << std::endl;
+
+  const size_t n_threads[4] = {1, 2, 4, 8};
+  for (int k=0; k<4; ++k)
+  {
+    bob::core::setNThreads(n_threads[k]);
+    t1 = boost::posix_time::microsec_clock::local_time();
+    trainer.eStep(machine, data);
+    t2 = boost::posix_time::microsec_clock::local_time();
+    diff = t2 - t1;
+    std::cout << "  E-step with " << n_threads[k] << " thread(s) (samples/second) " << samplesPerSecond(n_samples, diff) << std::endl;
+  }
+  bob::core::setNThreads(0);
+}
+
+int main()
+{
+  benchmark_kmeans(64, 20, 100000);
+  benchmark_kmeans(512, 60, 100000);
+  benchmark_kmeans(2048, 60, 50000);
+
+  return 0;
+}
@@ -53,6 +53,26 @@ static void py_mStep(EMTrainerGMMBase& trainer, bob::machine::GMMMachine& machin
   trainer.mStep(machine, sample.bz<double,2>());
 }
 
+static void py_train_array(bob::trainer::GMMTrainer& trainer, bob::machine::GMMMachine& machine, bob::python::const_ndarray sample)
+{
+  trainer.train(machine, sample.bz<double,2>());
+}
+
+static void py_eStep_array(bob::trainer::GMMTrainer& trainer, bob::machine::GMMMachine& machine, bob::python::const_ndarray sample)
+{
+  trainer.eStep(machine, sample.bz<double,2>());
+}
+
+static void py_train_sampler(bob::trainer::GMMTrainer& trainer, bob::machine::GMMMachine& machine, bob::trainer::DataBlockSampler& sampler)
+{
+  trainer.train(machine, sampler);
+}
+
+static void py_eStep_sampler(bob::trainer::GMMTrainer& trainer, bob::machine::GMMMachine& machine, bob::trainer::DataBlockSampler& sampler)
+{
+  trainer.eStep(machine, sampler);
+}
+
 void bind_trainer_gmm() {
 
   class_<EMTrainerGMMBase, boost::noncopyable>("EMTrainerGMM", "The base python class for all EM-based trainers.", no_init)
@@ -75,6 +95,10 @@ void bind_trainer_gmm() {
       "This class implements the E-step of the expectation-maximisation algorithm for a GMM Machine.\n"
       "See Section 9.2.2 of Bishop, \"Pattern recognition and machine learning\", 2006", no_init)
     .add_property("gmm_statistics", make_function(&bob::trainer::GMMTrainer::getGMMStats, return_value_policy<copy_const_reference>()), &bob::trainer::GMMTrainer::setGMMStats, "The internal GMM statistics. Useful to parallelize the E-step.")
+    .def("train", &py_train_array, (arg("self"), arg("machine"), arg("data")), "Train a machine using data")
+    .def("train", &py_train_sampler, (arg("self"), arg("machine"), arg("sampler")), "Train a machine over the blocks of samples streamed by a DataBlockSampler. The statistics are accumulated block by block, which gives the same result as the training over the whole data in memory.")
+    .def("e_step", &py_eStep_array, (arg("self"), arg("machine"), arg("data")), "Accumulates the statistics of the data")
+    .def("e_step", &py_eStep_sampler, (arg("self"), arg("machine"), arg("sampler")), "Accumulates the statistics of the blocks of samples streamed by a DataBlockSampler")
   ;
 
   class_<bob::trainer::MAP_GMMTrainer, boost::noncopyable, bases<bob::trainer::GMMTrainer> >("MAP_GMMTrainer",
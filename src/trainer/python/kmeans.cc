@@ -69,6 +69,42 @@ static void py_mStep(EMTrainerKMeansBase& trainer,
   trainer.mStep(machine, sample.bz<double,2>());
 }
 
+static void py_train_array(bob::trainer::KMeansTrainer& trainer, 
+  bob::machine::KMeansMachine& machine, bob::python::const_ndarray sample)
+{
+  trainer.train(machine, sample.bz<double,2>());
+}
+
+static void py_initialize_array(bob::trainer::KMeansTrainer& trainer, 
+  bob::machine::KMeansMachine& machine, bob::python::const_ndarray sample)
+{
+  trainer.initialize(machine, sample.bz<double,2>());
+}
+
+static void py_eStep_array(bob::trainer::KMeansTrainer& trainer, 
+  bob::machine::KMeansMachine& machine, bob::python::const_ndarray sample)
+{
+  trainer.eStep(machine, sample.bz<double,2>());
+}
+
+static void py_train_sampler(bob::trainer::KMeansTrainer& trainer, 
+  bob::machine::KMeansMachine& machine, bob::trainer::DataBlockSampler& sampler)
+{
+  trainer.train(machine, sampler);
+}
+
+static void py_initialize_sampler(bob::trainer::KMeansTrainer& trainer, 
+  bob::machine::KMeansMachine& machine, bob::trainer::DataBlockSampler& sampler)
+{
+  trainer.initialize(machine, sampler);
+}
+
+static void py_eStep_sampler(bob::trainer::KMeansTrainer& trainer, 
+  bob::machine::KMeansMachine& machine, bob::trainer::DataBlockSampler& sampler)
+{
+  trainer.eStep(machine, sampler);
+}
+
 void bind_trainer_kmeans() 
 {
   class_<EMTrainerKMeansBase, boost::noncopyable>("EMTrainerKMeans", "The base python class for all EM-based trainers.", no_init)
@@ -103,6 +139,14 @@ void bind_trainer_kmeans()
   KMT.def(self == self)
      .def(self != self)
      .add_property("initialization_method", &bob::trainer::KMeansTrainer::getInitializationMethod, &bob::trainer::KMeansTrainer::setInitializationMethod, "The initialization method to generate the initial means.")
+     .add_property("mini_batch_size", &bob::trainer::KMeansTrainer::getMiniBatchSize, &bob::trainer::KMeansTrainer::setMiniBatchSize, "The number of samples of the mini-batches used to update the means before the EM iterations, when training over a DataBlockSampler (0 disables the mini-batch k-means).")
+     .def("train", &py_train_array, (arg("self"), arg("machine"), arg("data")), "Train a machine using data")
+     .def("train", &py_train_sampler, (arg("self"), arg("machine"), arg("sampler")), "Train a machine over the blocks of samples streamed by a DataBlockSampler. The means are initialized by a single pass over the data, updated by one pass of mini-batch k-means if mini_batch_size is set, and then by the EM iterations.")
+     .def("initialize", &py_initialize_array, (arg("self"), arg("machine"), arg("data")), "This method is called before the EM algorithm")
+     .def("initialize", &py_initialize_sampler, (arg("self"), arg("machine"), arg("sampler")), "Initializes the means with samples selected uniformly at random over the blocks streamed by a DataBlockSampler, in a single pass. The k-means++ initialization is replaced by this random selection. If mini_batch_size is set, the means are then updated by one pass of mini-batch k-means.")
+     .def("e_step", &py_eStep_array, (arg("self"), arg("machine"), arg("data")), "Accumulates the statistics of the data")
+     .def("e_step", &py_eStep_sampler, (arg("self"), arg("machine"), arg("sampler")), "Accumulates the statistics of the blocks of samples streamed by a DataBlockSampler")
+     .def("mini_batch_step", &bob::trainer::KMeansTrainer::miniBatchStep, (arg("self"), arg("machine"), arg("sampler")), "Updates the means with one pass of mini-batch k-means over the blocks of samples streamed by a DataBlockSampler, taking mini-batches of mini_batch_size samples in the order of the stream.")
      .add_property("rng", &bob::trainer::KMeansTrainer::getRng, &bob::trainer::KMeansTrainer::setRng, "The Mersenne Twister mt19937 random generator used for the initialization of the means.")
      .add_property("average_min_distance", &bob::trainer::KMeansTrainer::getAverageMinDistance, &bob::trainer::KMeansTrainer::setAverageMinDistance, "Average min (square Euclidean) distance. Useful to parallelize the E-step.")
      .add_property("zeroeth_order_statistics", make_function(&bob::trainer::KMeansTrainer::getZeroethOrderStats, return_value_policy<copy_const_reference>()), &py_setZeroethOrderStats, "The zeroeth order statistics. Useful to parallelize the E-step.")
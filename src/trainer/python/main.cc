@@ -31,6 +31,7 @@ void bind_trainer_mlpbase();
 void bind_trainer_backprop();
 void bind_trainer_rprop();
 void bind_trainer_shuffler();
+void bind_trainer_sampler();
 void bind_trainer_jfa();
 void bind_trainer_ivector();
 void bind_trainer_plda();
@@ -58,6 +59,7 @@ BOOST_PYTHON_MODULE(_trainer) {
   bind_trainer_backprop();
   bind_trainer_rprop();
   bind_trainer_shuffler();
+  bind_trainer_sampler();
   bind_trainer_jfa();
   bind_trainer_ivector();
   bind_trainer_plda();
@@ -0,0 +1,63 @@
+/**
+ * @file trainer/python/sampler.cc
+ * @date Sat Oct 17 19:12:40 CEST 2026
+ * @author Laurent El Shafey <Laurent.El-Shafey@idiap.ch>
+ *
+ * @brief Python bindings for the DataBlockSampler
+ *
+ * Copyright (C) 2011-2013 Idiap Research Institute, Martigny, Switzerland
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <boost/python.hpp>
+#include <boost/make_shared.hpp>
+#include <bob/python/ndarray.h>
+#include <bob/core/array_copy.h>
+#include <bob/trainer/DataBlockSampler.h>
+
+using namespace boost::python;
+
+static boost::shared_ptr<bob::trainer::DataBlockSampler> sampler_from_files
+(object files, const size_t block_size, const bool prefetch) {
+  // Files are either given by their names or already opened
+  std::vector<boost::shared_ptr<bob::io::HDF5File> > vfiles;
+  for (int i=0; i<len(files); ++i) {
+    extract<std::string> filename(files[i]);
+    if (filename.check())
+      vfiles.push_back(boost::make_shared<bob::io::HDF5File>(filename(),
+        bob::io::HDF5File::in));
+    else
+      vfiles.push_back(extract<boost::shared_ptr<bob::io::HDF5File> >(files[i]));
+  }
+  return boost::make_shared<bob::trainer::DataBlockSampler>(vfiles,
+    block_size, prefetch);
+}
+
+static object next_block(bob::trainer::DataBlockSampler& s) {
+  // The block refers to an internal buffer of the sampler
+  blitz::Array<double,2> block;
+  if (!s.next(block)) return object();
+  return object(bob::core::array::ccopy(block));
+}
+
+void bind_trainer_sampler() {
+  class_<bob::trainer::DataBlockSampler, boost::shared_ptr<bob::trainer::DataBlockSampler>, boost::noncopyable>("DataBlockSampler", "Streams the samples stored in a list of HDF5 files, such that trainers can process datasets which do not fit in memory. The first dataset of each file is read, by blocks of samples. It either contains 1D arrays (one sample each, which is how a 2D array saved into an HDF5 file is seen) or 2D arrays (one sample per row). The samples are returned by blocks of at most block_size rows, in the order of the files. When prefetching is enabled, the next block is read by a background thread while the current one is processed.", no_init)
+    .def("__init__", make_constructor(&sampler_from_files, default_call_policies(), (arg("files"), arg("block_size")=10000, arg("prefetch")=true)), "Initializes the sampler with a list of file names or of bob.io.HDF5File objects opened for reading.")
+    .add_property("n_inputs", &bob::trainer::DataBlockSampler::getNInputs, "The dimensionality of the samples")
+    .add_property("block_size", &bob::trainer::DataBlockSampler::getBlockSize, "The maximum number of samples of a block")
+    .add_property("prefetch", &bob::trainer::DataBlockSampler::getPrefetch, "Tells whether the blocks are read by a background thread")
+    .def("reset", &bob::trainer::DataBlockSampler::reset, (arg("self")), "Rewinds to the first block of the first file")
+    .def("next", &next_block, (arg("self")), "Returns a copy of the next block of samples, or None once all the samples have been returned")
+    ;
+}
@@ -22,34 +22,70 @@
 
 #include <bob/python/ndarray.h>
 #include <boost/python/stl_iterator.hpp>
+#include <boost/make_shared.hpp>
 #include <bob/trainer/SVMTrainer.h>
 
 using namespace boost::python;
 
-static boost::shared_ptr<bob::machine::SupportVector> train1 
-(const bob::trainer::SVMTrainer& trainer, object data) {
+static std::vector<blitz::Array<double,2> > to_vector(object data) {
   stl_input_iterator<bob::python::const_ndarray> dbegin(data), dend;
   std::vector<bob::python::const_ndarray> vdata_ref(dbegin, dend);
   std::vector<blitz::Array<double,2> > vdata;
   for(std::vector<bob::python::const_ndarray>::iterator it=vdata_ref.begin(); 
       it!=vdata_ref.end(); ++it)
     vdata.push_back(it->bz<double,2>());
-  return trainer.train(vdata);
+  return vdata;
+}
+
+static boost::shared_ptr<bob::machine::SupportVector> train1 
+(const bob::trainer::SVMTrainer& trainer, object data) {
+  return trainer.train(to_vector(data));
 }
 
 static boost::shared_ptr<bob::machine::SupportVector> train2
 (const bob::trainer::SVMTrainer& trainer, object data, bob::python::const_ndarray sub,
  bob::python::const_ndarray div) {
-  stl_input_iterator<bob::python::const_ndarray> dbegin(data), dend;
-  std::vector<bob::python::const_ndarray> vdata_ref(dbegin, dend);
-  std::vector<blitz::Array<double,2> > vdata;
-  for(std::vector<bob::python::const_ndarray>::iterator it=vdata_ref.begin(); 
-      it!=vdata_ref.end(); ++it)
-    vdata.push_back(it->bz<double,2>());
-  return trainer.train(vdata, sub.bz<double,1>(), div.bz<double,1>());
+  return trainer.train(to_vector(data), sub.bz<double,1>(), div.bz<double,1>());
+}
+
+static boost::shared_ptr<bob::trainer::SVMProblem> problem_init1(object data) {
+  return boost::make_shared<bob::trainer::SVMProblem>(to_vector(data));
+}
+
+static boost::shared_ptr<bob::trainer::SVMProblem> problem_init2(object data,
+    bob::python::const_ndarray sub, bob::python::const_ndarray div) {
+  return boost::make_shared<bob::trainer::SVMProblem>(to_vector(data),
+      sub.bz<double,1>(), div.bz<double,1>());
+}
+
+static tuple train_grid(const bob::trainer::SVMTrainer& trainer,
+    const bob::trainer::SVMProblem& problem, object costs, object gammas) {
+  stl_input_iterator<double> cbegin(costs), cend;
+  std::vector<double> vcosts(cbegin, cend);
+  stl_input_iterator<double> gbegin(gammas), gend;
+  std::vector<double> vgammas(gbegin, gend);
+  std::vector<boost::shared_ptr<bob::machine::SupportVector> > machines =
+    trainer.trainGrid(problem, vcosts, vgammas);
+  list retval;
+  for (size_t k=0; k<machines.size(); ++k) retval.append(machines[k]);
+  return tuple(retval);
+}
+
+static boost::shared_ptr<bob::machine::SupportVector> train3
+(const bob::trainer::SVMTrainer& trainer,
+ const bob::trainer::SVMProblem& problem) {
+  return trainer.train(problem);
 }
 
 void bind_trainer_svm() {
+  class_<bob::trainer::SVMProblem, boost::shared_ptr<bob::trainer::SVMProblem>, boost::noncopyable>("SVMProblem", "A training set converted to the libsvm format, which several trainings (e.g. a grid search) can share. The samples are grouped by class, in the order of the given arrays.", no_init)
+    .def("__init__", make_constructor(&problem_init1, default_call_policies(), (arg("data"))), "Converts the given data, one 2D array (one sample per row) per class.")
+    .def("__init__", make_constructor(&problem_init2, default_call_policies(), (arg("data"), arg("subtract"), arg("divide"))), "Converts the given data, one 2D array (one sample per row) per class, after scaling each column as (x - subtract) / divide.")
+    .add_property("number_of_classes", &bob::trainer::SVMProblem::numberOfClasses, "Number of classes")
+    .add_property("number_of_samples", &bob::trainer::SVMProblem::numberOfSamples, "Number of samples")
+    .add_property("input_size", &bob::trainer::SVMProblem::inputSize, "Number of features of each sample")
+    ;
+
   class_<bob::trainer::SVMTrainer, boost::shared_ptr<bob::trainer::SVMTrainer> >("SVMTrainer", "This class emulates the behavior of the command line utility called svm-train, from libsvm. These bindings do not support:\n\n * Precomputed Kernels\n * Regression Problems\n * Different weights for every label (-wi option in svm-train)\n\nFell free to implement those and remove these remarks.", no_init)
     .def(init<optional<bob::machine::SupportVector::svm_t, bob::machine::SupportVector::kernel_t, int, double, double, double, double, double, double, double, bool, bool> >(
           (arg("self"),
@@ -82,5 +118,7 @@ void bind_trainer_svm() {
     .add_property("probability", &bob::trainer::SVMTrainer::getProbabilityEstimates, &bob::trainer::SVMTrainer::setProbabilityEstimates, "do probability estimates")
     .def("train", &train1, (arg("self"), arg("data")), "Trains a new machine for multi-class classification. If the number of classes in data is 2, then the assigned labels will be -1 and +1. If the number of classes is greater than 2, labels are picked starting from 1 (i.e., 1, 2, 3, 4, etc.). If what you want is regression, the size of the input data array should be 1.")
     .def("train", &train2, (arg("self"), arg("data"), arg("subtract"), arg("divide")), "This version accepts scaling parameters that will be applied column-wise to the input data.")
+    .def("train", &train3, (arg("self"), arg("problem")), "Trains a new machine on a prepared problem. The one-versus-one sub-problems of multi-class problems are trained in parallel, each with an equal share of the kernel cache.")
+    .def("train_grid", &train_grid, (arg("self"), arg("problem"), arg("costs"), arg("gammas")), "Trains one machine for each (cost, gamma) pair of a grid, on the same problem. The grid points are trained in parallel, each with an equal share of the kernel cache. The machine trained with costs[i] and gammas[j] is at position i*len(gammas)+j of the returned tuple.")
     ;
 }
@@ -22,6 +22,8 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <algorithm>
+#include <boost/bind.hpp>
 #include <boost/lambda/lambda.hpp>
 #include <boost/lambda/bind.hpp>
 #include <boost/format.hpp>
@@ -31,6 +33,7 @@
 #include "bob/visioner/cv/cv_detector.h"
 #include "bob/visioner/model/mdecoder.h"
 #include "bob/visioner/util/timer.h"
+#include "bob/core/parallel.h"
 
 namespace bob { namespace visioner {
 
@@ -98,6 +101,7 @@ namespace bob { namespace visioner {
         << "Failed to load the model <" << cmd_model << ">!" << std::endl;
       return false;
     }
+    m_smodels.clear();
     if (valid_model() == false)
     {
       bob::core::error << "Invalid model!" << std::endl;
@@ -151,6 +155,7 @@ namespace bob { namespace visioner {
         m % model;
         throw std::runtime_error(m.str());
       }
+      m_smodels.clear();
 
       if (valid_model() == false) {
         boost::format m("the model loaded from file '%s' is not valid");
@@ -225,6 +230,27 @@ namespace bob { namespace visioner {
     return	output < m_model->n_outputs();
   }
 
+  // Sliding-windows scanned by a task of the parallel scan: the windows of
+  //	the scale <m_scale> for the output <m_output>, with <x> in
+  //	[m_min_x, m_max_x), together with the resulting detections
+  struct CVDetector::band_t
+  {
+    band_t()
+      :       m_scale(0), m_model(0), m_output(0), m_min_x(0), m_max_x(0),
+      m_evals(0), m_sws(0)
+    {
+    }
+
+    uint64_t                 m_scale;        // Scale index
+    uint64_t                 m_model;        // Index of the preprocessed model copy
+    uint64_t                 m_output;       // Output (model type)
+    int                      m_min_x;        // [begin, end) range of <x>
+    int                      m_max_x;
+    std::vector<detection_t> m_detections;   // Thresholded detections
+    uint64_t                 m_evals;        // #LUT evaluations
+    uint64_t                 m_sws;          // #SWs processed
+  };
+
   // Detect objects
   // NB: The detections are thresholded and clustered!
   bool CVDetector::scan(std::vector<detection_t>& detections) const
@@ -257,42 +283,67 @@ namespace bob { namespace visioner {
     }
 
     // Scan the image ... 
+    // NB: The scales are preprocessed concurrently with a copy of the model
+    //	each, then the sliding-windows of these scales are split in bands of
+    //	<x> positions which are scanned by the thread pool. The detections
+    //	of each band are merged in the serial scanning order, such that the
+    //	result does not depend on the number of threads.
     Timer timer;
-    for (uint64_t is = 0; is < m_ipyramid.size(); is ++)
+    const uint64_t n_threads = bob::core::getNThreads();
+    const uint64_t n_scales = m_ipyramid.size();
+    const uint64_t n_models = std::max((uint64_t)1,
+        std::min(n_threads, n_scales));
+    while (m_smodels.size() < n_models)
     {
-      const ipscale_t& ip = m_ipyramid[is];
-      m_model->preprocess(ip);
+      m_smodels.push_back(m_model->clone());
+    }
 
-      // ... with every model type
-      for (uint64_t o = 0; o < n_outputs(); o ++)
+    std::vector<band_t> bands;
+    for (uint64_t is_begin = 0; is_begin < n_scales; is_begin += n_models)
+    {
+      const uint64_t is_end = std::min(is_begin + n_models, n_scales);
+
+      // Preprocess the scales ...
+      bob::core::parallelFor(0, is_end - is_begin,
+          boost::bind(&CVDetector::preprocess_scales, this, is_begin, _1, _2), 1);
+
+      // ... split the sliding-windows in bands ...
+      bands.clear();
+      for (uint64_t is = is_begin; is < is_end; is ++)
       {
-        for (int x = ip.m_scan_min_x; x < ip.m_scan_max_x; x += ip.m_scan_dx)
-          for (int y = ip.m_scan_min_y; y < ip.m_scan_max_y; y += ip.m_scan_dy)
+        const ipscale_t& ip = m_ipyramid[is];
+        const int n_xs = ip.m_scan_max_x > ip.m_scan_min_x ?
+          (ip.m_scan_max_x - ip.m_scan_min_x + ip.m_scan_dx - 1) / ip.m_scan_dx : 0;
+        const int n_bands = std::max(1, std::min(n_xs, (int)n_threads));
+        const int band_xs = (n_xs + n_bands - 1) / n_bands;
+
+        for (uint64_t o = 0; o < n_outputs(); o ++)
+        {
+          for (int ix = 0; ix < n_xs; ix += band_xs)
           {
-            // Concentrate computation on the most promising detections
-            double score = 0.0;
-            for (uint64_t l = 0; l <= m_levels && score >= 0.0; l ++)
-            {
-              const uint64_t lbegin = m_lmodel_begins[o][l];
-              const uint64_t lend = m_lmodel_ends[o][l];
-              score += m_model->score(o, lbegin, lend, x, y);
+            band_t band;
+            band.m_scale = is;
+            band.m_model = is - is_begin;
+            band.m_output = o;
+            band.m_min_x = ip.m_scan_min_x + ix * ip.m_scan_dx;
+            band.m_max_x = std::min(ip.m_scan_max_x, band.m_min_x + band_xs * ip.m_scan_dx);
+            bands.push_back(band);
+          }
+        }
+      }
 
-              // Update statistics
-              m_stats.m_evals += lend - lbegin;
-            }
+      // ... scan them ...
+      bob::core::parallelFor(0, bands.size(),
+          boost::bind(&CVDetector::scan_bands, this, boost::ref(bands), _1, _2), 1);
 
-            // Threshold detection and map it to the original image size
-            if (score >= m_threshold)
-            {
-              detections.push_back(make_detection(
-                    score, 
-                    m_ipyramid.map(subwindow_t(x, y, is)), 
-                    o));
-            }
+      // ... and merge the detections in order
+      for (std::vector<band_t>::const_iterator it = bands.begin(); it != bands.end(); ++ it)
+      {
+        detections.insert(detections.end(), it->m_detections.begin(), it->m_detections.end());
 
-            // Update statistics
-            m_stats.m_sws ++;
-          }
+        // Update statistics
+        m_stats.m_evals += it->m_evals;
+        m_stats.m_sws += it->m_sws;
       }
     }
 
@@ -305,6 +356,61 @@ namespace bob { namespace visioner {
     return true;
   }
 
+  // Preprocess the scales <is_begin + imodel> with the <imodel>-th copy of the
+  //	model, for <imodel> in [begin, end)
+  void CVDetector::preprocess_scales(uint64_t is_begin, size_t begin, size_t end) const
+  {
+    for (size_t imodel = begin; imodel < end; imodel ++)
+    {
+      m_smodels[imodel]->preprocess(m_ipyramid[is_begin + imodel]);
+    }
+  }
+
+  // Scan the sliding-windows of the bands in [begin, end)
+  void CVDetector::scan_bands(std::vector<band_t>& bands, size_t begin, size_t end) const
+  {
+    for (size_t iband = begin; iband < end; iband ++)
+    {
+      scan_band(bands[iband]);
+    }
+  }
+
+  // Scan the sliding-windows of the given band
+  void CVDetector::scan_band(band_t& band) const
+  {
+    const ipscale_t& ip = m_ipyramid[band.m_scale];
+    const Model& model = *m_smodels[band.m_model];
+    const uint64_t o = band.m_output;
+
+    for (int x = band.m_min_x; x < band.m_max_x; x += ip.m_scan_dx)
+      for (int y = ip.m_scan_min_y; y < ip.m_scan_max_y; y += ip.m_scan_dy)
+      {
+        // Concentrate computation on the most promising detections
+        double score = 0.0;
+        for (uint64_t l = 0; l <= m_levels && score >= 0.0; l ++)
+        {
+          const uint64_t lbegin = m_lmodel_begins[o][l];
+          const uint64_t lend = m_lmodel_ends[o][l];
+          score += model.score(o, lbegin, lend, x, y);
+
+          // Update statistics
+          band.m_evals += lend - lbegin;
+        }
+
+        // Threshold detection and map it to the original image size
+        if (score >= m_threshold)
+        {
+          band.m_detections.push_back(make_detection(
+                score, 
+                m_ipyramid.map(subwindow_t(x, y, band.m_scale)), 
+                o));
+        }
+
+        // Update statistics
+        band.m_sws ++;
+      }
+  }
+
   // Match detections with ground truth locations
   bool CVDetector::match(const detection_t& detection, Object& object) const
   {